@@ -4,104 +4,468 @@
 #include "MaterialSerializer.h"
 #include "Core/Project.h"
 #include "Render/Mesh.h"
+#include "Render/Vulkan/PerFrame.h"
 #include "Utils/Profiler.h"
 
 namespace Oxylus {
   AssetManager::AssetsLibrary AssetManager::s_AssetsLibrary;
   std::mutex AssetManager::s_AssetMutex;
+  std::mutex AssetManager::s_RetiredMutex;
 
   std::filesystem::path AssetManager::GetAssetFileSystemPath(const std::filesystem::path& path) {
     return Project::GetAssetDirectory() / path;
   }
 
-  const Asset<VulkanImage>& AssetManager::GetImageAsset(const std::string& path) {
-    ZoneScoped;
-    for (auto& asset : s_AssetsLibrary.ImageAssets) {
-      if (asset.Path == path) {
-        return asset;
+  AssetHandle AssetManager::GetHandle(const std::string& path) {
+    const std::string normalized = std::filesystem::path(path).lexically_normal().generic_string();
+    return AssetHandle{std::hash<std::string>{}(normalized)};
+  }
+
+  template<typename T, typename LoadFunc>
+  Asset<T> AssetManager::GetOrLoad(AssetRegistry<T>& registry, const std::string& path, const LoadFunc& load) {
+    const AssetHandle handle = GetHandle(path);
+    Ref<PendingLoad<T>> pendingLoad = nullptr;
+    {
+      std::lock_guard lock(s_AssetMutex);
+      if (const auto it = registry.Assets.find(handle); it != registry.Assets.end()) {
+        it->second.LastUsed = s_AssetsLibrary.FrameCount;
+        return it->second.Value;
+      }
+      if (const auto it = registry.Pending.find(handle); it != registry.Pending.end())
+        pendingLoad = it->second;
+    }
+
+    //An async load of the asset is finished right away instead of loading it twice. Workers can't finish loads,
+    //they load the asset themselves like loads that failed.
+    if (pendingLoad && !JobSystem::IsWorkerThread()) {
+      FinishLoad(registry, pendingLoad);
+      if (pendingLoad->LoadHandle.IsLoaded())
+        return pendingLoad->LoadHandle.Get();
+    }
+
+    //Loaded without the lock so other threads can keep looking up and loading assets meanwhile.
+    Asset<T> asset = load();
+    asset.Handle = handle;
+
+    std::lock_guard lock(s_AssetMutex);
+    return Register(registry, std::move(asset));
+  }
+
+  template<typename T>
+  AssetLoadHandle<T> AssetManager::LoadAsync(AssetRegistry<T>& registry,
+                                             const std::string& path,
+                                             JobFunction job,
+                                             std::function<Asset<T>()> finish) {
+    const AssetHandle handle = GetHandle(path);
+    Ref<PendingLoad<T>> load = nullptr;
+    {
+      std::lock_guard lock(s_AssetMutex);
+      if (const auto it = registry.Assets.find(handle); it != registry.Assets.end()) {
+        it->second.LastUsed = s_AssetsLibrary.FrameCount;
+        AssetLoadHandle<T> loaded;
+        loaded.m_State = CreateRef<typename AssetLoadHandle<T>::LoadState>();
+        loaded.m_State->Result = it->second.Value;
+        loaded.m_State->State = AssetLoadState::Loaded;
+        return loaded;
       }
+      if (const auto it = registry.Pending.find(handle); it != registry.Pending.end())
+        return it->second->LoadHandle;
+
+      load = CreateRef<PendingLoad<T>>();
+      load->Handle = handle;
+      load->LoadHandle.m_State = CreateRef<typename AssetLoadHandle<T>::LoadState>();
+      load->Finish = std::move(finish);
+      registry.Pending.emplace(handle, load);
     }
 
-    VulkanImageDescription desc;
-    desc.Path = GetAssetFileSystemPath(path).string();
-    desc.CreateDescriptorSet = true;
-    return LoadImageAsset(desc);
+    //Scheduled without the lock, jobs run inline while the job system isn't running and may request other assets.
+    load->Job = JobSystem::Schedule(std::move(job));
+    load->Scheduled = true;
+    return load->LoadHandle;
   }
 
-  const Asset<VulkanImage>& AssetManager::GetImageAsset(const VulkanImageDescription& description) {
+  template<typename T>
+  void AssetManager::FinishLoad(AssetRegistry<T>& registry, const Ref<PendingLoad<T>>& load) {
     ZoneScoped;
-    for (auto& asset : s_AssetsLibrary.ImageAssets) {
-      if (asset.Path == description.Path) {
-        return asset;
+    //Finishing a load can finish others, one that is already being finished is left to its caller.
+    if (load->Finishing)
+      return;
+    load->Finishing = true;
+
+    //Only a few instructions away if another thread is still scheduling the job.
+    while (!load->Scheduled)
+      std::this_thread::yield();
+    load->Job.Wait();
+
+    Asset<T> asset = load->Finish();
+    {
+      std::lock_guard lock(s_AssetMutex);
+      registry.Pending.erase(load->Handle);
+      if (asset.Data) {
+        asset.Handle = load->Handle;
+        asset = Register(registry, std::move(asset));
+      }
+    }
+    load->Finish = nullptr;
+
+    auto& state = *load->LoadHandle.m_State;
+    state.Result = std::move(asset);
+    state.State = state.Result.Data ? AssetLoadState::Loaded : AssetLoadState::Failed;
+    const auto callbacks = std::move(state.Callbacks);
+    state.Callbacks.clear();
+    for (const auto& callback : callbacks)
+      callback(load->LoadHandle);
+  }
+
+  template<typename T>
+  void AssetManager::FinishPendingLoads(AssetRegistry<T>& registry, const bool wait) {
+    std::vector<Ref<PendingLoad<T>>> ready;
+    {
+      std::lock_guard lock(s_AssetMutex);
+      for (const auto& [handle, load] : registry.Pending) {
+        if (wait || (load->Scheduled && load->Job.IsDone()))
+          ready.emplace_back(load);
       }
     }
+    for (const auto& load : ready)
+      FinishLoad(registry, load);
+  }
+
+  template<typename T>
+  Asset<T> AssetManager::Register(AssetRegistry<T>& registry, Asset<T>&& asset) {
+    auto [it, inserted] = registry.Assets.try_emplace(asset.Handle);
+    auto& resident = it->second;
+    resident.LastUsed = s_AssetsLibrary.FrameCount;
+    if (!inserted) {
+      //Another thread loaded the same asset in the meantime, everyone keeps using the first one.
+      if constexpr (std::is_same_v<T, VulkanImage>)
+        Retire(asset);
+      return resident.Value;
+    }
+
+    resident.Value = std::move(asset);
+    resident.Memory = GetMemoryUsage(*resident.Value.Data);
+    registry.Usage.CPUBytes += resident.Memory.CPUBytes;
+    registry.Usage.GPUBytes += resident.Memory.GPUBytes;
+    return resident.Value;
+  }
+
+  template<typename T>
+  void AssetManager::EvictUnused(AssetRegistry<T>& registry, const bool force) {
+    const auto overBudget = [&registry] {
+      return registry.Usage.CPUBytes > registry.Budget.CPUBytes || registry.Usage.GPUBytes > registry.Budget.GPUBytes;
+    };
+    if (!force && !overBudget())
+      return;
+    ZoneScoped;
+
+    //Assets only the registry holds on to have no users left.
+    using Iterator = typename decltype(registry.Assets)::iterator;
+    std::vector<Iterator> unused;
+    for (auto it = registry.Assets.begin(); it != registry.Assets.end(); ++it) {
+      if (it->second.Value.Data.use_count() <= 1)
+        unused.emplace_back(it);
+    }
+    std::sort(unused.begin(), unused.end(), [](const Iterator& a, const Iterator& b) { return a->second.LastUsed < b->second.LastUsed; });
+
+    for (const Iterator& it : unused) {
+      if (!force && !overBudget())
+        break;
+      registry.Usage.CPUBytes -= it->second.Memory.CPUBytes;
+      registry.Usage.GPUBytes -= it->second.Memory.GPUBytes;
+      if constexpr (std::is_same_v<T, VulkanImage>)
+        Retire(it->second.Value);
+      registry.Assets.erase(it);
+      registry.EvictionCount++;
+    }
+  }
+
+  template<typename T>
+  AssetStats AssetManager::GetStats(const AssetRegistry<T>& registry) {
+    AssetStats stats;
+    stats.ResidentCount = (uint32_t)registry.Assets.size();
+    stats.PendingCount = (uint32_t)registry.Pending.size();
+    stats.CPUBytes = registry.Usage.CPUBytes;
+    stats.GPUBytes = registry.Usage.GPUBytes;
+    stats.Budget = registry.Budget;
+    stats.EvictionCount = registry.EvictionCount;
+    for (const auto& [handle, resident] : registry.Assets) {
+      if (resident.Value.Data.use_count() <= 1)
+        stats.UnreferencedCount++;
+    }
+    return stats;
+  }
+
+  Asset<VulkanImage> AssetManager::GetImageAsset(const std::string& path) {
+    ZoneScoped;
+    return GetOrLoad(s_AssetsLibrary.Images,
+      path,
+      [&path] {
+        VulkanImageDescription desc;
+        desc.Path = GetAssetFileSystemPath(path).string();
+        desc.CreateDescriptorSet = true;
+        return LoadImageAsset(desc);
+      });
+  }
+
+  Asset<VulkanImage> AssetManager::GetImageAsset(const VulkanImageDescription& description) {
+    ZoneScoped;
+    return GetOrLoad(s_AssetsLibrary.Images,
+      description.Path,
+      [&description] {
+        auto desc = description;
+        desc.Path = (Project::GetProjectDirectory() / description.Path).string();
+        return LoadImageAsset(desc);
+      });
+  }
+
+  Asset<Mesh> AssetManager::GetMeshAsset(const std::string& path, const int32_t loadingFlags) {
+    ZoneScoped;
+    return GetOrLoad(s_AssetsLibrary.Meshes,
+      path,
+      [&] { return LoadMeshAsset(path, loadingFlags); });
+  }
+
+  Asset<Material> AssetManager::GetMaterialAsset(const std::string& path) {
+    ZoneScoped;
+    return GetOrLoad(s_AssetsLibrary.Materials,
+      path,
+      [&path] { return LoadMaterialAsset(path); });
+  }
+
+  AssetLoadHandle<VulkanImage> AssetManager::LoadImageAsync(const VulkanImageDescription& description) {
+    ZoneScoped;
+    //RGBA8 pixels decoded by the job, the image is created from them on the main thread.
+    struct DecodedImage {
+      uint8_t* Pixels = nullptr;
+      int Width = 0;
+      int Height = 0;
+
+      ~DecodedImage() {
+        if (Pixels)
+          VulkanImage::FreeStbData(Pixels);
+      }
+    };
+
     auto desc = description;
     desc.Path = (Project::GetProjectDirectory() / description.Path).string();
+    const auto extension = std::filesystem::path(desc.Path).extension();
+    //KTX files are loaded by libktx which uploads them itself, those are loaded entirely on the main thread.
+    const bool decode = extension != ".ktx" && extension != ".ktx2" && !desc.EmbeddedData && !desc.EmbeddedStbData &&
+                        !desc.EmbeddedKtxData && desc.Type != ImageType::TYPE_CUBE;
+    auto decoded = CreateRef<DecodedImage>();
 
-    return LoadImageAsset(desc);
+    return LoadAsync<VulkanImage>(s_AssetsLibrary.Images,
+      description.Path,
+      [decoded, decode, path = desc.Path, flip = desc.FlipOnLoad] {
+        if (!decode)
+          return;
+        decoded->Pixels = VulkanImage::DecodeStbFile(path, flip, decoded->Width, decoded->Height);
+        if (!decoded->Pixels)
+          OX_CORE_ERROR("Failed to load texture file {}", path);
+      },
+      [decoded, decode, desc]() mutable {
+        if (decode) {
+          if (!decoded->Pixels)
+            return Asset<VulkanImage>{};
+          desc.EmbeddedStbData = decoded->Pixels;
+          desc.FlipOnLoad = false;
+          if (desc.Width == 0)
+            desc.Width = (uint32_t)decoded->Width;
+          if (desc.Height == 0)
+            desc.Height = (uint32_t)decoded->Height;
+        }
+        Asset<VulkanImage> asset = LoadImageAsset(desc);
+        //The uploader copied the pixels, the description shouldn't point at them once they are freed.
+        decoded.reset();
+        return asset;
+      });
   }
 
-  const Asset<Mesh>& AssetManager::GetMeshAsset(const std::string& path, const int32_t loadingFlags) {
+  AssetLoadHandle<Mesh> AssetManager::LoadMeshAsync(const std::string& path, const int32_t loadingFlags) {
     ZoneScoped;
-    for (auto& asset : s_AssetsLibrary.MeshAssets) {
-      if (asset.Path == path) {
+    auto mesh = CreateRef<Mesh>();
+    auto loaded = CreateRef<bool>(false);
+
+    return LoadAsync<Mesh>(s_AssetsLibrary.Meshes,
+      path,
+      [mesh, loaded, path, loadingFlags] { *loaded = mesh->LoadData(path, loadingFlags); },
+      [mesh, loaded, path] {
+        if (!*loaded)
+          return Asset<Mesh>{};
+        mesh->CreateResources();
+        Asset<Mesh> asset;
+        asset.Data = mesh;
+        asset.Path = path;
+        asset.Type = AssetType::Mesh;
         return asset;
-      }
-    }
+      });
+  }
 
-    return LoadMeshAsset(path, loadingFlags);
+  AssetLoadHandle<Material> AssetManager::LoadMaterialAsync(const std::string& path) {
+    ZoneScoped;
+    //Textures are requested by the job so they decode in parallel, the material picks them up once it is finished.
+    return LoadAsync<Material>(s_AssetsLibrary.Materials,
+      path,
+      [path] { MaterialSerializer::LoadTexturesAsync(path); },
+      [path] { return LoadMaterialAsset(path); });
   }
 
-  const Asset<Material>& AssetManager::GetMaterialAsset(const std::string& path) {
+  void AssetManager::Update() {
     ZoneScoped;
-    for (auto& asset : s_AssetsLibrary.MaterialAssets) {
-      if (asset.Path == path) {
-        return asset;
-      }
+    const uint64_t frame = ++s_AssetsLibrary.FrameCount;
+
+    FinishPendingLoads(s_AssetsLibrary.Images, false);
+    FinishPendingLoads(s_AssetsLibrary.Materials, false);
+    FinishPendingLoads(s_AssetsLibrary.Meshes, false);
+
+    std::vector<RetiredAsset> released;
+    {
+      std::lock_guard lock(s_AssetMutex);
+      //Meshes hold on to their materials and textures, so those are evicted after them.
+      EvictUnused(s_AssetsLibrary.Meshes, false);
+      EvictUnused(s_AssetsLibrary.Materials, false);
+      EvictUnused(s_AssetsLibrary.Images, false);
+
+      //The frame recorded after the eviction may still be in flight, it is done once it came around again.
+      std::lock_guard retiredLock(s_RetiredMutex);
+      std::erase_if(s_AssetsLibrary.RetiredAssets,
+        [frame, &released](RetiredAsset& retired) {
+          if (retired.Frame + MAX_FRAMES_IN_FLIGHT >= frame)
+            return false;
+          released.emplace_back(std::move(retired));
+          return true;
+        });
     }
+    for (const auto& retired : released)
+      retired.Release();
+  }
 
-    return LoadMaterialAsset(path);
+  void AssetManager::WaitForLoads() {
+    ZoneScoped;
+    while (true) {
+      {
+        std::lock_guard lock(s_AssetMutex);
+        if (s_AssetsLibrary.Images.Pending.empty() && s_AssetsLibrary.Materials.Pending.empty() &&
+            s_AssetsLibrary.Meshes.Pending.empty())
+          return;
+      }
+      //Materials request their textures while loading, so those are finished last.
+      FinishPendingLoads(s_AssetsLibrary.Meshes, true);
+      FinishPendingLoads(s_AssetsLibrary.Materials, true);
+      FinishPendingLoads(s_AssetsLibrary.Images, true);
+    }
   }
 
   void AssetManager::FreeUnusedAssets() {
     ZoneScoped;
-    for (auto& asset : s_AssetsLibrary.MeshAssets) {
-      asset.Data.reset();
-      asset.Path.clear();
-      asset.Handle = {};
+    std::lock_guard lock(s_AssetMutex);
+    EvictUnused(s_AssetsLibrary.Meshes, true);
+    EvictUnused(s_AssetsLibrary.Materials, true);
+    EvictUnused(s_AssetsLibrary.Images, true);
+  }
+
+  void AssetManager::Shutdown() {
+    ZoneScoped;
+    std::vector<RetiredAsset> released;
+    {
+      std::lock_guard lock(s_AssetMutex);
+      //Loads that never finished only hold CPU data.
+      s_AssetsLibrary.Meshes.Pending.clear();
+      s_AssetsLibrary.Materials.Pending.clear();
+      s_AssetsLibrary.Images.Pending.clear();
+      std::lock_guard retiredLock(s_RetiredMutex);
+      released = std::move(s_AssetsLibrary.RetiredAssets);
+      s_AssetsLibrary.RetiredAssets.clear();
     }
-    for (auto& asset : s_AssetsLibrary.MaterialAssets) {
-      asset.Data.reset();
-      asset.Path.clear();
-      asset.Handle = {};
+    for (const auto& retired : released)
+      retired.Release();
+  }
+
+  void AssetManager::SetBudget(const AssetType type, const AssetBudget& budget) {
+    std::lock_guard lock(s_AssetMutex);
+    switch (type) {
+      case AssetType::Mesh: s_AssetsLibrary.Meshes.Budget = budget;
+        break;
+      case AssetType::Image: s_AssetsLibrary.Images.Budget = budget;
+        break;
+      case AssetType::Material: s_AssetsLibrary.Materials.Budget = budget;
+        break;
+      default: OX_CORE_WARN("Asset type {} has no budget", (int)type);
+        break;
     }
-    for (auto& asset : s_AssetsLibrary.ImageAssets) {
-      asset.Data.reset();
-      asset.Path.clear();
-      asset.Handle = {};
+  }
+
+  AssetStats AssetManager::GetStats(const AssetType type) {
+    std::lock_guard lock(s_AssetMutex);
+    switch (type) {
+      case AssetType::Mesh: return GetStats(s_AssetsLibrary.Meshes);
+      case AssetType::Image: return GetStats(s_AssetsLibrary.Images);
+      case AssetType::Material: return GetStats(s_AssetsLibrary.Materials);
+      default: return {};
     }
   }
 
-  const Asset<VulkanImage>& AssetManager::LoadImageAsset(const VulkanImageDescription& description) {
+  AssetManager::AssetMemory AssetManager::GetMemoryUsage(const VulkanImage& image) {
+    //Pixels are freed once uploaded.
+    return AssetMemory{0, image.ImageSize};
+  }
+
+  AssetManager::AssetMemory AssetManager::GetMemoryUsage(const Mesh& mesh) {
+    AssetMemory memory;
+    memory.CPUBytes = sizeof(Mesh) + mesh.LinearNodes.size() * sizeof(Mesh::Node);
+    for (const auto* node : mesh.LinearNodes)
+      memory.CPUBytes += node->Primitives.size() * sizeof(Mesh::Primitive);
+    memory.GPUBytes = (uint64_t)mesh.Geometry.VertexCount * VertexFormat::GetVertexSize(mesh.Geometry.Streams) + (uint64_t)mesh.Geometry.IndexCount * sizeof(uint32_t);
+    //Embedded textures aren't in the image registry.
+    memory.GPUBytes += mesh.EmbeddedTextureBytes;
+    return memory;
+  }
+
+  AssetManager::AssetMemory AssetManager::GetMemoryUsage(const Material& material) {
+    //Textures are accounted for by the images.
+    return AssetMemory{sizeof(Material), 0};
+  }
+
+  void AssetManager::Retire(std::function<void()> release) {
+    std::lock_guard lock(s_RetiredMutex);
+    s_AssetsLibrary.RetiredAssets.emplace_back(RetiredAsset{std::move(release), s_AssetsLibrary.FrameCount});
+  }
+
+  void AssetManager::Retire(const Asset<VulkanImage>& asset) {
+    Retire([image = asset.Data] { image->Destroy(); });
+  }
+
+  Ref<VulkanImage> AssetManager::CreateUnregisteredImage(const VulkanImageDescription& description) {
+    ZoneScoped;
+    return Ref<VulkanImage>(new VulkanImage(description),
+      [](VulkanImage* image) {
+        Retire([image] {
+          image->Destroy();
+          delete image;
+        });
+      });
+  }
+
+  Asset<VulkanImage> AssetManager::LoadImageAsset(const VulkanImageDescription& description) {
     ZoneScoped;
     Asset<VulkanImage> asset;
-    std::lock_guard lock(s_AssetMutex);
     asset.Data = CreateRef<VulkanImage>(description);
     asset.Path = description.Path;
     asset.Type = AssetType::Image;
-    return s_AssetsLibrary.ImageAssets.emplace_back(asset);
+    return asset;
   }
 
-  const Asset<Mesh>& AssetManager::LoadMeshAsset(const std::string& path, int32_t loadingFlags) {
+  Asset<Mesh> AssetManager::LoadMeshAsset(const std::string& path, int32_t loadingFlags) {
     ZoneScoped;
     Asset<Mesh> asset;
     asset.Data = CreateRef<Mesh>(path, loadingFlags);
     asset.Path = path;
     asset.Type = AssetType::Mesh;
-    return s_AssetsLibrary.MeshAssets.emplace_back(asset);
+    return asset;
   }
 
-  const Asset<Material>& AssetManager::LoadMaterialAsset(const std::string& path) {
+  Asset<Material> AssetManager::LoadMaterialAsset(const std::string& path) {
     ZoneScoped;
     Asset<Material> asset;
     asset.Data = CreateRef<Material>();
@@ -110,6 +474,6 @@ namespace Oxylus {
     serializer.Deserialize(path);
     asset.Path = path;
     asset.Type = AssetType::Material;
-    return s_AssetsLibrary.MaterialAssets.emplace_back(asset);
+    return asset;
   }
 }
@@ -1,40 +1,168 @@
 #pragma once
 
 #include "Assets/Assets.h"
+#include "Thread/JobSystem.h"
 
 #include <filesystem>
+#include <mutex>
+#include <unordered_map>
 
 namespace Oxylus {
   class VulkanImage;
   class Material;
   class Mesh;
 
+  //Memory resident assets of a type may keep. Unreferenced assets are evicted least recently used first once it is exceeded.
+  struct AssetBudget {
+    uint64_t CPUBytes = UINT64_MAX;
+    uint64_t GPUBytes = UINT64_MAX;
+  };
+
+  struct AssetStats {
+    uint32_t ResidentCount = 0;
+    //Resident but used by nothing besides the registry, these are evicted first.
+    uint32_t UnreferencedCount = 0;
+    uint32_t PendingCount = 0;
+    uint64_t CPUBytes = 0;
+    uint64_t GPUBytes = 0;
+    AssetBudget Budget;
+    uint64_t EvictionCount = 0;
+  };
+
+  /**
+   * \brief Registry of loaded assets keyed by the handle of their path.
+   * Lookups are thread safe and return copies, so assets stay valid while other threads load or free them.
+   * Async loads parse and decode on the job system and create their GPU resources on the main thread in Update.
+   * Assets nothing else references stay cached until their type exceeds its budget or FreeUnusedAssets is called.
+   */
   class AssetManager {
   public:
     static std::filesystem::path GetAssetFileSystemPath(const std::filesystem::path& path);
+    //Handle of the asset a path refers to, the path is normalized first.
+    static AssetHandle GetHandle(const std::string& path);
 
     // Assumes the path already points to an existing asset file.
-    static const Asset<VulkanImage>& GetImageAsset(const std::string& path);
+    static Asset<VulkanImage> GetImageAsset(const std::string& path);
     // Assumes the path already points to an existing asset file.
-    static const Asset<VulkanImage>& GetImageAsset(const VulkanImageDescription& description);
+    static Asset<VulkanImage> GetImageAsset(const VulkanImageDescription& description);
     // Assumes the path already points to an existing asset file.
-    static const Asset<Mesh>& GetMeshAsset(const std::string& path, int32_t loadingFlags = 0);
+    static Asset<Mesh> GetMeshAsset(const std::string& path, int32_t loadingFlags = 0);
     // Assumes the path already points to an existing asset file.
-    static const Asset<Material>& GetMaterialAsset(const std::string& path); 
+    static Asset<Material> GetMaterialAsset(const std::string& path);
+    //Thread safe. For images that aren't assets of their own, like textures embedded in meshes. Once the last reference
+    //is gone the image is destroyed like an evicted one, after the frames in flight are done with it.
+    static Ref<VulkanImage> CreateUnregisteredImage(const VulkanImageDescription& description);
 
+    //Thread safe. Requests of an asset that is already loading or loaded share its load instead of starting another one.
+    static AssetLoadHandle<VulkanImage> LoadImageAsync(const VulkanImageDescription& description);
+    static AssetLoadHandle<Mesh> LoadMeshAsync(const std::string& path, int32_t loadingFlags = 0);
+    static AssetLoadHandle<Material> LoadMaterialAsync(const std::string& path);
+
+    //Finishes the loads whose jobs are done, enforces the budgets and destroys evicted GPU resources. Main thread, once per frame.
+    static void Update();
+    //Finishes every pending load, including the ones requested by loads finishing meanwhile. Main thread.
+    static void WaitForLoads();
+
+    //Evicts every asset nothing outside of the registry references anymore.
     static void FreeUnusedAssets();
+    //Destroys the GPU resources of evicted assets right away, the device has to be idle.
+    static void Shutdown();
+
+    static void SetBudget(AssetType type, const AssetBudget& budget);
+    static AssetStats GetStats(AssetType type);
 
   private:
-    static const Asset<VulkanImage>& LoadImageAsset(const VulkanImageDescription& description);
-    static const Asset<Mesh>& LoadMeshAsset(const std::string& path, int32_t loadingFlags);
-    static const Asset<Material>& LoadMaterialAsset(const std::string& path);
+    struct AssetMemory {
+      uint64_t CPUBytes = 0;
+      uint64_t GPUBytes = 0;
+    };
+
+    template<typename T>
+    struct ResidentAsset {
+      Asset<T> Value;
+      AssetMemory Memory;
+      //Update count of the last lookup, least recently used assets are evicted first.
+      uint64_t LastUsed = 0;
+    };
+
+    template<typename T>
+    struct PendingLoad {
+      AssetHandle Handle;
+      AssetLoadHandle<T> LoadHandle;
+      //Runs on the main thread once Job is done, creates the GPU resources. An asset without data failed to load.
+      std::function<Asset<T>()> Finish;
+      JobHandle Job;
+      //Job is only assigned after the load was registered, it is read once this is set.
+      std::atomic<bool> Scheduled = false;
+      bool Finishing = false;
+    };
+
+    template<typename T>
+    struct AssetRegistry {
+      std::unordered_map<AssetHandle, ResidentAsset<T>> Assets;
+      std::unordered_map<AssetHandle, Ref<PendingLoad<T>>> Pending;
+      AssetBudget Budget;
+      //Sum over the resident assets.
+      AssetMemory Usage;
+      uint64_t EvictionCount = 0;
+    };
+
+    struct RetiredAsset {
+      //Destroys what the destructor of the asset doesn't.
+      std::function<void()> Release;
+      uint64_t Frame = 0;
+    };
+
+    template<typename T, typename LoadFunc>
+    static Asset<T> GetOrLoad(AssetRegistry<T>& registry, const std::string& path, const LoadFunc& load);
+    template<typename T>
+    static AssetLoadHandle<T> LoadAsync(AssetRegistry<T>& registry,
+                                        const std::string& path,
+                                        JobFunction job,
+                                        std::function<Asset<T>()> finish);
+    template<typename T>
+    static void FinishLoad(AssetRegistry<T>& registry, const Ref<PendingLoad<T>>& load);
+    //Finishes the loads whose jobs are done, or all of them if wait is set.
+    template<typename T>
+    static void FinishPendingLoads(AssetRegistry<T>& registry, bool wait);
+
+    //Has to hold the lock. Returns the asset the registry keeps, the first one if another thread registered it meanwhile.
+    template<typename T>
+    static Asset<T> Register(AssetRegistry<T>& registry, Asset<T>&& asset);
+    //Has to hold the lock. Evicts unreferenced assets least recently used first until the registry fits into its budget,
+    //or all of them if force is set.
+    template<typename T>
+    static void EvictUnused(AssetRegistry<T>& registry, bool force);
+    template<typename T>
+    static AssetStats GetStats(const AssetRegistry<T>& registry);
+
+    static AssetMemory GetMemoryUsage(const VulkanImage& image);
+    static AssetMemory GetMemoryUsage(const Mesh& mesh);
+    static AssetMemory GetMemoryUsage(const Material& material);
+    //Images aren't destroyed with their last reference, evicted ones are destroyed once the frames in flight are done.
+    //Takes the retired lock, so it can be called with or without the asset lock held.
+    static void Retire(std::function<void()> release);
+    static void Retire(const Asset<VulkanImage>& asset);
+
+    static Asset<VulkanImage> LoadImageAsset(const VulkanImageDescription& description);
+    static Asset<Mesh> LoadMeshAsset(const std::string& path, int32_t loadingFlags);
+    static Asset<Material> LoadMaterialAsset(const std::string& path);
 
     static struct AssetsLibrary {
-      std::vector<Asset<Material>> MaterialAssets{};
-      std::vector<Asset<Mesh>> MeshAssets{};
-      std::vector<Asset<VulkanImage>> ImageAssets{};
+      //Default budgets, set with SetBudget.
+      AssetRegistry<Material> Materials{.Budget = {16ull << 20, UINT64_MAX}};
+      AssetRegistry<Mesh> Meshes{.Budget = {64ull << 20, 512ull << 20}};
+      AssetRegistry<VulkanImage> Images{.Budget = {UINT64_MAX, 1024ull << 20}};
+
+      //Evicted assets the frames in flight may still use.
+      std::vector<RetiredAsset> RetiredAssets{};
+      std::atomic<uint64_t> FrameCount = 0;
     } s_AssetsLibrary;
 
+    //Guards the library, assets are loaded without holding it.
     static std::mutex s_AssetMutex;
+    //Guards RetiredAssets. Unregistered images are retired by their last reference, which may be dropped while
+    //s_AssetMutex is held, e.g. by evicting the mesh owning them. Always taken after s_AssetMutex.
+    static std::mutex s_RetiredMutex;
   };
 }
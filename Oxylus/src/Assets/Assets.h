@@ -1,6 +1,7 @@
 #pragma once
 
 #include <oxpch.h>
+#include <atomic>
 
 #include "Core/UUID.h"
 #include "Render/Vulkan/VulkanImage.h"
@@ -20,8 +21,9 @@ namespace Oxylus {
     Material
   };
 
+  //Identifies an asset by the hash of its path, so the same file always maps to the same handle.
   struct AssetHandle {
-    UUID ID;
+    UUID ID = 0;
 
     bool operator==(const AssetHandle& other) const {
       return ID == other.ID;
@@ -39,4 +41,59 @@ namespace Oxylus {
       return !Path.empty();
     }
   };
+
+  enum class AssetLoadState {
+    Pending,
+    Loaded,
+    Failed
+  };
+
+  /**
+   * \brief Handle of an asynchronous asset load, copies and requests of an asset that is already loading share the load.
+   * The state changes on the main thread once AssetManager finished the load, callbacks run there as well.
+   */
+  template<typename T>
+  class AssetLoadHandle {
+  public:
+    using Callback = std::function<void(const AssetLoadHandle& handle)>;
+
+    AssetLoadHandle() = default;
+
+    bool IsValid() const { return m_State != nullptr; }
+    AssetLoadState GetState() const { return m_State ? m_State->State.load() : AssetLoadState::Failed; }
+    bool IsPending() const { return GetState() == AssetLoadState::Pending; }
+    bool IsLoaded() const { return GetState() == AssetLoadState::Loaded; }
+    bool IsFailed() const { return GetState() == AssetLoadState::Failed; }
+
+    //Only holds data once loaded.
+    const Asset<T>& Get() const { return m_State->Result; }
+
+    //Runs once the load finished or failed, right away if it already did. Main thread only.
+    void OnComplete(Callback callback) const {
+      if (!m_State)
+        return;
+      if (IsPending())
+        m_State->Callbacks.emplace_back(std::move(callback));
+      else
+        callback(*this);
+    }
+
+  private:
+    struct LoadState {
+      std::atomic<AssetLoadState> State = AssetLoadState::Pending;
+      Asset<T> Result;
+      std::vector<Callback> Callbacks;
+    };
+
+    Ref<LoadState> m_State = nullptr;
+
+    friend class AssetManager;
+  };
 }
+
+template<>
+struct std::hash<Oxylus::AssetHandle> {
+  size_t operator()(const Oxylus::AssetHandle& handle) const noexcept {
+    return handle.ID;
+  }
+};
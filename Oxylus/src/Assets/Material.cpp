@@ -3,10 +3,51 @@
 #include "Material.h"
 
 #include "Core/Resources.h"
-#include "Render/Vulkan/VulkanRenderer.h"
+#include "Utils/Profiler.h"
 
 namespace Oxylus {
-  VulkanDescriptorSet Material::s_DescriptorSet;
+  PerFrame<VulkanDescriptorSet> Material::s_DescriptorSet;
+
+  Material::Material(const Material& other) : AlphaMode(other.AlphaMode),
+                                                Parameters(other.Parameters),
+                                                Name(other.Name),
+                                                Path(other.Path),
+                                                Shader(other.Shader),
+                                                AlbedoTexture(other.AlbedoTexture),
+                                                NormalTexture(other.NormalTexture),
+                                                RoughnessTexture(other.RoughnessTexture),
+                                                MetallicTexture(other.MetallicTexture),
+                                                AOTexture(other.AOTexture),
+                                                EmissiveTexture(other.EmissiveTexture),
+                                                SpecularTexture(other.SpecularTexture),
+                                                DiffuseTexture(other.DiffuseTexture) {
+    if (other.m_PoolHandle.IsValid())
+      MaterialPool::Register(*this);
+  }
+
+  Material& Material::operator=(const Material& other) {
+    if (this == &other)
+      return *this;
+    AlphaMode = other.AlphaMode;
+    Parameters = other.Parameters;
+    Name = other.Name;
+    Path = other.Path;
+    Shader = other.Shader;
+    AlbedoTexture = other.AlbedoTexture;
+    NormalTexture = other.NormalTexture;
+    RoughnessTexture = other.RoughnessTexture;
+    MetallicTexture = other.MetallicTexture;
+    AOTexture = other.AOTexture;
+    EmissiveTexture = other.EmissiveTexture;
+    SpecularTexture = other.SpecularTexture;
+    DiffuseTexture = other.DiffuseTexture;
+    //Keeps the index this material already has and points its slots at the new textures.
+    if (other.m_PoolHandle.IsValid())
+      MaterialPool::Register(*this);
+    else
+      m_PoolHandle.Release();
+    return *this;
+  }
 
   Material::~Material() { }
 
@@ -18,21 +59,7 @@ namespace Oxylus {
     //Shader = VulkanRenderer::GetShaderByID(shaderID); 
 
     ClearTextures();
-
-    if (!s_DescriptorSet.Get())
-      s_DescriptorSet.CreateFromPipeline(VulkanRenderer::s_Pipelines.PBRPipeline);
-    MaterialDescriptorSet.CreateFromPipeline(VulkanRenderer::s_Pipelines.PBRPipeline, 1);
-
-    s_DescriptorSet.WriteDescriptorSets[9].pImageInfo = &VulkanRenderer::s_FrameBuffers.DepthNormalPassFB.GetImage()[0].GetDescImageInfo();
-    s_DescriptorSet.WriteDescriptorSets[10].pImageInfo = &VulkanRenderer::s_Resources.DirectShadowsDepthArray.GetDescImageInfo();
-    s_DescriptorSet.Update(true);
-
-    MaterialDescriptorSet.WriteDescriptorSets[0].pImageInfo = &AlbedoTexture->GetDescImageInfo();
-    MaterialDescriptorSet.WriteDescriptorSets[1].pImageInfo = &NormalTexture->GetDescImageInfo();
-    MaterialDescriptorSet.WriteDescriptorSets[2].pImageInfo = &AOTexture->GetDescImageInfo();
-    MaterialDescriptorSet.WriteDescriptorSets[3].pImageInfo = &MetallicTexture->GetDescImageInfo();
-    MaterialDescriptorSet.WriteDescriptorSets[4].pImageInfo = &RoughnessTexture->GetDescImageInfo();
-    MaterialDescriptorSet.Update(true);
+    MaterialPool::Register(*this);
   }
 
   bool Material::IsOpaque() const {
@@ -41,21 +68,11 @@ namespace Oxylus {
 
   void Material::Update() {
     ZoneScoped;
-    s_DescriptorSet.WriteDescriptorSets[9].pImageInfo = &VulkanRenderer::s_FrameBuffers.DepthNormalPassFB.GetImage()[0].GetDescImageInfo();
-    s_DescriptorSet.WriteDescriptorSets[10].pImageInfo = &VulkanRenderer::s_Resources.DirectShadowsDepthArray.GetDescImageInfo();
-    s_DescriptorSet.Update(true);
-
-    MaterialDescriptorSet.WriteDescriptorSets[0].pImageInfo = &AlbedoTexture->GetDescImageInfo();
-    MaterialDescriptorSet.WriteDescriptorSets[1].pImageInfo = &NormalTexture->GetDescImageInfo();
-    MaterialDescriptorSet.WriteDescriptorSets[2].pImageInfo = &AOTexture->GetDescImageInfo();
-    MaterialDescriptorSet.WriteDescriptorSets[3].pImageInfo = &MetallicTexture->GetDescImageInfo();
-    MaterialDescriptorSet.WriteDescriptorSets[4].pImageInfo = &RoughnessTexture->GetDescImageInfo();
-    MaterialDescriptorSet.Update(true);
+    MaterialPool::Register(*this);
   }
 
   void Material::Destroy() {
-    if (MaterialDescriptorSet.Get())
-      MaterialDescriptorSet.Destroy();
+    m_PoolHandle.Release();
     ClearTextures();
     Parameters = {};
   }
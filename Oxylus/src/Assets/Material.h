@@ -2,6 +2,8 @@
 
 #include "glm/vec4.hpp"
 #include "Core/Base.h"
+#include "Render/MaterialPool.h"
+#include "Render/Vulkan/PerFrame.h"
 #include "Render/Vulkan/VulkanDescriptorSet.h"
 #include "Render/Vulkan/VulkanImage.h"
 #include "Render/Vulkan/VulkanShader.h"
@@ -39,8 +41,8 @@ namespace Oxylus {
     std::string Name = "Material";
     std::string Path{};
 
-    static VulkanDescriptorSet s_DescriptorSet;
-    VulkanDescriptorSet MaterialDescriptorSet;
+    //Scene wide set shared by every material, it binds per frame buffers.
+    static PerFrame<VulkanDescriptorSet> s_DescriptorSet;
     Ref<VulkanShader> Shader = nullptr;
     Ref<VulkanImage> AlbedoTexture = nullptr;
     Ref<VulkanImage> NormalTexture = nullptr;
@@ -52,14 +54,24 @@ namespace Oxylus {
     Ref<VulkanImage> DiffuseTexture = nullptr;
 
     Material() = default;
+    //Copies register their own pool index and texture slots if the original was registered.
+    Material(const Material& other);
+    Material(Material&& other) noexcept = default;
+    Material& operator=(const Material& other);
+    Material& operator=(Material&& other) noexcept = default;
     ~Material();
 
     //TODO: Use ShaderID
     void Create(const std::string& name = "Material", const UUID& shaderID = {});
     bool IsOpaque() const;
+    //Registers the textures with the material pool, parameters are picked up every frame the material is drawn.
     void Update();
     void Destroy();
   private:
+    MaterialPool::Handle m_PoolHandle;
+
     void ClearTextures();
+
+    friend class MaterialPool;
   };
 }
@@ -119,6 +119,37 @@ namespace Oxylus {
     m_Material->Update();
   }
 
+  void MaterialSerializer::LoadTexturesAsync(const std::string& path) {
+    if (path.empty())
+      return;
+    ZoneScoped;
+
+    auto content = FileUtils::ReadFile(path);
+    if (!content)
+      content = FileUtils::ReadFile(AssetManager::GetAssetFileSystemPath(path).string());
+    //Deserialize reports the missing file.
+    if (!content)
+      return;
+
+    ryml::Tree tree = ryml::parse_in_arena(c4::to_csubstr(content.value()));
+    const ryml::ConstNodeRef nodeRoot = tree.rootref();
+    if (!nodeRoot.has_child(ryml::to_csubstr("Textures")))
+      return;
+
+    //Same descriptions as Deserialize, so its lookups hit these loads.
+    VulkanImageDescription desc;
+    desc.FlipOnLoad = true;
+    desc.CreateDescriptorSet = true;
+
+    const auto texturesNode = nodeRoot["Textures"];
+    for (const char* nodeName : {"Albedo", "Normal", "Roughness", "Metallic", "AO", "Emmisive"}) {
+      if (!texturesNode.has_child(ryml::to_csubstr(nodeName)))
+        continue;
+      texturesNode[ryml::to_csubstr(nodeName)] >> desc.Path;
+      AssetManager::LoadImageAsync(desc);
+    }
+  }
+
   void MaterialSerializer::SaveIfPathExists(ryml::NodeRef node, const Ref<VulkanImage>& texture) const {
     if (!texture->GetDesc().Path.empty())
       node << texture->GetDesc().Path;
@@ -11,6 +11,8 @@ namespace Oxylus {
 
     void Serialize(const std::string& path) const;
     void Deserialize(const std::string& path) const;
+    //Requests the textures of the material file through AssetManager::LoadImageAsync so Deserialize finds them loaded.
+    static void LoadTexturesAsync(const std::string& path);
 
   private:
     void SaveIfPathExists(ryml::NodeRef node, const Ref<VulkanImage>& texture) const;
@@ -1,5 +1,6 @@
 #include "src/oxpch.h"
 #include "Application.h"
+#include "Assets/AssetManager.h"
 #include "Core.h"
 #include "Layer.h"
 #include "Render/Window.h"
@@ -55,6 +56,8 @@ namespace Oxylus {
     while (m_IsRunning) {
       Timestep::UpdateTime();
 
+      AssetManager::Update();
+
       //Layers
       UpdateLayers();
 
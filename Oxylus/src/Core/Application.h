@@ -6,7 +6,6 @@
 #include <filesystem>
 
 #include "Systems/System.h"
-#include "Thread/ThreadManager.h"
 #include "Utils/Log.h"
 
 int main(int argc,
@@ -70,8 +69,6 @@ namespace Oxylus {
     std::vector<Scope<System>> m_Systems;
     EventDispatcher m_Dispatcher;
 
-    ThreadManager m_ThreadManager;
-
     bool m_IsRunning = true;
     static Application* s_Instance;
 
@@ -66,6 +66,23 @@ namespace Oxylus {
     }
   };
 
+  //Cached world matrix, updated once per frame by Scene::UpdateTransforms.
+  struct WorldTransformComponent {
+    Mat4 Transform = Mat4(1.0f);
+
+    //Local values the cached transform was built from. Used to detect changes to TransformComponent.
+    Vec3 Translation = Vec3(0);
+    Vec3 Rotation = Vec3(0);
+    Vec3 Scale = Vec3(1);
+
+    //Forces a recompute of this entity and its children, e.g. after reparenting.
+    bool Dirty = true;
+
+    bool Matches(const TransformComponent& transform) const {
+      return Translation == transform.Translation && Rotation == transform.Rotation && Scale == transform.Scale;
+    }
+  };
+
   //Rendering
   struct MaterialComponent {
     std::vector<Ref<Material>> Materials{};
@@ -2,13 +2,16 @@
 #include "Core.h"
 
 #include "Project.h"
+#include "Assets/AssetManager.h"
 #include "Audio/AudioEngine.h"
 #include "Core/Input.h"
 
+#include "Render/MeshCache.h"
 #include "Render/Window.h"
 #include "Physics/Physics.h"
 #include "Render/Vulkan/VulkanContext.h"
 #include "Render/Vulkan/VulkanRenderer.h"
+#include "Thread/JobSystem.h"
 #include "Utils/UIUtils.h"
 
 namespace Oxylus {
@@ -16,8 +19,11 @@ namespace Oxylus {
 
   void Core::Init(const AppSpec& spec) {
     s_Backend = spec.Backend;
+    JobSystem::Init();
     FileDialogs::InitNFD();
     Project::New();
+    //Cooked meshes persist between runs next to the pipeline cache.
+    MeshCache::SetDirectory(std::filesystem::absolute("resources/cache/meshes"));
     Window::InitWindow(spec);
     VulkanContext::CreateContext(spec);
     VulkanRenderer::Init();
@@ -28,13 +34,14 @@ namespace Oxylus {
 
   void Core::Shutdown() {
     FileDialogs::CloseNFD();
+    //Finish outstanding jobs while the renderer and physics they might use are still alive.
+    JobSystem::Shutdown();
     VulkanRenderer::WaitDeviceIdle();
+    AssetManager::Shutdown();
     VulkanRenderer::Shutdown();
     AudioEngine::Shutdown();
     Physics::ShutdownPhysics();
 
-    ThreadManager::Get()->WaitAllThreads();
-
     Window::CloseWindow(Window::GetGLFWWindow());
   }
 }
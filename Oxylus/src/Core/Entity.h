@@ -112,6 +112,7 @@ namespace Oxylus {
       auto& [Parent, Children] = GetComponent<RelationshipComponent>();
       Parent = parent.GetUUID();
       parent.GetRelationship().Children.emplace_back(GetUUID());
+      MarkWorldTransformDirty();
 
       return *this;
     }
@@ -132,16 +133,19 @@ namespace Oxylus {
         }
       }
       transform.Parent = 0;
+      MarkWorldTransformDirty();
     }
 
 
+    //Returns the world matrix cached by Scene::UpdateTransforms if neither this entity nor its parents were moved since.
+    //Falls back to walking the parent chain otherwise. Parents missing from the scene are treated as the root.
     glm::mat4 GetWorldTransform() const {
-      const auto& transform = GetTransform();
-      const auto& rc = GetRelationship();
-      const Entity parent = m_Scene->GetEntityByUUID(rc.Parent);
+      if (IsWorldTransformCached())
+        return GetComponent<WorldTransformComponent>().Transform;
+
+      const Entity parent = GetParent();
       const glm::mat4 parentTransform = parent ? parent.GetWorldTransform() : glm::mat4(1.0f);
-      return parentTransform * glm::translate(glm::mat4(1.0f), transform.Translation) *
-             glm::toMat4(glm::quat(transform.Rotation)) * glm::scale(glm::mat4(1.0f), transform.Scale);
+      return parentTransform * GetLocalTransform();
     }
 
     glm::mat4 GetLocalTransform() const {
@@ -173,6 +177,21 @@ namespace Oxylus {
     }
 
   private:
+    //TransformComponent is written directly, so the cache is compared against it up the whole parent chain.
+    bool IsWorldTransformCached() const {
+      for (Entity entity = *this; entity; entity = entity.GetParent()) {
+        const auto* world = m_Scene->m_Registry.try_get<WorldTransformComponent>(entity.m_EntityHandle);
+        if (!world || world->Dirty || !world->Matches(entity.GetTransform()))
+          return false;
+      }
+      return true;
+    }
+
+    void MarkWorldTransformDirty() const {
+      if (auto* world = m_Scene->m_Registry.try_get<WorldTransformComponent>(m_EntityHandle))
+        world->Dirty = true;
+    }
+
     entt::entity m_EntityHandle{entt::null};
     Scene* m_Scene = nullptr;
   };
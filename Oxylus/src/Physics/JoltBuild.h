@@ -1,7 +1,6 @@
 #pragma once
 #include "Jolt/Jolt.h"
 JPH_SUPPRESS_WARNING_PUSH
-#include "Jolt/Core/JobSystemThreadPool.h"
 #include "Jolt/Core/TempAllocator.h"
 #include "Jolt/Physics/PhysicsSystem.h"
 #include "Jolt/Physics/Collision/ObjectLayer.h"
@@ -9,7 +8,6 @@ JPH_SUPPRESS_WARNING_PUSH
 #include <Jolt/RegisterTypes.h>
 #include <Jolt/Core/Factory.h>
 #include <Jolt/Core/TempAllocator.h>
-#include <Jolt/Core/JobSystemThreadPool.h>
 #include <Jolt/Physics/PhysicsSettings.h>
 #include <Jolt/Physics/PhysicsSystem.h>
 #include <Jolt/Physics/Collision/Shape/BoxShape.h>
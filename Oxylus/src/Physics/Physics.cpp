@@ -7,6 +7,7 @@
 namespace Oxylus {
   BPLayerInterfaceImpl Physics::s_LayerInterface;
   JPH::TempAllocatorImpl* Physics::s_TempAllocator = nullptr;
+  PhysicsJobSystem* Physics::s_JobSystem = nullptr;
   ObjectVsBroadPhaseLayerFilterImpl Physics::s_ObjectVsBroadPhaseLayerFilterInterface;
   ObjectLayerPairFilterImpl Physics::s_ObjectLayerPairFilterInterface;
 
@@ -41,6 +42,7 @@ namespace Oxylus {
     JPH::RegisterTypes();
 
     s_TempAllocator = new JPH::TempAllocatorImpl(10 * 1024 * 1024);
+    s_JobSystem = new PhysicsJobSystem(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers);
   }
 
   void Physics::ShutdownPhysics() {
@@ -48,5 +50,7 @@ namespace Oxylus {
     delete JPH::Factory::sInstance;
     JPH::Factory::sInstance = nullptr;
     delete s_TempAllocator;
+    delete s_JobSystem;
+    s_JobSystem = nullptr;
   }
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include "JoltBuild.h"
 #include "PhyiscsInterfaces.h"
+#include "PhysicsJobSystem.h"
 
 namespace Oxylus {
   class Physics {
@@ -12,6 +13,8 @@ namespace Oxylus {
     static ObjectVsBroadPhaseLayerFilterImpl s_ObjectVsBroadPhaseLayerFilterInterface;
     static ObjectLayerPairFilterImpl s_ObjectLayerPairFilterInterface;
     static JPH::TempAllocatorImpl* s_TempAllocator;
+    //Shared by every scene, runs on the engine job system workers.
+    static PhysicsJobSystem* s_JobSystem;
 
     static void InitPhysics();
     static void ShutdownPhysics();
@@ -0,0 +1,53 @@
+#include "src/oxpch.h"
+#include "PhysicsJobSystem.h"
+
+#include "Thread/JobSystem.h"
+#include "Utils/Log.h"
+
+namespace Oxylus {
+  PhysicsJobSystem::PhysicsJobSystem(const uint32_t maxJobs, const uint32_t maxBarriers) : JobSystemWithBarrier(maxBarriers) {
+    m_Jobs.Init(maxJobs, maxJobs);
+  }
+
+  int PhysicsJobSystem::GetMaxConcurrency() const {
+    return (int)Oxylus::JobSystem::GetConcurrency();
+  }
+
+  PhysicsJobSystem::JobHandle PhysicsJobSystem::CreateJob(const char* name,
+                                                          const JPH::ColorArg color,
+                                                          const JobFunction& function,
+                                                          const JPH::uint32 numDependencies) {
+    uint32_t index;
+    while (true) {
+      index = m_Jobs.ConstructObject(name, color, this, function, numDependencies);
+      if (index != AvailableJobs::cInvalidObjectIndex)
+        break;
+      OX_CORE_WARN("Out of physics jobs, waiting for one to finish");
+      std::this_thread::yield();
+    }
+    Job* job = &m_Jobs.Get(index);
+
+    //The handle keeps the job alive, it can finish as soon as it is queued.
+    JobHandle handle(job);
+    if (numDependencies == 0)
+      QueueJob(job);
+    return handle;
+  }
+
+  void PhysicsJobSystem::QueueJob(Job* job) {
+    job->AddRef();
+    Oxylus::JobSystem::Execute([job] {
+      job->Execute();
+      job->Release();
+    });
+  }
+
+  void PhysicsJobSystem::QueueJobs(Job** jobs, const JPH::uint numJobs) {
+    for (JPH::uint i = 0; i < numJobs; i++)
+      QueueJob(jobs[i]);
+  }
+
+  void PhysicsJobSystem::FreeJob(Job* job) {
+    m_Jobs.DestroyObject(job);
+  }
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "JoltBuild.h"
+
+JPH_SUPPRESS_WARNING_PUSH
+#include <Jolt/Core/FixedSizeFreeList.h>
+#include <Jolt/Core/JobSystemWithBarrier.h>
+JPH_SUPPRESS_WARNING_POP
+
+namespace Oxylus {
+  /**
+   * \brief Runs Jolt jobs on the engine job system so physics shares its workers instead of spawning its own pool.
+   */
+  class PhysicsJobSystem final : public JPH::JobSystemWithBarrier {
+  public:
+    PhysicsJobSystem(uint32_t maxJobs, uint32_t maxBarriers);
+    ~PhysicsJobSystem() override = default;
+
+    int GetMaxConcurrency() const override;
+    JobHandle CreateJob(const char* name, JPH::ColorArg color, const JobFunction& function, JPH::uint32 numDependencies = 0) override;
+
+  protected:
+    void QueueJob(Job* job) override;
+    void QueueJobs(Job** jobs, JPH::uint numJobs) override;
+    void FreeJob(Job* job) override;
+
+  private:
+    using AvailableJobs = JPH::FixedSizeFreeList<Job>;
+    AvailableJobs m_Jobs;
+  };
+}
@@ -0,0 +1,61 @@
+#include "src/oxpch.h"
+#include "DrawPacket.h"
+
+#include "Utils/Profiler.h"
+
+namespace Oxylus {
+  uint64_t DrawPacketBuilder::MakeKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t geometry, float depth) {
+    constexpr uint64_t depthMax = (1ull << DEPTH_BITS) - 1;
+    const uint64_t quantizedDepth = (uint64_t)(std::clamp(depth, 0.0f, 1.0f) * (float)depthMax);
+
+    uint64_t key = pass & ((1ull << PASS_BITS) - 1);
+    key = key << PIPELINE_BITS | (pipeline & ((1ull << PIPELINE_BITS) - 1));
+    key = key << MATERIAL_BITS | (material & ((1ull << MATERIAL_BITS) - 1));
+    key = key << GEOMETRY_BITS | (geometry & ((1ull << GEOMETRY_BITS) - 1));
+    key = key << DEPTH_BITS | quantizedDepth;
+    return key;
+  }
+
+  void DrawPacketBuilder::Begin(size_t count) {
+    m_Packets.clear();
+    m_Packets.reserve(count);
+  }
+
+  void DrawPacketBuilder::Add(uint64_t key, uint32_t index) {
+    m_Packets.emplace_back(DrawPacket{key, index});
+  }
+
+  void DrawPacketBuilder::Sort() {
+    ZoneScoped;
+    //LSD radix sort, 8 bits per pass.
+    m_Scratch.resize(m_Packets.size());
+    for (uint32_t shift = 0; shift < 64; shift += 8) {
+      uint32_t counts[256] = {};
+      for (const auto& packet : m_Packets)
+        counts[(packet.Key >> shift) & 0xFF]++;
+
+      //Every key has the same digit, nothing to reorder.
+      if (counts[(m_Packets.empty() ? 0 : m_Packets[0].Key >> shift) & 0xFF] == m_Packets.size())
+        continue;
+
+      uint32_t offset = 0;
+      for (auto& count : counts) {
+        const uint32_t c = count;
+        count = offset;
+        offset += c;
+      }
+      for (const auto& packet : m_Packets)
+        m_Scratch[counts[(packet.Key >> shift) & 0xFF]++] = packet;
+      std::swap(m_Packets, m_Scratch);
+    }
+  }
+
+  uint32_t DrawPacketBuilder::GetID(const void* ptr) {
+    //64-bit finalizer from MurmurHash3, spreads the address bits over the lower bits that end up in the key.
+    uint64_t value = (uint64_t)(uintptr_t)ptr;
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdull;
+    value ^= value >> 33;
+    return (uint32_t)value;
+  }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace Oxylus {
+  /**
+   * \brief Sort key layout from the most to the least significant bits:
+   * pass (4) | pipeline (6) | material (16) | geometry (16) | depth (22).
+   * Geometry identifies a mesh primitive so that copies of it end up next to each other and can be instanced.
+   * Sorting by it groups draws that share state so redundant binds can be skipped.
+   */
+  struct DrawPacket {
+    uint64_t Key = 0;
+    uint32_t Index = 0;
+  };
+
+  //Counters are atomic since passes can be recorded from several threads at once.
+  struct DrawStats {
+    //Draw calls recorded, an indirect call counts once.
+    std::atomic<uint32_t> DrawCalls = 0;
+    //Draw commands executed, directly or through indirect calls.
+    std::atomic<uint32_t> DrawCommands = 0;
+    //Primitive instances drawn by those commands.
+    std::atomic<uint32_t> Instances = 0;
+    std::atomic<uint32_t> PipelineBinds = 0;
+    std::atomic<uint32_t> VertexBufferBinds = 0;
+    std::atomic<uint32_t> DescriptorSetBinds = 0;
+
+    //Binds skipped compared to binding everything for every primitive instance.
+    uint32_t SkippedPipelineBinds() const { return Skipped(PipelineBinds); }
+    uint32_t SkippedVertexBufferBinds() const { return Skipped(VertexBufferBinds); }
+    uint32_t SkippedDescriptorSetBinds() const { return Skipped(DescriptorSetBinds); }
+
+    void Reset() {
+      for (auto* counter : {&DrawCalls, &DrawCommands, &Instances, &PipelineBinds, &VertexBufferBinds, &DescriptorSetBinds})
+        counter->store(0, std::memory_order_relaxed);
+    }
+
+  private:
+    uint32_t Skipped(const std::atomic<uint32_t>& binds) const {
+      const uint32_t instances = Instances.load(std::memory_order_relaxed);
+      return instances - std::min(instances, binds.load(std::memory_order_relaxed));
+    }
+  };
+
+  class DrawPacketBuilder {
+  public:
+    static constexpr uint32_t PASS_BITS = 4;
+    static constexpr uint32_t PIPELINE_BITS = 6;
+    static constexpr uint32_t MATERIAL_BITS = 16;
+    static constexpr uint32_t GEOMETRY_BITS = 16;
+    static constexpr uint32_t DEPTH_BITS = 22;
+
+    //depth is expected to be normalized to [0, 1].
+    static uint64_t MakeKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t geometry, float depth);
+
+    void Begin(size_t count);
+    void Add(uint64_t key, uint32_t index);
+    void Sort();
+
+    /**
+     * \brief Key id for an object, derived from its address so keys can be generated from any thread.
+     * Colliding ids only interleave draws within the same key range, emission still compares the actual objects.
+     */
+    static uint32_t GetID(const void* ptr);
+
+    const std::vector<DrawPacket>& GetPackets() const { return m_Packets; }
+
+  private:
+    std::vector<DrawPacket> m_Packets;
+    std::vector<DrawPacket> m_Scratch;
+  };
+}
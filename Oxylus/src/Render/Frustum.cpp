@@ -0,0 +1,56 @@
+#include "src/oxpch.h"
+#include "Frustum.h"
+
+namespace Oxylus {
+  void AABB::Merge(const AABB& other) {
+    Min = glm::min(Min, other.Min);
+    Max = glm::max(Max, other.Max);
+  }
+
+  AABB AABB::Transform(const Mat4& transform) const {
+    // Transform the center and project the extents onto the new axes (Arvo's method).
+    const Vec3 center = Vec3(transform * Vec4(GetCenter(), 1.0f));
+    const Vec3 extents = GetExtents();
+    const Vec3 newExtents = Vec3(
+      glm::abs(transform[0][0]) * extents.x + glm::abs(transform[1][0]) * extents.y + glm::abs(transform[2][0]) * extents.z,
+      glm::abs(transform[0][1]) * extents.x + glm::abs(transform[1][1]) * extents.y + glm::abs(transform[2][1]) * extents.z,
+      glm::abs(transform[0][2]) * extents.x + glm::abs(transform[1][2]) * extents.y + glm::abs(transform[2][2]) * extents.z);
+
+    return {center - newExtents, center + newExtents};
+  }
+
+  Frustum Frustum::FromMatrix(const Mat4& viewProjection) {
+    const Mat4 m = glm::transpose(viewProjection);
+
+    Frustum frustum;
+    frustum.Planes[Left] = m[3] + m[0];
+    frustum.Planes[Right] = m[3] - m[0];
+    frustum.Planes[Bottom] = m[3] + m[1];
+    frustum.Planes[Top] = m[3] - m[1];
+    frustum.Planes[Near] = m[3] + m[2];
+    frustum.Planes[Far] = m[3] - m[2];
+
+    for (auto& plane : frustum.Planes) {
+      plane /= glm::length(Vec3(plane));
+    }
+
+    return frustum;
+  }
+
+  bool Frustum::IsVisible(const AABB& aabb, const uint32_t planeMask) const {
+    const Vec3 center = aabb.GetCenter();
+    const Vec3 extents = aabb.GetExtents();
+
+    for (uint32_t side = 0; side < 6; side++) {
+      if (!(planeMask & (1u << side)))
+        continue;
+      const Vec4& plane = Planes[side];
+      const Vec3 normal = Vec3(plane);
+      const float radius = glm::dot(extents, glm::abs(normal));
+      if (glm::dot(normal, center) + plane.w < -radius)
+        return false;
+    }
+
+    return true;
+  }
+}
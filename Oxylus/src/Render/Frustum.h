@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cfloat>
+
+#include "Core/Types.h"
+
+namespace Oxylus {
+  struct AABB {
+    Vec3 Min = Vec3(FLT_MAX);
+    Vec3 Max = Vec3(-FLT_MAX);
+
+    AABB() = default;
+
+    AABB(const Vec3& min, const Vec3& max) : Min(min), Max(max) { }
+
+    Vec3 GetCenter() const { return (Min + Max) * 0.5f; }
+    Vec3 GetExtents() const { return (Max - Min) * 0.5f; }
+
+    void Merge(const AABB& other);
+    AABB Transform(const Mat4& transform) const;
+  };
+
+  struct Frustum {
+    enum Side { Left = 0, Right, Bottom, Top, Near, Far };
+
+    static constexpr uint32_t ALL_PLANES = (1u << 6) - 1;
+    //Shadow casters in front of the near plane are clamped onto it by depth clamp, so they are still visible.
+    static constexpr uint32_t SHADOW_CASTER_PLANES = ALL_PLANES & ~(1u << Near);
+
+    //xyz: normal pointing inside the frustum, w: distance
+    Vec4 Planes[6] = {};
+
+    Frustum() = default;
+
+    /**
+     * \brief Extracts the planes from a view-projection matrix. The near plane is taken for a [-1, 1] depth range
+     * which keeps the test conservative for [0, 1] projections too.
+     */
+    static Frustum FromMatrix(const Mat4& viewProjection);
+
+    bool IsVisible(const AABB& aabb) const { return IsVisible(aabb, ALL_PLANES); }
+    //Only tests against the planes whose Side bit is set in planeMask.
+    bool IsVisible(const AABB& aabb, uint32_t planeMask) const;
+  };
+}
@@ -0,0 +1,225 @@
+#include "src/oxpch.h"
+#include "GeometryPool.h"
+
+#include "Utils/Log.h"
+#include "Utils/Profiler.h"
+#include "Vulkan/VulkanRenderer.h"
+
+namespace Oxylus {
+  GeometryPool::PoolData GeometryPool::s_Data;
+
+  static constexpr uint32_t INITIAL_VERTEX_CAPACITY = 256 * 1024;
+  static constexpr uint32_t INITIAL_INDEX_CAPACITY = 1024 * 1024;
+  static constexpr uint32_t INDEX_SIZE = sizeof(uint32_t);
+
+  static constexpr vk::BufferUsageFlags VERTEX_USAGE = vk::BufferUsageFlagBits::eVertexBuffer |
+                                                       vk::BufferUsageFlagBits::eTransferDst |
+                                                       vk::BufferUsageFlagBits::eTransferSrc;
+  static constexpr vk::BufferUsageFlags INDEX_USAGE = vk::BufferUsageFlagBits::eIndexBuffer |
+                                                      vk::BufferUsageFlagBits::eTransferDst |
+                                                      vk::BufferUsageFlagBits::eTransferSrc;
+
+  void GeometryPool::RangeAllocator::Init(const uint32_t capacity) {
+    m_Capacity = capacity;
+    m_FreeRanges.clear();
+    m_FreeRanges.emplace_back(Range{0, capacity});
+  }
+
+  bool GeometryPool::RangeAllocator::Allocate(const uint32_t count, uint32_t& offset) {
+    for (auto it = m_FreeRanges.begin(); it != m_FreeRanges.end(); ++it) {
+      if (it->Count < count)
+        continue;
+      offset = it->Offset;
+      it->Offset += count;
+      it->Count -= count;
+      if (it->Count == 0)
+        m_FreeRanges.erase(it);
+      return true;
+    }
+    return false;
+  }
+
+  void GeometryPool::RangeAllocator::Free(const uint32_t offset, const uint32_t count) {
+    auto it = std::lower_bound(m_FreeRanges.begin(),
+      m_FreeRanges.end(),
+      offset,
+      [](const Range& range, const uint32_t value) { return range.Offset < value; });
+    it = m_FreeRanges.insert(it, Range{offset, count});
+
+    //Merge with the next and previous ranges.
+    if (it + 1 != m_FreeRanges.end() && it->Offset + it->Count == (it + 1)->Offset) {
+      it->Count += (it + 1)->Count;
+      m_FreeRanges.erase(it + 1);
+    }
+    if (it != m_FreeRanges.begin() && (it - 1)->Offset + (it - 1)->Count == it->Offset) {
+      (it - 1)->Count += it->Count;
+      m_FreeRanges.erase(it);
+    }
+  }
+
+  void GeometryPool::RangeAllocator::Grow(const uint32_t newCapacity) {
+    if (newCapacity <= m_Capacity)
+      return;
+    const uint32_t oldCapacity = m_Capacity;
+    m_Capacity = newCapacity;
+    Free(oldCapacity, newCapacity - oldCapacity);
+  }
+
+  void GeometryPool::Init() {
+    if (s_Data.Initialized)
+      return;
+    s_Data.Vertices.Init(INITIAL_VERTEX_CAPACITY);
+    s_Data.Indices.Init(INITIAL_INDEX_CAPACITY);
+    CreateStreamBuffer(VertexFormat::Base);
+    CreateBuffer(s_Data.IndexBuffer, INDEX_USAGE, (vk::DeviceSize)INITIAL_INDEX_CAPACITY * INDEX_SIZE);
+    s_Data.Initialized = true;
+  }
+
+  void GeometryPool::Shutdown() {
+    if (!s_Data.Initialized)
+      return;
+    for (auto& buffer : s_Data.VertexBuffers) {
+      if (buffer.Get())
+        buffer.Destroy();
+      buffer = {};
+    }
+    s_Data.IndexBuffer.Destroy();
+    s_Data.ReleasedRanges.clear();
+    s_Data.Initialized = false;
+  }
+
+  void GeometryPool::BeginFrame() {
+    s_Data.FrameCount++;
+    //Freed while recording a frame, free once that frame came around again and the upload can't write to the ranges anymore.
+    std::erase_if(s_Data.ReleasedRanges,
+      [](const ReleasedRange& range) {
+        if (range.Frame + MAX_FRAMES_IN_FLIGHT > s_Data.FrameCount || !range.Upload.IsDone())
+          return false;
+        s_Data.Vertices.Free(range.FirstVertex, range.VertexCount);
+        s_Data.Indices.Free(range.FirstIndex, range.IndexCount);
+        return true;
+      });
+  }
+
+  GeometryPool::Allocation GeometryPool::Allocate(const void* const (&streamData)[VertexFormat::STREAM_COUNT],
+                                                  const uint32_t vertexCount,
+                                                  const uint32_t* indexData,
+                                                  const uint32_t indexCount) {
+    ZoneScoped;
+    Init();
+
+    Allocation allocation;
+    if (!vertexCount || !indexCount || !streamData[VertexFormat::Base])
+      return allocation;
+
+    if (!s_Data.Vertices.Allocate(vertexCount, allocation.FirstVertex)) {
+      GrowVertexBuffers(vertexCount);
+      s_Data.Vertices.Allocate(vertexCount, allocation.FirstVertex);
+    }
+    if (!s_Data.Indices.Allocate(indexCount, allocation.FirstIndex)) {
+      GrowIndexBuffer(indexCount);
+      s_Data.Indices.Allocate(indexCount, allocation.FirstIndex);
+    }
+    allocation.VertexCount = vertexCount;
+    allocation.IndexCount = indexCount;
+
+    for (uint32_t stream = 0; stream < VertexFormat::STREAM_COUNT; stream++) {
+      if (!streamData[stream])
+        continue;
+      auto& buffer = s_Data.VertexBuffers[stream];
+      if (!buffer.Get())
+        CreateStreamBuffer((VertexFormat::Stream)stream);
+      const uint32_t stride = VertexFormat::STREAM_STRIDES[stream];
+      VulkanUploader::UploadBuffer(buffer, streamData[stream], (vk::DeviceSize)vertexCount * stride, (vk::DeviceSize)allocation.FirstVertex * stride);
+      allocation.Streams |= 1u << stream;
+    }
+    //Tickets are ordered, the later one covers both uploads.
+    allocation.Upload = VulkanUploader::UploadBuffer(s_Data.IndexBuffer, indexData, (vk::DeviceSize)indexCount * INDEX_SIZE, (vk::DeviceSize)allocation.FirstIndex * INDEX_SIZE);
+
+    return allocation;
+  }
+
+  void GeometryPool::Free(Allocation& allocation) {
+    if (!s_Data.Initialized || !allocation.IsValid())
+      return;
+    s_Data.ReleasedRanges.emplace_back(ReleasedRange{
+      allocation.FirstVertex, allocation.VertexCount, allocation.FirstIndex, allocation.IndexCount, s_Data.FrameCount, allocation.Upload
+    });
+    allocation = {};
+  }
+
+  void GeometryPool::Bind(const vk::CommandBuffer& commandBuffer, const uint32_t streams) {
+    constexpr vk::DeviceSize offsets[1] = {0};
+    for (uint32_t stream = 0; stream < VertexFormat::STREAM_COUNT; stream++) {
+      if (!(streams & (1u << stream)))
+        continue;
+      //Pipelines may read a stream no mesh had yet, the binding has to be valid anyway.
+      if (!s_Data.VertexBuffers[stream].Get())
+        CreateStreamBuffer((VertexFormat::Stream)stream);
+      commandBuffer.bindVertexBuffers(VertexFormat::STREAM_BINDINGS[stream], s_Data.VertexBuffers[stream].Get(), offsets);
+    }
+    commandBuffer.bindIndexBuffer(s_Data.IndexBuffer.Get(), 0, vk::IndexType::eUint32);
+  }
+
+  void GeometryPool::CreateBuffer(VulkanBuffer& buffer, const vk::BufferUsageFlags usage, const vk::DeviceSize size) {
+    buffer.CreateBuffer(usage, vk::MemoryPropertyFlagBits::eDeviceLocal, size, nullptr, VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
+  }
+
+  void GeometryPool::CreateStreamBuffer(const VertexFormat::Stream stream) {
+    const vk::DeviceSize size = (vk::DeviceSize)s_Data.Vertices.GetCapacity() * VertexFormat::STREAM_STRIDES[stream];
+    CreateBuffer(s_Data.VertexBuffers[stream], VERTEX_USAGE, size);
+  }
+
+  uint32_t GeometryPool::GetGrownCapacity(const RangeAllocator& allocator, const uint32_t requiredCount) {
+    const uint32_t oldCapacity = allocator.GetCapacity();
+    return std::max(oldCapacity * 2, oldCapacity + requiredCount);
+  }
+
+  void GeometryPool::GrowVertexBuffers(const uint32_t requiredCount) {
+    ZoneScoped;
+    const uint32_t oldCapacity = s_Data.Vertices.GetCapacity();
+    const uint32_t newCapacity = GetGrownCapacity(s_Data.Vertices, requiredCount);
+    OX_CORE_TRACE("Growing geometry pool vertex buffers from {} to {} vertices", oldCapacity, newCapacity);
+
+    //The old buffers might still be in use by frames in flight or uploads.
+    VulkanRenderer::WaitDeviceIdle();
+    VulkanUploader::WaitIdle();
+
+    for (uint32_t stream = 0; stream < VertexFormat::STREAM_COUNT; stream++) {
+      auto& buffer = s_Data.VertexBuffers[stream];
+      if (!buffer.Get())
+        continue;
+      const uint32_t stride = VertexFormat::STREAM_STRIDES[stream];
+      ResizeBuffer(buffer, VERTEX_USAGE, (vk::DeviceSize)oldCapacity * stride, (vk::DeviceSize)newCapacity * stride);
+    }
+    s_Data.Vertices.Grow(newCapacity);
+  }
+
+  void GeometryPool::GrowIndexBuffer(const uint32_t requiredCount) {
+    ZoneScoped;
+    const uint32_t oldCapacity = s_Data.Indices.GetCapacity();
+    const uint32_t newCapacity = GetGrownCapacity(s_Data.Indices, requiredCount);
+    OX_CORE_TRACE("Growing geometry pool index buffer from {} to {} indices", oldCapacity, newCapacity);
+
+    VulkanRenderer::WaitDeviceIdle();
+    VulkanUploader::WaitIdle();
+
+    ResizeBuffer(s_Data.IndexBuffer, INDEX_USAGE, (vk::DeviceSize)oldCapacity * INDEX_SIZE, (vk::DeviceSize)newCapacity * INDEX_SIZE);
+    s_Data.Indices.Grow(newCapacity);
+  }
+
+  void GeometryPool::ResizeBuffer(VulkanBuffer& buffer,
+                                  const vk::BufferUsageFlags usage,
+                                  const vk::DeviceSize oldSize,
+                                  const vk::DeviceSize newSize) {
+    VulkanBuffer newBuffer;
+    CreateBuffer(newBuffer, usage, newSize);
+    VulkanRenderer::SubmitOnce([&](const VulkanCommandBuffer& copyCmd) {
+      vk::BufferCopy copyRegion{};
+      copyRegion.size = oldSize;
+      buffer.CopyTo(newBuffer.Get(), copyCmd.Get(), copyRegion);
+    });
+    buffer.Destroy();
+    buffer = newBuffer;
+  }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "Render/VertexFormat.h"
+#include "Render/Vulkan/VulkanBuffer.h"
+#include "Render/Vulkan/VulkanUploader.h"
+
+namespace Oxylus {
+  /**
+   * \brief Shared vertex and index buffers that all meshes sub-allocate from,
+   * so every mesh draw can use the same bindings.
+   * Each vertex stream has its own buffer over the same vertex ranges. Optional streams are only created once a mesh
+   * has them, vertices of meshes without a stream are undefined in its buffer.
+   */
+  class GeometryPool {
+  public:
+    struct Allocation {
+      uint32_t FirstVertex = 0;
+      uint32_t VertexCount = 0;
+      uint32_t FirstIndex = 0;
+      uint32_t IndexCount = 0;
+      //VertexFormat::StreamFlags the vertices were uploaded with.
+      uint32_t Streams = 0;
+      //Vertices and indices stream in through the transfer queue, draws skip the allocation until they arrived.
+      UploadTicket Upload;
+
+      bool IsValid() const { return VertexCount > 0 && IndexCount > 0; }
+      bool IsResident() const { return IsValid() && Upload.IsAvailable(); }
+    };
+
+    static void Init();
+    static void Shutdown();
+    //Returns ranges freed earlier to the allocators once no frame in flight or upload uses them anymore.
+    static void BeginFrame();
+
+    //Queues the upload and returns where the data will be placed. Indices are relative to the first vertex of the allocation.
+    //Streams are indexed by VertexFormat::Stream, the base one is required and missing optional ones are null.
+    static Allocation Allocate(const void* const (&streamData)[VertexFormat::STREAM_COUNT],
+                               uint32_t vertexCount,
+                               const uint32_t* indexData,
+                               uint32_t indexCount);
+    //The ranges are only reused once the frames recorded until now and the upload of the allocation finished.
+    static void Free(Allocation& allocation);
+
+    //Binds the buffers of the streams in VertexFormat::StreamFlags at their bindings and the index buffer.
+    static void Bind(const vk::CommandBuffer& commandBuffer, uint32_t streams = VertexFormat::BaseStream);
+
+    static const VulkanBuffer& GetVertexBuffer(const VertexFormat::Stream stream = VertexFormat::Base) { return s_Data.VertexBuffers[stream]; }
+    static const VulkanBuffer& GetIndexBuffer() { return s_Data.IndexBuffer; }
+
+  private:
+    //First fit allocator over element ranges.
+    class RangeAllocator {
+    public:
+      void Init(uint32_t capacity);
+      bool Allocate(uint32_t count, uint32_t& offset);
+      void Free(uint32_t offset, uint32_t count);
+      void Grow(uint32_t newCapacity);
+      uint32_t GetCapacity() const { return m_Capacity; }
+
+    private:
+      struct Range {
+        uint32_t Offset = 0;
+        uint32_t Count = 0;
+      };
+
+      //Sorted by offset, adjacent ranges are merged.
+      std::vector<Range> m_FreeRanges;
+      uint32_t m_Capacity = 0;
+    };
+
+    struct ReleasedRange {
+      uint32_t FirstVertex = 0;
+      uint32_t VertexCount = 0;
+      uint32_t FirstIndex = 0;
+      uint32_t IndexCount = 0;
+      uint64_t Frame = 0;
+      UploadTicket Upload;
+    };
+
+    static struct PoolData {
+      VulkanBuffer VertexBuffers[VertexFormat::STREAM_COUNT];
+      VulkanBuffer IndexBuffer;
+      RangeAllocator Vertices;
+      RangeAllocator Indices;
+      std::vector<ReleasedRange> ReleasedRanges;
+      uint64_t FrameCount = 0;
+      bool Initialized = false;
+    } s_Data;
+
+    static void CreateBuffer(VulkanBuffer& buffer, vk::BufferUsageFlags usage, vk::DeviceSize size);
+    //Creates the buffer of an optional stream over the current vertex capacity.
+    static void CreateStreamBuffer(VertexFormat::Stream stream);
+    static void GrowVertexBuffers(uint32_t requiredCount);
+    static void GrowIndexBuffer(uint32_t requiredCount);
+    //Has to wait for the device to be idle first.
+    static void ResizeBuffer(VulkanBuffer& buffer, vk::BufferUsageFlags usage, vk::DeviceSize oldSize, vk::DeviceSize newSize);
+    static uint32_t GetGrownCapacity(const RangeAllocator& allocator, uint32_t requiredCount);
+  };
+}
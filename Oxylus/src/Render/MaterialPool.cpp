@@ -0,0 +1,226 @@
+#include "src/oxpch.h"
+#include "MaterialPool.h"
+
+#include "Assets/Material.h"
+#include "Core/Resources.h"
+#include "Utils/Log.h"
+#include "Utils/Profiler.h"
+#include "Utils/VulkanUtils.h"
+#include "Vulkan/VulkanContext.h"
+#include "Vulkan/VulkanPipeline.h"
+
+namespace Oxylus {
+  MaterialPool::PoolData MaterialPool::s_Data;
+
+  //Mirrors MaterialData in Material.glsl with std430 layout.
+  struct GPUMaterial {
+    decltype(Material::Parameters) Parameters;
+    std::array<uint32_t, MaterialPool::TEXTURES_PER_MATERIAL> TextureIndices = {};
+    uint32_t Padding[3] = {};
+  };
+
+  static_assert(sizeof(GPUMaterial) == 128, "GPUMaterial has to match MaterialData in Material.glsl");
+
+  MaterialPool::Handle::Handle(Handle&& other) noexcept : Index(other.Index), TextureSlots(other.TextureSlots) {
+    other.Index = INVALID_INDEX;
+    other.TextureSlots.fill(INVALID_INDEX);
+  }
+
+  MaterialPool::Handle& MaterialPool::Handle::operator=(Handle&& other) noexcept {
+    if (this == &other)
+      return *this;
+    Release();
+    Index = other.Index;
+    TextureSlots = other.TextureSlots;
+    other.Index = INVALID_INDEX;
+    other.TextureSlots.fill(INVALID_INDEX);
+    return *this;
+  }
+
+  void MaterialPool::Handle::Release() {
+    for (auto& slot : TextureSlots) {
+      ReleaseTexture(slot);
+      slot = INVALID_INDEX;
+    }
+    if (IsValid())
+      ReleaseMaterial(Index);
+    Index = INVALID_INDEX;
+  }
+
+  void MaterialPool::Init(const VulkanPipeline& pipeline, const uint32_t layoutIndex) {
+    ZoneScoped;
+    if (s_Data.Initialized)
+      return;
+    const auto& LogicalDevice = VulkanContext::GetDevice();
+    s_Data.TextureCapacity = GetTextureCapacity();
+
+    const vk::DescriptorPoolSize poolSizes[] = {
+      {vk::DescriptorType::eStorageBuffer, MAX_FRAMES_IN_FLIGHT},
+      {vk::DescriptorType::eCombinedImageSampler, s_Data.TextureCapacity * MAX_FRAMES_IN_FLIGHT},
+    };
+    vk::DescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind;
+    poolInfo.maxSets = MAX_FRAMES_IN_FLIGHT;
+    poolInfo.poolSizeCount = (uint32_t)std::size(poolSizes);
+    poolInfo.pPoolSizes = poolSizes;
+    VulkanUtils::CheckResult(LogicalDevice.createDescriptorPool(&poolInfo, nullptr, &s_Data.DescriptorPool));
+
+    for (uint32_t frame = 0; frame < MAX_FRAMES_IN_FLIGHT; frame++) {
+      auto& buffer = s_Data.MaterialBuffers[frame];
+      buffer.CreateBuffer(vk::BufferUsageFlagBits::eStorageBuffer,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+        (vk::DeviceSize)MAX_MATERIALS * sizeof(GPUMaterial),
+        nullptr,
+        VMA_MEMORY_USAGE_AUTO_PREFER_HOST).Map();
+
+      auto& set = s_Data.DescriptorSets[frame];
+      set.Allocate(pipeline.GetDescriptorSetLayout(), layoutIndex, s_Data.DescriptorPool);
+      const vk::DescriptorBufferInfo bufferInfo{buffer.Get(), 0, VK_WHOLE_SIZE};
+      LogicalDevice.updateDescriptorSets(vk::WriteDescriptorSet{set.Get(), 0, 0, 1, vk::DescriptorType::eStorageBuffer, nullptr, &bufferInfo}, nullptr);
+    }
+
+    //Handed out from the back, lowest first. The first material is the default one.
+    s_Data.FreeMaterials.clear();
+    for (uint32_t i = MAX_MATERIALS - 1; i > DEFAULT_MATERIAL; i--)
+      s_Data.FreeMaterials.emplace_back(i);
+    s_Data.TextureSlots.assign(s_Data.TextureCapacity, {});
+    s_Data.FreeTextureSlots.clear();
+    for (uint32_t i = s_Data.TextureCapacity; i > 0; i--)
+      s_Data.FreeTextureSlots.emplace_back(i - 1);
+    s_Data.Initialized = true;
+
+    s_Data.DefaultTextureSlot = AcquireTexture(Resources::s_EngineResources.EmptyTexture);
+    GPUMaterial defaultMaterial;
+    defaultMaterial.TextureIndices.fill(s_Data.DefaultTextureSlot);
+    for (auto& buffer : s_Data.MaterialBuffers)
+      buffer.Copy(&defaultMaterial, sizeof defaultMaterial, (vk::DeviceSize)DEFAULT_MATERIAL * sizeof(GPUMaterial));
+  }
+
+  void MaterialPool::Shutdown() {
+    if (!s_Data.Initialized)
+      return;
+    for (auto& buffer : s_Data.MaterialBuffers)
+      buffer.Destroy();
+    VulkanContext::GetDevice().destroyDescriptorPool(s_Data.DescriptorPool);
+    s_Data.TextureLookup.clear();
+    s_Data.ReleasedMaterials.clear();
+    s_Data.ReleasedTextureSlots.clear();
+    s_Data.Initialized = false;
+  }
+
+  uint32_t MaterialPool::GetTextureCapacity() {
+    const auto& limits = VulkanContext::Context.DeviceProperties12;
+    const uint32_t perStage = limits.maxPerStageDescriptorUpdateAfterBindSamplers > RESERVED_SAMPLERS
+                                ? limits.maxPerStageDescriptorUpdateAfterBindSamplers - RESERVED_SAMPLERS
+                                : 0;
+    const uint32_t capacity = std::min({MAX_TEXTURES, perStage, limits.maxDescriptorSetUpdateAfterBindSampledImages});
+    if (capacity == 0) {
+      OX_CORE_FATAL("Device update after bind sampler limits ({} per stage, {} per set) are too low for bindless materials",
+        limits.maxPerStageDescriptorUpdateAfterBindSamplers,
+        limits.maxDescriptorSetUpdateAfterBindSampledImages);
+      std::abort();
+    }
+    return capacity;
+  }
+
+  void MaterialPool::BeginFrame() {
+    s_Data.FrameCount++;
+    //Released while recording a frame, free once that frame came around again.
+    const auto recycle = [](std::vector<ReleasedIndex>& released, std::vector<uint32_t>& freeList) {
+      std::erase_if(released,
+        [&freeList](const ReleasedIndex& entry) {
+          if (entry.Frame + MAX_FRAMES_IN_FLIGHT > s_Data.FrameCount)
+            return false;
+          freeList.emplace_back(entry.Index);
+          return true;
+        });
+    };
+    recycle(s_Data.ReleasedMaterials, s_Data.FreeMaterials);
+    recycle(s_Data.ReleasedTextureSlots, s_Data.FreeTextureSlots);
+  }
+
+  void MaterialPool::Register(Material& material) {
+    ZoneScoped;
+    if (!s_Data.Initialized)
+      return;
+
+    auto& handle = material.m_PoolHandle;
+    if (!handle.IsValid()) {
+      if (s_Data.FreeMaterials.empty()) {
+        OX_CORE_ERROR("Material pool ran out of its {} materials", MAX_MATERIALS);
+        return;
+      }
+      handle.Index = s_Data.FreeMaterials.back();
+      s_Data.FreeMaterials.pop_back();
+    }
+
+    const VulkanImage* textures[TEXTURES_PER_MATERIAL] = {
+      material.AlbedoTexture.get(), material.NormalTexture.get(), material.AOTexture.get(),
+      material.MetallicTexture.get(), material.RoughnessTexture.get(),
+    };
+    //Acquired before releasing the old slots so textures the material keeps stay in theirs.
+    std::array<uint32_t, TEXTURES_PER_MATERIAL> slots;
+    for (uint32_t i = 0; i < TEXTURES_PER_MATERIAL; i++)
+      slots[i] = textures[i] ? AcquireTexture(*textures[i]) : INVALID_INDEX;
+    for (const uint32_t slot : handle.TextureSlots)
+      ReleaseTexture(slot);
+    handle.TextureSlots = slots;
+  }
+
+  uint32_t MaterialPool::Write(const Material& material) {
+    const auto& handle = material.m_PoolHandle;
+    if (!s_Data.Initialized || !handle.IsValid())
+      return DEFAULT_MATERIAL;
+
+    GPUMaterial data;
+    data.Parameters = material.Parameters;
+    for (uint32_t i = 0; i < TEXTURES_PER_MATERIAL; i++)
+      data.TextureIndices[i] = handle.TextureSlots[i] != INVALID_INDEX ? handle.TextureSlots[i] : s_Data.DefaultTextureSlot;
+    s_Data.MaterialBuffers.Current().Copy(&data, sizeof data, (vk::DeviceSize)handle.Index * sizeof(GPUMaterial));
+    return handle.Index;
+  }
+
+  uint32_t MaterialPool::AcquireTexture(const VulkanImage& image) {
+    const vk::DescriptorImageInfo& imageInfo = image.GetDescImageInfo();
+    if (!imageInfo.imageView)
+      return INVALID_INDEX;
+
+    if (const auto it = s_Data.TextureLookup.find(imageInfo.imageView); it != s_Data.TextureLookup.end()) {
+      s_Data.TextureSlots[it->second].RefCount++;
+      return it->second;
+    }
+
+    if (s_Data.FreeTextureSlots.empty()) {
+      OX_CORE_ERROR("Material pool ran out of its {} texture slots", s_Data.TextureCapacity);
+      return INVALID_INDEX;
+    }
+    const uint32_t slot = s_Data.FreeTextureSlots.back();
+    s_Data.FreeTextureSlots.pop_back();
+    s_Data.TextureSlots[slot] = TextureSlot{1, imageInfo.imageView};
+    s_Data.TextureLookup.emplace(imageInfo.imageView, slot);
+
+    //No pending frame uses the slot since it was released, so it can be written while the sets are bound.
+    std::array<vk::WriteDescriptorSet, MAX_FRAMES_IN_FLIGHT> writes;
+    for (uint32_t frame = 0; frame < MAX_FRAMES_IN_FLIGHT; frame++)
+      writes[frame] = vk::WriteDescriptorSet{s_Data.DescriptorSets[frame].Get(), 1, slot, 1, vk::DescriptorType::eCombinedImageSampler, &imageInfo};
+    VulkanContext::GetDevice().updateDescriptorSets(writes, nullptr);
+    return slot;
+  }
+
+  void MaterialPool::ReleaseTexture(const uint32_t slot) {
+    if (!s_Data.Initialized || slot == INVALID_INDEX)
+      return;
+    auto& texture = s_Data.TextureSlots[slot];
+    if (--texture.RefCount > 0)
+      return;
+    s_Data.TextureLookup.erase(texture.View);
+    texture.View = nullptr;
+    s_Data.ReleasedTextureSlots.emplace_back(ReleasedIndex{slot, s_Data.FrameCount});
+  }
+
+  void MaterialPool::ReleaseMaterial(const uint32_t index) {
+    if (!s_Data.Initialized)
+      return;
+    s_Data.ReleasedMaterials.emplace_back(ReleasedIndex{index, s_Data.FrameCount});
+  }
+}
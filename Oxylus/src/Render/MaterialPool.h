@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "Render/Vulkan/PerFrame.h"
+#include "Render/Vulkan/VulkanBuffer.h"
+#include "Render/Vulkan/VulkanDescriptorSet.h"
+
+namespace Oxylus {
+  class Material;
+  class VulkanImage;
+  class VulkanPipeline;
+
+  /**
+   * \brief Bindless material data shared by every mesh draw.
+   * Materials are records in a storage buffer and their textures are slots in one large texture array,
+   * draws pick their material with an index from the instance buffer so material changes need no binds.
+   * Texture slots are written with update after bind and only reused once frames in flight are done with them.
+   * Not thread safe, materials are registered from the main thread.
+   */
+  class MaterialPool {
+  public:
+    static constexpr uint32_t MAX_MATERIALS = 16384;
+    //Upper bound of texture slots, devices with lower descriptor limits get fewer. See GetTextureCapacity.
+    static constexpr uint32_t MAX_TEXTURES = 16384;
+    //Samplers the other sets of mesh pipelines use, kept free of the per stage limit.
+    static constexpr uint32_t RESERVED_SAMPLERS = 16;
+    static constexpr uint32_t INVALID_INDEX = ~0u;
+    //Albedo, normal, AO, metallic and roughness, in the order of MaterialData in Material.glsl.
+    static constexpr uint32_t TEXTURES_PER_MATERIAL = 5;
+    //Drawn for materials that weren't registered yet.
+    static constexpr uint32_t DEFAULT_MATERIAL = 0;
+
+    /**
+     * \brief Material index and texture slots a material holds. Released on destruction,
+     * not copyable since the slots belong to one material. Material copies register their own.
+     */
+    class Handle {
+    public:
+      Handle() = default;
+      Handle(const Handle&) = delete;
+      Handle(Handle&& other) noexcept;
+      Handle& operator=(const Handle&) = delete;
+      Handle& operator=(Handle&& other) noexcept;
+      ~Handle() { Release(); }
+
+      bool IsValid() const { return Index != INVALID_INDEX; }
+      void Release();
+
+      uint32_t Index = INVALID_INDEX;
+      std::array<uint32_t, TEXTURES_PER_MATERIAL> TextureSlots = {INVALID_INDEX, INVALID_INDEX, INVALID_INDEX, INVALID_INDEX, INVALID_INDEX};
+    };
+
+    //Allocates the sets from layoutIndex of the pipeline, every mesh pipeline has to use the same layout there.
+    static void Init(const VulkanPipeline& pipeline, uint32_t layoutIndex);
+    static void Shutdown();
+    //Recycles indices and slots released by frames the GPU is done with. Called once the frame in flight was waited on.
+    static void BeginFrame();
+
+    //Registers the material if it isn't yet and points its texture slots at its current textures.
+    static void Register(Material& material);
+    //Copies the material into the buffer of the current frame in flight, returns the index draws use for it.
+    static uint32_t Write(const Material& material);
+
+    static const vk::DescriptorSet& GetDescriptorSet() { return s_Data.DescriptorSets.Current().Get(); }
+    //Texture slots of the bindless array, MAX_TEXTURES clamped to the update after bind limits of the device.
+    static uint32_t GetTextureCapacity();
+
+  private:
+    struct TextureSlot {
+      uint32_t RefCount = 0;
+      vk::ImageView View;
+    };
+
+    struct ReleasedIndex {
+      uint32_t Index = 0;
+      uint64_t Frame = 0;
+    };
+
+    static struct PoolData {
+      vk::DescriptorPool DescriptorPool;
+      PerFrame<VulkanDescriptorSet> DescriptorSets;
+      PerFrame<VulkanBuffer> MaterialBuffers;
+
+      std::vector<uint32_t> FreeMaterials;
+      std::vector<ReleasedIndex> ReleasedMaterials;
+
+      std::vector<TextureSlot> TextureSlots;
+      std::unordered_map<VkImageView, uint32_t> TextureLookup;
+      std::vector<uint32_t> FreeTextureSlots;
+      std::vector<ReleasedIndex> ReleasedTextureSlots;
+
+      //Materials point missing textures here.
+      uint32_t DefaultTextureSlot = INVALID_INDEX;
+      uint32_t TextureCapacity = 0;
+      uint64_t FrameCount = 0;
+      bool Initialized = false;
+    } s_Data;
+
+    static uint32_t AcquireTexture(const VulkanImage& image);
+    static void ReleaseTexture(uint32_t slot);
+    static void ReleaseMaterial(uint32_t index);
+  };
+}
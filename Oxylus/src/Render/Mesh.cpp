@@ -5,6 +5,7 @@
 
 #include <glm/gtc/type_ptr.hpp>
 
+#include "MeshCache.h"
 #include "Assets/AssetManager.h"
 #include "Utils/Profiler.h"
 #include "Vulkan/VulkanContext.h"
@@ -46,11 +47,40 @@ namespace Oxylus {
     ZoneScoped;
     ProfilerTimer timer;
 
+    if (!LoadData(path, fileLoadingFlags, scale)) {
+      LoadFailFallback();
+      return;
+    }
+    const size_t materialCount = m_MaterialSources.size();
+    CreateResources();
+
+    timer.Stop();
+    OX_CORE_TRACE("Mesh file loaded: {}, {} materials, {} ms",
+      Name.c_str(),
+      materialCount,
+      timer.ElapsedMilliSeconds());
+  }
+
+  bool Mesh::LoadData(const std::string& path, uint32_t fileLoadingFlags, const float scale) {
+    ZoneScoped;
     Path = path;
+    Name = std::filesystem::path(path).filename().string();
     FileLoadingFlags = fileLoadingFlags;
     ShouldUpdate = true;
 
-    tinygltf::Model gltfModel;
+    if (MeshCache::Load(*this, path, fileLoadingFlags, scale))
+      return true;
+    if (!LoadGltf(path, fileLoadingFlags, scale))
+      return false;
+    MeshCache::Write(*this, path, fileLoadingFlags, scale);
+    return true;
+  }
+
+  bool Mesh::LoadGltf(const std::string& path, uint32_t fileLoadingFlags, const float scale) {
+    ZoneScoped;
+    m_StreamFlags = VertexFormat::BaseStream;
+    m_Model = CreateScope<tinygltf::Model>();
+    tinygltf::Model& gltfModel = *m_Model;
     tinygltf::TinyGLTF gltfContext;
     gltfContext.SetImageLoader(LoadImageDataCallback, nullptr);
 
@@ -60,15 +90,13 @@ namespace Oxylus {
       fileLoaded = gltfContext.LoadASCIIFromFile(&gltfModel, &error, &warning, path);
     else
       fileLoaded = gltfContext.LoadBinaryFromFile(&gltfModel, &error, &warning, path);
-    if (!fileLoaded) {
-      OX_CORE_ERROR("Couldnt load gltf file: {}", error);
-      LoadFailFallback();
-    }
     if (!warning.empty())
       OX_CORE_WARN("GLTF loader warning: {}", warning);
-
-    LoadTextures(gltfModel);
-    LoadMaterials(gltfModel);
+    if (!fileLoaded || gltfModel.scenes.empty()) {
+      OX_CORE_ERROR("Couldnt load gltf file: {}", error);
+      m_Model.reset();
+      return false;
+    }
 
     const tinygltf::Scene& scene = gltfModel.scenes[gltfModel.defaultScene > -1 ? gltfModel.defaultScene : 0];
 
@@ -84,7 +112,9 @@ namespace Oxylus {
       if (!node)
         continue;
       const Mat4 localMatrix = node->GetMatrix();
-      for (const Primitive* primitive : node->Primitives) {
+      for (Primitive* primitive : node->Primitives) {
+        Vec3 posMin = Vec3(FLT_MAX);
+        Vec3 posMax = Vec3(-FLT_MAX);
         for (uint32_t i = 0; i < primitive->vertexCount; i++) {
           Vertex& vertex = m_VertexBuffer[primitive->firstVertex + i];
           vertex.pos = Vec3(localMatrix * glm::vec4(vertex.pos, 1.0f));
@@ -96,69 +126,53 @@ namespace Oxylus {
           if (preMultiplyColor) {
             //vertex.color = primitive->material.baseColorFactor * vertex.color;
           }
+          posMin = glm::min(posMin, vertex.pos);
+          posMax = glm::max(posMax, vertex.pos);
         }
+        //Vertices are baked into mesh space so the bounds have to follow.
+        if (primitive->vertexCount > 0)
+          primitive->SetDimensions(posMin, posMax);
       }
     }
 
-    const vk::DeviceSize vBufferSize = m_VertexBuffer.size() * sizeof(Vertex);
-    const vk::DeviceSize iBufferSize = m_IndexBuffer.size() * sizeof(uint32_t);
     IndexCount = static_cast<uint32_t>(m_IndexBuffer.size());
     VertexCount = static_cast<uint32_t>(m_VertexBuffer.size());
+    EncodeVertices();
+    m_Indices = m_IndexBuffer;
 
-    OX_CORE_ASSERT(iBufferSize);
-    OX_CORE_ASSERT(vBufferSize);
-
-    VulkanBuffer vertexStaging, indexStaging;
-
-    vertexStaging.CreateBuffer(vk::BufferUsageFlagBits::eTransferSrc,
-      vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-      vBufferSize,
-      m_VertexBuffer.data(),
-      VMA_MEMORY_USAGE_AUTO_PREFER_HOST);
-
-    VerticiesBuffer.CreateBuffer(vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
-      vk::MemoryPropertyFlagBits::eDeviceLocal,
-      vBufferSize,
-      nullptr,
-      VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
-
-    indexStaging.CreateBuffer(vk::BufferUsageFlagBits::eTransferSrc,
-      vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-      iBufferSize,
-      m_IndexBuffer.data(),
-      VMA_MEMORY_USAGE_AUTO_PREFER_HOST);
-
-    IndiciesBuffer.CreateBuffer(vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst,
-      vk::MemoryPropertyFlagBits::eDeviceLocal,
-      iBufferSize,
-      nullptr,
-      VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
-
-    VulkanRenderer::SubmitOnce([&](const VulkanCommandBuffer copyCmd) {
-      vk::BufferCopy copyRegion{};
-
-      copyRegion.size = vBufferSize;
-      vertexStaging.CopyTo(VerticiesBuffer.Get(), copyCmd.Get(), copyRegion);
-
-      copyRegion.size = iBufferSize;
-      indexStaging.CopyTo(IndiciesBuffer.Get(), copyCmd.Get(), copyRegion);
-    });
-
-    // Destroy staging resources
-    vertexStaging.Destroy();
-    indexStaging.Destroy();
+    LoadTextures(gltfModel);
+    LoadMaterials(gltfModel);
+    return true;
+  }
 
-    m_VertexBuffer.clear();
-    m_IndexBuffer.clear();
+  void Mesh::CreateResources() {
+    ZoneScoped;
+    OX_CORE_ASSERT(!m_Indices.empty());
+    OX_CORE_ASSERT(!m_VertexStreams[VertexFormat::Base].empty());
+
+    CreateTextures();
+    CreateMaterials();
+
+    //The uploader copies straight from the parsed buffers or the mapped cooked file into its staging memory.
+    const void* streamData[VertexFormat::STREAM_COUNT];
+    for (uint32_t stream = 0; stream < VertexFormat::STREAM_COUNT; stream++)
+      streamData[stream] = m_VertexStreams[stream].empty() ? nullptr : m_VertexStreams[stream].data();
+    GeometryPool::Free(Geometry);
+    Geometry = GeometryPool::Allocate(streamData, VertexCount, m_Indices.data(), IndexCount);
+
+    for (auto& stream : m_VertexStreams)
+      stream = {};
+    m_Indices = {};
+    m_BaseVertices = {};
+    m_ColorVertices = {};
+    m_SkinVertices = {};
+    m_IndexBuffer = {};
+    m_TextureSources.clear();
+    m_MaterialSources.clear();
 
     m_Textures.clear();
-
-    timer.Stop();
-    Name = std::filesystem::path(path).filename().string();
-    OX_CORE_TRACE("Mesh file loaded: {}, {} materials, {} ms",
-      Name.c_str(),
-      gltfModel.materials.size(),
-      timer.ElapsedMilliSeconds());
+    m_Model.reset();
+    m_CookedFile.reset();
   }
 
   void Mesh::SetScale(const Vec3& scale) {
@@ -169,12 +183,12 @@ namespace Oxylus {
 
   void Mesh::Draw(const vk::CommandBuffer& cmdBuffer) const {
     ZoneScoped;
-    constexpr vk::DeviceSize offsets[1] = {0};
-    cmdBuffer.bindVertexBuffers(0, VerticiesBuffer.Get(), offsets);
-    cmdBuffer.bindIndexBuffer(IndiciesBuffer.Get(), 0, vk::IndexType::eUint32);
+    if (!Geometry.IsResident())
+      return;
+    GeometryPool::Bind(cmdBuffer);
     for (const auto& node : Nodes) {
       for (const auto& primitive : node->Primitives)
-        cmdBuffer.drawIndexed(primitive->indexCount, 1, primitive->firstIndex, 0, 0);
+        cmdBuffer.drawIndexed(primitive->indexCount, 1, Geometry.FirstIndex + primitive->firstIndex, (int32_t)Geometry.FirstVertex, 0);
     }
   }
 
@@ -185,49 +199,43 @@ namespace Oxylus {
   }
 
   void Mesh::LoadTextures(const tinygltf::Model& model) {
-    m_Textures.resize(model.images.size());
+    ZoneScoped;
+    m_TextureSources.resize(model.images.size());
     for (size_t i = 0; i < model.images.size(); i++) {
-      auto& img = model.images[i];
-      VulkanImageDescription desc;
-      desc.CreateDescriptorSet = true;
-      desc.Width = img.width;
-      desc.Height = img.height;
-      //desc.MipLevels = VulkanImage::GetMaxMipmapLevel(img.width, img.height, 1) - 1;
-      if (IsImageKtx(img) || !img.uri.empty()) {
-        desc.Path = (std::filesystem::path(Path).remove_filename() / img.uri).string();
-        m_Textures[i] = AssetManager::GetImageAsset(desc).Data;
-      }
-      else {
-        desc.EmbeddedStbData = img.image.data();
-        desc.EmbeddedDataLength = static_cast<uint32_t>(img.image.size());
-        m_Textures[i] = CreateRef<VulkanImage>(desc);
+      const auto& img = model.images[i];
+      auto& texture = m_TextureSources[i];
+      texture.Uri = img.uri;
+      texture.Width = (uint32_t)img.width;
+      texture.Height = (uint32_t)img.height;
+      //Image files are decoded by the parser too, only used if the image isn't loaded yet.
+      const bool decoded = img.uri.empty() || (!IsImageKtx(img) && img.bits == 8 && img.component == 4);
+      if (decoded && !img.image.empty()) {
+        texture.Pixels = img.image.data();
+        texture.PixelSize = img.image.size();
       }
     }
   }
 
   void Mesh::LoadMaterials(tinygltf::Model& model) {
     ZoneScoped;
-    //Create a empty material if the mesh file doesn't have any.
-    if (model.materials.empty()) {
-      m_Materials.emplace_back(CreateRef<Material>());
-      const bool dontCreateMaterials = FileLoadingFlags & FileLoadingFlags::DontCreateMaterials;
-      if (!dontCreateMaterials)
-        m_Materials[0]->Create();
+    //An empty material is created if the mesh file doesn't have any.
+    if (model.materials.empty())
       return;
-    }
+
+    const auto textureSource = [&model](const int textureIndex) {
+      return model.textures[textureIndex].source;
+    };
 
     for (tinygltf::Material& mat : model.materials) {
-      Material material;
-      material.Create();
-      if (!mat.name.empty())
-        material.Name = mat.name;
+      MaterialSource material;
+      material.Name = mat.name;
       material.Parameters.DoubleSided = mat.doubleSided;
       if (mat.values.contains("baseColorTexture")) {
-        material.AlbedoTexture = m_Textures.at(model.textures[mat.values["baseColorTexture"].TextureIndex()].source);
+        material.Textures[MaterialSource::Albedo] = textureSource(mat.values["baseColorTexture"].TextureIndex());
         material.Parameters.UseAlbedo = true;
       }
       if (mat.values.contains("metallicRoughnessTexture")) {
-        material.MetallicTexture = m_Textures.at(model.textures[mat.values["metallicRoughnessTexture"].TextureIndex()].source);
+        material.Textures[MaterialSource::Metallic] = textureSource(mat.values["metallicRoughnessTexture"].TextureIndex());
         material.Parameters.UseMetallic = true;
       }
       if (mat.values.contains("roughnessFactor")) {
@@ -246,15 +254,15 @@ namespace Oxylus {
         material.Parameters.Emmisive = glm::vec4(glm::make_vec3(mat.additionalValues["emissiveFactor"].ColorFactor().data()), 1.0);
       }
       if (mat.additionalValues.contains("normalTexture")) {
-        material.NormalTexture = m_Textures.at(model.textures[mat.additionalValues["normalTexture"].TextureIndex()].source);
+        material.Textures[MaterialSource::Normal] = textureSource(mat.additionalValues["normalTexture"].TextureIndex());
         material.Parameters.UseNormal = true;
       }
       if (mat.additionalValues.contains("emissiveTexture")) {
-        material.EmissiveTexture = m_Textures.at(model.textures[mat.additionalValues["emissiveTexture"].TextureIndex()].source);
+        material.Textures[MaterialSource::Emissive] = textureSource(mat.additionalValues["emissiveTexture"].TextureIndex());
         material.Parameters.UseEmissive = true;
       }
       if (mat.additionalValues.contains("occlusionTexture")) {
-        material.AOTexture = m_Textures.at(model.textures[mat.additionalValues["occlusionTexture"].TextureIndex()].source);
+        material.Textures[MaterialSource::AO] = textureSource(mat.additionalValues["occlusionTexture"].TextureIndex());
       }
       if (mat.additionalValues.contains("alphaMode")) {
         tinygltf::Parameter param = mat.additionalValues["alphaMode"];
@@ -273,7 +281,7 @@ namespace Oxylus {
         auto ext = mat.extensions.find("KHR_materials_pbrSpecularGlossiness");
         if (ext->second.Has("specularGlossinessTexture")) {
           auto index = ext->second.Get("specularGlossinessTexture").Get("index");
-          material.SpecularTexture = m_Textures.at(model.textures[mat.additionalValues["specularGlossinessTexture"].TextureIndex()].source);
+          material.Textures[MaterialSource::Specular] = textureSource(mat.additionalValues["specularGlossinessTexture"].TextureIndex());
           material.Parameters.UseSpecular = true;
         }
         if (ext->second.Has("specularFactor")) {
@@ -306,6 +314,89 @@ namespace Oxylus {
         }
       }
 
+      m_MaterialSources.emplace_back(std::move(material));
+    }
+  }
+
+  void Mesh::EncodeVertices() {
+    ZoneScoped;
+    const size_t vertexCount = m_VertexBuffer.size();
+    m_BaseVertices.resize(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++) {
+      const Vertex& vertex = m_VertexBuffer[i];
+      m_BaseVertices[i] = VertexFormat::EncodeBase(vertex.pos, vertex.normal, vertex.uv, vertex.tangent);
+    }
+    m_VertexStreams[VertexFormat::Base] = std::span((const uint8_t*)m_BaseVertices.data(), vertexCount * sizeof(VertexFormat::BaseVertex));
+
+    //Static geometry usually has neither, the streams are only kept if a primitive of the file has them.
+    if (m_StreamFlags & VertexFormat::ColorStream) {
+      m_ColorVertices.resize(vertexCount);
+      for (size_t i = 0; i < vertexCount; i++)
+        m_ColorVertices[i] = VertexFormat::EncodeColor(m_VertexBuffer[i].color);
+      m_VertexStreams[VertexFormat::Color] = std::span((const uint8_t*)m_ColorVertices.data(), vertexCount * sizeof(VertexFormat::ColorVertex));
+    }
+    if (m_StreamFlags & VertexFormat::SkinStream) {
+      m_SkinVertices.resize(vertexCount);
+      for (size_t i = 0; i < vertexCount; i++)
+        m_SkinVertices[i] = VertexFormat::EncodeSkin(m_VertexBuffer[i].joint0, m_VertexBuffer[i].weight0);
+      m_VertexStreams[VertexFormat::Skin] = std::span((const uint8_t*)m_SkinVertices.data(), vertexCount * sizeof(VertexFormat::SkinVertex));
+    }
+
+    m_VertexBuffer = {};
+  }
+
+  void Mesh::CreateTextures() {
+    ZoneScoped;
+    m_Textures.resize(m_TextureSources.size());
+    EmbeddedTextureBytes = 0;
+    for (size_t i = 0; i < m_TextureSources.size(); i++) {
+      const auto& texture = m_TextureSources[i];
+      VulkanImageDescription desc;
+      desc.CreateDescriptorSet = true;
+      desc.Width = texture.Width;
+      desc.Height = texture.Height;
+      //desc.MipLevels = VulkanImage::GetMaxMipmapLevel(img.width, img.height, 1) - 1;
+      desc.EmbeddedStbData = texture.Pixels;
+      if (!texture.Uri.empty()) {
+        desc.Path = (std::filesystem::path(Path).remove_filename() / texture.Uri).string();
+        m_Textures[i] = AssetManager::GetImageAsset(desc).Data;
+      }
+      else {
+        desc.EmbeddedDataLength = (uint32_t)texture.PixelSize;
+        //Materials hold on to the image, it is destroyed once the last of them is gone.
+        m_Textures[i] = AssetManager::CreateUnregisteredImage(desc);
+        EmbeddedTextureBytes += m_Textures[i]->ImageSize;
+      }
+    }
+  }
+
+  void Mesh::CreateMaterials() {
+    ZoneScoped;
+    if (m_MaterialSources.empty()) {
+      m_Materials.emplace_back(CreateRef<Material>());
+      const bool dontCreateMaterials = FileLoadingFlags & FileLoadingFlags::DontCreateMaterials;
+      if (!dontCreateMaterials)
+        m_Materials[0]->Create();
+      return;
+    }
+
+    for (const MaterialSource& source : m_MaterialSources) {
+      Material material;
+      material.Create();
+      if (!source.Name.empty())
+        material.Name = source.Name;
+      material.Parameters = source.Parameters;
+      material.AlphaMode = source.AlphaMode;
+
+      Ref<VulkanImage>* slots[MaterialSource::TEXTURE_COUNT] = {
+        &material.AlbedoTexture, &material.MetallicTexture, &material.NormalTexture,
+        &material.EmissiveTexture, &material.AOTexture, &material.SpecularTexture,
+      };
+      for (uint32_t slot = 0; slot < MaterialSource::TEXTURE_COUNT; slot++) {
+        if (source.Textures[slot] >= 0)
+          *slots[slot] = m_Textures.at(source.Textures[slot]);
+      }
+
       m_Materials.push_back(CreateRef<Material>(material));
     }
   }
@@ -330,8 +421,7 @@ namespace Oxylus {
     }
     LinearNodes.clear();
     Nodes.clear();
-    VerticiesBuffer.Destroy();
-    IndiciesBuffer.Destroy();
+    GeometryPool::Free(Geometry);
     m_Materials.clear();
   }
 
@@ -478,6 +568,10 @@ namespace Oxylus {
           }
 
           hasSkin = bufferJoints && bufferWeights;
+          if (bufferColors)
+            m_StreamFlags |= VertexFormat::ColorStream;
+          if (hasSkin)
+            m_StreamFlags |= VertexFormat::SkinStream;
 
           vertexCount = static_cast<uint32_t>(posAccessor.count);
 
@@ -490,6 +584,7 @@ namespace Oxylus {
             if (bufferColors) {
               switch (numColorComponents) {
                 case 3: vert.color = glm::vec4(glm::make_vec3(&bufferColors[v * 3]), 1.0f);
+                  break;
                 case 4: vert.color = glm::make_vec4(&bufferColors[v * 4]);
               }
             }
@@ -2,31 +2,21 @@
 
 #include <glm/glm.hpp>
 #include <vulkan/vulkan.hpp>
+#include <span>
 #include <string>
 #include <vector>
 #include <glm/detail/type_quat.hpp>
 
-#include "Render/Vulkan/VulkanBuffer.h"
+#include "Render/GeometryPool.h"
 #include "Assets/Material.h"
 
 #define TINYGLTF_NO_STB_IMAGE_WRITE 
 #include "tinygltf/tiny_gltf.h"
 #include "Utils/Log.h"
+#include "Utils/MappedFile.h"
 #include "Vulkan/VulkanImage.h"
 
 namespace Oxylus {
-  enum class VertexComponent {
-    POSITION2D,
-    POSITION,
-    NORMAL,
-    COLOR,
-    UV,
-    TANGENT,
-    BITANGENT,
-    JOINT0,
-    WEIGHT0,
-  };
-
   class Mesh {
   public:
     enum FileLoadingFlags {
@@ -75,6 +65,7 @@ namespace Oxylus {
       glm::mat4 GetMatrix() const;
     };
 
+    //Full precision vertex the loader bakes, encoded into VertexFormat streams for the geometry pool afterwards.
     struct Vertex {
       glm::vec3 pos;
       glm::vec3 normal;
@@ -88,9 +79,11 @@ namespace Oxylus {
     std::vector<Ref<VulkanImage>> m_Textures;
     std::vector<Node*> Nodes;
     std::vector<Node*> LinearNodes;
-    VulkanBuffer VerticiesBuffer;
-    VulkanBuffer IndiciesBuffer;
+    //Vertices and indices live in the shared GeometryPool buffers.
+    GeometryPool::Allocation Geometry;
     uint32_t IndexCount = 0;
+    //Size of the textures that came with the file, image files next to it are in the image registry.
+    uint64_t EmbeddedTextureBytes = 0;
     std::string Name;
     std::string Path;
     uint32_t FileLoadingFlags = 0;
@@ -101,6 +94,13 @@ namespace Oxylus {
     ~Mesh();
 
     void LoadFromFile(const std::string& path, uint32_t fileLoadingFlags = None, float scale = 1);
+    /**
+     * \brief CPU part of loading, parses the file and bakes the vertices. Touches no GPU state so it can run on any thread.
+     * Returns false if the file couldn't be loaded, CreateResources has to be called on the main thread afterwards.
+     */
+    bool LoadData(const std::string& path, uint32_t fileLoadingFlags = None, float scale = 1);
+    //Creates textures, materials and geometry from the data LoadData parsed.
+    void CreateResources();
     void SetScale(const glm::vec3& scale);
     void Draw(const vk::CommandBuffer& cmdBuffer) const;
     void UpdateMaterials() const;
@@ -114,15 +114,64 @@ namespace Oxylus {
     }
 
   private:
+    //Texture of the file, an image file next to it or pixels that came with it.
+    struct TextureSource {
+      //Relative to the mesh file, empty for embedded images.
+      std::string Uri;
+      //RGBA8, decoded by the parser or mapped from the cooked file. Optional for image files.
+      const uint8_t* Pixels = nullptr;
+      size_t PixelSize = 0;
+      uint32_t Width = 0;
+      uint32_t Height = 0;
+    };
+
+    //Material of the file, read on the loading thread and created on the main thread.
+    struct MaterialSource {
+      enum TextureSlot {
+        Albedo = 0,
+        Metallic,
+        Normal,
+        Emissive,
+        AO,
+        Specular,
+        TEXTURE_COUNT
+      };
+
+      std::string Name;
+      decltype(Material::Parameters) Parameters;
+      decltype(Material::AlphaMode) AlphaMode = decltype(Material::AlphaMode)::Opaque;
+      //Indices into the texture sources, -1 if the material doesn't use the slot.
+      int32_t Textures[TEXTURE_COUNT] = {-1, -1, -1, -1, -1, -1};
+    };
+
     std::vector<Ref<Material>> m_Materials;
     std::vector<uint32_t> m_IndexBuffer;
     std::vector<Vertex> m_VertexBuffer;
+    std::vector<VertexFormat::BaseVertex> m_BaseVertices;
+    std::vector<VertexFormat::ColorVertex> m_ColorVertices;
+    std::vector<VertexFormat::SkinVertex> m_SkinVertices;
+    //Point into the encoded buffers above or into the cooked file, uploaded from there by CreateResources.
+    //Indexed by VertexFormat::Stream, empty for streams the mesh doesn't have.
+    std::span<const uint8_t> m_VertexStreams[VertexFormat::STREAM_COUNT];
+    std::span<const uint32_t> m_Indices;
+    //VertexFormat::StreamFlags of the attributes the file has.
+    uint32_t m_StreamFlags = VertexFormat::BaseStream;
+    std::vector<TextureSource> m_TextureSources;
+    std::vector<MaterialSource> m_MaterialSources;
+    //Kept from LoadData until CreateResources is done with them, sources point into them.
+    Scope<tinygltf::Model> m_Model = nullptr;
+    Scope<MappedFile> m_CookedFile = nullptr;
     uint32_t VertexCount = 0;
     glm::vec3 m_Scale{1.0f};
     glm::vec3 center{0.0f};
     glm::vec2 uvscale{1.0f};
+    bool LoadGltf(const std::string& path, uint32_t fileLoadingFlags, float scale);
     void LoadTextures(const tinygltf::Model& model);
     void LoadMaterials(tinygltf::Model& model);
+    //Quantizes the baked vertices into the streams the mesh has and frees them.
+    void EncodeVertices();
+    void CreateTextures();
+    void CreateMaterials();
     void LoadNode(Node* parent,
                   const tinygltf::Node& node,
                   uint32_t nodeIndex,
@@ -131,14 +180,18 @@ namespace Oxylus {
                   std::vector<Vertex>& vertexBuffer,
                   float globalscale);
     void LoadFailFallback();
+
+    friend class MeshCache;
   };
 
+  //Interleaved float vertices. Mesh vertices are quantized instead, see VertexInputDescription::ForMesh.
   struct VertexLayout {
     std::vector<VertexComponent> components;
     VertexLayout() = default;
 
+    //Stride defaults to the tightly packed size of the components.
     VertexLayout(std::vector<VertexComponent>&& components,
-                 uint32_t binding = 0) : components(std::move(components)) { }
+                 const uint32_t stride = 0) : components(std::move(components)), m_Stride(stride) { }
 
     uint32_t ComponentIndex(const VertexComponent component) const {
       for (size_t i = 0; i < components.size(); ++i) {
@@ -153,6 +206,10 @@ namespace Oxylus {
       switch (component) {
         case VertexComponent::UV: return vk::Format::eR32G32Sfloat;
         case VertexComponent::POSITION2D: return vk::Format::eR32G32Sfloat;
+        case VertexComponent::COLOR:
+        case VertexComponent::TANGENT:
+        case VertexComponent::JOINT0:
+        case VertexComponent::WEIGHT0: return vk::Format::eR32G32B32A32Sfloat;
         default: return vk::Format::eR32G32B32Sfloat;
       }
     }
@@ -161,21 +218,28 @@ namespace Oxylus {
       switch (component) {
         case VertexComponent::UV: return 2 * sizeof(float);
         case VertexComponent::POSITION2D: return 2 * sizeof(float);
+        case VertexComponent::COLOR:
+        case VertexComponent::TANGENT:
+        case VertexComponent::JOINT0:
+        case VertexComponent::WEIGHT0: return 4 * sizeof(float);
         default: return 3 * sizeof(float);
       }
     }
 
     uint32_t stride() const {
-      return sizeof(Mesh::Vertex);
+      return m_Stride ? m_Stride : offset((uint32_t)components.size());
     }
 
     uint32_t offset(uint32_t index) const {
       uint32_t res = 0;
-      assert(index < components.size());
+      assert(index <= components.size());
       for (uint32_t i = 0; i < index; ++i) {
         res += ComponentSize(components[i]);
       }
       return res;
     }
+
+  private:
+    uint32_t m_Stride = 0;
   };
 }
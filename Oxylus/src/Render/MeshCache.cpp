@@ -0,0 +1,449 @@
+#include "src/oxpch.h"
+#include "MeshCache.h"
+
+#include <atomic>
+#include <fstream>
+#include <thread>
+
+#include "Mesh.h"
+#include "Utils/Log.h"
+#include "Utils/MappedFile.h"
+#include "Utils/Profiler.h"
+
+namespace Oxylus {
+  std::filesystem::path MeshCache::s_Directory;
+
+  static constexpr uint32_t COOKED_MAGIC = 0x48534D4F; //"OMSH"
+  static constexpr uint64_t COOKED_ALIGNMENT = 16;
+  static constexpr uint32_t COOKED_TEXTURE_SLOTS = 6;
+
+  struct CookedString {
+    uint32_t Offset = 0;
+    uint32_t Length = 0;
+  };
+
+  //Sections follow the header in the order of their offsets, each aligned to COOKED_ALIGNMENT.
+  struct CookedHeader {
+    uint32_t Magic = COOKED_MAGIC;
+    uint32_t Version = MeshCache::VERSION;
+    //VertexFormat::StreamFlags of the vertex streams in the file.
+    uint32_t VertexStreams = VertexFormat::BaseStream;
+    uint32_t LoadingFlags = 0;
+    float Scale = 1.0f;
+    uint32_t VertexCount = 0;
+    uint64_t SourceSize = 0;
+    int64_t SourceTime = 0;
+    uint32_t IndexCount = 0;
+    uint32_t NodeCount = 0;
+    uint32_t PrimitiveCount = 0;
+    uint32_t MaterialCount = 0;
+    uint32_t TextureCount = 0;
+    uint32_t Padding = 0;
+    uint64_t NodeOffset = 0;
+    uint64_t PrimitiveOffset = 0;
+    uint64_t MaterialOffset = 0;
+    uint64_t TextureOffset = 0;
+    uint64_t StringOffset = 0;
+    uint64_t StringSize = 0;
+    uint64_t StreamOffsets[VertexFormat::STREAM_COUNT] = {};
+    uint64_t IndexOffset = 0;
+    uint64_t FileSize = 0;
+  };
+
+  //Nodes are stored in the order of Mesh::LinearNodes, children come before their parent.
+  struct CookedNode {
+    glm::mat4 Matrix;
+    glm::vec3 Translation;
+    glm::vec3 Scale;
+    glm::quat Rotation;
+    int32_t Parent = -1;
+    uint32_t Index = 0;
+    uint32_t MeshIndex = 0;
+    int32_t SkinIndex = -1;
+    uint32_t ContainsMesh = 0;
+    uint32_t FirstPrimitive = 0;
+    uint32_t PrimitiveCount = 0;
+    CookedString Name;
+  };
+
+  struct CookedPrimitive {
+    uint32_t FirstIndex = 0;
+    uint32_t IndexCount = 0;
+    uint32_t FirstVertex = 0;
+    uint32_t VertexCount = 0;
+    int32_t MaterialIndex = 0;
+    glm::vec3 Min;
+    glm::vec3 Max;
+  };
+
+  static_assert(std::is_trivially_copyable_v<decltype(Material::Parameters)>, "Material parameters are cooked as raw bytes");
+
+  struct CookedMaterial {
+    decltype(Material::Parameters) Parameters;
+    CookedString Name;
+    uint32_t AlphaMode = 0;
+    int32_t Textures[COOKED_TEXTURE_SLOTS] = {};
+  };
+
+  //Pixels are only stored for embedded images, image files are loaded through the asset manager.
+  struct CookedTexture {
+    CookedString Uri;
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+    uint64_t PixelOffset = 0;
+    uint64_t PixelSize = 0;
+  };
+
+  static uint64_t AlignCooked(const uint64_t offset) {
+    return (offset + COOKED_ALIGNMENT - 1) & ~(COOKED_ALIGNMENT - 1);
+  }
+
+  template<typename T>
+  static std::vector<T> ReadCooked(const uint8_t* data, const uint64_t offset, const uint32_t count) {
+    std::vector<T> records(count);
+    if (count)
+      memcpy(records.data(), data + offset, (size_t)count * sizeof(T));
+    return records;
+  }
+
+  static bool GetSourceStamp(const std::string& sourcePath, uint64_t& size, int64_t& time) {
+    std::error_code error;
+    size = std::filesystem::file_size(sourcePath, error);
+    if (error)
+      return false;
+    time = (int64_t)std::filesystem::last_write_time(sourcePath, error).time_since_epoch().count();
+    return !error;
+  }
+
+  std::filesystem::path MeshCache::GetCookedPath(const std::string& sourcePath, const uint32_t loadingFlags) {
+    std::filesystem::path directory = s_Directory;
+    if (directory.empty()) {
+      std::error_code error;
+      directory = std::filesystem::temp_directory_path(error);
+      directory /= "Oxylus/MeshCache";
+    }
+    std::error_code error;
+    const std::string normalized = std::filesystem::absolute(sourcePath, error).lexically_normal().generic_string();
+    return directory / fmt::format("{:016x}_{}.oxmesh", std::hash<std::string>{}(normalized), loadingFlags);
+  }
+
+  bool MeshCache::Load(Mesh& mesh, const std::string& sourcePath, const uint32_t loadingFlags, const float scale) {
+    ZoneScoped;
+    static_assert(Mesh::MaterialSource::TEXTURE_COUNT == COOKED_TEXTURE_SLOTS, "Cooked materials have to match Mesh::MaterialSource");
+
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    if (!GetSourceStamp(sourcePath, sourceSize, sourceTime))
+      return false;
+
+    auto file = CreateScope<MappedFile>();
+    if (!file->Open(GetCookedPath(sourcePath, loadingFlags).string()))
+      return false;
+    const uint8_t* data = file->GetData();
+    const uint64_t size = file->GetSize();
+
+    CookedHeader header;
+    if (size < sizeof(CookedHeader))
+      return false;
+    memcpy(&header, data, sizeof(CookedHeader));
+    if (header.Magic != COOKED_MAGIC || header.Version != VERSION ||
+        header.FileSize != size || header.SourceSize != sourceSize || header.SourceTime != sourceTime ||
+        header.LoadingFlags != loadingFlags || header.Scale != scale)
+      return false;
+
+    const auto inBounds = [size](const uint64_t offset, const uint64_t bytes) {
+      return offset <= size && bytes <= size - offset;
+    };
+    if (!inBounds(header.NodeOffset, (uint64_t)header.NodeCount * sizeof(CookedNode)) ||
+        !inBounds(header.PrimitiveOffset, (uint64_t)header.PrimitiveCount * sizeof(CookedPrimitive)) ||
+        !inBounds(header.MaterialOffset, (uint64_t)header.MaterialCount * sizeof(CookedMaterial)) ||
+        !inBounds(header.TextureOffset, (uint64_t)header.TextureCount * sizeof(CookedTexture)) ||
+        !inBounds(header.StringOffset, header.StringSize) ||
+        !inBounds(header.IndexOffset, (uint64_t)header.IndexCount * sizeof(uint32_t)) ||
+        header.IndexOffset % alignof(uint32_t) != 0) {
+      OX_CORE_WARN("Cooked mesh file of {} is corrupt, cooking it again", sourcePath);
+      return false;
+    }
+
+    bool valid = (header.VertexStreams & VertexFormat::BaseStream) && header.VertexStreams < (1u << VertexFormat::STREAM_COUNT);
+    for (uint32_t stream = 0; stream < VertexFormat::STREAM_COUNT; stream++) {
+      if (header.VertexStreams & (1u << stream)) {
+        valid &= inBounds(header.StreamOffsets[stream], (uint64_t)header.VertexCount * VertexFormat::STREAM_STRIDES[stream]);
+        valid &= header.StreamOffsets[stream] % alignof(uint32_t) == 0;
+      }
+    }
+
+    const auto cookedNodes = ReadCooked<CookedNode>(data, header.NodeOffset, header.NodeCount);
+    const auto cookedPrimitives = ReadCooked<CookedPrimitive>(data, header.PrimitiveOffset, header.PrimitiveCount);
+    const auto cookedMaterials = ReadCooked<CookedMaterial>(data, header.MaterialOffset, header.MaterialCount);
+    const auto cookedTextures = ReadCooked<CookedTexture>(data, header.TextureOffset, header.TextureCount);
+
+    const char* strings = (const char*)(data + header.StringOffset);
+    const auto getString = [&](const CookedString& string) {
+      if ((uint64_t)string.Offset + string.Length > header.StringSize) {
+        valid = false;
+        return std::string();
+      }
+      return std::string(strings + string.Offset, string.Length);
+    };
+
+    //Everything is validated before the mesh is touched, so a corrupt file only costs a parse of the source.
+    for (uint32_t i = 0; i < header.NodeCount; i++) {
+      const CookedNode& node = cookedNodes[i];
+      //Parents come after their children, which also rules out cycles.
+      valid &= node.Parent == -1 || (node.Parent > (int32_t)i && node.Parent < (int32_t)header.NodeCount);
+      valid &= (uint64_t)node.FirstPrimitive + node.PrimitiveCount <= header.PrimitiveCount;
+    }
+    //Meshes without materials get a default one from CreateMaterials.
+    const int32_t materialCount = (int32_t)std::max(header.MaterialCount, 1u);
+    for (const CookedPrimitive& primitive : cookedPrimitives) {
+      valid &= (uint64_t)primitive.FirstIndex + primitive.IndexCount <= header.IndexCount;
+      valid &= (uint64_t)primitive.FirstVertex + primitive.VertexCount <= header.VertexCount;
+      valid &= primitive.MaterialIndex >= 0 && primitive.MaterialIndex < materialCount;
+    }
+    for (const CookedMaterial& material : cookedMaterials) {
+      for (const int32_t texture : material.Textures)
+        valid &= texture >= -1 && texture < (int32_t)header.TextureCount;
+    }
+    for (const CookedTexture& texture : cookedTextures) {
+      valid &= inBounds(texture.PixelOffset, texture.PixelSize);
+      //Embedded pixels are uploaded as RGBA8 of the stored size.
+      valid &= texture.PixelSize == 0 || texture.PixelSize == (uint64_t)texture.Width * texture.Height * 4;
+    }
+    //Indices are relative to the first vertex of the mesh, the geometry pool offsets them.
+    if (valid) {
+      const auto* indices = (const uint32_t*)(data + header.IndexOffset);
+      uint32_t maxIndex = 0;
+      for (uint32_t i = 0; i < header.IndexCount; i++)
+        maxIndex = std::max(maxIndex, indices[i]);
+      valid &= header.IndexCount == 0 || maxIndex < header.VertexCount;
+    }
+
+    std::vector<Mesh::TextureSource> textures(header.TextureCount);
+    for (uint32_t i = 0; i < header.TextureCount; i++) {
+      const CookedTexture& cooked = cookedTextures[i];
+      auto& texture = textures[i];
+      texture.Uri = getString(cooked.Uri);
+      texture.Width = cooked.Width;
+      texture.Height = cooked.Height;
+      texture.Pixels = cooked.PixelSize ? data + cooked.PixelOffset : nullptr;
+      texture.PixelSize = (size_t)cooked.PixelSize;
+    }
+    std::vector<Mesh::MaterialSource> materials(header.MaterialCount);
+    for (uint32_t i = 0; i < header.MaterialCount; i++) {
+      const CookedMaterial& cooked = cookedMaterials[i];
+      auto& material = materials[i];
+      material.Name = getString(cooked.Name);
+      material.Parameters = cooked.Parameters;
+      material.AlphaMode = (decltype(Material::AlphaMode))cooked.AlphaMode;
+      std::copy_n(cooked.Textures, COOKED_TEXTURE_SLOTS, material.Textures);
+    }
+    std::vector<std::string> nodeNames(header.NodeCount);
+    for (uint32_t i = 0; i < header.NodeCount; i++)
+      nodeNames[i] = getString(cookedNodes[i].Name);
+
+    if (!valid) {
+      OX_CORE_WARN("Cooked mesh file of {} is corrupt, cooking it again", sourcePath);
+      return false;
+    }
+
+    std::vector<Mesh::Node*> nodes(header.NodeCount);
+    for (uint32_t i = 0; i < header.NodeCount; i++) {
+      const CookedNode& cooked = cookedNodes[i];
+      auto* node = new Mesh::Node{};
+      node->Index = cooked.Index;
+      node->MeshIndex = cooked.MeshIndex;
+      node->Name = std::move(nodeNames[i]);
+      node->SkinIndex = cooked.SkinIndex;
+      node->Matrix = cooked.Matrix;
+      node->Translation = cooked.Translation;
+      node->Scale = cooked.Scale;
+      node->Rotation = cooked.Rotation;
+      node->ContainsMesh = cooked.ContainsMesh != 0;
+      for (uint32_t p = cooked.FirstPrimitive; p < cooked.FirstPrimitive + cooked.PrimitiveCount; p++) {
+        const CookedPrimitive& primitive = cookedPrimitives[p];
+        auto* newPrimitive = new Mesh::Primitive(primitive.FirstIndex, primitive.IndexCount);
+        newPrimitive->firstVertex = primitive.FirstVertex;
+        newPrimitive->vertexCount = primitive.VertexCount;
+        newPrimitive->materialIndex = primitive.MaterialIndex;
+        newPrimitive->SetDimensions(primitive.Min, primitive.Max);
+        node->Primitives.push_back(newPrimitive);
+      }
+      nodes[i] = node;
+    }
+    //Children were added to their parent in the order they finished loading, which is the order they are stored in.
+    for (uint32_t i = 0; i < header.NodeCount; i++) {
+      Mesh::Node* node = nodes[i];
+      const int32_t parent = cookedNodes[i].Parent;
+      node->Parent = parent >= 0 ? nodes[parent] : nullptr;
+      if (node->Parent)
+        node->Parent->Children.push_back(node);
+      else
+        mesh.Nodes.push_back(node);
+      mesh.LinearNodes.push_back(node);
+    }
+
+    //Uploaded straight from the mapping, its pages are read in while the uploader copies them.
+    for (uint32_t stream = 0; stream < VertexFormat::STREAM_COUNT; stream++) {
+      if (header.VertexStreams & (1u << stream))
+        mesh.m_VertexStreams[stream] = std::span(data + header.StreamOffsets[stream], (size_t)header.VertexCount * VertexFormat::STREAM_STRIDES[stream]);
+    }
+    mesh.m_StreamFlags = header.VertexStreams;
+    mesh.m_Indices = std::span((const uint32_t*)(data + header.IndexOffset), header.IndexCount);
+    mesh.VertexCount = header.VertexCount;
+    mesh.IndexCount = header.IndexCount;
+    mesh.m_TextureSources = std::move(textures);
+    mesh.m_MaterialSources = std::move(materials);
+    mesh.m_CookedFile = std::move(file);
+    return true;
+  }
+
+  bool MeshCache::Write(const Mesh& mesh, const std::string& sourcePath, const uint32_t loadingFlags, const float scale) {
+    ZoneScoped;
+    CookedHeader header;
+    if (!GetSourceStamp(sourcePath, header.SourceSize, header.SourceTime))
+      return false;
+    header.LoadingFlags = loadingFlags;
+    header.Scale = scale;
+    header.VertexCount = mesh.VertexCount;
+    header.VertexStreams = mesh.m_StreamFlags;
+    header.IndexCount = (uint32_t)mesh.m_Indices.size();
+
+    std::string strings;
+    const auto addString = [&strings](const std::string& value) {
+      const CookedString string{(uint32_t)strings.size(), (uint32_t)value.size()};
+      strings += value;
+      return string;
+    };
+
+    std::unordered_map<const Mesh::Node*, int32_t> nodeIndices;
+    for (size_t i = 0; i < mesh.LinearNodes.size(); i++)
+      nodeIndices.emplace(mesh.LinearNodes[i], (int32_t)i);
+
+    std::vector<CookedNode> nodes;
+    std::vector<CookedPrimitive> primitives;
+    nodes.reserve(mesh.LinearNodes.size());
+    for (const Mesh::Node* node : mesh.LinearNodes) {
+      CookedNode& cooked = nodes.emplace_back();
+      cooked.Matrix = node->Matrix;
+      cooked.Translation = node->Translation;
+      cooked.Scale = node->Scale;
+      cooked.Rotation = node->Rotation;
+      cooked.Parent = node->Parent ? nodeIndices.at(node->Parent) : -1;
+      cooked.Index = node->Index;
+      cooked.MeshIndex = node->MeshIndex;
+      cooked.SkinIndex = node->SkinIndex;
+      cooked.ContainsMesh = node->ContainsMesh;
+      cooked.FirstPrimitive = (uint32_t)primitives.size();
+      cooked.PrimitiveCount = (uint32_t)node->Primitives.size();
+      cooked.Name = addString(node->Name);
+      for (const Mesh::Primitive* primitive : node->Primitives) {
+        primitives.emplace_back(CookedPrimitive{
+          primitive->firstIndex, primitive->indexCount, primitive->firstVertex, primitive->vertexCount,
+          primitive->materialIndex, primitive->dimensions.min, primitive->dimensions.max
+        });
+      }
+    }
+
+    std::vector<CookedMaterial> materials;
+    materials.reserve(mesh.m_MaterialSources.size());
+    for (const auto& source : mesh.m_MaterialSources) {
+      CookedMaterial& cooked = materials.emplace_back();
+      cooked.Parameters = source.Parameters;
+      cooked.Name = addString(source.Name);
+      cooked.AlphaMode = (uint32_t)source.AlphaMode;
+      std::copy_n(source.Textures, COOKED_TEXTURE_SLOTS, cooked.Textures);
+    }
+
+    header.NodeCount = (uint32_t)nodes.size();
+    header.PrimitiveCount = (uint32_t)primitives.size();
+    header.MaterialCount = (uint32_t)materials.size();
+    header.TextureCount = (uint32_t)mesh.m_TextureSources.size();
+
+    uint64_t offset = sizeof(CookedHeader);
+    const auto place = [&offset](const uint64_t size) {
+      offset = AlignCooked(offset);
+      const uint64_t placed = offset;
+      offset += size;
+      return placed;
+    };
+    header.NodeOffset = place(nodes.size() * sizeof(CookedNode));
+    header.PrimitiveOffset = place(primitives.size() * sizeof(CookedPrimitive));
+    header.MaterialOffset = place(materials.size() * sizeof(CookedMaterial));
+    header.TextureOffset = place(mesh.m_TextureSources.size() * sizeof(CookedTexture));
+    //Texture uris are added after the offsets of everything else are known.
+    std::vector<CookedTexture> textures;
+    textures.reserve(mesh.m_TextureSources.size());
+    for (const auto& source : mesh.m_TextureSources) {
+      CookedTexture& cooked = textures.emplace_back();
+      cooked.Uri = addString(source.Uri);
+      cooked.Width = source.Width;
+      cooked.Height = source.Height;
+    }
+    header.StringSize = strings.size();
+    header.StringOffset = place(strings.size());
+    for (uint32_t stream = 0; stream < VertexFormat::STREAM_COUNT; stream++) {
+      if (header.VertexStreams & (1u << stream))
+        header.StreamOffsets[stream] = place(mesh.m_VertexStreams[stream].size_bytes());
+    }
+    header.IndexOffset = place(mesh.m_Indices.size_bytes());
+    for (size_t i = 0; i < textures.size(); i++) {
+      const auto& source = mesh.m_TextureSources[i];
+      if (!source.Uri.empty() || !source.Pixels)
+        continue;
+      textures[i].PixelSize = source.PixelSize;
+      textures[i].PixelOffset = place(source.PixelSize);
+    }
+    header.FileSize = offset;
+
+    const std::filesystem::path cookedPath = GetCookedPath(sourcePath, loadingFlags);
+    std::error_code error;
+    std::filesystem::create_directories(cookedPath.parent_path(), error);
+    //Written next to the cooked file and renamed, so readers never map a partially written file.
+    //The name has to be unique across threads outside the job system and other running instances too.
+    static std::atomic<uint32_t> s_TempCounter = 0;
+    std::filesystem::path tempPath = cookedPath;
+    tempPath += fmt::format(".{}.{}.tmp", std::hash<std::thread::id>{}(std::this_thread::get_id()), s_TempCounter++);
+    {
+      std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+      if (!stream) {
+        OX_CORE_WARN("Couldn't write cooked mesh file {}", cookedPath.string());
+        return false;
+      }
+      uint64_t written = 0;
+      const auto writeAt = [&stream, &written](const uint64_t at, const void* data, const uint64_t size) {
+        static constexpr char padding[COOKED_ALIGNMENT] = {};
+        stream.write(padding, (std::streamsize)(at - written));
+        stream.write((const char*)data, (std::streamsize)size);
+        written = at + size;
+      };
+      writeAt(0, &header, sizeof(CookedHeader));
+      writeAt(header.NodeOffset, nodes.data(), nodes.size() * sizeof(CookedNode));
+      writeAt(header.PrimitiveOffset, primitives.data(), primitives.size() * sizeof(CookedPrimitive));
+      writeAt(header.MaterialOffset, materials.data(), materials.size() * sizeof(CookedMaterial));
+      writeAt(header.TextureOffset, textures.data(), textures.size() * sizeof(CookedTexture));
+      writeAt(header.StringOffset, strings.data(), strings.size());
+      for (uint32_t stream = 0; stream < VertexFormat::STREAM_COUNT; stream++) {
+        if (header.VertexStreams & (1u << stream))
+          writeAt(header.StreamOffsets[stream], mesh.m_VertexStreams[stream].data(), mesh.m_VertexStreams[stream].size_bytes());
+      }
+      writeAt(header.IndexOffset, mesh.m_Indices.data(), mesh.m_Indices.size_bytes());
+      for (size_t i = 0; i < textures.size(); i++) {
+        if (textures[i].PixelSize)
+          writeAt(textures[i].PixelOffset, mesh.m_TextureSources[i].Pixels, textures[i].PixelSize);
+      }
+      if (!stream) {
+        OX_CORE_WARN("Couldn't write cooked mesh file {}", cookedPath.string());
+        stream.close();
+        std::filesystem::remove(tempPath, error);
+        return false;
+      }
+    }
+    std::filesystem::rename(tempPath, cookedPath, error);
+    if (error) {
+      std::filesystem::remove(tempPath, error);
+      return false;
+    }
+    return true;
+  }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+
+namespace Oxylus {
+  class Mesh;
+
+  /**
+   * \brief Cooked binary copy of mesh files, written the first time a mesh file is loaded.
+   * It holds the baked vertices and indices, the node hierarchy, primitive bounds, materials and embedded texture pixels.
+   * Later loads map the cooked file and upload straight from the mapping instead of parsing the source file again.
+   * Cooked files are rewritten once the source file, the loading flags, the scale or the version changed.
+   */
+  class MeshCache {
+  public:
+    //Bumped whenever the layout of cooked files or of VertexFormat changes.
+    static constexpr uint32_t VERSION = 2;
+
+    //Where cooked files are written, a temporary directory by default. Set it before loading any mesh.
+    static void SetDirectory(const std::filesystem::path& directory) { s_Directory = directory; }
+    //Meshes loaded with different flags are cooked into separate files.
+    static std::filesystem::path GetCookedPath(const std::string& sourcePath, uint32_t loadingFlags);
+
+    //Fills the mesh from its cooked file if there is an up to date one. Thread safe.
+    static bool Load(Mesh& mesh, const std::string& sourcePath, uint32_t loadingFlags, float scale);
+    //Cooks the data LoadData parsed before CreateResources released it. Thread safe.
+    static bool Write(const Mesh& mesh, const std::string& sourcePath, uint32_t loadingFlags, float scale);
+
+  private:
+    static std::filesystem::path s_Directory;
+  };
+}
@@ -302,10 +302,7 @@ namespace Oxylus {
     pipelineDescription.DepthSpec.DepthEnable = false;
     pipelineDescription.DepthSpec.DepthWriteEnable = false;
     pipelineDescription.DepthSpec.CompareOp = vk::CompareOp::eNever;
-    pipelineDescription.VertexInputState.bindingDescriptions = {
-      {0, vertexLayout.stride(), vk::VertexInputRate::eVertex},
-    };
-    pipelineDescription.VertexInputState.attributeDescriptions = {{0, 0, vk::Format::eR32G32B32Sfloat, 0},};
+    pipelineDescription.VertexInputState = VertexInputDescription::ForMesh(vertexLayout);
     pipeline.CreateGraphicsPipeline(pipelineDescription);
 
     // Render
@@ -373,11 +370,8 @@ namespace Oxylus {
           pipeline.BindPipeline(cmdBuf.Get());
           pipeline.BindDescriptorSets(cmdBuf.Get(), {descriptorset});
 
-          std::vector<vk::DeviceSize> offsets{0};
-
-          cmdBuf.Get().bindVertexBuffers(0, skybox.VerticiesBuffer.Get(), offsets);
-          cmdBuf.Get().bindIndexBuffer(skybox.IndiciesBuffer.Get(), 0, vk::IndexType::eUint32);
-          cmdBuf.Get().drawIndexed(skybox.IndexCount, 1, 0, 0, 0);
+          GeometryPool::Bind(cmdBuf.Get());
+          cmdBuf.Get().drawIndexed(skybox.IndexCount, 1, skybox.Geometry.FirstIndex, (int32_t)skybox.Geometry.FirstVertex, 0);
 
           cmdBuf.EndRenderPass();
 
@@ -587,10 +581,7 @@ namespace Oxylus {
     pipelineDescription.DepthSpec.DepthWriteEnable = false;
     pipelineDescription.DepthSpec.CompareOp = vk::CompareOp::eNever;
     pipelineDescription.RasterizerDesc.CullMode = vk::CullModeFlagBits::eNone;
-    pipelineDescription.VertexInputState.bindingDescriptions = {
-      {0, vertexLayout.stride(), vk::VertexInputRate::eVertex},
-    };
-    pipelineDescription.VertexInputState.attributeDescriptions = {{0, 0, vk::Format::eR32G32B32Sfloat, 0},};
+    pipelineDescription.VertexInputState = VertexInputDescription::ForMesh(vertexLayout);
     VulkanPipeline pipeline;
     pipeline.CreateGraphicsPipeline(pipelineDescription);
 
@@ -655,10 +646,8 @@ namespace Oxylus {
           cmdBuf.Get().bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline.Get());
           cmdBuf.Get().bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelinelayout, 0, descriptorset, nullptr);
 
-          std::vector<vk::DeviceSize> offsets{0};
-          cmdBuf.Get().bindVertexBuffers(0, skybox.VerticiesBuffer.Get(), offsets);
-          cmdBuf.Get().bindIndexBuffer(skybox.IndiciesBuffer.Get(), 0, vk::IndexType::eUint32);
-          cmdBuf.Get().drawIndexed(skybox.IndexCount, 1, 0, 0, 0);
+          GeometryPool::Bind(cmdBuf.Get());
+          cmdBuf.Get().drawIndexed(skybox.IndexCount, 1, skybox.Geometry.FirstIndex, (int32_t)skybox.Geometry.FirstVertex, 0);
 
           cmdBuf.Get().endRenderPass();
 
@@ -1,12 +1,17 @@
 #include "src/oxpch.h"
 #include "RenderGraph.h"
+#include "ResourcePool.h"
 #include "Utils/Log.h"
 #include "Vulkan/VulkanContext.h"
 #include "Vulkan/VulkanRenderer.h"
+#include "Vulkan/VulkanUploader.h"
 #include "Utils/Profiler.h"
 
+#include "Thread/JobSystem.h"
 #include "Vulkan/Utils/VulkanUtils.h"
 
+#include <queue>
+
 namespace Oxylus {
   const RenderGraphPass* RenderGraph::FindRenderGraphPass(const std::string& name) const {
     const RenderGraphPass* renderGraphPass = nullptr;
@@ -26,13 +31,27 @@ namespace Oxylus {
   }
 
   RenderGraphPass& RenderGraphPass::AddReadDependency(const RenderGraph& renderGraph, const std::string& passName) {
-    const auto& pass = renderGraph.FindRenderGraphPass(passName);
-    if (!pass) {
+    if (!renderGraph.FindRenderGraphPass(passName)) {
       OX_CORE_BERROR("Can't find {0} named render pass to add as dependency!", passName);
       return *this;
     }
-    m_WaitSemaphores.emplace_back(pass->m_SignalSemaphore);
-    pass->m_HasDependency = true;
+    m_Dependencies.emplace_back(passName);
+    return *this;
+  }
+
+  RenderGraphPass& RenderGraphPass::Read(const std::string& resource,
+                                         const vk::PipelineStageFlags stage,
+                                         const vk::AccessFlags access,
+                                         const vk::ImageLayout layout) {
+    m_Accesses.emplace_back(RenderGraphResourceAccess{resource, stage, access, layout, false});
+    return *this;
+  }
+
+  RenderGraphPass& RenderGraphPass::Write(const std::string& resource,
+                                          const vk::PipelineStageFlags stage,
+                                          const vk::AccessFlags access,
+                                          const vk::ImageLayout layout) {
+    m_Accesses.emplace_back(RenderGraphResourceAccess{resource, stage, access, layout, true});
     return *this;
   }
 
@@ -56,13 +75,154 @@ namespace Oxylus {
     return *this;
   }
 
-  void RenderGraphPass::Init() {
-    const auto& LogicalDevice = VulkanContext::Context.Device;
-    constexpr vk::FenceCreateInfo fenceCreateInfo{};
-    VulkanUtils::CheckResult(LogicalDevice.createFence(&fenceCreateInfo, nullptr, &m_Fence));
+  RenderGraphPass& RenderGraphPass::RecordInParallel(const bool parallel) {
+    m_RecordInParallel = parallel;
+    return *this;
+  }
+
+  void RenderGraphPass::ResetCompiledState() {
+    m_BarrierSrcStages = {};
+    m_BarrierDstStages = {};
+    m_BarrierSrcAccess = {};
+    m_BarrierDstAccess = {};
+    m_ImageTransitions.clear();
+    m_AcquireTransfers.clear();
+    m_ReleaseTransfers.clear();
+    m_WaitPasses.clear();
+    m_WaitStages.clear();
+  }
+
+  void RenderGraphPass::ForEachRenderPass(const RenderPassFunc& func) const {
+    vk::RenderPassBeginInfo beginInfo;
+    if (m_RenderArea.extent.height < 1) {
+      beginInfo.renderArea = vk::Rect2D{vk::Offset2D{}, Window::GetWindowExtent()};
+    }
+    else {
+      beginInfo.renderArea = m_RenderArea;
+    }
+    beginInfo.renderPass = Pipeline->GetRenderPass().Get();
+    beginInfo.clearValueCount = (uint32_t)ClearValues.size();
+    beginInfo.pClearValues = ClearValues.data();
+
+    for (int32_t i = 0; i < (int32_t)Framebuffers.size(); i++) {
+      beginInfo.framebuffer = Framebuffers[i]->Get();
+      func(*this, i, beginInfo);
+    }
+    for (const auto& innerPass : m_InnerPasses) {
+      beginInfo.renderPass = innerPass.Pipeline->GetRenderPass().Get();
+      for (int32_t i = 0; i < (int32_t)innerPass.Framebuffers.size(); i++) {
+        beginInfo.framebuffer = innerPass.Framebuffers[i]->Get();
+        func(innerPass, i, beginInfo);
+      }
+    }
+  }
+
+  void RenderGraphPass::Record(VulkanCommandBuffer& commandBuffer, const VulkanCommandBuffer* const*& nextSecondaryBuffer) const {
+    ZoneScoped;
+    if (m_IsComputePass) {
+      Execute(commandBuffer, 0);
+      for (const auto& innerPass : m_InnerPasses)
+        innerPass.Execute(commandBuffer, 0);
+      return;
+    }
+
+    ForEachRenderPass([&](const RenderGraphPass& owner, const int32_t framebufferIndex, const vk::RenderPassBeginInfo& beginInfo) {
+      if (nextSecondaryBuffer) {
+        commandBuffer.BeginRenderPass(beginInfo, vk::SubpassContents::eSecondaryCommandBuffers);
+        commandBuffer.Get().executeCommands((*nextSecondaryBuffer++)->Get());
+      }
+      else {
+        commandBuffer.BeginRenderPass(beginInfo);
+        owner.Execute(commandBuffer, framebufferIndex);
+      }
+      commandBuffer.EndRenderPass();
+    });
+  }
+
+  void RenderGraphPass::RecordBarriers(const RenderGraph& renderGraph, const VulkanCommandBuffer& commandBuffer) const {
+    if (!m_BarrierDstStages)
+      return;
+
+    std::vector<vk::ImageMemoryBarrier> imageBarriers;
+    imageBarriers.reserve(m_ImageTransitions.size());
+    for (const auto& transition : m_ImageTransitions) {
+      for (const auto& getImage : renderGraph.m_ImportedImages.at(transition.Resource)) {
+        const auto* image = getImage();
+        if (!image)
+          continue;
+        vk::ImageMemoryBarrier barrier{};
+        barrier.image = image->GetImage();
+        barrier.oldLayout = transition.OldLayout;
+        barrier.newLayout = transition.NewLayout != vk::ImageLayout::eUndefined ? transition.NewLayout : image->GetImageLayout();
+        barrier.srcAccessMask = transition.SrcAccess;
+        barrier.dstAccessMask = transition.DstAccess;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.subresourceRange.aspectMask = image->GetDesc().AspectFlag;
+        barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+        barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+        imageBarriers.emplace_back(barrier);
+      }
+    }
+
+    vk::MemoryBarrier memoryBarrier{};
+    memoryBarrier.srcAccessMask = m_BarrierSrcAccess;
+    memoryBarrier.dstAccessMask = m_BarrierDstAccess;
+    const bool hasMemoryBarrier = m_BarrierSrcAccess && m_BarrierDstAccess;
+
+    commandBuffer.Get().pipelineBarrier(m_BarrierSrcStages ? m_BarrierSrcStages : vk::PipelineStageFlagBits::eTopOfPipe,
+      m_BarrierDstStages,
+      {},
+      hasMemoryBarrier ? 1 : 0,
+      hasMemoryBarrier ? &memoryBarrier : nullptr,
+      0,
+      nullptr,
+      (uint32_t)imageBarriers.size(),
+      imageBarriers.data());
+  }
+
+  void RenderGraphPass::RecordOwnershipTransfers(const RenderGraph& renderGraph, const VulkanCommandBuffer& commandBuffer, const bool release) const {
+    const auto& transfers = release ? m_ReleaseTransfers : m_AcquireTransfers;
+    if (transfers.empty())
+      return;
+
+    std::vector<vk::ImageMemoryBarrier> imageBarriers;
+    vk::PipelineStageFlags stages{};
+    for (const auto& transfer : transfers) {
+      for (const auto& getImage : renderGraph.m_ImportedImages.at(transfer.Resource)) {
+        const auto* image = getImage();
+        if (!image)
+          continue;
+        //Both halves of a transfer have to use the same layouts.
+        const vk::ImageLayout layout = transfer.Layout != vk::ImageLayout::eUndefined ? transfer.Layout : image->GetImageLayout();
+        vk::ImageMemoryBarrier barrier{};
+        barrier.image = image->GetImage();
+        barrier.oldLayout = layout;
+        barrier.newLayout = layout;
+        barrier.srcAccessMask = release ? transfer.Access : vk::AccessFlags{};
+        barrier.dstAccessMask = release ? vk::AccessFlags{} : transfer.Access;
+        barrier.srcQueueFamilyIndex = transfer.SrcFamily;
+        barrier.dstQueueFamilyIndex = transfer.DstFamily;
+        barrier.subresourceRange.aspectMask = image->GetDesc().AspectFlag;
+        barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+        barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+        imageBarriers.emplace_back(barrier);
+      }
+      stages |= transfer.Stages;
+    }
+    if (imageBarriers.empty())
+      return;
 
-    constexpr vk::SemaphoreCreateInfo semaphoreCreateInfo;
-    VulkanUtils::CheckResult(LogicalDevice.createSemaphore(&semaphoreCreateInfo, nullptr, &m_SignalSemaphore));
+    //The semaphore between the queues orders the two halves, the barriers only have to cover the accesses on their own queue.
+    commandBuffer.Get().pipelineBarrier(release ? stages : vk::PipelineStageFlagBits::eTopOfPipe,
+      release ? vk::PipelineStageFlagBits::eBottomOfPipe : stages,
+      {},
+      0,
+      nullptr,
+      0,
+      nullptr,
+      (uint32_t)imageBarriers.size(),
+      imageBarriers.data());
   }
 
   RenderGraph& RenderGraph::AddRenderPass(RenderGraphPass& renderGraphPass) {
@@ -71,15 +231,20 @@ namespace Oxylus {
       return *this;
     }
     m_RenderGraphPasses.emplace(renderGraphPass.Name, renderGraphPass);
+    m_PassOrder.emplace_back(renderGraphPass.Name);
+    m_Dirty = true;
     return *this;
   }
 
   RenderGraph& RenderGraph::AddComputePass(RenderGraphPass& computePass) {
     if (FindRenderGraphPass(computePass.Name)) {
       OX_CORE_BERROR("There can't be two compute passes with the same name!");
+      return *this;
     }
     computePass.m_IsComputePass = true;
     m_RenderGraphPasses.emplace(computePass.Name, computePass);
+    m_PassOrder.emplace_back(computePass.Name);
+    m_Dirty = true;
     return *this;
   }
 
@@ -89,6 +254,8 @@ namespace Oxylus {
       return;
     }
     m_RenderGraphPasses.erase(Name);
+    std::erase(m_PassOrder, Name);
+    m_Dirty = true;
   }
 
   RenderGraph& RenderGraph::SetSwapchain(const SwapchainPass& swapchainPass) {
@@ -96,99 +263,650 @@ namespace Oxylus {
     return *this;
   }
 
-  bool RenderGraph::Update(VulkanSwapchain& swapchain, const uint32_t* currentFrame) {
+  RenderGraph& RenderGraph::SetSingleSubmit(const bool singleSubmit) {
+    m_SingleSubmit = singleSubmit;
+    return *this;
+  }
+
+  RenderGraph& RenderGraph::ImportImage(const std::string& resource, std::function<VulkanImage*()> getImage) {
+    m_ImportedImages[resource].emplace_back(std::move(getImage));
+    m_Dirty = true;
+    return *this;
+  }
+
+  RenderGraph& RenderGraph::AddTransientImage(const std::string& resource, VulkanImage* image) {
+    m_TransientImages.emplace_back(TransientImage{resource, image});
+    return ImportImage(resource, [image] { return image; });
+  }
+
+  RenderGraph& RenderGraph::AddConcurrentResource(const std::string& resource) {
+    m_ConcurrentResources.emplace(resource);
+    m_Dirty = true;
+    return *this;
+  }
+
+  RenderGraph& RenderGraph::SetOutput(const std::string& resource) {
+    m_Outputs.emplace(resource);
+    m_Dirty = true;
+    return *this;
+  }
+
+  RenderGraphQueue RenderGraph::ResolveQueue(const RenderGraphQueue queue) {
+    if (queue == RenderGraphQueue::Compute && VulkanContext::VulkanQueue.ComputeQueue == VulkanContext::VulkanQueue.GraphicsQueue)
+      return RenderGraphQueue::Graphics;
+    return queue;
+  }
+
+  vk::Queue RenderGraph::GetQueue(const RenderGraphQueue queue) {
+    return ResolveQueue(queue) == RenderGraphQueue::Compute ? VulkanContext::VulkanQueue.ComputeQueue : VulkanContext::VulkanQueue.GraphicsQueue;
+  }
+
+  uint32_t RenderGraph::GetQueueFamily(const RenderGraphQueue queue) {
+    return ResolveQueue(queue) == RenderGraphQueue::Compute
+             ? VulkanContext::VulkanQueue.computeQueueFamilyIndex
+             : VulkanContext::VulkanQueue.graphicsQueueFamilyIndex;
+  }
+
+  void RenderGraph::CreateQueueResources() {
     const auto& LogicalDevice = VulkanContext::GetDevice();
+    for (size_t i = 0; i < QUEUE_COUNT; i++) {
+      vk::SemaphoreTypeCreateInfo typeCreateInfo{vk::SemaphoreType::eTimeline, 0};
+      vk::SemaphoreCreateInfo semaphoreCreateInfo{};
+      semaphoreCreateInfo.pNext = &typeCreateInfo;
+      VulkanUtils::CheckResult(LogicalDevice.createSemaphore(&semaphoreCreateInfo, nullptr, &m_Timelines[i]));
+
+      vk::CommandPoolCreateInfo poolInfo;
+      poolInfo.queueFamilyIndex = GetQueueFamily((RenderGraphQueue)i);
+      poolInfo.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
+      m_CommandPools[i] = LogicalDevice.createCommandPool(poolInfo).value;
+    }
+  }
 
-    static bool isFirstPass = true;
+  std::unordered_map<std::string, std::vector<std::string>> RenderGraph::PlanTransientMemory() {
+    ZoneScoped;
+    std::unordered_map<std::string, std::vector<std::string>> aliases;
+    if (m_TransientImages.empty())
+      return aliases;
+
+    const auto passCount = (uint32_t)m_ExecutionOrder.size();
+    std::vector<TransientMemoryPlanner::Resource> resources;
+    resources.reserve(m_TransientImages.size());
+    bool lost = false;
+    for (const auto& transient : m_TransientImages) {
+      const auto& name = transient.Resource;
+      TransientMemoryPlanner::Resource resource;
+      resource.Requirements = VulkanImage::GetMemoryRequirements(transient.Image->GetDesc());
+      resource.FirstUse = UINT32_MAX;
+      RenderGraphQueue queue = RenderGraphQueue::Graphics;
+      bool readFirst = false;
+      bool mixedQueues = false;
+      for (uint32_t i = 0; i < passCount; i++) {
+        const auto& accesses = m_ExecutionOrder[i]->m_Accesses;
+        const auto access = std::find_if(accesses.begin(), accesses.end(), [&name](const auto& a) { return a.Resource == name; });
+        if (access == accesses.end())
+          continue;
+        const RenderGraphQueue passQueue = ResolveQueue(m_ExecutionOrder[i]->Queue);
+        if (resource.FirstUse == UINT32_MAX) {
+          resource.FirstUse = i;
+          queue = passQueue;
+          readFirst = !access->IsWrite;
+        }
+        mixedQueues |= passQueue != queue;
+        resource.LastUse = i;
+      }
+      //Passes on different queues aren't ordered by position, such resources and the ones that have to keep their contents
+      //into the next frame or past the graph hold their memory for the whole frame.
+      if (resource.IsUsed() && (readFirst || mixedQueues || m_Outputs.contains(name))) {
+        resource.FirstUse = 0;
+        resource.LastUse = passCount - 1;
+      }
+      resource.Group = (uint32_t)queue;
+      resources.emplace_back(resource);
+      lost |= !transient.Image->IsAliased();
+    }
 
-    VulkanUtils::CheckResult(LogicalDevice.waitForFences(1, &swapchain.InFlightFences[*currentFrame], true,UINT64_MAX));
-    VulkanUtils::CheckResult(LogicalDevice.resetFences(1, &swapchain.InFlightFences[*currentFrame]));
+    auto plan = TransientMemoryPlanner::Build(resources);
+    if (lost || plan.Blocks != m_TransientPlan.Blocks || plan.Placements != m_TransientPlan.Placements) {
+      AllocateTransientMemory(plan);
+      OX_CORE_INFO("Render graph transient images: {:.2f} MB in {} blocks, aliasing saved {:.2f} MB",
+        (double)plan.AllocatedSize / 1024.0 / 1024.0,
+        plan.Blocks.size(),
+        (double)(plan.RequiredSize - plan.AllocatedSize) / 1024.0 / 1024.0);
+    }
 
-    if (swapchain.Resizing || !swapchain.AcquireNextImage() && !isFirstPass) {
-      while (Window::IsMinimized()) {
-        Window::WaitForEvents();
+    for (size_t i = 0; i < m_TransientImages.size(); i++) {
+      for (const uint32_t alias : plan.Aliases[i]) {
+        if (m_TransientImages[alias].Resource != m_TransientImages[i].Resource)
+          aliases[m_TransientImages[i].Resource].emplace_back(m_TransientImages[alias].Resource);
       }
-      VulkanRenderer::ResizeBuffers();
-      return false;
     }
 
-    for (auto& [name, renderPass] : m_RenderGraphPasses) {
-      if (renderPass.m_RunCondition != nullptr && !renderPass.m_RunCondition)
-        continue;
-      ZoneScoped;
-      //Render pass
-      if (!isFirstPass) {
-        VulkanUtils::CheckResult(LogicalDevice.waitForFences(1, &renderPass.m_Fence, true, UINT64_MAX));
-        VulkanUtils::CheckResult(LogicalDevice.resetFences(1, &renderPass.m_Fence));
-      }
-      const auto& commandBuffer = renderPass.CommandBuffers[0];
-      OX_CORE_ASSERT(commandBuffer)
-      commandBuffer->Begin({vk::CommandBufferUsageFlagBits::eSimultaneousUse});
-      if (!renderPass.m_IsComputePass) {
-        vk::RenderPassBeginInfo beginInfo;
-        if (renderPass.m_RenderArea.extent.height < 1) {
-          beginInfo.renderArea = vk::Rect2D{vk::Offset2D{}, Window::GetWindowExtent()};
+    m_TransientStats = TransientMemoryStats{plan.RequiredSize, plan.AllocatedSize, (uint32_t)m_TransientImages.size(), (uint32_t)plan.Blocks.size()};
+    m_TransientPlan = std::move(plan);
+    return aliases;
+  }
+
+  void RenderGraph::AllocateTransientMemory(const TransientMemoryPlanner::Plan& plan) {
+    ZoneScoped;
+    //The images are destroyed below, nothing in flight may still use them.
+    VulkanRenderer::WaitDeviceIdle();
+
+    const auto& allocator = VulkanContext::GetAllocator();
+    std::vector<VmaAllocation> blocks(plan.Blocks.size());
+    for (size_t i = 0; i < plan.Blocks.size(); i++) {
+      const VkMemoryRequirements requirements = plan.Blocks[i];
+      VmaAllocationCreateInfo allocationCreateInfo{};
+      allocationCreateInfo.preferredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+      VmaAllocationInfo allocationInfo{};
+      VulkanUtils::CheckResult(vmaAllocateMemory(allocator, &requirements, &allocationCreateInfo, &blocks[i], &allocationInfo));
+      GPUMemory::TotalAllocated += allocationInfo.size;
+    }
+
+    for (size_t i = 0; i < m_TransientImages.size(); i++) {
+      auto* image = m_TransientImages[i].Image;
+      const VulkanImageDescription description = image->GetDesc();
+      const auto& placement = plan.Placements[i];
+      image->Destroy();
+      image->CreateAliased(description, blocks[placement.Block], placement.Offset);
+      ImagePool::OnImageRecreated(image);
+    }
+
+    //Freed only now, images that weren't recreated yet were still bound to them.
+    for (const auto& block : m_TransientBlocks) {
+      VmaAllocationInfo allocationInfo{};
+      vmaGetAllocationInfo(allocator, block, &allocationInfo);
+      GPUMemory::TotalFreed += allocationInfo.size;
+      vmaFreeMemory(allocator, block);
+    }
+    m_TransientBlocks = std::move(blocks);
+  }
+
+  void RenderGraph::Compile(const std::vector<RenderGraphPass*>& activePasses) {
+    ZoneScoped;
+    const auto passCount = (uint32_t)activePasses.size();
+
+    //Build the dependency edges. Every write of a resource creates a new version of it,
+    //reads see the version of the last writer declared before them or the final version if none was.
+    std::vector<std::vector<uint32_t>> successors(passCount);
+    std::vector<std::vector<uint32_t>> producers(passCount); //Passes whose results are consumed, used for culling.
+    const auto addEdge = [&successors](const uint32_t from, const uint32_t to) {
+      if (from != to && std::find(successors[from].begin(), successors[from].end(), to) == successors[from].end())
+        successors[from].emplace_back(to);
+    };
+
+    std::unordered_map<std::string, std::vector<uint32_t>> writers;
+    for (uint32_t i = 0; i < passCount; i++) {
+      for (const auto& access : activePasses[i]->m_Accesses) {
+        auto& resourceWriters = writers[access.Resource];
+        if (access.IsWrite && (resourceWriters.empty() || resourceWriters.back() != i))
+          resourceWriters.emplace_back(i);
+      }
+    }
+
+    for (uint32_t i = 0; i < passCount; i++) {
+      for (const auto& access : activePasses[i]->m_Accesses) {
+        const auto& resourceWriters = writers[access.Resource];
+        if (resourceWriters.empty())
+          continue;
+        const auto nextWriter = std::lower_bound(resourceWriters.begin(), resourceWriters.end(), i);
+        if (access.IsWrite) {
+          if (nextWriter != resourceWriters.begin())
+            addEdge(*(nextWriter - 1), i);
+          continue;
         }
-        else {
-          beginInfo.renderArea = renderPass.m_RenderArea;
+        const auto producer = nextWriter == resourceWriters.begin() ? resourceWriters.end() - 1 : nextWriter - 1;
+        if (*producer == i)
+          continue;
+        addEdge(*producer, i);
+        producers[i].emplace_back(*producer);
+        //The next version can't be written before this pass has read the current one.
+        if (producer + 1 != resourceWriters.end() && *(producer + 1) != i)
+          addEdge(i, *(producer + 1));
+      }
+      for (const auto& dependency : activePasses[i]->m_Dependencies) {
+        for (uint32_t j = 0; j < passCount; j++) {
+          if (activePasses[j]->Name == dependency) {
+            addEdge(j, i);
+            producers[i].emplace_back(j);
+          }
         }
-        beginInfo.renderPass = renderPass.Pipeline->GetRenderPass().Get();
-        beginInfo.clearValueCount = (uint32_t)renderPass.ClearValues.size();
-        beginInfo.pClearValues = renderPass.ClearValues.data();
-
-        for (int32_t i = 0; i < (int32_t)renderPass.Framebuffers.size(); i++) {
-          beginInfo.framebuffer = renderPass.Framebuffers[i]->Get();
-          commandBuffer->BeginRenderPass(beginInfo);
-          renderPass.Execute(*commandBuffer, i);
-          commandBuffer->EndRenderPass();
+      }
+    }
+
+    //Cull passes that don't contribute to an output. Passes that don't declare writes have side effects we can't see, keep them.
+    std::vector<bool> alive(passCount, m_Outputs.empty());
+    if (!m_Outputs.empty()) {
+      std::vector<uint32_t> stack;
+      for (uint32_t i = 0; i < passCount; i++) {
+        const auto& accesses = activePasses[i]->m_Accesses;
+        const bool hasWrites = std::any_of(accesses.begin(), accesses.end(), [](const auto& access) { return access.IsWrite; });
+        const bool writesOutput = std::any_of(accesses.begin(), accesses.end(), [this](const auto& access) { return access.IsWrite && m_Outputs.contains(access.Resource); });
+        if (!hasWrites || writesOutput) {
+          alive[i] = true;
+          stack.emplace_back(i);
         }
-        for (const auto& innerPass : renderPass.m_InnerPasses) {
-          beginInfo.renderPass = innerPass.Pipeline->GetRenderPass().Get();
-          for (int32_t i = 0; i < (int32_t)innerPass.Framebuffers.size(); i++) {
-            beginInfo.framebuffer = innerPass.Framebuffers[i]->Get();
-            commandBuffer->BeginRenderPass(beginInfo);
-            innerPass.Execute(*commandBuffer, i);
-            commandBuffer->EndRenderPass();
+      }
+      while (!stack.empty()) {
+        const uint32_t index = stack.back();
+        stack.pop_back();
+        for (const uint32_t producer : producers[index]) {
+          if (!alive[producer]) {
+            alive[producer] = true;
+            stack.emplace_back(producer);
           }
         }
+      }
+    }
+
+    //Topological sort, ties are broken by declaration order so independent passes keep the order they were added in.
+    std::vector<uint32_t> inDegree(passCount, 0);
+    uint32_t aliveCount = 0;
+    for (uint32_t i = 0; i < passCount; i++) {
+      if (!alive[i])
+        continue;
+      aliveCount++;
+      for (const uint32_t successor : successors[i])
+        if (alive[successor])
+          inDegree[successor]++;
+    }
+
+    std::vector<uint32_t> order;
+    order.reserve(aliveCount);
+    std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<>> ready;
+    for (uint32_t i = 0; i < passCount; i++)
+      if (alive[i] && inDegree[i] == 0)
+        ready.push(i);
+    while (!ready.empty()) {
+      const uint32_t index = ready.top();
+      ready.pop();
+      order.emplace_back(index);
+      for (const uint32_t successor : successors[index])
+        if (alive[successor] && --inDegree[successor] == 0)
+          ready.push(successor);
+    }
+    if (order.size() != aliveCount) {
+      OX_CORE_BERROR("Render graph has a dependency cycle, falling back to declaration order!");
+      order.clear();
+      for (uint32_t i = 0; i < passCount; i++)
+        if (alive[i])
+          order.emplace_back(i);
+    }
 
-        TracyProfiler::Collect(commandBuffer->Get());
+    m_ExecutionOrder.clear();
+    for (const uint32_t index : order) {
+      m_ExecutionOrder.emplace_back(activePasses[index]);
+      activePasses[index]->ResetCompiledState();
+    }
 
-        commandBuffer->End();
+    //Transient resources sharing memory take it over at their first use in the frame, once the passes of the others are done with it.
+    const auto aliases = PlanTransientMemory();
+    std::unordered_map<std::string, std::pair<vk::PipelineStageFlags, vk::AccessFlags>> aliasUsage;
+    for (const auto* pass : m_ExecutionOrder) {
+      for (const auto& access : pass->m_Accesses) {
+        if (!m_ImportedImages.contains(access.Resource))
+          continue;
+        auto& [stages, writeAccess] = aliasUsage[access.Resource];
+        stages |= access.Stage;
+        if (access.IsWrite)
+          writeAccess |= access.Access;
       }
-      else {
-        renderPass.Execute(*commandBuffer, 0);
+    }
 
-        for (const auto& innerPass : renderPass.m_InnerPasses) {
-          innerPass.Execute(*commandBuffer, 0);
+    //Derive barriers by replaying the frame twice, the first replay only leaves every resource
+    //in the state the previous frame left it in so hazards across frames get covered as well.
+    struct ResourceState {
+      vk::PipelineStageFlags WriteStages{};
+      vk::AccessFlags WriteAccess{};
+      vk::PipelineStageFlags ReadStages{};
+      vk::PipelineStageFlags VisibleStages{};
+      vk::AccessFlags VisibleAccess{};
+      vk::ImageLayout Layout = vk::ImageLayout::eUndefined;
+      //Last pass that used the resource and what its queue did with it since taking it over, kept across frames.
+      RenderGraphPass* LastUser = nullptr;
+      vk::PipelineStageFlags QueueStages{};
+      vk::AccessFlags QueueWriteAccess{};
+    };
+    std::unordered_map<std::string, ResourceState> states;
+    uint32_t waitCount = 0;
+    uint32_t transferCount = 0;
+    uint32_t aliasCount = 0;
+    std::unordered_set<std::string> untransferable;
+
+    for (uint32_t replay = 0; replay < 2; replay++) {
+      const bool record = replay == 1;
+      std::unordered_set<std::string> takenOver;
+      for (auto* passPtr : m_ExecutionOrder) {
+        auto& pass = *passPtr;
+        for (const auto& access : pass.m_Accesses) {
+          auto& state = states[access.Resource];
+
+          //A resource last used on another queue is handed over: the pass waits on the timeline of the previous user
+          //and, across queue families, the image is released there and acquired here.
+          RenderGraphPass* lastUser = state.LastUser;
+          const bool crossQueue = lastUser && lastUser != &pass && ResolveQueue(lastUser->Queue) != ResolveQueue(pass.Queue);
+          if (record && crossQueue) {
+            const auto it = std::find(pass.m_WaitPasses.begin(), pass.m_WaitPasses.end(), lastUser);
+            if (it == pass.m_WaitPasses.end()) {
+              pass.m_WaitPasses.emplace_back(lastUser);
+              pass.m_WaitStages.emplace_back(access.Stage);
+              waitCount++;
+            }
+            else {
+              pass.m_WaitStages[it - pass.m_WaitPasses.begin()] |= access.Stage;
+            }
+
+            const uint32_t srcFamily = GetQueueFamily(lastUser->Queue);
+            const uint32_t dstFamily = GetQueueFamily(pass.Queue);
+            if (srcFamily != dstFamily) {
+              if (m_ImportedImages.contains(access.Resource)) {
+                lastUser->m_ReleaseTransfers.emplace_back(RenderGraphPass::OwnershipTransfer{
+                  access.Resource, state.Layout, srcFamily, dstFamily, state.QueueStages, state.QueueWriteAccess
+                });
+                pass.m_AcquireTransfers.emplace_back(RenderGraphPass::OwnershipTransfer{
+                  access.Resource, state.Layout, srcFamily, dstFamily, access.Stage, access.Access
+                });
+                transferCount++;
+              }
+              else if (!m_ConcurrentResources.contains(access.Resource) && untransferable.emplace(access.Resource).second) {
+                //Exclusive resources used by another family without a transfer have undefined contents.
+                OX_CORE_BERROR("Render graph resource {} is shared between queue families but not imported, it can't be transferred!", access.Resource);
+              }
+            }
+          }
+          if (crossQueue || !lastUser) {
+            state.QueueStages = {};
+            state.QueueWriteAccess = {};
+          }
+          state.LastUser = &pass;
+          state.QueueStages |= access.Stage;
+          if (access.IsWrite)
+            state.QueueWriteAccess |= access.Access;
+
+          const auto aliased = aliases.find(access.Resource);
+          if (aliased != aliases.end() && takenOver.emplace(access.Resource).second) {
+            //The previous contents belong to another resource, the image starts out undefined and has no hazards of its own.
+            if (record) {
+              vk::PipelineStageFlags aliasStages{};
+              vk::AccessFlags aliasAccess{};
+              for (const auto& alias : aliased->second) {
+                aliasStages |= aliasUsage[alias].first;
+                aliasAccess |= aliasUsage[alias].second;
+              }
+              pass.m_ImageTransitions.emplace_back(RenderGraphPass::ImageTransition{
+                access.Resource, vk::ImageLayout::eUndefined, access.Layout, aliasAccess, access.Access
+              });
+              pass.m_BarrierSrcStages |= aliasStages;
+              pass.m_BarrierDstStages |= access.Stage;
+              aliasCount++;
+            }
+            state.WriteStages = {};
+            state.WriteAccess = {};
+            state.ReadStages = {};
+            state.VisibleStages = {};
+            state.VisibleAccess = {};
+            state.Layout = access.Layout;
+          }
+
+          const bool transition = access.Layout != vk::ImageLayout::eUndefined && access.Layout != state.Layout
+                                  && m_ImportedImages.contains(access.Resource);
+          if (transition) {
+            if (record) {
+              pass.m_ImageTransitions.emplace_back(RenderGraphPass::ImageTransition{
+                access.Resource, state.Layout, access.Layout, crossQueue ? vk::AccessFlags{} : state.WriteAccess, access.Access
+              });
+              pass.m_BarrierSrcStages |= crossQueue ? access.Stage : state.WriteStages | state.ReadStages;
+              pass.m_BarrierDstStages |= access.Stage;
+            }
+            state.Layout = access.Layout;
+          }
+          else if (!access.IsWrite) {
+            const bool visible = (state.VisibleStages & access.Stage) == access.Stage && (state.VisibleAccess & access.Access) == access.Access;
+            if (state.WriteAccess && !visible && !crossQueue && record) {
+              pass.m_BarrierSrcStages |= state.WriteStages;
+              pass.m_BarrierSrcAccess |= state.WriteAccess;
+              pass.m_BarrierDstStages |= access.Stage;
+              pass.m_BarrierDstAccess |= access.Access;
+            }
+            state.VisibleStages |= access.Stage;
+            state.VisibleAccess |= access.Access;
+            state.ReadStages |= access.Stage;
+            continue;
+          }
+          else if (record && !crossQueue && (state.ReadStages || state.WriteAccess)) {
+            //Write after read only needs the reads to finish, write after write also has to make the previous write available.
+            pass.m_BarrierSrcStages |= state.ReadStages | state.WriteStages;
+            pass.m_BarrierSrcAccess |= state.WriteAccess;
+            pass.m_BarrierDstStages |= access.Stage;
+            pass.m_BarrierDstAccess |= state.WriteAccess ? access.Access : vk::AccessFlags{};
+          }
+
+          if (access.IsWrite) {
+            state.WriteStages = access.Stage;
+            state.WriteAccess = access.Access;
+          }
+          else {
+            state.WriteStages = access.Stage;
+            state.WriteAccess = {};
+          }
+          state.ReadStages = access.IsWrite ? vk::PipelineStageFlags{} : access.Stage;
+          state.VisibleStages = access.Stage;
+          state.VisibleAccess = access.Access;
         }
+      }
+    }
+
+    m_Dirty = false;
+    OX_CORE_TRACE("Render graph compiled: {} passes, {} culled, {} cross queue waits, {} ownership transfers, {} aliased images",
+      m_ExecutionOrder.size(),
+      passCount - aliveCount,
+      waitCount,
+      transferCount,
+      aliasCount);
+  }
+
+  bool RenderGraph::BeginFrame(VulkanSwapchain& swapchain) {
+    ZoneScoped;
+    const auto& LogicalDevice = VulkanContext::GetDevice();
 
-        TracyProfiler::Collect(commandBuffer->Get());
+    VulkanUtils::CheckResult(LogicalDevice.waitForFences(1, &swapchain.InFlightFences[swapchain.CurrentFrame], true, UINT64_MAX));
 
-        commandBuffer->End();
+    //The fence stays signaled when nothing gets submitted so the next attempt doesn't wait forever.
+    if (swapchain.Resizing || !swapchain.AcquireNextImage()) {
+      while (Window::IsMinimized()) {
+        Window::WaitForEvents();
       }
+      VulkanRenderer::ResizeBuffers();
+      return false;
+    }
+    VulkanUtils::CheckResult(LogicalDevice.resetFences(1, &swapchain.InFlightFences[swapchain.CurrentFrame]));
+
+    FrameIndex::s_Index = swapchain.CurrentFrame;
+
+    if (!m_Timelines[0])
+      CreateQueueResources();
+
+    //Per frame resources of this frame can be written once every queue is done with the graph work that read them.
+    auto& frame = m_Frames.Current();
+    {
+      ZoneScopedN("Wait for frame in flight");
+      vk::SemaphoreWaitInfo waitInfo{};
+      waitInfo.semaphoreCount = (uint32_t)QUEUE_COUNT;
+      waitInfo.pSemaphores = m_Timelines.data();
+      waitInfo.pValues = frame.SubmitValues.data();
+      VulkanUtils::CheckResult(LogicalDevice.waitSemaphores(waitInfo, UINT64_MAX));
+    }
+    for (auto& threadPool : frame.ThreadPools) {
+      if (threadPool.UsedCount == 0)
+        continue;
+      VulkanUtils::CheckResult(LogicalDevice.resetCommandPool(threadPool.Pool));
+      threadPool.UsedCount = 0;
+    }
+
+    return true;
+  }
+
+  void RenderGraph::Update() {
+    ZoneScoped;
+    std::vector<RenderGraphPass*> activePasses;
+    std::vector<bool> activeMask;
+    activePasses.reserve(m_PassOrder.size());
+    activeMask.reserve(m_PassOrder.size());
+    for (const auto& name : m_PassOrder) {
+      auto& renderPass = m_RenderGraphPasses.at(name);
+      activeMask.emplace_back(renderPass.IsActive());
+      if (renderPass.IsActive())
+        activePasses.emplace_back(&renderPass);
+    }
+    //Transient images recreated outside of the graph (e.g. on resize) lost their place in the shared memory.
+    const bool transientLost = std::any_of(m_TransientImages.begin(), m_TransientImages.end(), [](const TransientImage& transient) {
+      return !transient.Image->IsAliased();
+    });
+    if (m_Dirty || activeMask != m_CompiledActivePasses || transientLost) {
+      Compile(activePasses);
+      m_CompiledActivePasses = std::move(activeMask);
+    }
+
+    auto& frame = m_Frames.Current();
+    std::array<uint32_t, QUEUE_COUNT> runIndices{};
+    std::vector<SecondaryRecord> secondaryRecords;
+    std::vector<const VulkanCommandBuffer*> secondaryBuffers;
+
+    //Passes are recorded in runs of consecutive passes sharing a queue, every run is one command buffer and one submit.
+    std::vector<vk::Semaphore> waitSemaphores;
+    std::vector<uint64_t> waitValues;
+    std::vector<vk::PipelineStageFlags> waitStages;
+    bool uploadsAcquired = false;
+    size_t runBegin = 0;
+    while (runBegin < m_ExecutionOrder.size()) {
+      ZoneScopedN("Record and submit");
+      const RenderGraphQueue queue = ResolveQueue(m_ExecutionOrder[runBegin]->Queue);
+      const auto queueIndex = (size_t)queue;
+      size_t runEnd = runBegin + 1;
+      if (m_SingleSubmit) {
+        while (runEnd < m_ExecutionOrder.size() && ResolveQueue(m_ExecutionOrder[runEnd]->Queue) == queue)
+          runEnd++;
+      }
+
+      //Render passes of parallel passes are recorded into secondary buffers up front, the primary only executes them.
+      secondaryRecords.clear();
+      for (size_t i = runBegin; i < runEnd; i++) {
+        const auto& renderPass = *m_ExecutionOrder[i];
+        if (!renderPass.m_RecordInParallel || renderPass.m_IsComputePass)
+          continue;
+        renderPass.ForEachRenderPass([&](const RenderGraphPass& owner, const int32_t framebufferIndex, const vk::RenderPassBeginInfo& beginInfo) {
+          secondaryRecords.emplace_back(SecondaryRecord{&owner, framebufferIndex, beginInfo});
+        });
+      }
+      RecordSecondaryBuffers(secondaryRecords, secondaryBuffers);
+      const VulkanCommandBuffer* const* nextSecondaryBuffer = secondaryBuffers.data();
+
+      auto& commandBuffers = frame.CommandBuffers[queueIndex];
+      auto& runIndex = runIndices[queueIndex];
+      if (runIndex == commandBuffers.size())
+        commandBuffers.emplace_back().CreateBuffer(vk::CommandBufferLevel::ePrimary, m_CommandPools[queueIndex]);
+      auto* commandBuffer = &commandBuffers[runIndex++];
+      commandBuffer->Begin({vk::CommandBufferUsageFlagBits::eSimultaneousUse});
+      //Secondary buffers are only recorded for graphics passes, the job threads keep using the graphics context.
+      TracyProfiler::SetRecordingCompute(queue == RenderGraphQueue::Compute);
+      waitSemaphores.clear();
+      waitValues.clear();
+      waitStages.clear();
+      //Streamed data that arrived since the last frame is taken over from the transfer queue before the first graphics pass.
+      if (queue == RenderGraphQueue::Graphics && !uploadsAcquired) {
+        uploadsAcquired = true;
+        const uint64_t uploadValue = VulkanUploader::AcquireCompleted(*commandBuffer);
+        if (uploadValue != 0) {
+          waitSemaphores.emplace_back(VulkanUploader::GetTimeline());
+          waitValues.emplace_back(uploadValue);
+          waitStages.emplace_back(vk::PipelineStageFlagBits::eAllCommands);
+        }
+      }
+      for (size_t i = runBegin; i < runEnd; i++) {
+        const auto& renderPass = *m_ExecutionOrder[i];
+        renderPass.RecordOwnershipTransfers(*this, *commandBuffer, false);
+        renderPass.RecordBarriers(*this, *commandBuffer);
+        const VulkanCommandBuffer* const* inlineRecording = nullptr;
+        const bool parallel = renderPass.m_RecordInParallel && !renderPass.m_IsComputePass;
+        renderPass.Record(*commandBuffer, parallel ? nextSecondaryBuffer : inlineRecording);
+        renderPass.RecordOwnershipTransfers(*this, *commandBuffer, true);
+        //Passes later in the order haven't run yet this frame, waiting on them waits for the previous frame.
+        for (size_t wait = 0; wait < renderPass.m_WaitPasses.size(); wait++) {
+          waitSemaphores.emplace_back(m_Timelines[(size_t)ResolveQueue(renderPass.m_WaitPasses[wait]->Queue)]);
+          waitValues.emplace_back(renderPass.m_WaitPasses[wait]->m_SubmitValue);
+          waitStages.emplace_back(renderPass.m_WaitStages[wait]);
+        }
+      }
+      TracyProfiler::Collect(commandBuffer->Get());
+      TracyProfiler::SetRecordingCompute(false);
+      commandBuffer->End();
+
+      const uint64_t signalValue = ++m_TimelineValues[queueIndex];
+      vk::TimelineSemaphoreSubmitInfo timelineInfo{};
+      timelineInfo.waitSemaphoreValueCount = (uint32_t)waitValues.size();
+      timelineInfo.pWaitSemaphoreValues = waitValues.data();
+      timelineInfo.signalSemaphoreValueCount = 1;
+      timelineInfo.pSignalSemaphoreValues = &signalValue;
 
       //Submit
       vk::SubmitInfo submitInfo = {};
+      submitInfo.pNext = &timelineInfo;
       submitInfo.commandBufferCount = 1;
       submitInfo.pCommandBuffers = &commandBuffer->Get();
-      if (renderPass.m_HasDependency) {
-        submitInfo.signalSemaphoreCount = 1;
-        submitInfo.pSignalSemaphores = &renderPass.m_SignalSemaphore;
-      }
-      submitInfo.waitSemaphoreCount = (uint32_t)renderPass.m_WaitSemaphores.size();
-      const std::vector<vk::PipelineStageFlags> stageColorFlag = {vk::PipelineStageFlagBits::eColorAttachmentOutput};
-
-      if (!renderPass.m_WaitSemaphores.empty()) {
-        submitInfo.pWaitSemaphores = renderPass.m_WaitSemaphores.data();
-        submitInfo.pWaitDstStageMask = stageColorFlag.data();
+      submitInfo.signalSemaphoreCount = 1;
+      submitInfo.pSignalSemaphores = &m_Timelines[queueIndex];
+      submitInfo.waitSemaphoreCount = (uint32_t)waitSemaphores.size();
+      submitInfo.pWaitSemaphores = waitSemaphores.data();
+      submitInfo.pWaitDstStageMask = waitStages.data();
+      {
+        std::lock_guard lock(VulkanContext::VulkanQueue.SubmitMutex);
+        VulkanUtils::CheckResult(GetQueue(queue).submit(1, &submitInfo, vk::Fence{}));
       }
 
-      VulkanUtils::CheckResult(renderPass.SubmitQueue->submit(1, &submitInfo, renderPass.m_Fence));
+      for (size_t i = runBegin; i < runEnd; i++)
+        m_ExecutionOrder[i]->m_SubmitValue = signalValue;
+      frame.SubmitValues[queueIndex] = signalValue;
+      runBegin = runEnd;
     }
+  }
 
-    isFirstPass = false;
+  void RenderGraph::RecordSecondaryBuffers(const std::vector<SecondaryRecord>& records, std::vector<const VulkanCommandBuffer*>& secondaryBuffers) {
+    secondaryBuffers.resize(records.size());
+    if (records.empty())
+      return;
+    ZoneScoped;
+
+    auto& frame = m_Frames.Current();
+    if (frame.ThreadPools.size() < JobSystem::GetConcurrency()) {
+      vk::CommandPoolCreateInfo poolInfo;
+      poolInfo.queueFamilyIndex = VulkanContext::VulkanQueue.graphicsQueueFamilyIndex;
+      poolInfo.flags = vk::CommandPoolCreateFlagBits::eTransient;
+      frame.ThreadPools.resize(JobSystem::GetConcurrency());
+      for (auto& threadPool : frame.ThreadPools) {
+        if (!threadPool.Pool)
+          threadPool.Pool = VulkanContext::GetDevice().createCommandPool(poolInfo).value;
+      }
+    }
 
-    return true;
+    //One record per chunk, a cascade or a pass is already enough work to be worth a job.
+    JobSystem::ParallelFor((uint32_t)records.size(),
+      JobSystem::GetChunkCount((uint32_t)records.size(), 1),
+      [&](uint32_t, const uint32_t begin, const uint32_t end) {
+        auto& threadPool = frame.ThreadPools[JobSystem::GetThreadIndex()];
+        for (uint32_t i = begin; i < end; i++) {
+          const auto& record = records[i];
+          if (threadPool.UsedCount == threadPool.SecondaryBuffers.size())
+            threadPool.SecondaryBuffers.emplace_back().CreateBuffer(vk::CommandBufferLevel::eSecondary, threadPool.Pool);
+          auto& commandBuffer = threadPool.SecondaryBuffers[threadPool.UsedCount++];
+
+          vk::CommandBufferInheritanceInfo inheritanceInfo;
+          inheritanceInfo.renderPass = record.BeginInfo.renderPass;
+          inheritanceInfo.subpass = 0;
+          inheritanceInfo.framebuffer = record.BeginInfo.framebuffer;
+          commandBuffer.Begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit | vk::CommandBufferUsageFlagBits::eRenderPassContinue, &inheritanceInfo});
+          record.Owner->Execute(commandBuffer, record.FramebufferIndex);
+          commandBuffer.End();
+          secondaryBuffers[i] = &commandBuffer;
+        }
+      });
   }
 }
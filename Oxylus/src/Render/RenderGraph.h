@@ -1,7 +1,9 @@
 #pragma once
+#include "TransientMemoryPlanner.h"
 #include "Vulkan/VulkanCommandBuffer.h"
 #include "Vulkan/VulkanDescriptorSet.h"
 #include "Vulkan/VulkanFramebuffer.h"
+#include "Vulkan/PerFrame.h"
 #include "Vulkan/VulkanPipeline.h"
 #include "Vulkan/VulkanSwapchain.h"
 #include "Vulkan/Utils/PipelineStats.h"
@@ -13,48 +15,126 @@ namespace Oxylus {
     VulkanDescriptorSet* Desc;
   };
 
+  /**
+   * \brief Queue class a pass is submitted on. Compute passes on their own queue overlap with graphics work,
+   * devices without a spare queue run them on the graphics queue.
+   */
+  enum class RenderGraphQueue {
+    Graphics = 0,
+    Compute,
+    Count
+  };
+
+  /**
+   * \brief A resource use declared by a pass. Resources are identified by name so the graph doesn't have to own them.
+   * Layout is only transitioned by the graph when it is not undefined and the image was imported with RenderGraph::ImportImage,
+   * otherwise the pass (or its render pass) is expected to manage it.
+   */
+  struct RenderGraphResourceAccess {
+    std::string Resource;
+    vk::PipelineStageFlags Stage;
+    vk::AccessFlags Access;
+    vk::ImageLayout Layout = vk::ImageLayout::eUndefined;
+    bool IsWrite = false;
+  };
+
   struct RenderGraphPass {
     std::string Name;
-    std::vector<VulkanCommandBuffer*> CommandBuffers;
     std::vector<VulkanFramebuffer*> Framebuffers;
     std::function<void(VulkanCommandBuffer& commandBuffer, int32_t framebufferIndex)> Execute;
     std::array<vk::ClearValue, 2> ClearValues;
-    vk::Queue* SubmitQueue;
+    RenderGraphQueue Queue;
     VulkanPipeline* Pipeline;
 
     RenderGraphPass(std::string name,
-                    std::vector<VulkanCommandBuffer*> commandBuffers,
                     VulkanPipeline* pipeline,
                     std::vector<VulkanFramebuffer*> framebuffers,
                     std::function<void(VulkanCommandBuffer& commandBuffer, int32_t framebufferIndex)> execute,
                     std::array<vk::ClearValue, 2> clearValues = {},
-                    vk::Queue* submitQueue = {}) : Name(std::move(name)), CommandBuffers(std::move(commandBuffers)),
-                                                   Framebuffers(std::move(framebuffers)), Execute(std::move(execute)),
-                                                   ClearValues(clearValues), SubmitQueue(submitQueue),
-                                                   Pipeline(pipeline) {
-      Init();
-    }
+                    RenderGraphQueue queue = RenderGraphQueue::Graphics) : Name(std::move(name)),
+                                                                           Framebuffers(std::move(framebuffers)), Execute(std::move(execute)),
+                                                                           ClearValues(clearValues), Queue(queue),
+                                                                           Pipeline(pipeline) { }
 
     ~RenderGraphPass() = default;
 
     RenderGraphPass& AddInnerPass(const RenderGraphPass& innerPass);
+    //Explicit ordering for dependencies that can't be expressed with Read/Write.
     RenderGraphPass& AddReadDependency(const RenderGraph& renderGraph, const std::string& passName);
+    RenderGraphPass& Read(const std::string& resource,
+                          vk::PipelineStageFlags stage,
+                          vk::AccessFlags access = vk::AccessFlagBits::eShaderRead,
+                          vk::ImageLayout layout = vk::ImageLayout::eUndefined);
+    RenderGraphPass& Write(const std::string& resource,
+                           vk::PipelineStageFlags stage,
+                           vk::AccessFlags access = vk::AccessFlagBits::eShaderWrite,
+                           vk::ImageLayout layout = vk::ImageLayout::eUndefined);
     RenderGraphPass& SetRenderArea(const vk::Rect2D& renderArea);
     RenderGraphPass& AddToGraph(RenderGraph& renderGraph);
     RenderGraphPass& AddToGraphCompute(RenderGraph& renderGraph);
     RenderGraphPass& RunWithCondition(bool& condition);
+    /**
+     * \brief Records every framebuffer of the pass (and its inner passes) into its own secondary command buffer on the job system.
+     * Execute has to be safe to call from several threads at once.
+     */
+    RenderGraphPass& RecordInParallel(bool parallel = true);
 
   private:
-    void Init();
+    struct ImageTransition {
+      std::string Resource;
+      vk::ImageLayout OldLayout;
+      //Undefined keeps the layout the image rests in between passes.
+      vk::ImageLayout NewLayout;
+      vk::AccessFlags SrcAccess;
+      vk::AccessFlags DstAccess;
+    };
+
+    //Moves an image between queue families, recorded as a release after the last use on one queue and an acquire before the first use on the other.
+    struct OwnershipTransfer {
+      std::string Resource;
+      //Undefined keeps the layout the image rests in between passes.
+      vk::ImageLayout Layout;
+      uint32_t SrcFamily;
+      uint32_t DstFamily;
+      vk::PipelineStageFlags Stages;
+      vk::AccessFlags Access;
+    };
+
+    using RenderPassFunc = std::function<void(const RenderGraphPass& owner, int32_t framebufferIndex, const vk::RenderPassBeginInfo& beginInfo)>;
+
+    void ResetCompiledState();
+    //Calls func for every render pass instance of the pass and its inner passes in recording order.
+    void ForEachRenderPass(const RenderPassFunc& func) const;
+    /**
+     * \brief Records the pass inline, or when nextSecondaryBuffer is set executes one already recorded
+     * secondary buffer per render pass instance and advances it past them.
+     */
+    void Record(VulkanCommandBuffer& commandBuffer, const VulkanCommandBuffer* const*& nextSecondaryBuffer) const;
+    void RecordBarriers(const RenderGraph& renderGraph, const VulkanCommandBuffer& commandBuffer) const;
+    void RecordOwnershipTransfers(const RenderGraph& renderGraph, const VulkanCommandBuffer& commandBuffer, bool release) const;
+    bool IsActive() const { return m_RunCondition == nullptr || *m_RunCondition; }
+
     std::vector<RenderGraphPass> m_InnerPasses{};
+    std::vector<RenderGraphResourceAccess> m_Accesses{};
+    std::vector<std::string> m_Dependencies{};
 
-    vk::Fence m_Fence;
-    vk::Semaphore m_SignalSemaphore{};
-    std::vector<vk::Semaphore> m_WaitSemaphores{};
+    //Derived by RenderGraph::Compile
+    vk::PipelineStageFlags m_BarrierSrcStages{};
+    vk::PipelineStageFlags m_BarrierDstStages{};
+    vk::AccessFlags m_BarrierSrcAccess{};
+    vk::AccessFlags m_BarrierDstAccess{};
+    std::vector<ImageTransition> m_ImageTransitions{};
+    std::vector<OwnershipTransfer> m_AcquireTransfers{};
+    std::vector<OwnershipTransfer> m_ReleaseTransfers{};
+    //Passes on other queues this one waits for, they might belong to the previous frame.
+    std::vector<const RenderGraphPass*> m_WaitPasses{};
+    std::vector<vk::PipelineStageFlags> m_WaitStages{};
 
+    //Timeline value signaled by the submit that last ran the pass.
+    uint64_t m_SubmitValue = 0;
     bool* m_RunCondition = nullptr;
     bool m_IsComputePass = false;
-    mutable bool m_HasDependency = false;
+    bool m_RecordInParallel = false;
 
     vk::Rect2D m_RenderArea{};
 
@@ -74,13 +154,126 @@ namespace Oxylus {
     void RemoveRenderPass(const std::string& Name);
 
     RenderGraph& SetSwapchain(const SwapchainPass& swapchainPass);
+    /**
+     * \brief Lets the graph transition the layout of an image resource and move it between queue families.
+     * The getter is called while recording so it survives resizes, importing several images under one name makes them one resource.
+     * Every exclusive image used on both queues has to be imported, Compile fails loudly on one that isn't.
+     */
+    RenderGraph& ImportImage(const std::string& resource, std::function<VulkanImage*()> getImage);
+    /**
+     * \brief Imports an image whose memory the graph owns, it is aliased with other transient images that are never alive at the same time.
+     * The image is recreated whenever the memory plan changes and its ImagePool resize callbacks run afterwards.
+     * Contents only survive into the next frame when the first pass using the image reads it.
+     */
+    RenderGraph& AddTransientImage(const std::string& resource, VulkanImage* image);
+    /**
+     * \brief Declares a resource created with concurrent sharing between the graphics and the compute queue family, e.g. a buffer.
+     * It needs no ownership transfers, passes on different queues using it are still ordered through the timelines.
+     */
+    RenderGraph& AddConcurrentResource(const std::string& resource);
+    //Marks a resource as consumed outside of the graph. Once outputs are set passes that don't contribute to one are culled.
+    RenderGraph& SetOutput(const std::string& resource);
+    /**
+     * \brief When enabled (default) consecutive passes on the same queue are recorded into one command buffer
+     * and submitted together, otherwise every pass is submitted on its own which is easier to debug.
+     */
+    RenderGraph& SetSingleSubmit(bool singleSubmit);
 
     const RenderGraphPass* FindRenderGraphPass(const std::string& name) const;
 
-    bool Update(VulkanSwapchain& swapchain, const uint32_t* currentFrame);
+    /**
+     * \brief Waits until the GPU released the next frame in flight and acquires a swapchain image for it.
+     * Returns false if the swapchain had to be recreated, nothing should be recorded for this frame then.
+     */
+    bool BeginFrame(VulkanSwapchain& swapchain);
+    //Records and submits the passes of the frame started with BeginFrame.
+    void Update();
+
+    struct TransientMemoryStats {
+      //Memory the transient images would take on their own.
+      uint64_t RequiredSize = 0;
+      uint64_t AllocatedSize = 0;
+      uint32_t ImageCount = 0;
+      uint32_t BlockCount = 0;
+    };
+    const TransientMemoryStats& GetTransientMemoryStats() const { return m_TransientStats; }
 
   private:
     std::unordered_map<std::string, RenderGraphPass> m_RenderGraphPasses;
+    //Declaration order, resources written by several passes are versioned in this order.
+    std::vector<std::string> m_PassOrder;
+    std::vector<RenderGraphPass*> m_ExecutionOrder;
+    std::vector<bool> m_CompiledActivePasses;
+    bool m_Dirty = true;
+
+    std::unordered_set<std::string> m_Outputs;
+    std::unordered_map<std::string, std::vector<std::function<VulkanImage*()>>> m_ImportedImages;
+    std::unordered_set<std::string> m_ConcurrentResources;
+    bool m_SingleSubmit = true;
+
+    struct TransientImage {
+      std::string Resource;
+      VulkanImage* Image;
+    };
+    std::vector<TransientImage> m_TransientImages;
+    std::vector<VmaAllocation> m_TransientBlocks;
+    TransientMemoryPlanner::Plan m_TransientPlan;
+    TransientMemoryStats m_TransientStats;
+
+    static constexpr size_t QUEUE_COUNT = (size_t)RenderGraphQueue::Count;
+    //One timeline per queue, every submit signals the next value.
+    std::array<vk::Semaphore, QUEUE_COUNT> m_Timelines{};
+    std::array<uint64_t, QUEUE_COUNT> m_TimelineValues{};
+    std::array<vk::CommandPool, QUEUE_COUNT> m_CommandPools{};
+
+    //Command pools are externally synchronized, every thread that records secondary buffers gets its own.
+    struct ThreadCommandPool {
+      vk::CommandPool Pool;
+      //Deque so buffers handed out earlier in the frame stay valid while more are created.
+      std::deque<VulkanCommandBuffer> SecondaryBuffers;
+      uint32_t UsedCount = 0;
+    };
+
+    struct FrameData {
+      //One per submitted run of passes and queue, created on demand.
+      std::array<std::vector<VulkanCommandBuffer>, QUEUE_COUNT> CommandBuffers;
+      //Indexed by JobSystem::GetThreadIndex, reset as a whole once the frame's fence was waited on.
+      std::vector<ThreadCommandPool> ThreadPools;
+      //Last timeline values the frame signaled, waited on before its command buffers are recorded again.
+      std::array<uint64_t, QUEUE_COUNT> SubmitValues{};
+    };
+    PerFrame<FrameData> m_Frames;
+
     SwapchainPass m_SwapchainPass;
+
+    /**
+     * \brief Orders the active passes by their resource dependencies, culls the ones that don't reach an output
+     * and derives the barriers and semaphores needed between them.
+     */
+    void Compile(const std::vector<RenderGraphPass*>& activePasses);
+    //Creates the timelines and the command pools of every queue.
+    void CreateQueueResources();
+    /**
+     * \brief Plans the memory of the transient images for the execution order and reallocates it if the plan changed.
+     * Returns the resources each transient resource shares memory with.
+     */
+    std::unordered_map<std::string, std::vector<std::string>> PlanTransientMemory();
+    //Recreates every transient image inside the blocks of the plan. Waits for the device to be idle.
+    void AllocateTransientMemory(const TransientMemoryPlanner::Plan& plan);
+
+    //Maps a queue class to the one actually used, compute falls back to graphics without a separate queue.
+    static RenderGraphQueue ResolveQueue(RenderGraphQueue queue);
+    static vk::Queue GetQueue(RenderGraphQueue queue);
+    static uint32_t GetQueueFamily(RenderGraphQueue queue);
+
+    struct SecondaryRecord {
+      const RenderGraphPass* Owner;
+      int32_t FramebufferIndex;
+      vk::RenderPassBeginInfo BeginInfo;
+    };
+    //Records the render pass instances into secondary buffers across the job system, results match the order of records.
+    void RecordSecondaryBuffers(const std::vector<SecondaryRecord>& records, std::vector<const VulkanCommandBuffer*>& secondaryBuffers);
+
+    friend RenderGraphPass;
   };
 }
@@ -47,6 +47,13 @@ namespace Oxylus {
     m_Pool.emplace_back(ImageResource{image, extent, onresize, extentMultiplier});
   }
 
+  void ImagePool::OnImageRecreated(const VulkanImage* image) {
+    for (const auto& resource : m_Pool) {
+      if (resource.Image == image && resource.OnResize)
+        resource.OnResize();
+    }
+  }
+
   void ImagePool::RemoveFromPool(const std::string_view name) {
     OX_CORE_ERROR("Not implemented");
   }
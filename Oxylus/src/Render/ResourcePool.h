@@ -21,6 +21,8 @@ namespace Oxylus {
   public:
     static void ResizeImages();
     static void AddToPool(VulkanImage* image, vk::Extent2D* extent, const std::function<void()>& onresize, uint32_t extentMultiplier = 1);
+    //Runs the resize callbacks of an image that was recreated outside of the pool.
+    static void OnImageRecreated(const VulkanImage* image);
     static void RemoveFromPool(std::string_view name);
 
   private:
@@ -0,0 +1,104 @@
+#include "src/oxpch.h"
+#include "TransientMemoryPlanner.h"
+
+#include "Utils/Profiler.h"
+
+namespace Oxylus {
+  static bool LifetimesOverlap(const TransientMemoryPlanner::Resource& a, const TransientMemoryPlanner::Resource& b) {
+    return a.IsUsed() && b.IsUsed() && a.FirstUse <= b.LastUse && b.FirstUse <= a.LastUse;
+  }
+
+  static vk::DeviceSize AlignUp(const vk::DeviceSize value, const vk::DeviceSize alignment) {
+    return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+  }
+
+  TransientMemoryPlanner::Plan TransientMemoryPlanner::Build(const std::vector<Resource>& resources) {
+    ZoneScoped;
+    const auto resourceCount = (uint32_t)resources.size();
+    Plan plan;
+    plan.Placements.resize(resourceCount);
+    plan.Aliases.resize(resourceCount);
+
+    //Largest first, smaller resources then fill the gaps the large ones leave while they are dead.
+    std::vector<uint32_t> order(resourceCount);
+    for (uint32_t i = 0; i < resourceCount; i++)
+      order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&resources](const uint32_t a, const uint32_t b) {
+      return resources[a].Requirements.size > resources[b].Requirements.size;
+    });
+
+    std::vector<uint32_t> blockGroups;
+    std::vector<std::vector<uint32_t>> blockResources;
+    std::vector<std::pair<vk::DeviceSize, vk::DeviceSize>> occupied;
+    for (const uint32_t index : order) {
+      const auto& resource = resources[index];
+      const auto& requirements = resource.Requirements;
+      plan.RequiredSize += requirements.size;
+
+      //Lowest offset in every compatible block where the resource doesn't overlap a live one, pick the block that grows least.
+      uint32_t bestBlock = UINT32_MAX;
+      vk::DeviceSize bestOffset = 0;
+      vk::DeviceSize bestGrowth = 0;
+      for (uint32_t block = 0; block < (uint32_t)plan.Blocks.size(); block++) {
+        if (blockGroups[block] != resource.Group || !(plan.Blocks[block].memoryTypeBits & requirements.memoryTypeBits))
+          continue;
+
+        occupied.clear();
+        for (const uint32_t other : blockResources[block]) {
+          if (LifetimesOverlap(resource, resources[other]))
+            occupied.emplace_back(plan.Placements[other].Offset, plan.Placements[other].Offset + resources[other].Requirements.size);
+        }
+        std::sort(occupied.begin(), occupied.end());
+        vk::DeviceSize offset = 0;
+        for (const auto& [begin, end] : occupied) {
+          if (AlignUp(offset, requirements.alignment) + requirements.size <= begin)
+            break;
+          offset = std::max(offset, end);
+        }
+        offset = AlignUp(offset, requirements.alignment);
+
+        const vk::DeviceSize end = offset + requirements.size;
+        const vk::DeviceSize growth = end > plan.Blocks[block].size ? end - plan.Blocks[block].size : 0;
+        if (bestBlock == UINT32_MAX || growth < bestGrowth) {
+          bestBlock = block;
+          bestOffset = offset;
+          bestGrowth = growth;
+        }
+      }
+
+      if (bestBlock == UINT32_MAX) {
+        bestBlock = (uint32_t)plan.Blocks.size();
+        plan.Blocks.emplace_back(vk::MemoryRequirements{0, requirements.alignment, requirements.memoryTypeBits});
+        blockGroups.emplace_back(resource.Group);
+        blockResources.emplace_back();
+      }
+      auto& block = plan.Blocks[bestBlock];
+      block.size = std::max(block.size, bestOffset + requirements.size);
+      block.alignment = std::max(block.alignment, requirements.alignment);
+      block.memoryTypeBits &= requirements.memoryTypeBits;
+      blockResources[bestBlock].emplace_back(index);
+      plan.Placements[index] = Placement{bestBlock, bestOffset};
+    }
+
+    for (uint32_t block = 0; block < (uint32_t)plan.Blocks.size(); block++) {
+      plan.AllocatedSize += plan.Blocks[block].size;
+      const auto& placed = blockResources[block];
+      for (size_t a = 0; a < placed.size(); a++) {
+        for (size_t b = a + 1; b < placed.size(); b++) {
+          const uint32_t first = placed[a];
+          const uint32_t second = placed[b];
+          if (!resources[first].IsUsed() || !resources[second].IsUsed())
+            continue;
+          const vk::DeviceSize firstBegin = plan.Placements[first].Offset;
+          const vk::DeviceSize secondBegin = plan.Placements[second].Offset;
+          if (firstBegin < secondBegin + resources[second].Requirements.size && secondBegin < firstBegin + resources[first].Requirements.size) {
+            plan.Aliases[first].emplace_back(second);
+            plan.Aliases[second].emplace_back(first);
+          }
+        }
+      }
+    }
+
+    return plan;
+  }
+}
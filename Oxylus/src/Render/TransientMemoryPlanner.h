@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+namespace Oxylus {
+  /**
+   * \brief Packs transient resources into as few memory blocks as possible, resources that are never alive at the same time alias.
+   * Lifetimes are inclusive ranges of pass indices in execution order. Resources of different groups never share a block,
+   * which keeps apart resources whose passes aren't ordered against each other (e.g. different queues).
+   */
+  class TransientMemoryPlanner {
+  public:
+    struct Resource {
+      vk::MemoryRequirements Requirements;
+      uint32_t Group = 0;
+      //FirstUse > LastUse marks a resource no pass uses, it may overlap anything.
+      uint32_t FirstUse = 0;
+      uint32_t LastUse = 0;
+
+      bool IsUsed() const { return FirstUse <= LastUse; }
+    };
+
+    struct Placement {
+      uint32_t Block = 0;
+      vk::DeviceSize Offset = 0;
+
+      bool operator==(const Placement& other) const = default;
+    };
+
+    struct Plan {
+      //Size, alignment and memory types every block has to be allocated with.
+      std::vector<vk::MemoryRequirements> Blocks;
+      //Indexed like the resources.
+      std::vector<Placement> Placements;
+      //Used resources sharing memory with each one, their contents are lost to each other.
+      std::vector<std::vector<uint32_t>> Aliases;
+      //Memory every resource would take on its own against what the blocks take.
+      vk::DeviceSize RequiredSize = 0;
+      vk::DeviceSize AllocatedSize = 0;
+    };
+
+    static Plan Build(const std::vector<Resource>& resources);
+  };
+}
@@ -0,0 +1,76 @@
+#include "src/oxpch.h"
+#include "VertexFormat.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include "Utils/Log.h"
+
+namespace Oxylus {
+  //Smallest second tangent component that still carries the sign once quantized.
+  static constexpr float MIN_SIGNED_SNORM16 = 1.0f / 32767.0f;
+
+  static glm::vec2 SignNotZero(const glm::vec2& value) {
+    return {value.x >= 0.0f ? 1.0f : -1.0f, value.y >= 0.0f ? 1.0f : -1.0f};
+  }
+
+  static glm::vec2 EncodeOctahedral(const glm::vec3& direction) {
+    const float length = glm::abs(direction.x) + glm::abs(direction.y) + glm::abs(direction.z);
+    //Missing normals and tangents are zero, they end up facing +Z instead of NaN.
+    if (length <= FLT_EPSILON)
+      return glm::vec2(0.0f);
+    const glm::vec3 n = direction / length;
+    if (n.z >= 0.0f)
+      return {n.x, n.y};
+    return (1.0f - glm::abs(glm::vec2(n.y, n.x))) * SignNotZero({n.x, n.y});
+  }
+
+  VertexFormat::Attribute VertexFormat::GetAttribute(const VertexComponent component) {
+    switch (component) {
+      case VertexComponent::POSITION: return {Base, vk::Format::eR32G32B32Sfloat, offsetof(BaseVertex, Position)};
+      case VertexComponent::NORMAL: return {Base, vk::Format::eR16G16Snorm, offsetof(BaseVertex, Normal)};
+      case VertexComponent::TANGENT: return {Base, vk::Format::eR16G16Snorm, offsetof(BaseVertex, Tangent)};
+      case VertexComponent::UV: return {Base, vk::Format::eR16G16Sfloat, offsetof(BaseVertex, UV)};
+      case VertexComponent::COLOR: return {Color, vk::Format::eR8G8B8A8Unorm, offsetof(ColorVertex, Color)};
+      case VertexComponent::JOINT0: return {Skin, vk::Format::eR16G16B16A16Uint, offsetof(SkinVertex, Joints)};
+      case VertexComponent::WEIGHT0: return {Skin, vk::Format::eR8G8B8A8Unorm, offsetof(SkinVertex, Weights)};
+      default: OX_CORE_ERROR("Vertex component {} isn't part of mesh vertices", (int)component);
+        return {};
+    }
+  }
+
+  uint32_t VertexFormat::GetVertexSize(const uint32_t streams) {
+    uint32_t size = 0;
+    for (uint32_t stream = 0; stream < STREAM_COUNT; stream++) {
+      if (streams & (1u << stream))
+        size += STREAM_STRIDES[stream];
+    }
+    return size;
+  }
+
+  VertexFormat::BaseVertex VertexFormat::EncodeBase(const glm::vec3& position,
+                                                    const glm::vec3& normal,
+                                                    const glm::vec2& uv,
+                                                    const glm::vec4& tangent) {
+    BaseVertex vertex;
+    vertex.Position = position;
+    vertex.Normal = glm::packSnorm2x16(EncodeOctahedral(normal));
+    //The second component is remapped to [0, 1] so its sign can hold the one of the bitangent.
+    glm::vec2 encodedTangent = EncodeOctahedral(glm::vec3(tangent));
+    encodedTangent.y = glm::max(encodedTangent.y * 0.5f + 0.5f, MIN_SIGNED_SNORM16) * (tangent.w < 0.0f ? -1.0f : 1.0f);
+    vertex.Tangent = glm::packSnorm2x16(encodedTangent);
+    vertex.UV = glm::packHalf2x16(uv);
+    return vertex;
+  }
+
+  VertexFormat::ColorVertex VertexFormat::EncodeColor(const glm::vec4& color) {
+    return ColorVertex{glm::packUnorm4x8(color)};
+  }
+
+  VertexFormat::SkinVertex VertexFormat::EncodeSkin(const glm::vec4& joints, const glm::vec4& weights) {
+    SkinVertex vertex;
+    for (int i = 0; i < 4; i++)
+      vertex.Joints[i] = (uint16_t)joints[i];
+    vertex.Weights = glm::packUnorm4x8(weights);
+    return vertex;
+  }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+namespace Oxylus {
+  enum class VertexComponent {
+    POSITION2D,
+    POSITION,
+    NORMAL,
+    COLOR,
+    UV,
+    TANGENT,
+    BITANGENT,
+    JOINT0,
+    WEIGHT0,
+  };
+
+  /**
+   * \brief Quantized vertex format of meshes in the geometry pool.
+   * Vertices are split into streams with their own vertex buffer binding. Every mesh has the base stream,
+   * colors and skinning are only stored for meshes whose files have them.
+   * Normals and tangents are octahedral snorm pairs, decoded with VertexFormat.glsl.
+   */
+  class VertexFormat {
+  public:
+    enum Stream : uint32_t {
+      Base = 0,
+      Color,
+      Skin,
+      STREAM_COUNT
+    };
+
+    enum StreamFlags : uint32_t {
+      BaseStream = 1u << Base,
+      ColorStream = 1u << Color,
+      SkinStream = 1u << Skin,
+    };
+
+    struct BaseVertex {
+      glm::vec3 Position;
+      //Octahedral snorm16 pair.
+      uint32_t Normal = 0;
+      //Octahedral snorm16 pair, the bitangent sign is folded into the second one.
+      uint32_t Tangent = 0;
+      //Half floats.
+      uint32_t UV = 0;
+    };
+
+    struct ColorVertex {
+      //Unorm8 RGBA.
+      uint32_t Color = 0;
+    };
+
+    struct SkinVertex {
+      uint16_t Joints[4] = {};
+      //Unorm8, renormalize after reading.
+      uint32_t Weights = 0;
+    };
+
+    //Where a component of mesh vertices lives, see VertexInputDescription::ForMesh.
+    struct Attribute {
+      Stream Source = Base;
+      vk::Format Format = vk::Format::eUndefined;
+      uint32_t Offset = 0;
+    };
+
+    //Binding 1 holds the per instance data of mesh draws.
+    static constexpr uint32_t STREAM_BINDINGS[STREAM_COUNT] = {0, 2, 3};
+    static constexpr uint32_t STREAM_STRIDES[STREAM_COUNT] = {sizeof(BaseVertex), sizeof(ColorVertex), sizeof(SkinVertex)};
+
+    static Attribute GetAttribute(VertexComponent component);
+    //Bytes a vertex takes over all streams in flags.
+    static uint32_t GetVertexSize(uint32_t streams);
+
+    static BaseVertex EncodeBase(const glm::vec3& position, const glm::vec3& normal, const glm::vec2& uv, const glm::vec4& tangent);
+    static ColorVertex EncodeColor(const glm::vec4& color);
+    static SkinVertex EncodeSkin(const glm::vec4& joints, const glm::vec4& weights);
+  };
+
+  static_assert(sizeof(VertexFormat::BaseVertex) == 24, "BaseVertex has to stay tightly packed");
+  static_assert(sizeof(VertexFormat::SkinVertex) == 12, "SkinVertex has to stay tightly packed");
+}
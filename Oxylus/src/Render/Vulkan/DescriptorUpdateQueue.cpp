@@ -0,0 +1,41 @@
+#include "src/oxpch.h"
+#include "DescriptorUpdateQueue.h"
+
+#include "Utils/Profiler.h"
+
+namespace Oxylus {
+  std::vector<DescriptorUpdateQueue::PendingUpdate> DescriptorUpdateQueue::s_PendingUpdates;
+
+  void DescriptorUpdateQueue::Queue(PerFrame<VulkanDescriptorSet>& sets, WriteFunc write) {
+    constexpr uint32_t allFrames = (1u << MAX_FRAMES_IN_FLIGHT) - 1;
+    for (auto& update : s_PendingUpdates) {
+      if (update.Sets == &sets) {
+        update.Write = std::move(write);
+        update.PendingFrames = allFrames;
+        return;
+      }
+    }
+    s_PendingUpdates.emplace_back(PendingUpdate{&sets, std::move(write), allFrames});
+  }
+
+  void DescriptorUpdateQueue::Flush() {
+    ZoneScoped;
+    const uint32_t frame = FrameIndex::Get();
+    const uint32_t frameBit = 1u << frame;
+    std::erase_if(s_PendingUpdates,
+      [frame, frameBit](PendingUpdate& update) {
+        if (update.PendingFrames & frameBit) {
+          auto& set = (*update.Sets)[frame];
+          if (update.Write)
+            update.Write(set);
+          set.Update();
+          update.PendingFrames &= ~frameBit;
+        }
+        return update.PendingFrames == 0;
+      });
+  }
+
+  void DescriptorUpdateQueue::Clear() {
+    s_PendingUpdates.clear();
+  }
+}
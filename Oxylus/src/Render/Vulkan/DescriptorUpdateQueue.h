@@ -0,0 +1,37 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "PerFrame.h"
+#include "VulkanDescriptorSet.h"
+
+namespace Oxylus {
+  /**
+   * \brief Defers descriptor writes of per frame sets until the frame using each copy has retired.
+   * A set bound by a frame the GPU is still executing can't be rewritten, so instead of waiting for the queue
+   * every copy is written once its frame comes around again and the CPU waited on that frame's fence anyway.
+   * Not thread safe, updates are queued from the main thread.
+   */
+  class DescriptorUpdateQueue {
+  public:
+    //Points the writes of a set at the current resources, Update is called on the set afterwards.
+    using WriteFunc = std::function<void(VulkanDescriptorSet& set)>;
+
+    //Every copy of the sets is rewritten once its frame comes around, queuing the sets again replaces their pending write.
+    static void Queue(PerFrame<VulkanDescriptorSet>& sets, WriteFunc write = nullptr);
+    //Writes the pending copies of the current frame. Called once the frame's fence was waited on, can be called again later in the frame.
+    static void Flush();
+    static void Clear();
+
+  private:
+    struct PendingUpdate {
+      PerFrame<VulkanDescriptorSet>* Sets = nullptr;
+      WriteFunc Write;
+      //One bit per frame in flight whose copy still has to be written.
+      uint32_t PendingFrames = 0;
+    };
+
+    static std::vector<PendingUpdate> s_PendingUpdates;
+  };
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace Oxylus {
+  //How many frames the CPU can record ahead of the GPU.
+  constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+
+  /**
+   * \brief Index of the frame in flight that is being recorded, set by the render graph once the GPU released it.
+   */
+  class FrameIndex {
+  public:
+    static uint32_t Get() { return s_Index; }
+
+  private:
+    static inline uint32_t s_Index = 0;
+
+    friend class RenderGraph;
+  };
+
+  /**
+   * \brief One copy of T per frame in flight.
+   * The CPU only writes the copy of the frame it is recording while the GPU can still read the others.
+   */
+  template<typename T>
+  class PerFrame {
+  public:
+    T& Current() { return m_Frames[FrameIndex::Get()]; }
+    const T& Current() const { return m_Frames[FrameIndex::Get()]; }
+
+    T& operator[](const uint32_t frame) { return m_Frames[frame]; }
+    const T& operator[](const uint32_t frame) const { return m_Frames[frame]; }
+
+    auto begin() { return m_Frames.begin(); }
+    auto end() { return m_Frames.end(); }
+    auto begin() const { return m_Frames.begin(); }
+    auto end() const { return m_Frames.end(); }
+
+  private:
+    std::array<T, MAX_FRAMES_IN_FLIGHT> m_Frames{};
+  };
+}
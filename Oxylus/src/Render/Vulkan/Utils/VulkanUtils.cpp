@@ -231,8 +231,29 @@ namespace Oxylus {
     return static_cast<uint32_t>(std::distance(queueFamilyProperties.begin(), graphicsQueueFamilyProperty));
   }
 
+  uint32_t ContextUtils::FindDedicatedComputeQueueFamilyIndex(
+    std::vector<vk::QueueFamilyProperties> const& queueFamilyProperties) {
+    const auto computeQueueFamilyProperty = std::find_if(queueFamilyProperties.begin(),
+      queueFamilyProperties.end(),
+      [](vk::QueueFamilyProperties const& qfp) {
+        return (qfp.queueFlags & vk::QueueFlagBits::eCompute) && !(qfp.queueFlags & vk::QueueFlagBits::eGraphics);
+      });
+    return static_cast<uint32_t>(std::distance(queueFamilyProperties.begin(), computeQueueFamilyProperty));
+  }
+
+  uint32_t ContextUtils::FindDedicatedTransferQueueFamilyIndex(
+    std::vector<vk::QueueFamilyProperties> const& queueFamilyProperties) {
+    const auto transferQueueFamilyProperty = std::find_if(queueFamilyProperties.begin(),
+      queueFamilyProperties.end(),
+      [](vk::QueueFamilyProperties const& qfp) {
+        return (qfp.queueFlags & vk::QueueFlagBits::eTransfer)
+               && !(qfp.queueFlags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute));
+      });
+    return static_cast<uint32_t>(std::distance(queueFamilyProperties.begin(), transferQueueFamilyProperty));
+  }
+
   vk::Device ContextUtils::CreateDevice(const vk::PhysicalDevice& physicalDevice,
-                                        uint32_t queueFamilyIndex,
+                                        const std::vector<vk::DeviceQueueCreateInfo>& queueCreateInfos,
                                         const std::vector<std::string>& extensions,
                                         const vk::PhysicalDeviceFeatures* physicalDeviceFeatures,
                                         const void* pNext) {
@@ -247,10 +268,8 @@ namespace Oxylus {
     enabledExtensions.emplace_back("VK_KHR_portability_subset");
 #endif
 
-    constexpr float queuePriority = 0.0f;
-    vk::DeviceQueueCreateInfo deviceQueueCreateInfo({}, queueFamilyIndex, 1, &queuePriority);
     const vk::DeviceCreateInfo deviceCreateInfo({},
-      deviceQueueCreateInfo,
+      queueCreateInfos,
       {},
       enabledExtensions,
       physicalDeviceFeatures,
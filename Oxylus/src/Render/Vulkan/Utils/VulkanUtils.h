@@ -72,7 +72,7 @@ namespace Oxylus {
     static std::vector<std::string> GetInstanceExtensions();
 
     static vk::Device CreateDevice(vk::PhysicalDevice const& physicalDevice,
-                                   uint32_t queueFamilyIndex,
+                                   std::vector<vk::DeviceQueueCreateInfo> const& queueCreateInfos,
                                    std::vector<std::string> const& extensions,
                                    vk::PhysicalDeviceFeatures const* physicalDeviceFeatures,
                                    void const* pNext = nullptr);
@@ -80,5 +80,9 @@ namespace Oxylus {
     static std::vector<std::string> GetDeviceExtensions() { return {VK_KHR_SWAPCHAIN_EXTENSION_NAME}; }
 
     static uint32_t FindGraphicsQueueFamilyIndex(std::vector<vk::QueueFamilyProperties> const& queueFamilyProperties);
+    //Prefers a family without graphics support so compute work can run next to graphics, returns the size of the list if there is none.
+    static uint32_t FindDedicatedComputeQueueFamilyIndex(std::vector<vk::QueueFamilyProperties> const& queueFamilyProperties);
+    //A family that only supports transfers (usually a DMA engine), returns the size of the list if there is none.
+    static uint32_t FindDedicatedTransferQueueFamilyIndex(std::vector<vk::QueueFamilyProperties> const& queueFamilyProperties);
   };
 }
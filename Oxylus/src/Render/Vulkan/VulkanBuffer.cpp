@@ -19,11 +19,18 @@ namespace Oxylus {
     vk::BufferCreateInfo bufferCI;
     bufferCI.usage = usageFlags;
     bufferCI.size = size;
+    if (QueueFamilies.size() > 1) {
+      bufferCI.sharingMode = vk::SharingMode::eConcurrent;
+      bufferCI.queueFamilyIndexCount = (uint32_t)QueueFamilies.size();
+      bufferCI.pQueueFamilyIndices = QueueFamilies.data();
+    }
 
     VmaAllocationCreateInfo allocInfo = {};
     allocInfo.usage = memoryUsageFlag;
     allocInfo.preferredFlags = (VkMemoryPropertyFlags)memoryPropertyFlags;
-    allocInfo.flags = VMA_ALLOCATION_CREATE_DONT_BIND_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+    //VMA binds the memory itself. Asking for host access on device local buffers would force them into host visible memory.
+    if (memoryPropertyFlags & vk::MemoryPropertyFlagBits::eHostVisible)
+      allocInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
     const VkBufferCreateInfo createinfo = bufferCI;
     VmaAllocationInfo allocationInfo{};
     vmaCreateBuffer(VulkanContext::GetAllocator(), &createinfo, &allocInfo, &m_Buffer, &m_Allocation, &allocationInfo);
@@ -41,8 +48,6 @@ namespace Oxylus {
     m_Descriptor.offset = 0;
     m_Descriptor.range = VK_WHOLE_SIZE;
 
-    Bind();
-
     m_Freed = false;
 
     return *this;
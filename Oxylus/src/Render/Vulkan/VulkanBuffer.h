@@ -10,6 +10,8 @@ namespace Oxylus {
   public:
     vk::DeviceSize Size = 0;
     vk::BufferUsageFlags UsageFlags = {};
+    //Set before creating to share the buffer concurrently between these queue families, exclusive when there are fewer than two.
+    std::vector<uint32_t> QueueFamilies;
 
     VulkanBuffer() = default;
     ~VulkanBuffer();
@@ -47,6 +49,8 @@ namespace Oxylus {
     }
 
     vk::Buffer Get() const { return m_Buffer; }
+    //Only valid while the buffer is mapped.
+    void* GetMapped(const vk::DeviceSize offset = 0) const { return (uint8_t*)m_Mapped + offset; }
     const vk::DescriptorBufferInfo& GetDescriptor() const { return m_Descriptor; }
     vk::DescriptorBufferInfo& GetDescriptor() { return m_Descriptor; }
 
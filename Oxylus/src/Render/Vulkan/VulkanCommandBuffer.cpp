@@ -2,12 +2,13 @@
 #include "VulkanCommandBuffer.h"
 #include "VulkanContext.h"
 #include "VulkanRenderer.h"
+#include "VulkanUploader.h"
 #include "Utils/VulkanUtils.h"
 
 namespace Oxylus {
-  void VulkanCommandBuffer::CreateBuffer(vk::CommandBufferLevel level) {
+  void VulkanCommandBuffer::CreateBuffer(vk::CommandBufferLevel level, const vk::CommandPool commandPool) {
     vk::CommandBufferAllocateInfo cmdBufAllocateInfo;
-    cmdBufAllocateInfo.commandPool = VulkanRenderer::s_RendererContext.CommandPool;
+    cmdBufAllocateInfo.commandPool = commandPool ? commandPool : VulkanRenderer::s_RendererContext.CommandPool;
     cmdBufAllocateInfo.level = level;
     cmdBufAllocateInfo.commandBufferCount = 1;
     m_Buffer = VulkanContext::GetDevice().allocateCommandBuffers(cmdBufAllocateInfo).value[0];
@@ -84,9 +85,30 @@ namespace Oxylus {
     return *this;
   }
 
-  void VulkanCommandBuffer::FlushBuffer() const {
-    VulkanUtils::CheckResult(VulkanContext::VulkanQueue.GraphicsQueue.submit(vk::SubmitInfo{0, nullptr, nullptr, 1, &m_Buffer}, vk::Fence()));
-    VulkanUtils::CheckResult(VulkanContext::VulkanQueue.GraphicsQueue.waitIdle());
+  void VulkanCommandBuffer::FlushBuffer(const uint64_t uploadValue) const {
+    const auto& LogicalDevice = VulkanContext::GetDevice();
+    const vk::Semaphore uploadTimeline = VulkanUploader::GetTimeline();
+    constexpr vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eAllCommands;
+    vk::TimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.waitSemaphoreValueCount = 1;
+    timelineInfo.pWaitSemaphoreValues = &uploadValue;
+
+    vk::SubmitInfo submitInfo{0, nullptr, nullptr, 1, &m_Buffer};
+    if (uploadValue != 0) {
+      submitInfo.pNext = &timelineInfo;
+      submitInfo.waitSemaphoreCount = 1;
+      submitInfo.pWaitSemaphores = &uploadTimeline;
+      submitInfo.pWaitDstStageMask = &waitStage;
+    }
+
+    //Only waits for this submit, frames in flight on the same queue keep going.
+    const vk::Fence fence = LogicalDevice.createFence({}).value;
+    {
+      std::lock_guard lock(VulkanContext::VulkanQueue.SubmitMutex);
+      VulkanUtils::CheckResult(VulkanContext::VulkanQueue.GraphicsQueue.submit(submitInfo, fence));
+    }
+    VulkanUtils::CheckResult(LogicalDevice.waitForFences(fence, VK_TRUE, UINT64_MAX));
+    LogicalDevice.destroyFence(fence);
   }
 
   void VulkanCommandBuffer::FreeBuffer() const {
@@ -6,7 +6,8 @@ namespace Oxylus {
   public:
     VulkanCommandBuffer() = default;
 
-    void CreateBuffer(vk::CommandBufferLevel level = vk::CommandBufferLevel::ePrimary);
+    //Allocates from the renderer's command pool unless another pool is given.
+    void CreateBuffer(vk::CommandBufferLevel level = vk::CommandBufferLevel::ePrimary, vk::CommandPool commandPool = {});
 
     const VulkanCommandBuffer& Begin(const vk::CommandBufferBeginInfo& beginInfo) const;
 
@@ -33,7 +34,8 @@ namespace Oxylus {
     VulkanCommandBuffer& SetScissor(vk::Rect2D scissor);
     const vk::CommandBuffer& Get() const { return m_Buffer; }
 
-    void FlushBuffer() const;
+    //Submits to the graphics queue and waits for it to finish. A non zero uploadValue waits for the uploader timeline to reach it first.
+    void FlushBuffer(uint64_t uploadValue = 0) const;
 
     void FreeBuffer() const;
 
@@ -37,7 +37,10 @@ namespace Oxylus {
     //Physical Device
     Context.PhysicalDevices = Context.Instance.enumeratePhysicalDevices().value;
     Context.PhysicalDevice = Context.PhysicalDevices[0];
-    Context.DeviceProperties = Context.PhysicalDevice.getProperties();
+    const auto properties = Context.PhysicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceVulkan12Properties>();
+    Context.DeviceProperties = properties.get<vk::PhysicalDeviceProperties2>().properties;
+    Context.DeviceProperties12 = properties.get<vk::PhysicalDeviceVulkan12Properties>();
+    Context.DeviceProperties12.pNext = nullptr;
 
     OX_CORE_TRACE("Vulkan renderer initialized using device: {}", Context.DeviceProperties.deviceName.data());
 
@@ -84,11 +87,66 @@ namespace Oxylus {
       OX_CORE_FATAL("Could not find a queue for graphics or present!");
     }
 
+    //Async compute: a dedicated family if there is one, otherwise a second queue of the graphics family.
+    VulkanQueue.computeQueueFamilyIndex = ContextUtils::FindDedicatedComputeQueueFamilyIndex(VulkanQueue.queueFamilyProperties);
+    uint32_t computeQueueIndex = 0;
+    if (VulkanQueue.computeQueueFamilyIndex == VulkanQueue.queueFamilyProperties.size()) {
+      VulkanQueue.computeQueueFamilyIndex = VulkanQueue.graphicsQueueFamilyIndex;
+      computeQueueIndex = VulkanQueue.queueFamilyProperties[VulkanQueue.graphicsQueueFamilyIndex].queueCount > 1 ? 1 : 0;
+    }
+
+    //Asset uploads: a transfer only family if there is one, otherwise they go through the graphics queue.
+    VulkanQueue.transferQueueFamilyIndex = ContextUtils::FindDedicatedTransferQueueFamilyIndex(VulkanQueue.queueFamilyProperties);
+    const bool dedicatedTransfer = VulkanQueue.transferQueueFamilyIndex != VulkanQueue.queueFamilyProperties.size();
+    if (!dedicatedTransfer)
+      VulkanQueue.transferQueueFamilyIndex = VulkanQueue.graphicsQueueFamilyIndex;
+
+    const std::array queuePriorities = {1.0f, 1.0f};
+    std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos;
+    if (VulkanQueue.computeQueueFamilyIndex == VulkanQueue.graphicsQueueFamilyIndex) {
+      queueCreateInfos.emplace_back(vk::DeviceQueueCreateFlags{}, VulkanQueue.graphicsQueueFamilyIndex, computeQueueIndex + 1, queuePriorities.data());
+    }
+    else {
+      queueCreateInfos.emplace_back(vk::DeviceQueueCreateFlags{}, VulkanQueue.graphicsQueueFamilyIndex, 1, queuePriorities.data());
+      queueCreateInfos.emplace_back(vk::DeviceQueueCreateFlags{}, VulkanQueue.computeQueueFamilyIndex, 1, queuePriorities.data());
+    }
+    if (dedicatedTransfer)
+      queueCreateInfos.emplace_back(vk::DeviceQueueCreateFlags{}, VulkanQueue.transferQueueFamilyIndex, 1, queuePriorities.data());
+
     Context.DeviceMemoryProperties = Context.PhysicalDevice.getMemoryProperties();
 
     // Logical Device
+    const auto supportedFeatures = Context.PhysicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+    const auto& supported12 = supportedFeatures.get<vk::PhysicalDeviceVulkan12Features>();
+
+    //Timeline semaphores synchronize render graph submits across queues.
+    vk::PhysicalDeviceVulkan12Features features12{};
+    features12.timelineSemaphore = VK_TRUE;
+    //Descriptor indexing for the bindless material set. See MaterialPool.
+    const std::pair<vk::Bool32, const char*> descriptorIndexing[] = {
+      {supported12.runtimeDescriptorArray, "runtimeDescriptorArray"},
+      {supported12.shaderSampledImageArrayNonUniformIndexing, "shaderSampledImageArrayNonUniformIndexing"},
+      {supported12.descriptorBindingPartiallyBound, "descriptorBindingPartiallyBound"},
+      {supported12.descriptorBindingSampledImageUpdateAfterBind, "descriptorBindingSampledImageUpdateAfterBind"},
+      {supported12.descriptorBindingUpdateUnusedWhilePending, "descriptorBindingUpdateUnusedWhilePending"},
+    };
+    bool hasDescriptorIndexing = true;
+    for (const auto& [supported, name] : descriptorIndexing) {
+      if (!supported) {
+        OX_CORE_FATAL("Device {} doesn't support the descriptor indexing feature {} bindless materials need", Context.DeviceProperties.deviceName.data(), name);
+        hasDescriptorIndexing = false;
+      }
+    }
+    if (!hasDescriptorIndexing)
+      std::abort();
+    features12.runtimeDescriptorArray = VK_TRUE;
+    features12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    features12.descriptorBindingPartiallyBound = VK_TRUE;
+    features12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    features12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
     vk::PhysicalDeviceVulkan13Features features{};
     features.maintenance4 = VK_TRUE;
+    features.pNext = &features12;
     Context.DeviceFeatures = Context.PhysicalDevice.getFeatures();
     //TODO: Check if device supports these
     Context.DeviceFeatures.shaderUniformBufferArrayDynamicIndexing = true;
@@ -96,7 +154,7 @@ namespace Oxylus {
     Context.DeviceFeatures.shaderStorageImageArrayDynamicIndexing = true;
     Context.DeviceFeatures.depthClamp = VK_TRUE;
     Context.Device = ContextUtils::CreateDevice(Context.PhysicalDevice,
-      VulkanQueue.graphicsQueueFamilyIndex,
+      queueCreateInfos,
       ContextUtils::GetDeviceExtensions(),
       &Context.DeviceFeatures,
       &features);
@@ -106,8 +164,9 @@ namespace Oxylus {
 
     // Get queues.
     VulkanQueue.GraphicsQueue = Context.Device.getQueue(VulkanQueue.graphicsQueueFamilyIndex, 0);
-    //VulkanQueue.ComputeQueue = Context.Device.getQueue(VulkanQueue.graphicsQueueFamilyIndex, 1);
+    VulkanQueue.ComputeQueue = Context.Device.getQueue(VulkanQueue.computeQueueFamilyIndex, computeQueueIndex);
     VulkanQueue.PresentQueue = Context.Device.getQueue(VulkanQueue.presentQueueFamilyIndex, 0);
+    VulkanQueue.TransferQueue = dedicatedTransfer ? Context.Device.getQueue(VulkanQueue.transferQueueFamilyIndex, 0) : VulkanQueue.GraphicsQueue;
 
     // VMA
     VmaAllocatorCreateInfo allocatorInfo{};
@@ -1,4 +1,5 @@
 #pragma once
+#include <mutex>
 #include <vulkan/vulkan.hpp>
 
 #include "Core/Application.h"
@@ -14,6 +15,7 @@ namespace Oxylus {
       vk::PhysicalDevice PhysicalDevice;
       vk::PhysicalDeviceFeatures DeviceFeatures;
       vk::PhysicalDeviceProperties DeviceProperties;
+      vk::PhysicalDeviceVulkan12Properties DeviceProperties12;
       vk::PhysicalDeviceMemoryProperties DeviceMemoryProperties;
       vk::Device Device;
       VmaAllocator Allocator;
@@ -24,10 +26,16 @@ namespace Oxylus {
       vk::Queue GraphicsQueue;
       vk::Queue PresentQueue;
       vk::Queue ComputeQueue;
+      vk::Queue TransferQueue;
       std::vector<vk::QueueFamilyProperties> queueFamilyProperties;
       uint32_t graphicsQueueFamilyIndex;
       uint32_t presentQueueFamilyIndex;
-      uint32_t computeQueueFamilyIndex; //TODO:
+      //Same as the graphics family and queue when the device has no queue to spare for async compute.
+      uint32_t computeQueueFamilyIndex;
+      //Same as the graphics family and queue when the device has no transfer only family.
+      uint32_t transferQueueFamilyIndex;
+      //Queues are externally synchronized and may be the same one, every submit, present and wait for idle holds it.
+      std::mutex SubmitMutex;
     };
 
     static void CreateContext(const AppSpec& spec);
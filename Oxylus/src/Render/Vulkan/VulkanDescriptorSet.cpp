@@ -8,11 +8,12 @@
 
 namespace Oxylus {
   VulkanDescriptorSet& VulkanDescriptorSet::Allocate(const std::vector<vk::DescriptorSetLayout>& layouts,
-                                                     uint32_t layoutIndex) {
+                                                     uint32_t layoutIndex,
+                                                     const vk::DescriptorPool pool) {
     const auto& LogicalDevice = VulkanContext::Context.Device;
 
     vk::DescriptorSetAllocateInfo allocateInfo;
-    allocateInfo.descriptorPool = VulkanRenderer::s_RendererContext.DescriptorPool;
+    allocateInfo.descriptorPool = pool ? pool : VulkanRenderer::s_RendererContext.DescriptorPool;
     allocateInfo.descriptorSetCount = 1;
     allocateInfo.pSetLayouts = &layouts[layoutIndex];
     VulkanUtils::CheckResult(LogicalDevice.allocateDescriptorSets(&allocateInfo, &m_DescriptorSet));
@@ -37,12 +38,8 @@ namespace Oxylus {
     return *this;
   }
 
-  void VulkanDescriptorSet::Update(bool waitForQueueIdle) const {
+  void VulkanDescriptorSet::Update() const {
     const auto& LogicalDevice = VulkanContext::Context.Device;
-
-    if (waitForQueueIdle)
-      VulkanRenderer::WaitGraphicsQueueIdle();
-
     LogicalDevice.updateDescriptorSets(WriteDescriptorSets, nullptr);
   }
 
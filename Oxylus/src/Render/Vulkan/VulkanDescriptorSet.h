@@ -14,6 +14,8 @@ namespace Oxylus {
     const vk::DescriptorImageInfo* pImageInfo = nullptr;
     const vk::DescriptorBufferInfo* pBufferInfo = nullptr;
     const vk::BufferView* pTexelBufferView = nullptr;
+    //Update after bind bindings make the layout require a pool created for them.
+    vk::DescriptorBindingFlags BindingFlags = {};
   };
 
   class VulkanDescriptorSet {
@@ -22,9 +24,11 @@ namespace Oxylus {
 
     VulkanDescriptorSet() = default;
 
-    VulkanDescriptorSet& Allocate(const std::vector<vk::DescriptorSetLayout>& layouts, uint32_t layoutIndex = 0);
+    //Allocates from the renderer pool unless a pool is given.
+    VulkanDescriptorSet& Allocate(const std::vector<vk::DescriptorSetLayout>& layouts, uint32_t layoutIndex = 0, vk::DescriptorPool pool = {});
     VulkanDescriptorSet& CreateFromPipeline(const VulkanPipeline& pipeline, uint32_t layoutIndex = 0);
-    void Update(bool waitForQueueIdle = false) const;
+    //Writes immediately, the set must not be in use by a pending frame. See DescriptorUpdateQueue.
+    void Update() const;
     void Destroy();
 
     const vk::DescriptorSet& Get() const { return m_DescriptorSet; }
@@ -0,0 +1,87 @@
+#include "src/oxpch.h"
+#include "VulkanFrameAllocator.h"
+
+#include "PerFrame.h"
+#include "VulkanContext.h"
+#include "Utils/Log.h"
+
+namespace Oxylus {
+  void VulkanFrameAllocator::Create(const vk::DeviceSize frameSize, const vk::BufferUsageFlags usage) {
+    m_Usage = usage;
+    const auto& limits = VulkanContext::Context.DeviceProperties.limits;
+    m_Alignment = 16;
+    if (usage & vk::BufferUsageFlagBits::eUniformBuffer)
+      m_Alignment = std::max(m_Alignment, limits.minUniformBufferOffsetAlignment);
+    if (usage & vk::BufferUsageFlagBits::eStorageBuffer)
+      m_Alignment = std::max(m_Alignment, limits.minStorageBufferOffsetAlignment);
+    m_FrameSize = (frameSize + m_Alignment - 1) & ~(m_Alignment - 1);
+
+    //Compute passes may run on their own queue and read the same data.
+    const auto& queues = VulkanContext::VulkanQueue;
+    m_Buffer.QueueFamilies.clear();
+    if (queues.computeQueueFamilyIndex != queues.graphicsQueueFamilyIndex)
+      m_Buffer.QueueFamilies = {queues.graphicsQueueFamilyIndex, queues.computeQueueFamilyIndex};
+    m_Buffer.CreateBuffer(usage,
+      vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+      m_FrameSize * MAX_FRAMES_IN_FLIGHT,
+      nullptr,
+      VMA_MEMORY_USAGE_AUTO_PREFER_HOST).Map();
+
+    m_FrameBegin = 0;
+    m_Head = 0;
+    m_RequestedSize = 0;
+    m_Overflowed = false;
+  }
+
+  void VulkanFrameAllocator::Destroy() {
+    m_Buffer.Destroy();
+    m_FrameSize = 0;
+  }
+
+  void VulkanFrameAllocator::BeginFrame() {
+    m_FrameBegin = m_FrameSize * FrameIndex::Get();
+    m_Head = m_FrameBegin;
+    m_RequestedSize = 0;
+  }
+
+  void VulkanFrameAllocator::Grow() {
+    const vk::DeviceSize frameSize = std::max(m_FrameSize * 2, m_RequestedSize.load());
+    OX_CORE_TRACE("Growing frame allocator from {} to {} bytes per frame", m_FrameSize, frameSize);
+    m_Buffer.Destroy();
+    Create(frameSize, m_Usage);
+  }
+
+  VulkanFrameAllocator::Allocation VulkanFrameAllocator::Allocate(const vk::DeviceSize size) {
+    const vk::DeviceSize alignedSize = (size + m_Alignment - 1) & ~(m_Alignment - 1);
+    m_RequestedSize.fetch_add(alignedSize);
+
+    //Failed allocations don't take space, smaller ones after them can still fit.
+    vk::DeviceSize offset = m_Head.load();
+    do {
+      if (offset + alignedSize > m_FrameBegin + m_FrameSize) {
+        if (!m_Overflowed.exchange(true))
+          OX_CORE_ERROR("Frame allocator ran out of space, {} bytes per frame. It grows before the next frame", m_FrameSize);
+        return {};
+      }
+    } while (!m_Head.compare_exchange_weak(offset, offset + alignedSize));
+
+    Allocation allocation;
+    allocation.Data = m_Buffer.GetMapped(offset);
+    allocation.Offset = (uint32_t)offset;
+    allocation.Size = size;
+    return allocation;
+  }
+
+  bool VulkanFrameAllocator::Push(const void* data, const vk::DeviceSize size, uint32_t& offset) {
+    const Allocation allocation = Allocate(size);
+    if (!allocation.IsValid())
+      return false;
+    memcpy(allocation.Data, data, size);
+    offset = allocation.Offset;
+    return true;
+  }
+
+  vk::DescriptorBufferInfo VulkanFrameAllocator::GetDescriptor(const vk::DeviceSize range) const {
+    return vk::DescriptorBufferInfo{m_Buffer.Get(), 0, range};
+  }
+}
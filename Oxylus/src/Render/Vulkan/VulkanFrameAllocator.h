@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <vulkan/vulkan.hpp>
+
+#include "VulkanBuffer.h"
+
+namespace Oxylus {
+  /**
+   * \brief Linear allocator over one persistently mapped buffer that is split into a region per frame in flight.
+   * Data of a frame is written into its own region while the GPU still reads the others, the region is reused
+   * once the frame came around again. Allocations are bound with dynamic offsets, descriptors point at the buffer once.
+   */
+  class VulkanFrameAllocator {
+  public:
+    struct Allocation {
+      void* Data = nullptr;
+      //From the start of the buffer, used as the dynamic offset.
+      uint32_t Offset = 0;
+      vk::DeviceSize Size = 0;
+
+      bool IsValid() const { return Data != nullptr; }
+    };
+
+    VulkanFrameAllocator() = default;
+    VulkanFrameAllocator(const VulkanFrameAllocator&) = delete;
+    VulkanFrameAllocator& operator=(const VulkanFrameAllocator&) = delete;
+
+    void Create(vk::DeviceSize frameSize, vk::BufferUsageFlags usage);
+    void Destroy();
+
+    //Starts over in the region of the current frame in flight, the GPU has to be done with it.
+    void BeginFrame();
+    //A frame ran out of space since the buffer was created, Grow should be called before the next one begins.
+    bool HasOverflowed() const { return m_Overflowed.load(); }
+    /**
+     * \brief Recreates the buffer with regions large enough for everything the last frame asked for.
+     * The GPU has to be idle, descriptors pointing at the old buffer have to be rewritten afterwards.
+     */
+    void Grow();
+
+    //Thread safe. Returns an invalid allocation if the frame ran out of space, it is grown by Grow then.
+    Allocation Allocate(vk::DeviceSize size);
+    /**
+     * \brief Copies the data into a new allocation and writes its dynamic offset.
+     * Returns false and leaves offset alone when the frame ran out of space, the binding keeps the data of the previous frame.
+     */
+    bool Push(const void* data, vk::DeviceSize size, uint32_t& offset);
+
+    template<typename T>
+    bool Push(const T& data, uint32_t& offset) {
+      return Push(&data, sizeof(T), offset);
+    }
+
+    //Descriptor of dynamic bindings, range is how much a binding sees from its dynamic offset.
+    vk::DescriptorBufferInfo GetDescriptor(vk::DeviceSize range) const;
+
+    vk::Buffer Get() const { return m_Buffer.Get(); }
+    vk::DeviceSize GetFrameSize() const { return m_FrameSize; }
+    //Bytes allocated in the current frame so far.
+    vk::DeviceSize GetUsedSize() const { return m_Head.load() - m_FrameBegin; }
+
+  private:
+    VulkanBuffer m_Buffer;
+    vk::BufferUsageFlags m_Usage;
+    vk::DeviceSize m_FrameSize = 0;
+    vk::DeviceSize m_Alignment = 1;
+    vk::DeviceSize m_FrameBegin = 0;
+    std::atomic<vk::DeviceSize> m_Head = 0;
+    //Everything asked for in the current frame including failed allocations, what a grown region has to fit.
+    std::atomic<vk::DeviceSize> m_RequestedSize = 0;
+    //Cleared by Grow, reported once.
+    std::atomic<bool> m_Overflowed = false;
+  };
+}
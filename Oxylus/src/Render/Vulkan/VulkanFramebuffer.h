@@ -37,6 +37,10 @@ namespace Oxylus {
       return m_Images;
     }
 
+    std::vector<VulkanImage>& GetImage() {
+      return m_Images;
+    }
+
     const FramebufferDescription& GetDescription() const {
       return m_FramebufferDescription;
     }
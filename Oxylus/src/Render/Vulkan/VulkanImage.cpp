@@ -2,6 +2,7 @@
 #include "VulkanImage.h"
 #include "VulkanContext.h"
 #include "VulkanRenderer.h"
+#include "VulkanUploader.h"
 #include "Utils/VulkanUtils.h"
 #include "Core/Resources.h"
 #include "Utils/Profiler.h"
@@ -43,35 +44,50 @@ namespace Oxylus {
     }
   }
 
+  //The stb flip flag is global, flipping the rows here keeps decoding safe on any thread.
+  static void FlipRows(uint8_t* pixels, const int width, const int height) {
+    const size_t rowSize = (size_t)width * 4;
+    std::vector<uint8_t> row(rowSize);
+    for (int y = 0; y < height / 2; y++) {
+      uint8_t* top = pixels + (size_t)y * rowSize;
+      uint8_t* bottom = pixels + (size_t)(height - 1 - y) * rowSize;
+      memcpy(row.data(), top, rowSize);
+      memcpy(top, bottom, rowSize);
+      memcpy(bottom, row.data(), rowSize);
+    }
+  }
+
   VulkanImage::VulkanImage(const VulkanImageDescription& imageDescription) {
     Create(imageDescription);
   }
 
-  void VulkanImage::CreateImage(const bool hasPath) {
-    if (m_ImageDescription.FlipOnLoad)
-      stbi_set_flip_vertically_on_load(true);
+  uint8_t* VulkanImage::DecodeStbFile(const std::string& path, const bool flip, int& width, int& height) {
+    ZoneScoped;
+    int channels = 4;
+    uint8_t* pixels = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+    if (pixels && flip)
+      FlipRows(pixels, width, height);
+    return pixels;
+  }
+
+  void VulkanImage::FreeStbData(const uint8_t* data) {
+    stbi_image_free((void*)data);
+  }
 
+  void VulkanImage::CreateImage(const bool hasPath) {
     if (!hasPath && !m_ImageDescription.EmbeddedStbData && !m_ImageDescription.EmbeddedKtxData) {
-      vk::ImageCreateInfo imageCreateInfo;
-      imageCreateInfo.imageType = vk::ImageType::e2D;
-      imageCreateInfo.extent = vk::Extent3D{m_ImageDescription.Width, m_ImageDescription.Height, m_ImageDescription.Depth};
-      imageCreateInfo.mipLevels = m_ImageDescription.MipLevels;
-      imageCreateInfo.format = m_ImageDescription.Format;
-      imageCreateInfo.arrayLayers = m_ImageDescription.Type == ImageType::TYPE_CUBE ? 6 : m_ImageDescription.ImageArrayLayerCount;
-      imageCreateInfo.tiling = m_ImageDescription.ImageTiling;
-      imageCreateInfo.initialLayout = vk::ImageLayout::eUndefined;
-      imageCreateInfo.usage = m_ImageDescription.UsageFlags;
-      imageCreateInfo.samples = m_ImageDescription.SampleCount;
-      imageCreateInfo.sharingMode = m_ImageDescription.SharingMode;
-      imageCreateInfo.flags = m_ImageDescription.Type == ImageType::TYPE_CUBE
-                                ? vk::ImageCreateFlagBits::eCubeCompatible
-                                : vk::ImageCreateFlags{};
-
-      const VkImageCreateInfo _imageci = (VkImageCreateInfo)imageCreateInfo;
-      VmaAllocationCreateInfo allocationCreateInfo{};
-      allocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+      const VkImageCreateInfo _imageci = (VkImageCreateInfo)GetImageCreateInfo(m_ImageDescription);
       VmaAllocationInfo allocInfo{};
-      vmaCreateImage(VulkanContext::GetAllocator(), &_imageci, &allocationCreateInfo, &m_Image, &m_Allocation, &allocInfo);
+      if (m_AliasAllocation) {
+        //The owner of the memory accounts for it.
+        VulkanUtils::CheckResult(vmaCreateAliasingImage2(VulkanContext::GetAllocator(), m_AliasAllocation, m_AliasOffset, &_imageci, &m_Image));
+        m_Allocation = nullptr;
+      }
+      else {
+        VmaAllocationCreateInfo allocationCreateInfo{};
+        allocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+        vmaCreateImage(VulkanContext::GetAllocator(), &_imageci, &allocationCreateInfo, &m_Image, &m_Allocation, &allocInfo);
+      }
       if (m_ImageDescription.TransitionLayoutAtCreate) {
         vk::ImageSubresourceRange subresourceRange;
         subresourceRange.aspectMask = m_ImageDescription.AspectFlag;
@@ -109,9 +125,6 @@ namespace Oxylus {
     DescriptorImageInfo.imageLayout = m_ImageLayout;
     DescriptorImageInfo.imageView = m_View;
     DescriptorImageInfo.sampler = m_Sampler;
-
-    if (m_ImageDescription.FlipOnLoad)
-      stbi_set_flip_vertically_on_load(false);
   }
 
   void VulkanImage::Create(const VulkanImageDescription& imageDescription) {
@@ -126,6 +139,12 @@ namespace Oxylus {
     LoadCallback = true;
   }
 
+  void VulkanImage::CreateAliased(const VulkanImageDescription& imageDescription, const VmaAllocation allocation, const vk::DeviceSize offset) {
+    m_AliasAllocation = allocation;
+    m_AliasOffset = offset;
+    Create(imageDescription);
+  }
+
   void VulkanImage::CreateWithImage(const VulkanImageDescription& imageDescription, const vk::Image image) {
     m_ImageDescription = imageDescription;
     m_Image = image;
@@ -250,6 +269,8 @@ namespace Oxylus {
     imageCreateInfo.usage = m_ImageDescription.UsageFlags;
     imageCreateInfo.samples = m_ImageDescription.SampleCount;
     imageCreateInfo.sharingMode = m_ImageDescription.SharingMode;
+    imageCreateInfo.queueFamilyIndexCount = (uint32_t)m_ImageDescription.QueueFamilies.size();
+    imageCreateInfo.pQueueFamilyIndices = m_ImageDescription.QueueFamilies.data();
 
     if (m_ImageDescription.EmbeddedStbData) {
       m_ImageData = m_ImageDescription.EmbeddedStbData;
@@ -257,15 +278,18 @@ namespace Oxylus {
 
     else {
       if (m_ImageDescription.EmbeddedData) {
-        m_ImageData = stbi_load_from_memory(m_ImageDescription.EmbeddedData,
+        uint8_t* pixels = stbi_load_from_memory(m_ImageDescription.EmbeddedData,
           (int)m_ImageDescription.EmbeddedDataLength,
           &texWidth,
           &texHeight,
           &texChannels,
           STBI_rgb_alpha);
+        if (pixels && m_ImageDescription.FlipOnLoad)
+          FlipRows(pixels, texWidth, texHeight);
+        m_ImageData = pixels;
       }
       else
-        m_ImageData = stbi_load(path.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+        m_ImageData = DecodeStbFile(path, m_ImageDescription.FlipOnLoad, texWidth, texHeight);
       if (!m_ImageData) {
         OX_CORE_BERROR("Failed to load texture file {}", path);
       }
@@ -286,22 +310,6 @@ namespace Oxylus {
 
     const int sizeMultiplier = GetDesc().Type == ImageType::TYPE_CUBE ? 6 : 1;
 
-    VulkanBuffer stagingBuffer;
-    stagingBuffer.CreateBuffer(vk::BufferUsageFlagBits::eTransferSrc,
-      vk::MemoryPropertyFlagBits::eHostVisible |
-      vk::MemoryPropertyFlagBits::eHostCoherent,
-      imageSize,
-      m_ImageData,
-      VMA_MEMORY_USAGE_AUTO_PREFER_HOST).Map();
-
-    if (m_ImageData)
-      stagingBuffer.Copy(m_ImageData, imageSize);
-    stagingBuffer.Flush();
-    stagingBuffer.Unmap();
-
-    if (!m_ImageDescription.Path.empty())
-      delete m_ImageData;
-
     const VkImageCreateInfo _imagecreateinfo = imageCreateInfo;
     VmaAllocationCreateInfo allocationInfo{};
     allocationInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
@@ -317,58 +325,22 @@ namespace Oxylus {
     subresourceRange.levelCount = 1;
     subresourceRange.layerCount = sizeMultiplier;
 
-    VulkanCommandBuffer copyCmd;
-    copyCmd.CreateBuffer();
-
-    vk::ImageMemoryBarrier imageMemoryBarrier{};
-    imageMemoryBarrier.image = m_Image;
-    imageMemoryBarrier.subresourceRange = subresourceRange;
-    imageMemoryBarrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
-    imageMemoryBarrier.oldLayout = vk::ImageLayout::eUndefined;
-    imageMemoryBarrier.newLayout = vk::ImageLayout::eTransferDstOptimal;
-
-    std::vector<vk::BufferImageCopy> bufferCopyRegions;
-    bufferCopyRegions.clear();
-
-    vk::BufferImageCopy bufferCopyRegion = {};
-    bufferCopyRegion.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
-    bufferCopyRegion.imageSubresource.layerCount = sizeMultiplier;
-    bufferCopyRegion.imageExtent.width = m_ImageDescription.Width;
-    bufferCopyRegion.imageExtent.height = m_ImageDescription.Height;
-    bufferCopyRegion.imageExtent.depth = 1;
-    bufferCopyRegions.push_back(bufferCopyRegion);
-
-    copyCmd.Begin(vk::CommandBufferBeginInfo{});
-    copyCmd.Get().pipelineBarrier(vk::PipelineStageFlagBits::eHost,
-      vk::PipelineStageFlagBits::eTransfer,
-      {},
-      nullptr,
-      nullptr,
-      imageMemoryBarrier);
-    copyCmd.Get().copyBufferToImage(stagingBuffer.Get(),
-      m_Image,
-      vk::ImageLayout::eTransferDstOptimal,
-      static_cast<uint32_t>(bufferCopyRegions.size()),
-      bufferCopyRegions.data());
-
-    imageMemoryBarrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
-    imageMemoryBarrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
-    imageMemoryBarrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
-    imageMemoryBarrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
-
-    copyCmd.Get().pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
-      vk::PipelineStageFlagBits::eFragmentShader,
-      vk::DependencyFlags{},
-      nullptr,
-      nullptr,
-      imageMemoryBarrier);
-    copyCmd.End();
-
-    VulkanRenderer::SubmitQueue(copyCmd);
-
+    //The uploader copies the pixels into its staging memory right away, they can be freed once it returns.
+    m_UploadTicket = VulkanUploader::UploadImage(m_Image,
+      subresourceRange,
+      vk::Extent3D{m_ImageDescription.Width, m_ImageDescription.Height, 1},
+      m_ImageData,
+      imageSize,
+      vk::ImageLayout::eShaderReadOnlyOptimal);
     m_ImageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
 
-    stagingBuffer.Destroy();
+    //Embedded stb data belongs to the caller.
+    if (!m_ImageDescription.EmbeddedStbData)
+      FreeStbData(m_ImageData);
+    m_ImageData = nullptr;
+
+    //Callers use the image right after loading it, only this upload is waited for instead of the whole device.
+    m_UploadTicket.Wait();
 
     timer.Stop();
     if (!m_ImageDescription.Path.empty())
@@ -461,6 +433,36 @@ namespace Oxylus {
       timer.ElapsedMilliSeconds());
   }
 
+  vk::ImageCreateInfo VulkanImage::GetImageCreateInfo(const VulkanImageDescription& imageDescription) {
+    vk::ImageCreateInfo imageCreateInfo;
+    imageCreateInfo.imageType = vk::ImageType::e2D;
+    imageCreateInfo.extent = vk::Extent3D{imageDescription.Width, imageDescription.Height, imageDescription.Depth};
+    imageCreateInfo.mipLevels = imageDescription.MipLevels;
+    imageCreateInfo.format = imageDescription.Format;
+    imageCreateInfo.arrayLayers = imageDescription.Type == ImageType::TYPE_CUBE ? 6 : imageDescription.ImageArrayLayerCount;
+    imageCreateInfo.tiling = imageDescription.ImageTiling;
+    imageCreateInfo.initialLayout = vk::ImageLayout::eUndefined;
+    imageCreateInfo.usage = imageDescription.UsageFlags;
+    imageCreateInfo.samples = imageDescription.SampleCount;
+    imageCreateInfo.sharingMode = imageDescription.SharingMode;
+    imageCreateInfo.queueFamilyIndexCount = (uint32_t)imageDescription.QueueFamilies.size();
+    imageCreateInfo.pQueueFamilyIndices = imageDescription.QueueFamilies.data();
+    imageCreateInfo.flags = imageDescription.Type == ImageType::TYPE_CUBE
+                              ? vk::ImageCreateFlagBits::eCubeCompatible
+                              : vk::ImageCreateFlags{};
+    return imageCreateInfo;
+  }
+
+  vk::MemoryRequirements VulkanImage::GetMemoryRequirements(const VulkanImageDescription& imageDescription) {
+    const auto& LogicalDevice = VulkanContext::GetDevice();
+    const vk::ImageCreateInfo imageCreateInfo = GetImageCreateInfo(imageDescription);
+    vk::Image image;
+    VulkanUtils::CheckResult(LogicalDevice.createImage(&imageCreateInfo, nullptr, &image));
+    const vk::MemoryRequirements requirements = LogicalDevice.getImageMemoryRequirements(image);
+    LogicalDevice.destroyImage(image);
+    return requirements;
+  }
+
   vk::ImageView VulkanImage::CreateImageView(const uint32_t mipmapIndex) const {
     const auto& LogicalDevice = VulkanContext::GetDevice();
 
@@ -715,6 +717,8 @@ namespace Oxylus {
     }
     vmaDestroyImage(VulkanContext::GetAllocator(), m_Image, m_Allocation);
     GPUMemory::TotalFreed += ImageSize;
+    m_AliasAllocation = nullptr;
+    m_AliasOffset = 0;
     if (m_Sampler) {
       LogicalDevice.destroySampler(m_Sampler);
     }
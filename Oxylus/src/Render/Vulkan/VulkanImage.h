@@ -3,6 +3,7 @@
 
 #include "vk_mem_alloc.h"
 #include "VulkanCommandBuffer.h"
+#include "VulkanUploader.h"
 #include "Core/Base.h"
 #include "Core/Types.h"
 
@@ -30,6 +31,8 @@ namespace Oxylus {
     vk::ImageAspectFlags AspectFlag = vk::ImageAspectFlagBits::eColor;
     vk::SampleCountFlagBits SampleCount = vk::SampleCountFlagBits::e1;
     vk::SharingMode SharingMode = vk::SharingMode::eExclusive;
+    //Families sharing the image when SharingMode is concurrent.
+    std::vector<uint32_t> QueueFamilies;
     vk::ImageLayout InitalImageLayout = vk::ImageLayout::eUndefined;
     vk::ImageLayout FinalImageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
     unsigned char* EmbeddedData = nullptr;
@@ -62,6 +65,11 @@ namespace Oxylus {
 
     void Create(const VulkanImageDescription& imageDescription);
     void CreateWithImage(const VulkanImageDescription& imageDescription, vk::Image image);
+    /**
+     * \brief Creates the image inside memory owned by someone else, several images can alias the same range.
+     * The allocation has to outlive the image, Destroy only destroys the image.
+     */
+    void CreateAliased(const VulkanImageDescription& imageDescription, VmaAllocation allocation, vk::DeviceSize offset);
 
     void SetImageLayout(vk::ImageLayout oldImageLayout,
                         vk::ImageLayout newImageLayout,
@@ -77,6 +85,9 @@ namespace Oxylus {
     const vk::DescriptorSet& GetDescriptorSet() const { return m_DescSet; }
     const vk::DescriptorImageInfo& GetDescImageInfo() const { return DescriptorImageInfo; }
     const vk::ImageLayout& GetImageLayout() const { return m_ImageLayout; }
+    bool IsAliased() const { return m_AliasAllocation != nullptr; }
+    //Upload of the pixels of images loaded with stb, empty for everything else.
+    const UploadTicket& GetUploadTicket() const { return m_UploadTicket; }
     std::vector<vk::DescriptorImageInfo> GetMipDescriptors() const;
     static VulkanImageDescription GetColorAttachmentImageDescription(vk::Format format,
                                                                      uint32_t width,
@@ -84,6 +95,11 @@ namespace Oxylus {
     static Ref<VulkanImage> GetBlankImage();
     static IVec3 GetMipMapLevelSize(uint32_t width, uint32_t height, uint32_t depth, uint32_t level);
     static uint32_t GetMaxMipmapLevel(uint32_t width, uint32_t height, uint32_t depth);
+    //Memory an image created from the description needs, only valid for descriptions without a path or embedded data.
+    static vk::MemoryRequirements GetMemoryRequirements(const VulkanImageDescription& imageDescription);
+    //Decodes the file into RGBA8 pixels, thread safe. Returns null on failure, free the pixels with FreeStbData.
+    static uint8_t* DecodeStbFile(const std::string& path, bool flip, int& width, int& height);
+    static void FreeStbData(const uint8_t* data);
 
     void Destroy();
 
@@ -95,6 +111,7 @@ namespace Oxylus {
     void CreateImage(bool hasPath);
     void LoadAndCreateResources(bool hasPath);
     vk::ImageView CreateImageView(uint32_t mipmapIndex = 0) const;
+    static vk::ImageCreateInfo GetImageCreateInfo(const VulkanImageDescription& imageDescription);
     void CreateSampler();
     void GenerateMips();
     vk::DescriptorSet CreateDescriptorSet() const;
@@ -107,5 +124,8 @@ namespace Oxylus {
     VulkanImageDescription m_ImageDescription{};
     const uint8_t* m_ImageData = nullptr;
     VmaAllocation m_Allocation{};
+    VmaAllocation m_AliasAllocation{};
+    vk::DeviceSize m_AliasOffset = 0;
+    UploadTicket m_UploadTicket;
   };
 }
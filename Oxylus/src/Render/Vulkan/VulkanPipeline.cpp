@@ -1,19 +1,153 @@
 ﻿#include "src/oxpch.h"
 #include "VulkanPipeline.h"
 
-#include <future>
-#include <type_traits>
-#include <type_traits>
-#include <type_traits>
+#include <cstring>
+#include <fstream>
 #include <type_traits>
 
 #include "Render/ShaderLibrary.h"
 #include "VulkanContext.h"
+#include "Utils/Hash.h"
+#include "Utils/Profiler.h"
 #include "Utils/VulkanUtils.h"
 
 namespace Oxylus {
   vk::PipelineCache VulkanPipeline::s_Cache;
 
+  static constexpr uint32_t PIPELINE_CACHE_MAGIC = 0x4350584F; //"OXPC"
+  static constexpr uint32_t PIPELINE_CACHE_VERSION = 1;
+
+  struct PipelineCacheHeader {
+    uint32_t Magic = PIPELINE_CACHE_MAGIC;
+    uint32_t Version = PIPELINE_CACHE_VERSION;
+    uint32_t VendorID = 0;
+    uint32_t DeviceID = 0;
+    uint32_t DriverVersion = 0;
+    uint8_t PipelineCacheUUID[VK_UUID_SIZE] = {};
+    uint64_t DataSize = 0;
+    uint64_t DataHash = 0;
+  };
+
+  static const char* GetPipelineCachePath() {
+    return "resources/cache/pipelines.bin";
+  }
+
+  static PipelineCacheHeader MakePipelineCacheHeader() {
+    const auto& properties = VulkanContext::Context.DeviceProperties;
+    PipelineCacheHeader header;
+    header.VendorID = properties.vendorID;
+    header.DeviceID = properties.deviceID;
+    header.DriverVersion = properties.driverVersion;
+    memcpy(header.PipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE);
+    return header;
+  }
+
+  //Catches truncated or corrupted files before the data reaches the driver.
+  static uint64_t HashPipelineCacheData(const std::vector<uint8_t>& data) {
+    return Hash::FNV1a(data.data(), data.size());
+  }
+
+  static std::vector<uint8_t> ReadPipelineCacheFile() {
+    std::ifstream in(GetPipelineCachePath(), std::ios::in | std::ios::binary | std::ios::ate);
+    if (!in.is_open())
+      return {};
+    const uint64_t fileSize = (uint64_t)in.tellg();
+    in.seekg(0);
+
+    PipelineCacheHeader header;
+    in.read(reinterpret_cast<char*>(&header), sizeof header);
+    const PipelineCacheHeader expected = MakePipelineCacheHeader();
+    if (!in || header.Magic != expected.Magic || header.Version != expected.Version) {
+      OX_CORE_WARN("Pipeline cache file has an unknown format, ignoring it.");
+      return {};
+    }
+    if (header.VendorID != expected.VendorID || header.DeviceID != expected.DeviceID ||
+        header.DriverVersion != expected.DriverVersion ||
+        memcmp(header.PipelineCacheUUID, expected.PipelineCacheUUID, VK_UUID_SIZE) != 0) {
+      OX_CORE_TRACE("Pipeline cache was written for a different device or driver, ignoring it.");
+      return {};
+    }
+
+    //The size comes from the file, don't trust it with an allocation before checking it against what's there.
+    if (header.DataSize != fileSize - sizeof header) {
+      OX_CORE_WARN("Pipeline cache file is truncated or has trailing data, ignoring it.");
+      return {};
+    }
+
+    std::vector<uint8_t> data(header.DataSize);
+    in.read(reinterpret_cast<char*>(data.data()), (std::streamsize)data.size());
+    if (!in || HashPipelineCacheData(data) != header.DataHash) {
+      OX_CORE_WARN("Pipeline cache file is corrupted, ignoring it.");
+      return {};
+    }
+    return data;
+  }
+
+  void VulkanPipeline::LoadPipelineCache() {
+    ZoneScoped;
+    if (s_Cache)
+      return;
+
+    const std::vector<uint8_t> data = ReadPipelineCacheFile();
+    vk::PipelineCacheCreateInfo cacheCI;
+    cacheCI.initialDataSize = data.size();
+    cacheCI.pInitialData = data.data();
+    const auto res = VulkanContext::Context.Device.createPipelineCache(cacheCI);
+    if (res.result == vk::Result::eSuccess) {
+      s_Cache = res.value;
+      if (!data.empty())
+        OX_CORE_TRACE("Loaded pipeline cache ({} bytes)", data.size());
+      return;
+    }
+
+    //The driver rejected the data, start with an empty cache.
+    cacheCI.initialDataSize = 0;
+    cacheCI.pInitialData = nullptr;
+    const auto emptyRes = VulkanContext::Context.Device.createPipelineCache(cacheCI);
+    VulkanUtils::CheckResult(emptyRes.result);
+    s_Cache = emptyRes.value;
+  }
+
+  void VulkanPipeline::SavePipelineCache() {
+    ZoneScoped;
+    if (!s_Cache)
+      return;
+
+    const auto res = VulkanContext::Context.Device.getPipelineCacheData(s_Cache);
+    if (res.result != vk::Result::eSuccess || res.value.empty())
+      return;
+
+    PipelineCacheHeader header = MakePipelineCacheHeader();
+    header.DataSize = res.value.size();
+    header.DataHash = HashPipelineCacheData(res.value);
+
+    const std::filesystem::path path = GetPipelineCachePath();
+    std::filesystem::create_directories(path.parent_path());
+    //Written next to the old file and swapped in so a crash can't leave a partial cache behind.
+    std::filesystem::path tempPath = path;
+    tempPath += ".tmp";
+    {
+      std::ofstream out(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+      if (!out.is_open()) {
+        OX_CORE_WARN("Couldn't write the pipeline cache to {}", tempPath.string());
+        return;
+      }
+      out.write(reinterpret_cast<const char*>(&header), sizeof header);
+      out.write(reinterpret_cast<const char*>(res.value.data()), (std::streamsize)res.value.size());
+    }
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error)
+      OX_CORE_WARN("Couldn't write the pipeline cache to {}: {}", path.string(), error.message());
+  }
+
+  void VulkanPipeline::DestroyPipelineCache() {
+    if (!s_Cache)
+      return;
+    VulkanContext::Context.Device.destroyPipelineCache(s_Cache);
+    s_Cache = nullptr;
+  }
+
   static std::pair<vk::PipelineLayout, std::vector<vk::DescriptorSetLayout>> CreatePipelineLayout(
     const PipelineDescription& pipDesc) {
     const auto& LogicalDevice = VulkanContext::Context.Device;
@@ -25,12 +159,21 @@ namespace Oxylus {
     for (auto& bindings : pipDesc.SetDescriptions) {
       vk::DescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo;
       std::vector<vk::DescriptorSetLayoutBinding> binds;
+      std::vector<vk::DescriptorBindingFlags> bindingFlags;
       for (auto& bind : bindings) {
         binds.emplace_back(bind.Binding, bind.DescriptorType, bind.DescriptorCount, bind.ShaderStage);
+        bindingFlags.emplace_back(bind.BindingFlags);
+        if (bind.BindingFlags & vk::DescriptorBindingFlagBits::eUpdateAfterBind)
+          descriptorSetLayoutCreateInfo.flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool;
       }
       descriptorSetLayoutCreateInfo.pBindings = binds.data();
       descriptorSetLayoutCreateInfo.bindingCount = (uint32_t)binds.size();
 
+      vk::DescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo;
+      bindingFlagsInfo.bindingCount = (uint32_t)bindingFlags.size();
+      bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+      descriptorSetLayoutCreateInfo.pNext = &bindingFlagsInfo;
+
       descriptorSetLayouts.emplace_back(
         LogicalDevice.createDescriptorSetLayout(descriptorSetLayoutCreateInfo, nullptr).value);
     }
@@ -288,9 +431,9 @@ namespace Oxylus {
     });
   }
 
-  std::future<void> VulkanPipeline::CreateGraphicsPipelineAsync(PipelineDescription& pipelineSpecification) {
-    return std::async([this, &pipelineSpecification] {
-      CreateGraphicsPipeline(pipelineSpecification);
+  JobHandle VulkanPipeline::CreateGraphicsPipelineAsync(PipelineDescription pipelineSpecification) {
+    return JobSystem::Schedule([this, description = std::move(pipelineSpecification)]() mutable {
+      CreateGraphicsPipeline(description);
     });
   }
 
@@ -346,9 +489,9 @@ namespace Oxylus {
     });
   }
 
-  std::future<void> VulkanPipeline::CreateComputePipelineAsync(const PipelineDescription& pipelineSpecification) {
-    return std::async([this, &pipelineSpecification] {
-      CreateComputePipeline(pipelineSpecification);
+  JobHandle VulkanPipeline::CreateComputePipelineAsync(PipelineDescription pipelineSpecification) {
+    return JobSystem::Schedule([this, description = std::move(pipelineSpecification)] {
+      CreateComputePipeline(description);
     });
   }
 
@@ -1,11 +1,10 @@
 ﻿#pragma once
-#include <future>
 #include <vulkan/vulkan.hpp>
 
 #include "VulkanRenderPass.h"
 #include "VulkanShader.h"
 #include "Render/Mesh.h"
-#include "Thread/Thread.h"
+#include "Thread/JobSystem.h"
 
 namespace Oxylus {
 #define MAX_RENDER_TARGETS 8
@@ -29,6 +28,36 @@ namespace Oxylus {
         attributeDescriptions.emplace_back(attributeIndexOffset + i, binding, format, offset);
       }
     }
+
+    //Mesh vertices from the geometry pool, each component is read from its stream with its location in the order of the layout.
+    static VertexInputDescription ForMesh(const VertexLayout& vertexLayout) {
+      VertexInputDescription description;
+      uint32_t streams = 0;
+      for (uint32_t i = 0; i < (uint32_t)vertexLayout.components.size(); ++i) {
+        const auto attribute = VertexFormat::GetAttribute(vertexLayout.components[i]);
+        description.attributeDescriptions.emplace_back(i, VertexFormat::STREAM_BINDINGS[attribute.Source], attribute.Format, attribute.Offset);
+        streams |= 1u << attribute.Source;
+      }
+      for (uint32_t stream = 0; stream < VertexFormat::STREAM_COUNT; ++stream) {
+        if (streams & (1u << stream))
+          description.bindingDescriptions.emplace_back(VertexFormat::STREAM_BINDINGS[stream], VertexFormat::STREAM_STRIDES[stream], vk::VertexInputRate::eVertex);
+      }
+      return description;
+    }
+
+    //Per instance model matrix at the start of each instance, read as four vec4 attributes starting at location.
+    VertexInputDescription& AddInstanceTransform(uint32_t binding, uint32_t location, uint32_t stride = sizeof(glm::mat4)) {
+      bindingDescriptions.emplace_back(binding, stride, vk::VertexInputRate::eInstance);
+      for (uint32_t i = 0; i < 4; ++i)
+        attributeDescriptions.emplace_back(location + i, binding, vk::Format::eR32G32B32A32Sfloat, i * (uint32_t)sizeof(glm::vec4));
+      return *this;
+    }
+
+    //Another per instance attribute of a binding added before.
+    VertexInputDescription& AddInstanceAttribute(uint32_t binding, uint32_t location, vk::Format format, uint32_t offset) {
+      attributeDescriptions.emplace_back(location, binding, format, offset);
+      return *this;
+    }
   };
 
   struct StencilDescription {
@@ -144,10 +173,19 @@ namespace Oxylus {
     ~VulkanPipeline() = default;
 
     void CreateGraphicsPipeline(PipelineDescription& pipelineSpecification);
-    [[nodiscard]] std::future<void> CreateGraphicsPipelineAsync(PipelineDescription& pipelineSpecification);
+    //The description is copied so the caller can reuse it right away.
+    [[nodiscard]] JobHandle CreateGraphicsPipelineAsync(PipelineDescription pipelineSpecification);
 
     void CreateComputePipeline(const PipelineDescription& pipelineSpecification);
-    [[nodiscard]] std::future<void> CreateComputePipelineAsync(const PipelineDescription& pipelineSpecification);
+    [[nodiscard]] JobHandle CreateComputePipelineAsync(PipelineDescription pipelineSpecification);
+
+    /**
+     * \brief Creates the pipeline cache shared by every pipeline from the file saved by a previous run.
+     * The file is only used if it was written for the same vendor, device, driver and cache UUID.
+     */
+    static void LoadPipelineCache();
+    static void SavePipelineCache();
+    static void DestroyPipelineCache();
 
     void BindDescriptorSets(const vk::CommandBuffer& commandBuffer,
                             const std::vector<vk::DescriptorSet>& descriptorSets,
@@ -3,12 +3,15 @@
 
 #include <future>
 
+#include "DescriptorUpdateQueue.h"
 #include "VulkanCommandBuffer.h"
 #include "VulkanContext.h"
 #include "VulkanPipeline.h"
 #include "VulkanSwapchain.h"
+#include "VulkanUploader.h"
 #include "Utils/VulkanUtils.h"
 #include "Core/Resources.h"
+#include "Render/MaterialPool.h"
 #include "Render/Mesh.h"
 #include "Render/Window.h"
 #include "Render/PBR/Prefilter.h"
@@ -17,6 +20,7 @@
 #include "Render/ShaderLibrary.h"
 #include "Utils/Profiler.h"
 #include "Core/Entity.h"
+#include "Thread/JobSystem.h"
 
 #include <backends/imgui_impl_vulkan.h>
 
@@ -30,24 +34,32 @@ namespace Oxylus {
   RendererConfig VulkanRenderer::s_RendererConfig;
 
   static VulkanDescriptorSet s_PostProcessDescriptorSet;
-  static VulkanDescriptorSet s_SkyboxDescriptorSet;
-  static VulkanDescriptorSet s_ComputeDescriptorSet;
-  static VulkanDescriptorSet s_SSAODescriptorSet;
+  static PerFrame<VulkanDescriptorSet> s_SkyboxDescriptorSet;
+  static PerFrame<VulkanDescriptorSet> s_ComputeDescriptorSet;
+  static PerFrame<VulkanDescriptorSet> s_SSAODescriptorSet;
   static VulkanDescriptorSet s_SSAOBlurDescriptorSet;
-  static VulkanDescriptorSet s_SSRDescriptorSet;
+  static PerFrame<VulkanDescriptorSet> s_SSRDescriptorSet;
   static VulkanDescriptorSet s_QuadDescriptorSet;
   static VulkanDescriptorSet s_DepthDescriptorSet;
-  static VulkanDescriptorSet s_ShadowDepthDescriptorSet;
+  static PerFrame<VulkanDescriptorSet> s_ShadowDepthDescriptorSet;
   static VulkanDescriptorSet s_BloomDescriptorSet;
   static VulkanDescriptorSet s_CompositeDescriptorSet;
-  static VulkanDescriptorSet s_AtmosphereDescriptorSet;
+  static PerFrame<VulkanDescriptorSet> s_AtmosphereDescriptorSet;
   static VulkanDescriptorSet s_DepthOfFieldDescriptorSet;
   static Mesh s_SkyboxCube;
   static VulkanBuffer s_TriangleVertexBuffer;
   static VulkanBuffer s_QuadVertexBuffer;
 
-  std::vector<VulkanRenderer::MeshData> VulkanRenderer::s_MeshDrawList;
-  static bool s_ForceUpdateMaterials = false;
+  std::vector<std::vector<VulkanRenderer::MeshData>> VulkanRenderer::s_MeshDrawChunks;
+  std::vector<VulkanRenderer::CullChunk> VulkanRenderer::s_CullChunks;
+  VulkanRenderer::VisibleMeshLists VulkanRenderer::s_VisibleMeshes;
+  DrawPacketBuilder VulkanRenderer::s_DrawPacketBuilder;
+  DrawStats VulkanRenderer::s_DrawStats;
+  std::vector<VulkanRenderer::InstanceData> VulkanRenderer::s_InstanceData;
+  std::vector<vk::DrawIndexedIndirectCommand> VulkanRenderer::s_DrawCommands;
+  bool VulkanRenderer::s_IndirectDraws = true;
+  static bool s_MultiDrawIndirect = false;
+  static bool s_DrawIndirectFirstInstance = false;
 
   std::vector<Entity> VulkanRenderer::s_SceneLights;
   Entity VulkanRenderer::s_Skylight;
@@ -60,6 +72,14 @@ namespace Oxylus {
 
   static EventDispatcher s_LightBufferDispatcher;
 
+  //Dynamic offsets of the scene set in binding order: view, parameters, lights and direct shadow. Compute sets use the first three.
+  static std::array<uint32_t, 4> GetSceneDynamicOffsets() {
+    return {
+      s_RendererData.VSData.Offset, s_RendererData.ParametersData.Offset,
+      s_RendererData.LightsData.Offset, s_RendererData.DirectShadowData.Offset
+    };
+  }
+
   /*
     Calculate frustum split depths and matrices for the shadow map cascades
     Based on https://johanmedestrom.wordpress.com/2016/03/18/opengl-cascaded-shadow-maps/
@@ -166,6 +186,7 @@ namespace Oxylus {
 
   void VulkanRenderer::UpdateLightingData() {
     ZoneScoped;
+    s_PointLightsData.clear();
     for (auto& e : s_SceneLights) {
       auto& lightComponent = e.GetComponent<LightComponent>();
       auto& transformComponent = e.GetComponent<TransformComponent>();
@@ -181,38 +202,80 @@ namespace Oxylus {
         case LightComponent::LightType::Spot: break;
       }
     }
-
-    if (!s_PointLightsData.empty()) {
-      s_RendererData.LightsBuffer.Copy(s_PointLightsData);
-      s_PointLightsData.clear();
-    }
   }
 
   void VulkanRenderer::UpdateUniformBuffers() {
     ZoneScoped;
+    auto& frameAllocator = s_RendererData.FrameAllocator;
     s_RendererData.UBO_VS.projection = s_RendererContext.CurrentCamera->GetProjectionMatrixFlipped();
-    s_RendererData.SkyboxBuffer.Copy(&s_RendererData.UBO_VS, sizeof s_RendererData.UBO_VS);
+    frameAllocator.Push(s_RendererData.UBO_VS, s_RendererData.SkyboxData.Offset);
 
     s_RendererData.UBO_VS.projection = s_RendererContext.CurrentCamera->GetProjectionMatrixFlipped();
     s_RendererData.UBO_VS.view = s_RendererContext.CurrentCamera->GetViewMatrix();
     s_RendererData.UBO_VS.camPos = s_RendererContext.CurrentCamera->GetPosition();
-    s_RendererData.VSBuffer.Copy(&s_RendererData.UBO_VS, sizeof s_RendererData.UBO_VS);
+    frameAllocator.Push(s_RendererData.UBO_VS, s_RendererData.VSData.Offset);
+
+    //The binding always sees the whole capacity, only the lights of the scene are written.
+    const auto lightCount = (uint32_t)s_PointLightsData.size();
+    if (lightCount > s_RendererData.LightCapacity)
+      GrowLightCapacity(lightCount);
+    const auto lights = frameAllocator.Allocate(s_RendererData.LightsData.Descriptor.range);
+    if (lights.IsValid()) {
+      if (lightCount > 0)
+        memcpy(lights.Data, s_PointLightsData.data(), lightCount * sizeof(LightingData));
+      s_RendererData.LightsData.Offset = lights.Offset;
+    }
 
-    s_RendererData.UBO_PbrPassParams.numLights = 1;
+    s_RendererData.UBO_PbrPassParams.numLights = lights.IsValid() ? (int)lightCount : 0;
     s_RendererData.UBO_PbrPassParams.numThreads = (glm::ivec2(Window::GetWidth(), Window::GetHeight()) + PIXELS_PER_TILE - 1) /
                                                   PIXELS_PER_TILE;
     s_RendererData.UBO_PbrPassParams.numThreadGroups = (s_RendererData.UBO_PbrPassParams.numThreads + TILES_PER_THREADGROUP - 1) /
                                                        TILES_PER_THREADGROUP;
     s_RendererData.UBO_PbrPassParams.screenDimensions = glm::ivec2(Window::GetWidth(), Window::GetHeight());
 
-    s_RendererData.ParametersBuffer.Copy(&s_RendererData.UBO_PbrPassParams, sizeof s_RendererData.UBO_PbrPassParams);
+    frameAllocator.Push(s_RendererData.UBO_PbrPassParams, s_RendererData.ParametersData.Offset);
 
     s_RendererData.UBO_Atmosphere.LightPos = Vec4{
       Vec3(0.0f, glm::sin(glm::radians(s_RendererData.UBO_Atmosphere.Time * 360.0f)), glm::cos(glm::radians(s_RendererData.UBO_Atmosphere.Time * 360.0f))) * 149600000e3f,
       s_RendererData.UBO_Atmosphere.LightPos.w
     };
     s_RendererData.UBO_Atmosphere.InvProjection = glm::inverse(s_RendererContext.CurrentCamera->GetProjectionMatrixFlipped());
-    s_RendererData.AtmosphereBuffer.Copy(&s_RendererData.UBO_Atmosphere, sizeof s_RendererData.UBO_Atmosphere);
+    frameAllocator.Push(s_RendererData.UBO_Atmosphere, s_RendererData.AtmosphereData.Offset);
+  }
+
+  void VulkanRenderer::GrowFrameAllocator() {
+    ZoneScoped;
+    //Frames in flight still read the old buffer.
+    WaitDeviceIdle();
+    auto& frameAllocator = s_RendererData.FrameAllocator;
+    frameAllocator.Grow();
+    for (auto* binding : {
+           &s_RendererData.SkyboxData, &s_RendererData.VSData, &s_RendererData.ParametersData, &s_RendererData.LightsData,
+           &s_RendererData.DirectShadowData, &s_RendererData.AtmosphereData
+         })
+      binding->Descriptor.buffer = frameAllocator.Get();
+
+    //Nothing is in flight, every copy of the sets binding frame data can be rewritten right away.
+    for (auto* sets : {
+           &s_SkyboxDescriptorSet, &s_ComputeDescriptorSet, &s_SSAODescriptorSet, &s_ShadowDepthDescriptorSet,
+           &s_SSRDescriptorSet, &s_AtmosphereDescriptorSet, &Material::s_DescriptorSet
+         }) {
+      for (const auto& set : *sets)
+        set.Update();
+    }
+  }
+
+  void VulkanRenderer::GrowLightCapacity(const uint32_t lightCount) {
+    ZoneScoped;
+    s_RendererData.LightCapacity = std::max(s_RendererData.LightCapacity * 2, lightCount);
+    s_RendererData.LightsData.Descriptor.range = (vk::DeviceSize)s_RendererData.LightCapacity * sizeof(LightingData);
+    OX_CORE_TRACE("Growing light capacity to {} lights", s_RendererData.LightCapacity);
+
+    //The range is part of the descriptors. Frames in flight keep their sets and the smaller range,
+    //the current frame is rewritten right away since its lights are pushed with the new capacity.
+    UpdateSceneDescriptorSets();
+    UpdateComputeDescriptorSets();
+    DescriptorUpdateQueue::Flush();
   }
 
   void VulkanRenderer::GeneratePrefilter() {
@@ -226,6 +289,8 @@ namespace Oxylus {
       s_SkyboxCube,
       VertexLayout({VertexComponent::POSITION, VertexComponent::NORMAL, VertexComponent::UV}),
       s_Resources.CubeMap.GetDescImageInfo());
+    //The cubes are recreated, the scene sets have to point at the new views.
+    UpdateSceneDescriptorSets();
   }
 
   void VulkanRenderer::CreateGraphicsPipelines() {
@@ -316,6 +381,9 @@ namespace Oxylus {
       .Name = "GaussianBlur",
       .ComputePath = Resources::GetResourcesPath("Shaders/GaussianBlur.comp").string(),
     });
+    //Pipelines compile in parallel, every description is copied into its job.
+    std::vector<JobHandle> pipelineJobs;
+
     PipelineDescription pipelineDescription{};
     pipelineDescription.Shader = skyboxShader.get();
     pipelineDescription.ColorAttachmentCount = 1;
@@ -334,7 +402,7 @@ namespace Oxylus {
     pipelineDescription.DepthSpec.MaxDepthBound = 0;
     pipelineDescription.DepthSpec.DepthStenctilFormat = vk::Format::eD32Sfloat;
     pipelineDescription.DynamicStates = {vk::DynamicState::eViewport, vk::DynamicState::eScissor};
-    pipelineDescription.VertexInputState = VertexInputDescription(VertexLayout({
+    pipelineDescription.VertexInputState = VertexInputDescription::ForMesh(VertexLayout({
       VertexComponent::POSITION, VertexComponent::NORMAL, VertexComponent::UV
     }));
     pipelineDescription.PushConstantRanges = {
@@ -342,18 +410,23 @@ namespace Oxylus {
     };
     pipelineDescription.SetDescriptions = {
       {
-        SetDescription{0, 0, 1, vDT::eUniformBuffer, vSS::eVertex, nullptr, &s_RendererData.SkyboxBuffer.GetDescriptor()},
+        SetDescription{0, 0, 1, vDT::eUniformBufferDynamic, vSS::eVertex, nullptr, &s_RendererData.SkyboxData.Descriptor},
         SetDescription{1, 0, 1, vDT::eUniformBuffer, vSS::eFragment, nullptr, &s_RendererData.PostProcessBuffer.GetDescriptor()},
         SetDescription{6, 0, 1, vDT::eCombinedImageSampler, vSS::eFragment, &s_Resources.CubeMap.GetDescImageInfo()},
       }
     };
-    s_Pipelines.SkyboxPipeline.CreateGraphicsPipelineAsync(pipelineDescription).wait();
+    pipelineJobs.emplace_back(s_Pipelines.SkyboxPipeline.CreateGraphicsPipelineAsync(pipelineDescription));
+
+    //Mesh pipelines read their model matrix and material index from the instance buffer.
+    pipelineDescription.VertexInputState
+                       .AddInstanceTransform(INSTANCE_BINDING, INSTANCE_TRANSFORM_LOCATION, sizeof(InstanceData))
+                       .AddInstanceAttribute(INSTANCE_BINDING, INSTANCE_MATERIAL_LOCATION, vk::Format::eR32Uint, offsetof(InstanceData, MaterialIndex));
 
     std::vector<std::vector<SetDescription>> pbrDescriptorSet = {
       {
-        SetDescription{0, 0, 1, vDT::eUniformBuffer, vSS::eFragment | vSS::eVertex, nullptr, &s_RendererData.VSBuffer.GetDescriptor()},
-        SetDescription{1, 0, 1, vDT::eUniformBuffer, vSS::eFragment | vSS::eVertex, nullptr, &s_RendererData.ParametersBuffer.GetDescriptor()},
-        SetDescription{2, 0, 1, vDT::eStorageBuffer, vSS::eFragment, nullptr, &s_RendererData.LightsBuffer.GetDescriptor()},
+        SetDescription{0, 0, 1, vDT::eUniformBufferDynamic, vSS::eFragment | vSS::eVertex, nullptr, &s_RendererData.VSData.Descriptor},
+        SetDescription{1, 0, 1, vDT::eUniformBufferDynamic, vSS::eFragment | vSS::eVertex, nullptr, &s_RendererData.ParametersData.Descriptor},
+        SetDescription{2, 0, 1, vDT::eStorageBufferDynamic, vSS::eFragment, nullptr, &s_RendererData.LightsData.Descriptor},
         SetDescription{3, 0, 1, vDT::eStorageBuffer, vSS::eFragment, nullptr, &s_RendererData.FrustumBuffer.GetDescriptor()},
         SetDescription{4, 0, 1, vDT::eStorageBuffer, vSS::eFragment, nullptr, &s_RendererData.LighIndexBuffer.GetDescriptor()},
         SetDescription{5, 0, 1, vDT::eStorageBuffer, vSS::eFragment, nullptr, &s_RendererData.LighGridBuffer.GetDescriptor()},
@@ -362,26 +435,25 @@ namespace Oxylus {
         SetDescription{8, 0, 1, vDT::eCombinedImageSampler, vSS::eFragment, &s_Resources.PrefilteredCube.GetDescImageInfo()},
         SetDescription{9, 0, 1, vDT::eCombinedImageSampler, vSS::eFragment},
         SetDescription{10, 0, 1, vDT::eCombinedImageSampler, vSS::eFragment},
-        SetDescription{11, 0, 1, vDT::eUniformBuffer, vSS::eFragment, nullptr, &s_RendererData.DirectShadowBuffer.GetDescriptor()},
+        SetDescription{11, 0, 1, vDT::eUniformBufferDynamic, vSS::eFragment, nullptr, &s_RendererData.DirectShadowData.Descriptor},
       },
+      //Bindless materials, owned by MaterialPool.
       {
-        SetDescription{0, 0, 1, vDT::eCombinedImageSampler, vSS::eFragment},
-        SetDescription{1, 0, 1, vDT::eCombinedImageSampler, vSS::eFragment},
-        SetDescription{2, 0, 1, vDT::eCombinedImageSampler, vSS::eFragment},
-        SetDescription{3, 0, 1, vDT::eCombinedImageSampler, vSS::eFragment},
-        SetDescription{4, 0, 1, vDT::eCombinedImageSampler, vSS::eFragment},
+        SetDescription{0, 0, 1, vDT::eStorageBuffer, vSS::eFragment},
+        SetDescription{
+          1, 0, MaterialPool::GetTextureCapacity(), vDT::eCombinedImageSampler, vSS::eFragment, nullptr, nullptr, nullptr,
+          vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eUpdateAfterBind |
+          vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending
+        },
       }
     };
 
     pipelineDescription.SetDescriptions = pbrDescriptorSet;
-    pipelineDescription.PushConstantRanges.emplace_back(vk::ShaderStageFlagBits::eFragment,
-      sizeof(glm::mat4),
-      sizeof Material::Parameters);
     pipelineDescription.Shader = pbrShader.get();
     pipelineDescription.DepthSpec.DepthWriteEnable = true;
     pipelineDescription.DepthSpec.DepthEnable = true;
     pipelineDescription.RasterizerDesc.CullMode = vk::CullModeFlagBits::eBack;
-    s_Pipelines.PBRPipeline.CreateGraphicsPipelineAsync(pipelineDescription).wait();
+    pipelineJobs.emplace_back(s_Pipelines.PBRPipeline.CreateGraphicsPipelineAsync(pipelineDescription));
 
     PipelineDescription unlitPipelineDesc;
     unlitPipelineDesc.Shader = unlitShader.get();
@@ -390,13 +462,13 @@ namespace Oxylus {
     unlitPipelineDesc.DepthSpec.DepthWriteEnable = false;
     unlitPipelineDesc.DepthSpec.DepthEnable = false;
     unlitPipelineDesc.RasterizerDesc.CullMode = vk::CullModeFlagBits::eBack;
-    unlitPipelineDesc.VertexInputState = VertexInputDescription(VertexLayout({
+    unlitPipelineDesc.VertexInputState = VertexInputDescription::ForMesh(VertexLayout({
       VertexComponent::POSITION, VertexComponent::NORMAL, VertexComponent::UV, VertexComponent::COLOR
     }));
     unlitPipelineDesc.BlendStateDesc.RenderTargets[0].BlendEnable = true;
     unlitPipelineDesc.BlendStateDesc.RenderTargets[0].DestBlend = vk::BlendFactor::eOneMinusSrcAlpha;
 
-    s_Pipelines.UnlitPipeline.CreateGraphicsPipelineAsync(unlitPipelineDesc).wait();
+    pipelineJobs.emplace_back(s_Pipelines.UnlitPipeline.CreateGraphicsPipelineAsync(unlitPipelineDesc));
 
     PipelineDescription depthpassdescription;
     depthpassdescription.Shader = depthPassShader.get();
@@ -417,22 +489,20 @@ namespace Oxylus {
     depthpassdescription.SubpassDescription[1].SrcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite;
     depthpassdescription.SubpassDescription[1].DstAccessMask = vk::AccessFlagBits::eShaderRead;
     depthpassdescription.DepthAttachmentLayout = vk::ImageLayout::eDepthStencilReadOnlyOptimal;
-    depthpassdescription.VertexInputState = VertexInputDescription(VertexLayout({
+    depthpassdescription.VertexInputState = VertexInputDescription::ForMesh(VertexLayout({
       VertexComponent::POSITION,
       VertexComponent::NORMAL,
       VertexComponent::UV,
       VertexComponent::TANGENT
-    }));
+    })).AddInstanceTransform(INSTANCE_BINDING, INSTANCE_TRANSFORM_LOCATION, sizeof(InstanceData))
+       .AddInstanceAttribute(INSTANCE_BINDING, INSTANCE_MATERIAL_LOCATION, vk::Format::eR32Uint, offsetof(InstanceData, MaterialIndex));
     depthpassdescription.PushConstantRanges = {
       vk::PushConstantRange{vk::ShaderStageFlagBits::eVertex, 0, sizeof(glm::mat4)}
     };
-    depthpassdescription.PushConstantRanges.emplace_back(vk::ShaderStageFlagBits::eFragment,
-      sizeof(glm::mat4),
-      sizeof Material::Parameters);
-    s_Pipelines.DepthPrePassPipeline.CreateGraphicsPipelineAsync(depthpassdescription).wait();
+    pipelineJobs.emplace_back(s_Pipelines.DepthPrePassPipeline.CreateGraphicsPipelineAsync(depthpassdescription));
 
     pipelineDescription.Shader = directShadowShader.get();
-    pipelineDescription.PushConstantRanges = {vk::PushConstantRange{vk::ShaderStageFlagBits::eVertex, 0, 68}};
+    pipelineDescription.PushConstantRanges = {vk::PushConstantRange{vk::ShaderStageFlagBits::eVertex, 0, sizeof(uint32_t)}};
     pipelineDescription.ColorAttachmentCount = 0;
     pipelineDescription.RasterizerDesc.CullMode = vk::CullModeFlagBits::eNone;
     pipelineDescription.DepthSpec.DepthEnable = true;
@@ -446,10 +516,10 @@ namespace Oxylus {
     pipelineDescription.DepthAttachmentLayout = vk::ImageLayout::eDepthStencilReadOnlyOptimal;
     pipelineDescription.SetDescriptions = {
       {
-        SetDescription{0, 0, 1, vDT::eUniformBuffer, vSS::eVertex, nullptr, &s_RendererData.DirectShadowBuffer.GetDescriptor()}
+        SetDescription{0, 0, 1, vDT::eUniformBufferDynamic, vSS::eVertex, nullptr, &s_RendererData.DirectShadowData.Descriptor}
       }
     };
-    s_Pipelines.DirectShadowDepthPipeline.CreateGraphicsPipelineAsync(pipelineDescription).wait();
+    pipelineJobs.emplace_back(s_Pipelines.DirectShadowDepthPipeline.CreateGraphicsPipelineAsync(pipelineDescription));
 
     PipelineDescription ssaoDescription;
     ssaoDescription.RenderTargets[0].Format = vk::Format::eR8Unorm;
@@ -458,14 +528,14 @@ namespace Oxylus {
     ssaoDescription.SubpassDescription[0].SrcAccessMask = {};
     ssaoDescription.SetDescriptions = {
       {
-        SetDescription{0, 0, 1, vDT::eUniformBuffer, vSS::eCompute, nullptr, &s_RendererData.VSBuffer.GetDescriptor()},
+        SetDescription{0, 0, 1, vDT::eUniformBufferDynamic, vSS::eCompute, nullptr, &s_RendererData.VSData.Descriptor},
         SetDescription{1, 0, 1, vDT::eCombinedImageSampler, vSS::eCompute},
         SetDescription{2, 0, 1, vDT::eStorageImage, vSS::eCompute},
         SetDescription{3, 0, 1, vDT::eCombinedImageSampler, vSS::eCompute},
       }
     };
     ssaoDescription.Shader = ssaoShader.get();
-    s_Pipelines.SSAOPassPipeline.CreateComputePipelineAsync(ssaoDescription).wait();
+    pipelineJobs.emplace_back(s_Pipelines.SSAOPassPipeline.CreateComputePipelineAsync(ssaoDescription));
 
     {
       PipelineDescription gaussianBlur;
@@ -479,7 +549,7 @@ namespace Oxylus {
       };
       gaussianBlur.Shader = gaussianBlurShader.get();
       gaussianBlur.PushConstantRanges.emplace_back(vk::ShaderStageFlagBits::eCompute, 0, 4);
-      s_Pipelines.GaussianBlurPipeline.CreateComputePipelineAsync(gaussianBlur).wait();
+      pipelineJobs.emplace_back(s_Pipelines.GaussianBlurPipeline.CreateComputePipelineAsync(gaussianBlur));
     }
     {
       PipelineDescription bloomDesc;
@@ -495,7 +565,7 @@ namespace Oxylus {
         }
       };
       bloomDesc.Shader = bloomShader.get();
-      s_Pipelines.BloomPipeline.CreateComputePipelineAsync(bloomDesc).wait();
+      pipelineJobs.emplace_back(s_Pipelines.BloomPipeline.CreateComputePipelineAsync(bloomDesc));
     }
     {
       PipelineDescription ssrDesc;
@@ -507,12 +577,12 @@ namespace Oxylus {
           SetDescription{2, 0, 1, vDT::eCombinedImageSampler, vSS::eCompute},
           SetDescription{3, 0, 1, vDT::eCombinedImageSampler, vSS::eCompute},
           SetDescription{4, 0, 1, vDT::eCombinedImageSampler, vSS::eCompute},
-          SetDescription{5, 0, 1, vDT::eUniformBuffer, vSS::eCompute, nullptr, &s_RendererData.VSBuffer.GetDescriptor()},
+          SetDescription{5, 0, 1, vDT::eUniformBufferDynamic, vSS::eCompute, nullptr, &s_RendererData.VSData.Descriptor},
           SetDescription{6, 0, 1, vDT::eUniformBuffer, vSS::eCompute, nullptr, &s_RendererData.SSRBuffer.GetDescriptor()},
         }
       };
       ssrDesc.Shader = ssrShader.get();
-      s_Pipelines.SSRPipeline.CreateComputePipelineAsync(ssrDesc).wait();
+      pipelineJobs.emplace_back(s_Pipelines.SSRPipeline.CreateComputePipelineAsync(ssrDesc));
     }
     {
       PipelineDescription atmDesc;
@@ -520,11 +590,11 @@ namespace Oxylus {
       atmDesc.SetDescriptions = {
         {
           SetDescription{0, 0, 1, vDT::eStorageImage, vSS::eCompute},
-          SetDescription{1, 0, 1, vDT::eUniformBuffer, vSS::eCompute, nullptr, &s_RendererData.AtmosphereBuffer.GetDescriptor()},
+          SetDescription{1, 0, 1, vDT::eUniformBufferDynamic, vSS::eCompute, nullptr, &s_RendererData.AtmosphereData.Descriptor},
         }
       };
       atmDesc.Shader = atmosphereShader.get();
-      s_Pipelines.AtmospherePipeline.CreateComputePipelineAsync(atmDesc).wait();
+      pipelineJobs.emplace_back(s_Pipelines.AtmospherePipeline.CreateComputePipelineAsync(atmDesc));
     }
     {
       PipelineDescription depthOfField;
@@ -537,7 +607,7 @@ namespace Oxylus {
         }
       };
       depthOfField.Shader = depthOfFieldShader.get();
-      s_Pipelines.DepthOfFieldPipeline.CreateComputePipelineAsync(depthOfField).wait();
+      pipelineJobs.emplace_back(s_Pipelines.DepthOfFieldPipeline.CreateComputePipelineAsync(depthOfField));
     }
     {
       PipelineDescription composite;
@@ -553,7 +623,7 @@ namespace Oxylus {
         }
       };
       composite.Shader = compositeShader.get();
-      s_Pipelines.CompositePipeline.CreateComputePipelineAsync(composite).wait();
+      pipelineJobs.emplace_back(s_Pipelines.CompositePipeline.CreateComputePipelineAsync(composite));
     }
     {
       PipelineDescription ppPass;
@@ -567,9 +637,9 @@ namespace Oxylus {
       ppPass.RasterizerDesc.CullMode = vk::CullModeFlagBits::eNone;
       ppPass.VertexInputState = VertexInputDescription(VertexLayout({
         VertexComponent::POSITION, VertexComponent::NORMAL, VertexComponent::UV
-      }));
+      }, sizeof(RendererData::Vertex)));
       ppPass.DepthSpec.DepthEnable = false;
-      s_Pipelines.PostProcessPipeline.CreateGraphicsPipelineAsync(ppPass).wait();
+      pipelineJobs.emplace_back(s_Pipelines.PostProcessPipeline.CreateGraphicsPipelineAsync(ppPass));
     }
     {
       PipelineDescription quadDescription;
@@ -583,15 +653,15 @@ namespace Oxylus {
       quadDescription.VertexInputState.bindingDescriptions.clear();
       quadDescription.Shader = quadShader.get();
       quadDescription.RasterizerDesc.CullMode = vk::CullModeFlagBits::eNone;
-      s_Pipelines.QuadPipeline.CreateGraphicsPipelineAsync(quadDescription).wait();
+      pipelineJobs.emplace_back(s_Pipelines.QuadPipeline.CreateGraphicsPipelineAsync(quadDescription));
     }
 
     PipelineDescription computePipelineDesc;
     computePipelineDesc.SetDescriptions = {
       {
-        SetDescription{0, 0, 1, vDT::eUniformBuffer, vSS::eCompute, nullptr, &s_RendererData.VSBuffer.GetDescriptor()},
-        SetDescription{1, 0, 1, vDT::eUniformBuffer, vSS::eCompute, nullptr, &s_RendererData.ParametersBuffer.GetDescriptor()},
-        SetDescription{2, 0, 1, vDT::eStorageBuffer, vSS::eCompute, nullptr, &s_RendererData.LightsBuffer.GetDescriptor()},
+        SetDescription{0, 0, 1, vDT::eUniformBufferDynamic, vSS::eCompute, nullptr, &s_RendererData.VSData.Descriptor},
+        SetDescription{1, 0, 1, vDT::eUniformBufferDynamic, vSS::eCompute, nullptr, &s_RendererData.ParametersData.Descriptor},
+        SetDescription{2, 0, 1, vDT::eStorageBufferDynamic, vSS::eCompute, nullptr, &s_RendererData.LightsData.Descriptor},
         SetDescription{3, 0, 1, vDT::eStorageBuffer, vSS::eCompute, nullptr, &s_RendererData.FrustumBuffer.GetDescriptor()},
         SetDescription{4, 0, 1, vDT::eStorageBuffer, vSS::eCompute, nullptr, &s_RendererData.LighIndexBuffer.GetDescriptor()},
         SetDescription{5, 0, 1, vDT::eStorageBuffer, vSS::eCompute, nullptr, &s_RendererData.LighGridBuffer.GetDescriptor()},
@@ -599,10 +669,10 @@ namespace Oxylus {
       }
     };
     computePipelineDesc.Shader = frustumGridShader.get();
-    s_Pipelines.FrustumGridPipeline.CreateComputePipelineAsync(computePipelineDesc).wait();
+    pipelineJobs.emplace_back(s_Pipelines.FrustumGridPipeline.CreateComputePipelineAsync(computePipelineDesc));
 
     computePipelineDesc.Shader = lightListShader.get();
-    s_Pipelines.LightListPipeline.CreateComputePipelineAsync(computePipelineDesc).wait();
+    pipelineJobs.emplace_back(s_Pipelines.LightListPipeline.CreateComputePipelineAsync(computePipelineDesc));
 
     const std::vector vertexInputBindings = {
       vk::VertexInputBindingDescription{0, sizeof(ImDrawVert), vk::VertexInputRate::eVertex},
@@ -645,7 +715,10 @@ namespace Oxylus {
     uiPipelineDecs.DepthSpec.MinDepthBound = 0;
     uiPipelineDecs.DepthSpec.MaxDepthBound = 0;
 
-    s_Pipelines.UIPipeline.CreateGraphicsPipelineAsync(uiPipelineDecs).wait();
+    pipelineJobs.emplace_back(s_Pipelines.UIPipeline.CreateGraphicsPipelineAsync(uiPipelineDecs));
+
+    for (const auto& job : pipelineJobs)
+      job.Wait();
   }
 
   void VulkanRenderer::CreateFramebuffers() {
@@ -684,9 +757,8 @@ namespace Oxylus {
       framebufferDescription.Extent = &Window::GetWindowExtent();
       framebufferDescription.ImageDescription = {depthImageDesc, colorImageDesc};
       framebufferDescription.OnResize = [] {
-        s_DepthDescriptorSet.WriteDescriptorSets[0].pBufferInfo = &s_RendererData.VSBuffer.GetDescriptor();
-        s_ComputeDescriptorSet.WriteDescriptorSets[6].pImageInfo = &s_FrameBuffers.DepthNormalPassFB.GetImage()[0].GetDescImageInfo();
         UpdateComputeDescriptorSets();
+        UpdateSceneDescriptorSets();
       };
       s_FrameBuffers.DepthNormalPassFB.CreateFramebuffer(framebufferDescription);
 
@@ -708,8 +780,8 @@ namespace Oxylus {
       framebufferDescription.DebugName = "Direct Shadow Depth Pass";
       framebufferDescription.RenderPass = s_Pipelines.DirectShadowDepthPipeline.GetRenderPass().Get();
       framebufferDescription.OnResize = [] {
-        s_ShadowDepthDescriptorSet.WriteDescriptorSets[0].pBufferInfo = &s_RendererData.DirectShadowBuffer.GetDescriptor();
-        s_ShadowDepthDescriptorSet.Update();
+        for (const auto& set : s_ShadowDepthDescriptorSet)
+          set.Update();
       };
       s_FrameBuffers.DirectionalCascadesFB.resize(SHADOW_MAP_CASCADE_COUNT);
       int baseArrayLayer = 0;
@@ -808,12 +880,14 @@ namespace Oxylus {
         &s_FrameBuffers.SSRPassImage,
         &Window::GetWindowExtent(),
         [] {
-          s_SSRDescriptorSet.WriteDescriptorSets[0].pImageInfo = &s_FrameBuffers.SSRPassImage.GetDescImageInfo();
-          s_SSRDescriptorSet.WriteDescriptorSets[1].pImageInfo = &s_FrameBuffers.PBRPassFB.GetImage()[0].GetDescImageInfo();
-          s_SSRDescriptorSet.WriteDescriptorSets[2].pImageInfo = &s_FrameBuffers.DepthNormalPassFB.GetImage()[0].GetDescImageInfo();
-          s_SSRDescriptorSet.WriteDescriptorSets[3].pImageInfo = &s_Resources.CubeMap.GetDescImageInfo();
-          s_SSRDescriptorSet.WriteDescriptorSets[4].pImageInfo = &s_FrameBuffers.DepthNormalPassFB.GetImage()[1].GetDescImageInfo();
-          s_SSRDescriptorSet.Update();
+          for (auto& set : s_SSRDescriptorSet) {
+            set.WriteDescriptorSets[0].pImageInfo = &s_FrameBuffers.SSRPassImage.GetDescImageInfo();
+            set.WriteDescriptorSets[1].pImageInfo = &s_FrameBuffers.PBRPassFB.GetImage()[0].GetDescImageInfo();
+            set.WriteDescriptorSets[2].pImageInfo = &s_FrameBuffers.DepthNormalPassFB.GetImage()[0].GetDescImageInfo();
+            set.WriteDescriptorSets[3].pImageInfo = &s_Resources.CubeMap.GetDescImageInfo();
+            set.WriteDescriptorSets[4].pImageInfo = &s_FrameBuffers.DepthNormalPassFB.GetImage()[1].GetDescImageInfo();
+            set.Update();
+          }
           s_FrameBuffers.PostProcessPassFB.GetDescription().OnResize();
         });
     }
@@ -827,14 +901,22 @@ namespace Oxylus {
       atmImage.Format = SwapChain.m_ImageFormat;
       atmImage.FinalImageLayout = vk::ImageLayout::eGeneral;
       atmImage.TransitionLayoutAtCreate = true;
+      //Rendered on the compute queue and sampled outside of the graph, which can't transfer it back.
+      const auto& queues = VulkanContext::VulkanQueue;
+      if (queues.computeQueueFamilyIndex != queues.graphicsQueueFamilyIndex) {
+        atmImage.SharingMode = vk::SharingMode::eConcurrent;
+        atmImage.QueueFamilies = {queues.graphicsQueueFamilyIndex, queues.computeQueueFamilyIndex};
+      }
       s_FrameBuffers.AtmosphereImage.Create(atmImage);
 
       ImagePool::AddToPool(
         &s_FrameBuffers.AtmosphereImage,
         nullptr,
         [] {
-          s_AtmosphereDescriptorSet.WriteDescriptorSets[0].pImageInfo = &s_FrameBuffers.AtmosphereImage.GetDescImageInfo();
-          s_AtmosphereDescriptorSet.Update();
+          for (auto& set : s_AtmosphereDescriptorSet) {
+            set.WriteDescriptorSets[0].pImageInfo = &s_FrameBuffers.AtmosphereImage.GetDescImageInfo();
+            set.Update();
+          }
           s_FrameBuffers.PostProcessPassFB.GetDescription().OnResize();
         });
     }
@@ -945,6 +1027,8 @@ namespace Oxylus {
       postProcess.Extent = &Window::GetWindowExtent();
       postProcess.RenderPass = s_Pipelines.PostProcessPipeline.GetRenderPass().Get();
       colorImageDesc.Format = SwapChain.m_ImageFormat;
+      //Read back by the render tests.
+      colorImageDesc.UsageFlags |= vk::ImageUsageFlagBits::eTransferSrc;
       postProcess.ImageDescription = {colorImageDesc};
       postProcess.OnResize = [] {
         s_PostProcessDescriptorSet.WriteDescriptorSets[0].pImageInfo = &s_FrameBuffers.CompositePassImage.GetDescImageInfo();
@@ -964,27 +1048,40 @@ namespace Oxylus {
   }
 
   void VulkanRenderer::UpdateSkyboxDescriptorSets() {
-    const auto& LogicalDevice = VulkanContext::Context.Device;
-    LogicalDevice.updateDescriptorSets(
-      {
-        {s_SkyboxDescriptorSet.Get(), 0, 0, 1, vk::DescriptorType::eUniformBuffer, nullptr, &s_RendererData.SkyboxBuffer.GetDescriptor()},
-        {s_SkyboxDescriptorSet.Get(), 1, 0, 1, vk::DescriptorType::eUniformBuffer, nullptr, &s_RendererData.PostProcessBuffer.GetDescriptor()},
-        {s_SkyboxDescriptorSet.Get(), 6, 0, 1, vk::DescriptorType::eCombinedImageSampler, &s_Resources.CubeMap.GetDescImageInfo()},
-      },
-      nullptr);
+    //The pipeline description already points at the cube map and the skybox buffers.
+    DescriptorUpdateQueue::Queue(s_SkyboxDescriptorSet);
   }
 
   void VulkanRenderer::UpdateComputeDescriptorSets() {
-    s_ComputeDescriptorSet.WriteDescriptorSets[6].pImageInfo = &s_FrameBuffers.DepthNormalPassFB.GetImage()[0].GetDescImageInfo();
-    s_ComputeDescriptorSet.Update();
+    DescriptorUpdateQueue::Queue(s_ComputeDescriptorSet,
+      [](VulkanDescriptorSet& set) {
+        set.WriteDescriptorSets[6].pImageInfo = &s_FrameBuffers.DepthNormalPassFB.GetImage()[0].GetDescImageInfo();
+      });
+  }
+
+  void VulkanRenderer::CreateFrameDescriptorSets(PerFrame<VulkanDescriptorSet>& sets, const VulkanPipeline& pipeline, const uint32_t layoutIndex) {
+    //Frame data lives in the frame allocator, sets of every frame point at the same buffer.
+    for (uint32_t frame = 0; frame < MAX_FRAMES_IN_FLIGHT; frame++)
+      sets[frame].CreateFromPipeline(pipeline, layoutIndex);
+  }
+
+  void VulkanRenderer::UpdateSceneDescriptorSets() {
+    DescriptorUpdateQueue::Queue(Material::s_DescriptorSet,
+      [](VulkanDescriptorSet& set) {
+        set.WriteDescriptorSets[9].pImageInfo = &s_FrameBuffers.DepthNormalPassFB.GetImage()[0].GetDescImageInfo();
+        set.WriteDescriptorSets[10].pImageInfo = &s_Resources.DirectShadowsDepthArray.GetDescImageInfo();
+      });
   }
 
   void VulkanRenderer::UpdateSSAODescriptorSets() {
-    s_SSAODescriptorSet.WriteDescriptorSets[1].pImageInfo = &s_FrameBuffers.DepthNormalPassFB.GetImage()[0].GetDescImageInfo();
-    s_SSAODescriptorSet.WriteDescriptorSets[2].pImageInfo = &s_FrameBuffers.SSAOPassImage.GetDescImageInfo();
-    s_SSAODescriptorSet.WriteDescriptorSets[3].pImageInfo = &s_FrameBuffers.DepthNormalPassFB.GetImage()[1].GetDescImageInfo();
-    s_SSAODescriptorSet.Update();
+    DescriptorUpdateQueue::Queue(s_SSAODescriptorSet,
+      [](VulkanDescriptorSet& set) {
+        set.WriteDescriptorSets[1].pImageInfo = &s_FrameBuffers.DepthNormalPassFB.GetImage()[0].GetDescImageInfo();
+        set.WriteDescriptorSets[2].pImageInfo = &s_FrameBuffers.SSAOPassImage.GetDescImageInfo();
+        set.WriteDescriptorSets[3].pImageInfo = &s_FrameBuffers.DepthNormalPassFB.GetImage()[1].GetDescImageInfo();
+      });
 
+    //Only rewritten when the SSAO images are resized, which happens with the device idle.
     s_SSAOBlurDescriptorSet.WriteDescriptorSets[0].pImageInfo = &s_FrameBuffers.SSAOBlurPassImage.GetDescImageInfo();
     s_SSAOBlurDescriptorSet.WriteDescriptorSets[1].pImageInfo = &s_FrameBuffers.SSAOPassImage.GetDescImageInfo();
     s_SSAOBlurDescriptorSet.Update();
@@ -995,38 +1092,58 @@ namespace Oxylus {
 
     SwapchainPass swapchain{&s_QuadDescriptorSet};
     renderGraph.SetSwapchain(swapchain);
+    //The final image is presented and shown in the editor viewport, everything that doesn't lead to it gets culled.
+    //The atmosphere cube map is sampled outside of the graph.
+    renderGraph.SetOutput("Final")
+               .SetOutput("Atmosphere");
+    //Images crossing between the graphics and the compute queue have to be imported so the graph can transfer their ownership.
+    //Every image the passes use is imported so moving a pass to another queue can't leave one behind.
+    renderGraph.ImportImage("DepthNormal", [] { return &s_FrameBuffers.DepthNormalPassFB.GetImage()[0]; })
+               .ImportImage("DepthNormal", [] { return &s_FrameBuffers.DepthNormalPassFB.GetImage()[1]; })
+               .ImportImage("DirectShadows", [] { return &s_Resources.DirectShadowsDepthArray; })
+               .ImportImage("PBR", [] { return &s_FrameBuffers.PBRPassFB.GetImage()[0]; })
+               .ImportImage("Final", [] { return &s_FrameBuffers.PostProcessPassFB.GetImage()[0]; })
+               .ImportImage("Atmosphere", [] { return &s_FrameBuffers.AtmosphereImage; });
+    //The light culling buffers are created with concurrent sharing in Init, they need no transfers.
+    renderGraph.AddConcurrentResource("Frustums")
+               .AddConcurrentResource("LightList");
+    //Intermediate images only live between the passes that use them, the graph aliases their memory.
+    renderGraph.AddTransientImage("SSAO", &s_FrameBuffers.SSAOPassImage)
+               .AddTransientImage("SSAOBlur", &s_FrameBuffers.SSAOBlurPassImage)
+               .AddTransientImage("SSR", &s_FrameBuffers.SSRPassImage)
+               .AddTransientImage("BloomDownsample", &s_FrameBuffers.BloomDownsampleImage)
+               .AddTransientImage("BloomUpsample", &s_FrameBuffers.BloomUpsampleImage)
+               .AddTransientImage("DepthOfField", &s_FrameBuffers.DepthOfFieldImage)
+               .AddTransientImage("Composite", &s_FrameBuffers.CompositePassImage);
+
+    constexpr vk::PipelineStageFlags computeStage = vk::PipelineStageFlagBits::eComputeShader;
+    constexpr vk::PipelineStageFlags fragmentStage = vk::PipelineStageFlagBits::eFragmentShader;
+    constexpr vk::PipelineStageFlags colorStage = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+    constexpr vk::PipelineStageFlags depthStages = vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+    constexpr vk::AccessFlags colorWrite = vk::AccessFlagBits::eColorAttachmentWrite;
+    constexpr vk::AccessFlags depthWrite = vk::AccessFlagBits::eDepthStencilAttachmentWrite;
 
     RenderGraphPass depthPrePass(
       "Depth Pre Pass",
-      {&s_RendererContext.DepthPassCommandBuffer},
       &s_Pipelines.DepthPrePassPipeline,
       {&s_FrameBuffers.DepthNormalPassFB},
       [](VulkanCommandBuffer& commandBuffer, int32_t) {
         ZoneScopedN("DepthPrePass");
         OX_TRACE_GPU(commandBuffer.Get(), "Depth Pre Pass")
         commandBuffer.SetViwportWindow().SetScissorWindow();
-        for (const auto& mesh : s_MeshDrawList) {
-          if (!mesh.MeshGeometry)
-            continue;
-
-          RenderMesh(mesh,
-            s_RendererContext.DepthPassCommandBuffer.Get(),
-            s_Pipelines.DepthPrePassPipeline,
-            [&](const Mesh::Primitive* part) {
-              const auto& material = mesh.Materials[part->materialIndex];
-              if (!material->IsOpaque())
-                return false;
-              const auto layout = s_Pipelines.DepthPrePassPipeline.GetPipelineLayout();
-              commandBuffer.PushConstants(layout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(glm::mat4), &mesh.Transform);
-              commandBuffer.PushConstants(layout, vk::ShaderStageFlagBits::eFragment, sizeof(glm::mat4), sizeof Material::Parameters, &material->Parameters);
-              s_Pipelines.DepthPrePassPipeline.BindDescriptorSets(commandBuffer.Get(), {Material::s_DescriptorSet.Get(), material->MaterialDescriptorSet.Get()}, 0, 2);
-              return true;
-            });
-        }
+        if (s_VisibleMeshes.DepthPrePass.CommandCount == 0)
+          return;
+
+        //Materials are indexed per instance from the bindless set, so the sets are bound once for the whole list.
+        const auto offsets = GetSceneDynamicOffsets();
+        s_Pipelines.DepthPrePassPipeline.BindDescriptorSets(commandBuffer.Get(), {Material::s_DescriptorSet.Current().Get(), MaterialPool::GetDescriptorSet()}, 0, 2, (uint32_t)offsets.size(), offsets.data());
+        s_DrawStats.DescriptorSetBinds++;
+        RenderMeshes(s_VisibleMeshes.DepthPrePass, commandBuffer.Get(), s_Pipelines.DepthPrePassPipeline);
       },
-      {vk::ClearDepthStencilValue{1.0f, 0}, vk::ClearColorValue(std::array{0.0f, 0.0f, 0.0f, 1.0f})},
-      &VulkanContext::VulkanQueue.GraphicsQueue);
-    renderGraph.AddRenderPass(depthPrePass);
+      {vk::ClearDepthStencilValue{1.0f, 0}, vk::ClearColorValue(std::array{0.0f, 0.0f, 0.0f, 1.0f})});
+    depthPrePass.Write("DepthNormal", colorStage | depthStages, colorWrite | depthWrite)
+                .RecordInParallel()
+                .AddToGraph(renderGraph);
 
     std::array<vk::ClearValue, 2> clearValues;
     clearValues[0].color = vk::ClearColorValue(std::array{0.0f, 0.0f, 0.0f, 1.0f});
@@ -1034,7 +1151,6 @@ namespace Oxylus {
 
     RenderGraphPass directShadowDepthPass(
       "Direct Shadow Depth Pass",
-      {&s_RendererContext.DirectShadowCommandBuffer},
       &s_Pipelines.DirectShadowDepthPipeline,
       {
         {
@@ -1051,61 +1167,47 @@ namespace Oxylus {
         }).SetScissor(vk::Rect2D{
           {}, {RendererConfig::Get()->DirectShadowsConfig.Size, RendererConfig::Get()->DirectShadowsConfig.Size,}
         });
-        for (const auto& e : s_SceneLights) {
-          const auto& lightComponent = e.GetComponent<LightComponent>();
-          if (lightComponent.Type != LightComponent::LightType::Directional)
-            continue;
-
-          glm::mat4 transform = e.GetWorldTransform();
-          UpdateCascades(transform, s_RendererContext.CurrentCamera, s_RendererData.UBO_DirectShadow);
-          s_RendererData.DirectShadowBuffer.Copy(&s_RendererData.UBO_DirectShadow, sizeof s_RendererData.UBO_DirectShadow);
-
-          for (const auto& mesh : s_MeshDrawList) {
-            if (!mesh.MeshGeometry)
-              continue;
-            RenderMesh(mesh,
-              commandBuffer.Get(),
-              s_Pipelines.DirectShadowDepthPipeline,
-              [&](const Mesh::Primitive*) {
-                struct PushConst {
-                  glm::mat4 modelMatrix{};
-                  uint32_t cascadeIndex = 0;
-                } pushConst;
-                pushConst.modelMatrix = mesh.Transform;
-                pushConst.cascadeIndex = framebufferIndex;
-                const auto& layout = s_Pipelines.DirectShadowDepthPipeline.GetPipelineLayout();
-                commandBuffer.PushConstants(layout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(PushConst), &pushConst);
-                s_Pipelines.DirectShadowDepthPipeline.BindDescriptorSets(commandBuffer.Get(), {s_ShadowDepthDescriptorSet.Get()});
-                return true;
-              });
-          }
-        }
+        //Cascades are only filled when there is a directional light. See CullMeshDrawList.
+        const auto& cascade = s_VisibleMeshes.Cascades[framebufferIndex];
+        if (cascade.CommandCount == 0)
+          return;
+
+        //Shadow depth doesn't depend on the material, the set only needs to be bound once.
+        s_Pipelines.DirectShadowDepthPipeline.BindDescriptorSets(commandBuffer.Get(), {s_ShadowDepthDescriptorSet.Current().Get()}, 0, 1, 1, &s_RendererData.DirectShadowData.Offset);
+        s_DrawStats.DescriptorSetBinds++;
+
+        const uint32_t cascadeIndex = framebufferIndex;
+        const auto& layout = s_Pipelines.DirectShadowDepthPipeline.GetPipelineLayout();
+        commandBuffer.PushConstants(layout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(uint32_t), &cascadeIndex);
+        RenderMeshes(cascade, commandBuffer.Get(), s_Pipelines.DirectShadowDepthPipeline);
       },
-      {vk::ClearDepthStencilValue{1.0f, 0}, vk::ClearColorValue(std::array{0.0f, 0.0f, 0.0f, 1.0f})},
-      &VulkanContext::VulkanQueue.GraphicsQueue);
+      {vk::ClearDepthStencilValue{1.0f, 0}, vk::ClearColorValue(std::array{0.0f, 0.0f, 0.0f, 1.0f})});
     directShadowDepthPass.SetRenderArea(vk::Rect2D{
       {}, {RendererConfig::Get()->DirectShadowsConfig.Size, RendererConfig::Get()->DirectShadowsConfig.Size},
-    }).AddToGraph(renderGraph);
+    }).Write("DirectShadows", depthStages, depthWrite)
+      .RecordInParallel()
+      .AddToGraph(renderGraph);
 
     RenderGraphPass ssaoPass(
       "SSAO Pass",
-      {&s_RendererContext.SSAOCommandBuffer},
       &s_Pipelines.SSAOPassPipeline,
       {},
       [](const VulkanCommandBuffer& commandBuffer, int32_t) {
         ZoneScopedN("SSAOPass");
         OX_TRACE_GPU(commandBuffer.Get(), "SSAO Pass")
         s_Pipelines.SSAOPassPipeline.BindPipeline(commandBuffer.Get());
-        s_Pipelines.SSAOPassPipeline.BindDescriptorSets(commandBuffer.Get(), {s_SSAODescriptorSet.Get()});
+        s_Pipelines.SSAOPassPipeline.BindDescriptorSets(commandBuffer.Get(), {s_SSAODescriptorSet.Current().Get()}, 0, 1, 1, &s_RendererData.VSData.Offset);
         commandBuffer.Dispatch((Window::GetWidth() + 8 - 1) / 8, (Window::GetHeight() + 8 - 1) / 8, 1);
       },
       {clearValues},
-      &VulkanContext::VulkanQueue.GraphicsQueue);
+      RenderGraphQueue::Compute);
     ssaoPass
      .RunWithCondition(RendererConfig::Get()->SSAOConfig.Enabled)
+     .Read("DepthNormal", computeStage)
+     .Write("SSAO", computeStage)
+     .Write("SSAOBlur", computeStage)
      .AddInnerPass(RenderGraphPass(
         "SSAO Blur Pass",
-        {},
         &s_Pipelines.GaussianBlurPipeline,
         {},
         [](VulkanCommandBuffer& commandBuffer, int32_t) {
@@ -1135,6 +1237,7 @@ namespace Oxylus {
           struct PushConst {
             GLSL_BOOL Horizontal = false;
           } pushConst;
+          commandBuffer.PushConstants(layout, vk::ShaderStageFlagBits::eCompute, 0, 4, &pushConst);
           s_Pipelines.GaussianBlurPipeline.BindDescriptorSets(commandBuffer.Get(), {s_SSAOBlurDescriptorSet.Get()});
           commandBuffer.Dispatch((Window::GetWidth() + 8 - 1) / 8, (Window::GetHeight() + 8 - 1) / 8, 1);
 
@@ -1145,9 +1248,47 @@ namespace Oxylus {
         }
       )).AddToGraphCompute(renderGraph);
 
+    RenderGraphPass frustumPass(
+      "Frustum Pass",
+      &s_Pipelines.FrustumGridPipeline,
+      {},
+      [](const VulkanCommandBuffer& commandBuffer, int32_t) {
+        ZoneScopedN("FrustumPass");
+        OX_TRACE_GPU(commandBuffer.Get(), "Frustum Pass")
+        s_Pipelines.FrustumGridPipeline.BindPipeline(commandBuffer.Get());
+        const auto offsets = GetSceneDynamicOffsets();
+        s_Pipelines.FrustumGridPipeline.BindDescriptorSets(commandBuffer.Get(), {s_ComputeDescriptorSet.Current().Get()}, 0, 1, 3, offsets.data());
+        commandBuffer.Dispatch(s_RendererData.UBO_PbrPassParams.numThreadGroups.x, s_RendererData.UBO_PbrPassParams.numThreadGroups.y, 1);
+      },
+      {},
+      RenderGraphQueue::Compute);
+    frustumPass.Write("Frustums", computeStage)
+               .AddToGraphCompute(renderGraph);
+
+    RenderGraphPass lightListPass(
+      "Light List Pass",
+      &s_Pipelines.LightListPipeline,
+      {},
+      [](const VulkanCommandBuffer& commandBuffer, int32_t) {
+        ZoneScopedN("Light List Pass");
+        OX_TRACE_GPU(commandBuffer.Get(), "Light List Pass")
+        s_Pipelines.LightListPipeline.BindPipeline(commandBuffer.Get());
+        const auto offsets = GetSceneDynamicOffsets();
+        s_Pipelines.LightListPipeline.BindDescriptorSets(commandBuffer.Get(), {s_ComputeDescriptorSet.Current().Get()}, 0, 1, 3, offsets.data());
+        commandBuffer.Dispatch(s_RendererData.UBO_PbrPassParams.numThreadGroups.x,
+          s_RendererData.UBO_PbrPassParams.numThreadGroups.y,
+          1);
+      },
+      {},
+      RenderGraphQueue::Compute);
+    //The PBR pass of the previous frame still reading the lists is waited on through the graphics timeline.
+    lightListPass.Read("Frustums", computeStage)
+                 .Read("DepthNormal", computeStage)
+                 .Write("LightList", computeStage)
+                 .AddToGraphCompute(renderGraph);
+
     RenderGraphPass pbrPass(
       "PBR Pass",
-      {&s_RendererContext.PBRPassCommandBuffer},
       &s_Pipelines.SkyboxPipeline,
       {&s_FrameBuffers.PBRPassFB},
       [](VulkanCommandBuffer& commandBuffer, int32_t) {
@@ -1157,56 +1298,46 @@ namespace Oxylus {
 
         //Skybox pass
         s_Pipelines.SkyboxPipeline.BindPipeline(commandBuffer.Get());
-        s_Pipelines.SkyboxPipeline.BindDescriptorSets(commandBuffer.Get(), {s_SkyboxDescriptorSet.Get()});
+        s_Pipelines.SkyboxPipeline.BindDescriptorSets(commandBuffer.Get(), {s_SkyboxDescriptorSet.Current().Get()}, 0, 1, 1, &s_RendererData.SkyboxData.Offset);
         const auto& skyboxLayout = s_Pipelines.SkyboxPipeline.GetPipelineLayout();
         commandBuffer.PushConstants(skyboxLayout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(glm::mat4), &s_RendererContext.CurrentCamera->SkyboxView);
         s_SkyboxCube.Draw(commandBuffer.Get());
 
         //PBR pipeline
-        for (const auto& mesh : s_MeshDrawList) {
-          if (!mesh.MeshGeometry)
-            continue;
-
-          RenderMesh(mesh,
-            commandBuffer.Get(),
-            s_Pipelines.PBRPipeline,
-            [&](const Mesh::Primitive* part) {
-              const auto& material = mesh.Materials[part->materialIndex];
-              const auto& layout = s_Pipelines.PBRPipeline.GetPipelineLayout();
-              commandBuffer.PushConstants(layout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(glm::mat4), &mesh.Transform);
-              commandBuffer.PushConstants(layout, vk::ShaderStageFlagBits::eFragment, sizeof(glm::mat4), sizeof Material::Parameters, &material->Parameters);
-
-              s_Pipelines.PBRPipeline.BindDescriptorSets(commandBuffer.Get(), {Material::s_DescriptorSet.Get(), material->MaterialDescriptorSet.Get()}, 0, 2);
-              return true;
-            });
-        }
-        s_ForceUpdateMaterials = false;
-        s_MeshDrawList.clear();
+        if (s_VisibleMeshes.Camera.CommandCount == 0)
+          return;
+        const auto offsets = GetSceneDynamicOffsets();
+        s_Pipelines.PBRPipeline.BindDescriptorSets(commandBuffer.Get(), {Material::s_DescriptorSet.Current().Get(), MaterialPool::GetDescriptorSet()}, 0, 2, (uint32_t)offsets.size(), offsets.data());
+        s_DrawStats.DescriptorSetBinds++;
+        RenderMeshes(s_VisibleMeshes.Camera, commandBuffer.Get(), s_Pipelines.PBRPipeline);
       },
-      {clearValues},
-      &VulkanContext::VulkanQueue.GraphicsQueue);
-    pbrPass.AddToGraph(renderGraph);
+      {clearValues});
+    pbrPass.Read("DirectShadows", fragmentStage)
+           .Read("LightList", fragmentStage)
+           .Write("PBR", colorStage | depthStages, colorWrite | depthWrite)
+           .RecordInParallel()
+           .AddToGraph(renderGraph);
 
     RenderGraphPass ssrPass(
       "SSR Pass",
-      {&s_RendererContext.SSRCommandBuffer},
       &s_Pipelines.SSRPipeline,
       {},
       [](const VulkanCommandBuffer& commandBuffer, int32_t) {
         ZoneScopedN("SSR Pass");
         OX_TRACE_GPU(commandBuffer.Get(), "SSR Pass")
         s_Pipelines.SSRPipeline.BindPipeline(commandBuffer.Get());
-        s_Pipelines.SSRPipeline.BindDescriptorSets(commandBuffer.Get(), {s_SSRDescriptorSet.Get()});
+        s_Pipelines.SSRPipeline.BindDescriptorSets(commandBuffer.Get(), {s_SSRDescriptorSet.Current().Get()}, 0, 1, 1, &s_RendererData.VSData.Offset);
         commandBuffer.Dispatch((Window::GetWidth() + 8 - 1) / 8, (Window::GetHeight() + 8 - 1) / 8, 1);
       },
-      clearValues,
-      &VulkanContext::VulkanQueue.GraphicsQueue);
+      clearValues);
     ssrPass.RunWithCondition(s_RendererConfig.SSRConfig.Enabled)
+           .Read("PBR", computeStage)
+           .Read("DepthNormal", computeStage)
+           .Write("SSR", computeStage)
            .AddToGraphCompute(renderGraph);
 
     RenderGraphPass bloomPass(
       "Bloom Pass",
-      {&s_RendererContext.BloomPassCommandBuffer},
       &s_Pipelines.BloomPipeline,
       {},
       [](VulkanCommandBuffer& commandBuffer, int32_t) {
@@ -1302,14 +1433,15 @@ namespace Oxylus {
           commandBuffer.Dispatch((size.x + 8 - 1) / 8, (size.y + 8 - 1) / 8, 1);
         }
       },
-      clearValues,
-      &VulkanContext::VulkanQueue.GraphicsQueue);
+      clearValues);
     bloomPass.RunWithCondition(RendererConfig::Get()->BloomConfig.Enabled)
+             .Read("PBR", computeStage)
+             .Write("BloomDownsample", computeStage)
+             .Write("BloomUpsample", computeStage)
              .AddToGraphCompute(renderGraph);
 
     RenderGraphPass dofPass(
       "DepthOfField Pass",
-      {&s_RendererContext.DepthOfFieldCommandBuffer},
       &s_Pipelines.DepthOfFieldPipeline,
       {},
       [](const VulkanCommandBuffer& commandBuffer, int32_t) {
@@ -1319,55 +1451,33 @@ namespace Oxylus {
         s_Pipelines.DepthOfFieldPipeline.BindDescriptorSets(commandBuffer.Get(), {s_DepthOfFieldDescriptorSet.Get()});
         commandBuffer.Dispatch((Window::GetWidth() + 8 - 1) / 8, (Window::GetHeight() + 8 - 1) / 8, 6);
       },
-      clearValues,
-      &VulkanContext::VulkanQueue.GraphicsQueue
-    );
-    dofPass.AddToGraphCompute(renderGraph);
+      clearValues);
+    dofPass.Read("PBR", computeStage)
+           .Read("DepthNormal", computeStage)
+           .Write("DepthOfField", computeStage)
+           .AddToGraphCompute(renderGraph);
 
     RenderGraphPass atmospherePass(
       "Atmosphere Pass",
-      {&s_RendererContext.AtmosphereCommandBuffer},
       &s_Pipelines.AtmospherePipeline,
       {},
       [](const VulkanCommandBuffer& commandBuffer, int32_t) {
         ZoneScopedN("Atmosphere Pass");
         OX_TRACE_GPU(commandBuffer.Get(), "Atmosphere Pass")
-        vk::ImageSubresourceRange subresourceRange;
-        subresourceRange.aspectMask = s_FrameBuffers.AtmosphereImage.GetDesc().AspectFlag;
-        subresourceRange.levelCount = 1;
-        subresourceRange.layerCount = 6;
-        const vk::ImageMemoryBarrier imageMemoryBarrier = {
-          {},
-          {},
-          vk::ImageLayout::eUndefined,
-          vk::ImageLayout::eGeneral,
-          0,
-          0,
-          s_FrameBuffers.AtmosphereImage.GetImage(),
-          subresourceRange
-        };
-        commandBuffer.Get().pipelineBarrier(
-          vk::PipelineStageFlagBits::eFragmentShader,
-          vk::PipelineStageFlagBits::eComputeShader,
-          {},
-          0,
-          nullptr,
-          0,
-          nullptr,
-          1,
-          &imageMemoryBarrier
-        );
         s_Pipelines.AtmospherePipeline.BindPipeline(commandBuffer.Get());
-        s_Pipelines.AtmospherePipeline.BindDescriptorSets(commandBuffer.Get(), {s_AtmosphereDescriptorSet.Get()});
-        commandBuffer.Dispatch((Window::GetWidth() + 8 - 1) / 8, (Window::GetHeight() + 8 - 1) / 8, 6);
+        s_Pipelines.AtmospherePipeline.BindDescriptorSets(commandBuffer.Get(), {s_AtmosphereDescriptorSet.Current().Get()}, 0, 1, 1, &s_RendererData.AtmosphereData.Offset);
+        //One layer per cube face.
+        const auto& atmosphereImage = s_FrameBuffers.AtmosphereImage;
+        commandBuffer.Dispatch((atmosphereImage.GetWidth() + 8 - 1) / 8, (atmosphereImage.GetHeight() + 8 - 1) / 8, 6);
       },
       clearValues,
-      &VulkanContext::VulkanQueue.GraphicsQueue);
-    //atmospherePass.AddToGraphCompute(renderGraph);
+      RenderGraphQueue::Compute);
+    //Every texel is rewritten, the graph keeps the image in the general layout.
+    atmospherePass.Write("Atmosphere", computeStage, vk::AccessFlagBits::eShaderWrite, vk::ImageLayout::eGeneral)
+                  .AddToGraphCompute(renderGraph);
 
     RenderGraphPass compositePass(
       "Composite Pass",
-      {&s_RendererContext.CompositeCommandBuffer},
       &s_Pipelines.CompositePipeline,
       {},
       [](VulkanCommandBuffer& commandBuffer, int32_t) {
@@ -1377,13 +1487,16 @@ namespace Oxylus {
         s_Pipelines.CompositePipeline.BindDescriptorSets(commandBuffer.Get(), {s_CompositeDescriptorSet.Get()});
         commandBuffer.Dispatch((Window::GetWidth() + 8 - 1) / 8, (Window::GetHeight() + 8 - 1) / 8, 1);
       },
-      clearValues,
-      &VulkanContext::VulkanQueue.GraphicsQueue);
-    compositePass.AddToGraphCompute(renderGraph);
-
-    RenderGraphPass ppPass({
+      clearValues);
+    compositePass.Read("DepthOfField", computeStage)
+                 .Read("SSAOBlur", computeStage)
+                 .Read("BloomUpsample", computeStage)
+                 .Read("SSR", computeStage)
+                 .Write("Composite", computeStage)
+                 .AddToGraphCompute(renderGraph);
+
+    RenderGraphPass ppPass(
       "PP Pass",
-      {&s_RendererContext.PostProcessCommandBuffer},
       &s_Pipelines.PostProcessPipeline,
       {&s_FrameBuffers.PostProcessPassFB},
       [](VulkanCommandBuffer& commandBuffer, int32_t) {
@@ -1394,86 +1507,10 @@ namespace Oxylus {
         s_Pipelines.PostProcessPipeline.BindDescriptorSets(commandBuffer.Get(), {s_PostProcessDescriptorSet.Get()});
         DrawFullscreenQuad(commandBuffer.Get(), true);
       },
-      clearValues, &VulkanContext::VulkanQueue.GraphicsQueue
-    });
-    ppPass.AddToGraph(renderGraph);
-
-    RenderGraphPass frustumPass(
-      "Frustum Pass",
-      {&s_RendererContext.FrustumCommandBuffer},
-      {},
-      {},
-      [](const VulkanCommandBuffer& commandBuffer, int32_t) {
-        ZoneScopedN("FrustumPass");
-        OX_TRACE_GPU(commandBuffer.Get(), "Frustum Pass")
-        s_Pipelines.FrustumGridPipeline.BindPipeline(commandBuffer.Get());
-        s_Pipelines.FrustumGridPipeline.BindDescriptorSets(s_RendererContext.FrustumCommandBuffer.Get(), {s_ComputeDescriptorSet.Get()});
-        commandBuffer.Dispatch(s_RendererData.UBO_PbrPassParams.numThreadGroups.x, s_RendererData.UBO_PbrPassParams.numThreadGroups.y, 1);
-      },
-      {},
-      &VulkanContext::VulkanQueue.GraphicsQueue);
-    //renderGraph.AddComputePass(frustumPass);
-
-    RenderGraphPass lightListPass(
-      "Light List Pass",
-      {&s_RendererContext.LightListCommandBuffer},
-      {},
-      {},
-      [](const VulkanCommandBuffer& commandBuffer, int32_t) {
-        ZoneScopedN("Light List Pass");
-        OX_TRACE_GPU(commandBuffer.Get(), "Light List Pass")
-        std::vector<vk::BufferMemoryBarrier> barriers1;
-        std::vector<vk::BufferMemoryBarrier> barriers2;
-        static bool initalizedBarries = false;
-        if (!initalizedBarries) {
-          barriers1 = {
-            s_RendererData.LightsBuffer.CreateMemoryBarrier(vk::AccessFlagBits::eShaderRead,
-              vk::AccessFlagBits::eShaderWrite),
-            s_RendererData.LighIndexBuffer.CreateMemoryBarrier(vk::AccessFlagBits::eShaderRead,
-              vk::AccessFlagBits::eShaderWrite),
-            s_RendererData.LighGridBuffer.CreateMemoryBarrier(vk::AccessFlagBits::eShaderRead,
-              vk::AccessFlagBits::eShaderWrite),
-          };
-
-          barriers2 = {
-            s_RendererData.LightsBuffer.CreateMemoryBarrier(vk::AccessFlagBits::eShaderWrite,
-              vk::AccessFlagBits::eShaderRead),
-            s_RendererData.LighIndexBuffer.CreateMemoryBarrier(vk::AccessFlagBits::eShaderWrite,
-              vk::AccessFlagBits::eShaderRead),
-            s_RendererData.LighGridBuffer.CreateMemoryBarrier(vk::AccessFlagBits::eShaderWrite,
-              vk::AccessFlagBits::eShaderRead),
-          };
-          initalizedBarries = true;
-        }
-
-        commandBuffer.Get().pipelineBarrier(vk::PipelineStageFlagBits::eFragmentShader,
-          vk::PipelineStageFlagBits::eComputeShader,
-          vk::DependencyFlagBits::eByRegion,
-          0,
-          nullptr,
-          (uint32_t)barriers1.size(),
-          barriers1.data(),
-          0,
-          nullptr);
-        s_Pipelines.LightListPipeline.BindPipeline(commandBuffer.Get());
-        s_Pipelines.LightListPipeline.BindDescriptorSets(commandBuffer.Get(), {s_ComputeDescriptorSet.Get()});
-        commandBuffer.Dispatch(s_RendererData.UBO_PbrPassParams.numThreadGroups.x,
-          s_RendererData.UBO_PbrPassParams.numThreadGroups.y,
-          1);
-        commandBuffer.Get().pipelineBarrier(vk::PipelineStageFlagBits::eFragmentShader,
-          vk::PipelineStageFlagBits::eComputeShader,
-          vk::DependencyFlagBits::eByRegion,
-          0,
-          nullptr,
-          (uint32_t)barriers2.size(),
-          barriers2.data(),
-          0,
-          nullptr);
-      },
-      {},
-      &VulkanContext::VulkanQueue.GraphicsQueue);
-
-    //renderGraph.AddComputePass(lightListPass);
+      clearValues);
+    ppPass.Read("Composite", fragmentStage)
+          .Write("Final", colorStage, colorWrite)
+          .AddToGraph(renderGraph);
   }
 
   void VulkanRenderer::Init() {
@@ -1511,18 +1548,9 @@ namespace Oxylus {
 
     s_RendererContext.TimelineCommandBuffer.CreateBuffer();
 
-    s_RendererContext.PostProcessCommandBuffer.CreateBuffer();
-    s_RendererContext.PBRPassCommandBuffer.CreateBuffer();
-    s_RendererContext.BloomPassCommandBuffer.CreateBuffer();
-    s_RendererContext.SSRCommandBuffer.CreateBuffer();
-    s_RendererContext.FrustumCommandBuffer.CreateBuffer();
-    s_RendererContext.LightListCommandBuffer.CreateBuffer();
-    s_RendererContext.DepthPassCommandBuffer.CreateBuffer();
-    s_RendererContext.SSAOCommandBuffer.CreateBuffer();
-    s_RendererContext.DirectShadowCommandBuffer.CreateBuffer();
-    s_RendererContext.CompositeCommandBuffer.CreateBuffer();
-    s_RendererContext.AtmosphereCommandBuffer.CreateBuffer();
-    s_RendererContext.DepthOfFieldCommandBuffer.CreateBuffer();
+    //Meshes and textures stream in through it from here on.
+    VulkanUploader::Init();
+
 
     vk::DescriptorSetLayoutBinding binding[1];
     binding[0].descriptorType = vk::DescriptorType::eCombinedImageSampler;
@@ -1535,30 +1563,26 @@ namespace Oxylus {
     VulkanUtils::CheckResult(
       LogicalDevice.createDescriptorSetLayout(&info, nullptr, &s_RendererData.ImageDescriptorSetLayout));
 
-    s_RendererData.SkyboxBuffer.CreateBuffer(vk::BufferUsageFlagBits::eUniformBuffer,
-      vk::MemoryPropertyFlagBits::eHostVisible |
-      vk::MemoryPropertyFlagBits::eHostCoherent,
-      sizeof RendererData::UBO_VS,
-      &s_RendererData.UBO_VS).Map();
-
-    s_RendererData.ParametersBuffer.CreateBuffer(vk::BufferUsageFlagBits::eUniformBuffer,
-      vk::MemoryPropertyFlagBits::eHostVisible |
-      vk::MemoryPropertyFlagBits::eHostCoherent,
-      sizeof RendererData::UBO_PbrPassParams,
-      &s_RendererData.UBO_PbrPassParams).Map();
-
-    s_RendererData.VSBuffer.CreateBuffer(vk::BufferUsageFlagBits::eUniformBuffer,
-      vk::MemoryPropertyFlagBits::eHostVisible |
-      vk::MemoryPropertyFlagBits::eHostCoherent,
-      sizeof RendererData::UBO_VS,
-      &s_RendererData.UBO_VS).Map();
-
-    s_RendererData.LightsBuffer.CreateBuffer(
-      vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
-      vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-      sizeof(LightingData)).Map().SetOnUpdate([] {
-      UpdateLightingData();
-    }).Sink<LightChangeEvent>(s_LightBufferDispatcher);
+    //Data that changes every frame is sub-allocated from one buffer and bound with dynamic offsets.
+    {
+      auto& frameAllocator = s_RendererData.FrameAllocator;
+      frameAllocator.Create(FRAME_ALLOCATOR_SIZE, vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
+      s_RendererData.SkyboxData.Descriptor = frameAllocator.GetDescriptor(sizeof RendererData::UBO_VS);
+      s_RendererData.VSData.Descriptor = frameAllocator.GetDescriptor(sizeof RendererData::UBO_VS);
+      s_RendererData.ParametersData.Descriptor = frameAllocator.GetDescriptor(sizeof RendererData::UBO_PbrPassParams);
+      s_RendererData.AtmosphereData.Descriptor = frameAllocator.GetDescriptor(sizeof RendererData::UBO_Atmosphere);
+      s_RendererData.DirectShadowData.Descriptor = frameAllocator.GetDescriptor(sizeof RendererData::UBO_DirectShadow);
+      s_RendererData.LightsData.Descriptor = frameAllocator.GetDescriptor((vk::DeviceSize)s_RendererData.LightCapacity * sizeof(LightingData));
+    }
+    //Gathers the lights once, every frame copies them into the frame allocator.
+    s_LightBufferDispatcher.sink<LightChangeEvent>().connect<&VulkanRenderer::UpdateLightingData>();
+
+    //Written by the light culling passes on the compute queue and read by the PBR pass, shared instead of transferred every frame.
+    const auto& queues = VulkanContext::VulkanQueue;
+    if (queues.computeQueueFamilyIndex != queues.graphicsQueueFamilyIndex) {
+      for (auto* buffer : {&s_RendererData.FrustumBuffer, &s_RendererData.LighIndexBuffer, &s_RendererData.LighGridBuffer})
+        buffer->QueueFamilies = {queues.graphicsQueueFamilyIndex, queues.computeQueueFamilyIndex};
+    }
 
     s_RendererData.FrustumBuffer.CreateBuffer(
       vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
@@ -1566,15 +1590,17 @@ namespace Oxylus {
       sizeof RendererData::Frustums,
       &s_RendererData.Frustums).Map();
 
+    //The light count of every tile.
     s_RendererData.LighGridBuffer.CreateBuffer(vk::BufferUsageFlagBits::eStorageBuffer,
       vk::MemoryPropertyFlagBits::eHostVisible |
       vk::MemoryPropertyFlagBits::eHostCoherent,
-      sizeof(uint32_t) * MAX_NUM_FRUSTUMS * MAX_NUM_LIGHTS_PER_TILE).Map();
+      sizeof(uint32_t) * MAX_NUM_FRUSTUMS).Map();
 
+    //Up to MAX_NUM_LIGHTS_PER_TILE light indices for every tile.
     s_RendererData.LighIndexBuffer.CreateBuffer(vk::BufferUsageFlagBits::eStorageBuffer,
       vk::MemoryPropertyFlagBits::eHostVisible |
       vk::MemoryPropertyFlagBits::eHostCoherent,
-      sizeof(uint32_t) * MAX_NUM_FRUSTUMS).Map();
+      sizeof(uint32_t) * MAX_NUM_FRUSTUMS * MAX_NUM_LIGHTS_PER_TILE).Map();
 
     s_RendererData.SSRBuffer.CreateBuffer(vk::BufferUsageFlagBits::eUniformBuffer,
       vk::MemoryPropertyFlagBits::eHostVisible |
@@ -1594,10 +1620,6 @@ namespace Oxylus {
 
       s_RendererData.UBO_Atmosphere.InvViews[4] = glm::inverse(Camera::GenerateViewMatrix({}, Vec3(0.0f, 0.0f, 1.0f), Vec3(0.0f, -1.0f, 0.0f))); // PositiveZ
       s_RendererData.UBO_Atmosphere.InvViews[5] = glm::inverse(Camera::GenerateViewMatrix({}, Vec3(0.0f, 0.0f, -1.0f), Vec3(0.0f, -1.0f, 0.0f))); // NegativeZ
-      s_RendererData.AtmosphereBuffer.CreateBuffer(vk::BufferUsageFlagBits::eUniformBuffer,
-        vk::MemoryPropertyFlagBits::eHostVisible |
-        vk::MemoryPropertyFlagBits::eHostCoherent,
-        sizeof RendererData::UBO_Atmosphere).Map();
     }
 
     s_RendererData.SSAOBuffer.CreateBuffer(vk::BufferUsageFlagBits::eUniformBuffer,
@@ -1625,14 +1647,6 @@ namespace Oxylus {
       }).Sink<RendererConfig::ConfigChangeEvent>(RendererConfig::Get()->ConfigChangeDispatcher);
     }
 
-    //Direct shadow buffer
-    {
-      s_RendererData.DirectShadowBuffer.CreateBuffer(vk::BufferUsageFlagBits::eUniformBuffer,
-        vk::MemoryPropertyFlagBits::eHostVisible,
-        sizeof RendererData::UBO_DirectShadow,
-        &s_RendererData.UBO_DirectShadow).Map();
-    }
-
     //Create Triangle Buffers for rendering a single triangle.
     {
       std::vector<RendererData::Vertex> vertexBuffer = {
@@ -1665,14 +1679,31 @@ namespace Oxylus {
     }
 
     //Lights data
-    s_PointLightsData.reserve(MAX_NUM_LIGHTS);
+    s_PointLightsData.reserve(INITIAL_LIGHT_CAPACITY);
 
     //Mesh data
-    s_MeshDrawList.reserve(MAX_NUM_MESHES);
+    s_MeshDrawChunks.resize(1);
+    s_MeshDrawChunks[0].reserve(MAX_NUM_MESHES);
+    GeometryPool::Init();
+
+    for (uint32_t frame = 0; frame < MAX_FRAMES_IN_FLIGHT; frame++) {
+      s_RendererData.InstanceBuffer[frame].CreateBuffer(vk::BufferUsageFlagBits::eVertexBuffer,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+        sizeof(InstanceData) * MAX_NUM_MESHES).Map();
+      s_RendererData.IndirectBuffer[frame].CreateBuffer(vk::BufferUsageFlagBits::eIndirectBuffer,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+        sizeof(vk::DrawIndexedIndirectCommand) * MAX_NUM_MESHES).Map();
+    }
+
+    //Device features are enabled as reported by the physical device. See VulkanContext.
+    s_MultiDrawIndirect = VulkanContext::Context.DeviceFeatures.multiDrawIndirect;
+    s_DrawIndirectFirstInstance = VulkanContext::Context.DeviceFeatures.drawIndirectFirstInstance;
 
     Resources::InitEngineResources();
 
     s_SkyboxCube.LoadFromFile(Resources::GetResourcesPath("Objects/cube.gltf").string(), Mesh::FlipY | Mesh::DontCreateMaterials);
+    //The prefilter passes below draw it right away.
+    s_SkyboxCube.Geometry.Upload.Wait();
 
     VulkanImageDescription CubeMapDesc{};
     //temp fail-safe until we have an actual atmosphere or load the sky from scene
@@ -1683,28 +1714,34 @@ namespace Oxylus {
     CubeMapDesc.Type = ImageType::TYPE_CUBE;
     s_Resources.CubeMap.Create(CubeMapDesc);
 
+    VulkanPipeline::LoadPipelineCache();
     CreateGraphicsPipelines();
+    //Saved right away so later runs benefit even if this one doesn't shut down cleanly.
+    VulkanPipeline::SavePipelineCache();
     CreateFramebuffers();
 
     s_QuadDescriptorSet.CreateFromPipeline(s_Pipelines.QuadPipeline);
-    s_SkyboxDescriptorSet.CreateFromPipeline(s_Pipelines.SkyboxPipeline);
-    s_ComputeDescriptorSet.CreateFromPipeline(s_Pipelines.LightListPipeline);
-    s_SSAODescriptorSet.CreateFromPipeline(s_Pipelines.SSAOPassPipeline);
+    CreateFrameDescriptorSets(s_SkyboxDescriptorSet, s_Pipelines.SkyboxPipeline);
+    CreateFrameDescriptorSets(s_ComputeDescriptorSet, s_Pipelines.LightListPipeline);
+    CreateFrameDescriptorSets(s_SSAODescriptorSet, s_Pipelines.SSAOPassPipeline);
     s_SSAOBlurDescriptorSet.CreateFromPipeline(s_Pipelines.GaussianBlurPipeline);
     s_PostProcessDescriptorSet.CreateFromPipeline(s_Pipelines.PostProcessPipeline);
     s_BloomDescriptorSet.CreateFromPipeline(s_Pipelines.BloomPipeline);
     s_DepthDescriptorSet.CreateFromPipeline(s_Pipelines.DepthPrePassPipeline);
-    s_ShadowDepthDescriptorSet.CreateFromPipeline(s_Pipelines.DirectShadowDepthPipeline);
-    s_SSRDescriptorSet.CreateFromPipeline(s_Pipelines.SSRPipeline);
+    CreateFrameDescriptorSets(s_ShadowDepthDescriptorSet, s_Pipelines.DirectShadowDepthPipeline);
+    CreateFrameDescriptorSets(s_SSRDescriptorSet, s_Pipelines.SSRPipeline);
     s_CompositeDescriptorSet.CreateFromPipeline(s_Pipelines.CompositePipeline);
-    s_AtmosphereDescriptorSet.CreateFromPipeline(s_Pipelines.AtmospherePipeline);
+    CreateFrameDescriptorSets(s_AtmosphereDescriptorSet, s_Pipelines.AtmospherePipeline);
     s_DepthOfFieldDescriptorSet.CreateFromPipeline(s_Pipelines.DepthOfFieldPipeline);
+    CreateFrameDescriptorSets(Material::s_DescriptorSet, s_Pipelines.PBRPipeline);
+    MaterialPool::Init(s_Pipelines.PBRPipeline, 1);
 
     GeneratePrefilter();
 
     UpdateSkyboxDescriptorSets();
     UpdateComputeDescriptorSets();
     UpdateSSAODescriptorSets();
+    UpdateSceneDescriptorSets();
     s_FrameBuffers.PBRPassFB.GetDescription().OnResize();
     s_FrameBuffers.PostProcessPassFB.GetDescription().OnResize();
     for (auto& fb : s_FrameBuffers.DirectionalCascadesFB)
@@ -1731,6 +1768,14 @@ namespace Oxylus {
 
   void VulkanRenderer::Shutdown() {
     RendererConfig::Get()->SaveConfig("renderer.oxconfig");
+    //Picks up pipelines recreated by shader reloads.
+    VulkanPipeline::SavePipelineCache();
+    VulkanPipeline::DestroyPipelineCache();
+    VulkanUploader::Shutdown();
+    GeometryPool::Shutdown();
+    MaterialPool::Shutdown();
+    DescriptorUpdateQueue::Clear();
+    s_RendererData.FrameAllocator.Destroy();
 #if GPU_PROFILER_ENABLED
     TracyProfiler::DestroyContext();
 #endif
@@ -1752,7 +1797,10 @@ namespace Oxylus {
     CommandBuffer.Begin(beginInfo);
     submitFunc();
     CommandBuffer.End();
-    VulkanUtils::CheckResult(GraphicsQueue.submit(endInfo));
+    {
+      std::lock_guard lock(VulkanContext::VulkanQueue.SubmitMutex);
+      VulkanUtils::CheckResult(GraphicsQueue.submit(endInfo));
+    }
     WaitDeviceIdle();
   }
 
@@ -1760,19 +1808,16 @@ namespace Oxylus {
     VulkanCommandBuffer cmdBuffer;
     cmdBuffer.CreateBuffer();
     cmdBuffer.Begin(vk::CommandBufferBeginInfo{vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+    //Work submitted here may read streamed data, e.g. the prefilter passes drawing the skybox cube.
+    const uint64_t uploadValue = VulkanUploader::AcquireCompleted(cmdBuffer);
     submitFunc(cmdBuffer);
     cmdBuffer.End();
-    cmdBuffer.FlushBuffer();
+    cmdBuffer.FlushBuffer(uploadValue);
     cmdBuffer.FreeBuffer();
   }
 
   void VulkanRenderer::SubmitQueue(const VulkanCommandBuffer& commandBuffer) {
-    vk::SubmitInfo end_info = {};
-    end_info.commandBufferCount = 1;
-    end_info.pCommandBuffers = &commandBuffer.Get();
-
-    VulkanUtils::CheckResult(VulkanContext::VulkanQueue.GraphicsQueue.submit(1, &end_info, VK_NULL_HANDLE));
-    WaitDeviceIdle();
+    commandBuffer.FlushBuffer();
   }
 
   void VulkanRenderer::SubmitLights(std::vector<Entity>&& lights) {
@@ -1786,13 +1831,25 @@ namespace Oxylus {
     s_RendererData.UBO_PbrPassParams.lodBias = skyLight.CubemapLodBias;
     if (skyLight.Cubemap && skyLight.Cubemap->LoadCallback) {
       s_Resources.CubeMap = *skyLight.Cubemap;
-      s_ForceUpdateMaterials = true;
+      //Frames in flight keep drawing the previous sky, nothing waits for the GPU.
+      UpdateSkyboxDescriptorSets();
+      UpdateSceneDescriptorSets();
       skyLight.Cubemap->LoadCallback = false;
     }
   }
 
-  void VulkanRenderer::SubmitMesh(Mesh& mesh, const Mat4& transform, std::vector<Ref<Material>>& materials, uint32_t submeshIndex) {
-    s_MeshDrawList.emplace_back(mesh, transform, materials, submeshIndex);
+  void VulkanRenderer::SubmitMesh(Mesh& mesh,
+                                  const Mat4& transform,
+                                  std::vector<Ref<Material>>& materials,
+                                  uint32_t submeshIndex,
+                                  uint32_t chunkIndex) {
+    s_MeshDrawChunks[chunkIndex].emplace_back(mesh, transform, materials, submeshIndex);
+  }
+
+  void VulkanRenderer::BeginMeshSubmission(const uint32_t chunkCount) {
+    //Chunks are only grown here, earlier submissions of this frame stay in place.
+    if (s_MeshDrawChunks.size() < chunkCount)
+      s_MeshDrawChunks.resize(chunkCount);
   }
 
   void VulkanRenderer::SubmitQuad(const Mat4& transform, const Ref<VulkanImage>& image, const Vec4& color) {
@@ -1807,37 +1864,271 @@ namespace Oxylus {
     s_RendererContext.CurrentCamera = &camera;
   }
 
-  void VulkanRenderer::RenderNode(const Mesh::Node* node,
-                                  const vk::CommandBuffer& commandBuffer,
-                                  const VulkanPipeline& pipeline,
-                                  const std::function<bool(Mesh::Primitive* prim)>& perMeshFunc) {
-    for (const auto& part : node->Primitives) {
-      if (!perMeshFunc(part))
+  void VulkanRenderer::CullMeshDrawList() {
+    ZoneScoped;
+    const Camera* camera = s_RendererContext.CurrentCamera;
+
+    CullView view;
+    view.CameraFrustum = Frustum::FromMatrix(camera->GetProjectionMatrix() * camera->GetViewMatrix());
+    view.ViewPosition = camera->GetPosition();
+    view.MaxDistance = std::max(camera->FarClip, 0.001f);
+
+    //Cascade matrices are needed up front to cull shadow casters per cascade.
+    for (const auto& e : s_SceneLights) {
+      if (e.GetComponent<LightComponent>().Type != LightComponent::LightType::Directional)
         continue;
-      commandBuffer.drawIndexed(part->indexCount, 1, part->firstIndex, 0, 0);
+      UpdateCascades(e.GetWorldTransform(), s_RendererContext.CurrentCamera, s_RendererData.UBO_DirectShadow);
+      view.HasCascades = true;
     }
-    for (const auto& child : node->Children) {
-      RenderNode(child, commandBuffer, pipeline, perMeshFunc);
+    //Bound by the PBR pass even without a directional light.
+    s_RendererData.FrameAllocator.Push(s_RendererData.UBO_DirectShadow, s_RendererData.DirectShadowData.Offset);
+    if (view.HasCascades) {
+      for (uint32_t i = 0; i < SHADOW_MAP_CASCADE_COUNT; i++)
+        view.CascadeFrustums[i] = Frustum::FromMatrix(s_RendererData.UBO_DirectShadow.cascadeViewProjMat[i]);
     }
+
+    //One job per submission chunk, every job only writes to its own cull chunk.
+    const uint32_t chunkCount = (uint32_t)s_MeshDrawChunks.size();
+    s_CullChunks.resize(chunkCount);
+    JobSystem::ParallelFor(chunkCount,
+      chunkCount,
+      [&view](const uint32_t chunkIndex, uint32_t, uint32_t) {
+        CullMeshChunk(s_MeshDrawChunks[chunkIndex], view, s_CullChunks[chunkIndex]);
+      });
+
+    //Merge in chunk order.
+    {
+      ZoneScopedN("Merge Cull Chunks");
+      for (uint32_t listIndex = 0; listIndex < VisibleMeshLists::LIST_COUNT; listIndex++) {
+        auto& list = s_VisibleMeshes.Get(listIndex);
+        list.Clear();
+        size_t count = 0;
+        for (auto& chunk : s_CullChunks)
+          count += chunk.Lists.Get(listIndex).Items.size();
+        list.Items.reserve(count);
+        list.Keys.reserve(count);
+        for (auto& chunk : s_CullChunks) {
+          const auto& chunkList = chunk.Lists.Get(listIndex);
+          list.Items.insert(list.Items.end(), chunkList.Items.begin(), chunkList.Items.end());
+          list.Keys.insert(list.Keys.end(), chunkList.Keys.begin(), chunkList.Keys.end());
+        }
+      }
+
+      //Material updates touch descriptor sets so they stay on this thread.
+      for (auto& chunk : s_CullChunks) {
+        for (Mesh* mesh : chunk.MaterialUpdates) {
+          //The same mesh can be queued by several entities.
+          if (!mesh->ShouldUpdate)
+            continue;
+          mesh->UpdateMaterials();
+          mesh->ShouldUpdate = false;
+        }
+      }
+    }
+
+    for (uint32_t listIndex = 0; listIndex < VisibleMeshLists::LIST_COUNT; listIndex++)
+      SortDrawItems(s_VisibleMeshes.Get(listIndex));
+
+    s_InstanceData.clear();
+    s_DrawCommands.clear();
+    BuildDrawCommands(s_VisibleMeshes.DepthPrePass);
+    BuildDrawCommands(s_VisibleMeshes.Camera);
+    for (auto& cascade : s_VisibleMeshes.Cascades)
+      BuildDrawCommands(cascade);
+    UploadDrawCommands();
   }
 
-  void VulkanRenderer::RenderMesh(const MeshData& mesh,
-                                  const vk::CommandBuffer& commandBuffer,
-                                  const VulkanPipeline& pipeline,
-                                  const std::function<bool(Mesh::Primitive* prim)>& perMeshFunc) {
-    pipeline.BindPipeline(commandBuffer);
+  void VulkanRenderer::CullMeshChunk(const std::vector<MeshData>& meshes, const CullView& view, CullChunk& chunk) {
+    ZoneScoped;
+    for (uint32_t i = 0; i < VisibleMeshLists::LIST_COUNT; i++)
+      chunk.Lists.Get(i).Clear();
+    chunk.MaterialUpdates.clear();
+
+    std::vector<const Mesh::Node*> nodeStack;
+    for (const auto& mesh : meshes) {
+      //Still streaming in.
+      if (!mesh.MeshGeometry || !mesh.MeshGeometry.Geometry.IsResident())
+        continue;
+
+      if (mesh.MeshGeometry.ShouldUpdate) {
+        chunk.MaterialUpdates.emplace_back(&mesh.MeshGeometry);
+        continue;
+      }
+
+      //Submeshes draw their node and all of its children.
+      nodeStack.push_back(mesh.MeshGeometry.LinearNodes[mesh.SubmeshIndex]);
+      while (!nodeStack.empty()) {
+        const Mesh::Node* node = nodeStack.back();
+        nodeStack.pop_back();
+        for (const auto& child : node->Children)
+          nodeStack.push_back(child);
+
+        for (const auto* primitive : node->Primitives) {
+          const auto& dimensions = primitive->dimensions;
+          const AABB bounds = AABB(dimensions.min, dimensions.max).Transform(mesh.Transform);
+          const MeshDrawItem item{&mesh, primitive};
+
+          //Opaque geometry front to back to help early depth rejection. Shadow casters only need state grouping.
+          if (view.CameraFrustum.IsVisible(bounds)) {
+            const float depth = glm::distance(bounds.GetCenter(), view.ViewPosition) / view.MaxDistance;
+            chunk.Lists.Camera.Add(item, MakeDrawKey(DRAW_PASS_PBR, item, depth));
+            if (mesh.Materials[primitive->materialIndex]->IsOpaque())
+              chunk.Lists.DepthPrePass.Add(item, MakeDrawKey(DRAW_PASS_DEPTH, item, depth));
+          }
+
+          if (!view.HasCascades)
+            continue;
+          for (uint32_t i = 0; i < SHADOW_MAP_CASCADE_COUNT; i++) {
+            if (view.CascadeFrustums[i].IsVisible(bounds, Frustum::SHADOW_CASTER_PLANES))
+              chunk.Lists.Cascades[i].Add(item, MakeDrawKey(DRAW_PASS_SHADOW, item, 0.0f));
+          }
+        }
+      }
+    }
+  }
+
+  uint64_t VulkanRenderer::MakeDrawKey(const DrawPass pass, const MeshDrawItem& item, const float depth) {
+    const Material* material = item.Data->Materials[item.Primitive->materialIndex].get();
+    //Every pass uses a single pipeline for meshes for now, so the pass doubles as the pipeline id.
+    return DrawPacketBuilder::MakeKey(pass,
+      pass,
+      DrawPacketBuilder::GetID(material),
+      DrawPacketBuilder::GetID(item.Primitive),
+      depth);
+  }
+
+  void VulkanRenderer::SortDrawItems(MeshDrawList& drawList) {
+    ZoneScoped;
+    if (drawList.Items.size() < 2)
+      return;
+
+    auto& builder = s_DrawPacketBuilder;
+    builder.Begin(drawList.Items.size());
+    for (uint32_t i = 0; i < (uint32_t)drawList.Items.size(); i++)
+      builder.Add(drawList.Keys[i], i);
+    builder.Sort();
+
+    static std::vector<MeshDrawItem> sortedItems;
+    sortedItems.clear();
+    sortedItems.reserve(drawList.Items.size());
+    for (const auto& packet : builder.GetPackets()) {
+      sortedItems.emplace_back(drawList.Items[packet.Index]);
+      drawList.Keys[sortedItems.size() - 1] = packet.Key;
+    }
+    drawList.Items.swap(sortedItems);
+  }
+
+  void VulkanRenderer::BuildDrawCommands(MeshDrawList& drawList) {
+    drawList.FirstCommand = (uint32_t)s_DrawCommands.size();
+    drawList.CommandCount = 0;
+
+    const Material* lastMaterial = nullptr;
+    uint32_t materialIndex = MaterialPool::DEFAULT_MATERIAL;
+    const Mesh::Primitive* lastPrimitive = nullptr;
+    for (const auto& item : drawList.Items) {
+      //Sorting groups items by material, its record only has to be written once per run.
+      const Material* material = item.Data->Materials[item.Primitive->materialIndex].get();
+      if (material != lastMaterial) {
+        materialIndex = MaterialPool::Write(*material);
+        lastMaterial = material;
+      }
 
-    if (mesh.MeshGeometry.ShouldUpdate || s_ForceUpdateMaterials) {
-      mesh.MeshGeometry.UpdateMaterials();
-      mesh.MeshGeometry.ShouldUpdate = false;
+      //Instance data is appended in item order so the instances of a command stay contiguous.
+      s_InstanceData.emplace_back(InstanceData{item.Data->Transform, materialIndex});
+
+      //Adjacent copies of a primitive become instances. The key sorts by material before geometry, so only copies
+      //sharing a material end up adjacent, the per instance material index would allow merging across materials.
+      if (item.Primitive == lastPrimitive) {
+        s_DrawCommands.back().instanceCount++;
+        continue;
+      }
+
+      const auto& geometry = item.Data->MeshGeometry.Geometry;
+      vk::DrawIndexedIndirectCommand command;
+      command.indexCount = item.Primitive->indexCount;
+      command.instanceCount = 1;
+      command.firstIndex = geometry.FirstIndex + item.Primitive->firstIndex;
+      command.vertexOffset = (int32_t)geometry.FirstVertex;
+      command.firstInstance = (uint32_t)s_InstanceData.size() - 1;
+      s_DrawCommands.emplace_back(command);
+      drawList.CommandCount++;
+      lastPrimitive = item.Primitive;
+    }
+  }
+
+  void VulkanRenderer::UploadDrawCommands() {
+    ZoneScoped;
+    auto& instanceBuffer = s_RendererData.InstanceBuffer.Current();
+    auto& indirectBuffer = s_RendererData.IndirectBuffer.Current();
+    const vk::DeviceSize instanceSize = s_InstanceData.size() * sizeof(InstanceData);
+    const vk::DeviceSize commandSize = s_DrawCommands.size() * sizeof(vk::DrawIndexedIndirectCommand);
+
+    //The GPU is done with this frame's copies once its fence was waited on, they can be recreated right away.
+    if (instanceSize > instanceBuffer.Size) {
+      instanceBuffer.Destroy();
+      instanceBuffer.CreateBuffer(vk::BufferUsageFlagBits::eVertexBuffer,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+        instanceSize * 2).Map();
+    }
+    if (commandSize > indirectBuffer.Size) {
+      indirectBuffer.Destroy();
+      indirectBuffer.CreateBuffer(vk::BufferUsageFlagBits::eIndirectBuffer,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+        commandSize * 2).Map();
+    }
+
+    instanceBuffer.Copy(s_InstanceData);
+    indirectBuffer.Copy(s_DrawCommands);
+  }
+
+  void VulkanRenderer::DrawIndexedIndirect(const vk::CommandBuffer& commandBuffer, const MeshDrawList& drawList) {
+    constexpr uint32_t stride = sizeof(vk::DrawIndexedIndirectCommand);
+    const uint32_t firstCommand = drawList.FirstCommand;
+    const uint32_t commandCount = drawList.CommandCount;
+    uint32_t instances = 0;
+    for (uint32_t i = firstCommand; i < firstCommand + commandCount; i++)
+      instances += s_DrawCommands[i].instanceCount;
+    s_DrawStats.DrawCommands += commandCount;
+    s_DrawStats.Instances += instances;
+
+    //Instance data is addressed through firstInstance which indirect commands can only use with the feature.
+    if (!s_DrawIndirectFirstInstance || !s_IndirectDraws) {
+      for (uint32_t i = firstCommand; i < firstCommand + commandCount; i++) {
+        const auto& command = s_DrawCommands[i];
+        commandBuffer.drawIndexed(command.indexCount, command.instanceCount, command.firstIndex, command.vertexOffset, command.firstInstance);
+      }
+      s_DrawStats.DrawCalls += commandCount;
+      return;
+    }
+
+    const vk::Buffer indirectBuffer = s_RendererData.IndirectBuffer.Current().Get();
+    if (s_MultiDrawIndirect) {
+      commandBuffer.drawIndexedIndirect(indirectBuffer, (vk::DeviceSize)firstCommand * stride, commandCount, stride);
+      s_DrawStats.DrawCalls++;
       return;
     }
 
+    for (uint32_t i = firstCommand; i < firstCommand + commandCount; i++)
+      commandBuffer.drawIndexedIndirect(indirectBuffer, (vk::DeviceSize)i * stride, 1, stride);
+    s_DrawStats.DrawCalls += commandCount;
+  }
+
+  void VulkanRenderer::RenderMeshes(const MeshDrawList& drawList,
+                                    const vk::CommandBuffer& commandBuffer,
+                                    const VulkanPipeline& pipeline) {
+    if (drawList.CommandCount == 0)
+      return;
+
+    pipeline.BindPipeline(commandBuffer);
+    s_DrawStats.PipelineBinds++;
+
+    //Every mesh lives in the geometry pool so the buffers are bound once for the whole list.
+    GeometryPool::Bind(commandBuffer);
     constexpr vk::DeviceSize offsets[1] = {0};
-    commandBuffer.bindVertexBuffers(0, mesh.MeshGeometry.VerticiesBuffer.Get(), offsets);
-    commandBuffer.bindIndexBuffer(mesh.MeshGeometry.IndiciesBuffer.Get(), 0, vk::IndexType::eUint32);
+    commandBuffer.bindVertexBuffers(INSTANCE_BINDING, s_RendererData.InstanceBuffer.Current().Get(), offsets);
+    s_DrawStats.VertexBufferBinds++;
 
-    RenderNode(mesh.MeshGeometry.LinearNodes[mesh.SubmeshIndex], commandBuffer, pipeline, perMeshFunc);
+    DrawIndexedIndirect(commandBuffer, drawList);
   }
 
   void VulkanRenderer::Draw() {
@@ -1847,12 +2138,30 @@ namespace Oxylus {
       return;
     }
 
-    UpdateUniformBuffers();
+    //Copies queued since the last frame start on the transfer queue while this one is recorded.
+    VulkanUploader::Flush();
 
-    if (!s_RendererContext.RenderGraph.Update(SwapChain, &SwapChain.CurrentFrame)) {
+    //Everything written below belongs to the current frame in flight, wait for the GPU to release it first.
+    if (!s_RendererContext.RenderGraph.BeginFrame(SwapChain)) {
+      for (auto& chunk : s_MeshDrawChunks)
+        chunk.clear();
       return;
     }
 
+    s_DrawStats.Reset();
+    if (s_RendererData.FrameAllocator.HasOverflowed())
+      GrowFrameAllocator();
+    s_RendererData.FrameAllocator.BeginFrame();
+    MaterialPool::BeginFrame();
+    GeometryPool::BeginFrame();
+    DescriptorUpdateQueue::Flush();
+    UpdateUniformBuffers();
+    CullMeshDrawList();
+
+    s_RendererContext.RenderGraph.Update();
+    for (auto& chunk : s_MeshDrawChunks)
+      chunk.clear();
+
     SwapChain.SubmitPass([](const VulkanCommandBuffer& commandBuffer) {
       ZoneScopedN("Swapchain pass");
       OX_TRACE_GPU(commandBuffer.Get(), "Swapchain Pass")
@@ -1888,10 +2197,12 @@ namespace Oxylus {
 
   void VulkanRenderer::WaitDeviceIdle() {
     const auto& LogicalDevice = VulkanContext::Context.Device;
+    std::lock_guard lock(VulkanContext::VulkanQueue.SubmitMutex);
     VulkanUtils::CheckResult(LogicalDevice.waitIdle());
   }
 
   void VulkanRenderer::WaitGraphicsQueueIdle() {
+    std::lock_guard lock(VulkanContext::VulkanQueue.SubmitMutex);
     VulkanUtils::CheckResult(VulkanContext::VulkanQueue.GraphicsQueue.waitIdle());
   }
 }
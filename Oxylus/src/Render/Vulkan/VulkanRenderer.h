@@ -4,13 +4,17 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm.hpp>
 
+#include "PerFrame.h"
 #include "VulkanCommandBuffer.h"
+#include "VulkanFrameAllocator.h"
 #include "VulkanSwapchain.h"
 #include "VulkanFramebuffer.h"
 #include "VulkanPipeline.h"
 #include "Core/Components.h"
 
 #include "Render/Camera.h"
+#include "Render/DrawPacket.h"
+#include "Render/Frustum.h"
 #include "Render/RendererConfig.h"
 #include "Render/RenderGraph.h"
 
@@ -19,13 +23,20 @@ namespace Oxylus {
   using vSS = vk::ShaderStageFlagBits;
 
   class Entity;
-  constexpr auto MAX_NUM_LIGHTS = 1000;
+  //Lights get more room when a scene has more of them, limited by the frame allocator.
+  constexpr auto INITIAL_LIGHT_CAPACITY = 1000;
+  constexpr auto FRAME_ALLOCATOR_SIZE = 4 * 1024 * 1024;
   constexpr auto MAX_NUM_MESHES = 1000;
   constexpr auto MAX_NUM_LIGHTS_PER_TILE = 128;
   constexpr auto MAX_NUM_FRUSTUMS = 20000;
   constexpr auto PIXELS_PER_TILE = 16;
   constexpr auto TILES_PER_THREADGROUP = 16;
   constexpr auto SHADOW_MAP_CASCADE_COUNT = 4;
+  constexpr auto INSTANCE_BINDING = 1;
+  static_assert(INSTANCE_BINDING != VertexFormat::STREAM_BINDINGS[VertexFormat::Color] &&
+                INSTANCE_BINDING != VertexFormat::STREAM_BINDINGS[VertexFormat::Skin], "Instance data shares its binding with a vertex stream");
+  constexpr auto INSTANCE_TRANSFORM_LOCATION = 4;
+  constexpr auto INSTANCE_MATERIAL_LOCATION = 8;
 
   class VulkanRenderer {
   public:
@@ -34,19 +45,7 @@ namespace Oxylus {
       bool Initialized = false;
 
       vk::DescriptorPool DescriptorPool;
-      VulkanCommandBuffer LightListCommandBuffer;
       VulkanCommandBuffer TimelineCommandBuffer;
-      VulkanCommandBuffer DirectShadowCommandBuffer;
-      VulkanCommandBuffer PBRPassCommandBuffer;
-      VulkanCommandBuffer PostProcessCommandBuffer;
-      VulkanCommandBuffer BloomPassCommandBuffer;
-      VulkanCommandBuffer FrustumCommandBuffer;
-      VulkanCommandBuffer DepthPassCommandBuffer;
-      VulkanCommandBuffer SSAOCommandBuffer;
-      VulkanCommandBuffer SSRCommandBuffer;
-      VulkanCommandBuffer CompositeCommandBuffer;
-      VulkanCommandBuffer AtmosphereCommandBuffer;
-      VulkanCommandBuffer DepthOfFieldCommandBuffer;
 
       vk::CommandPool CommandPool;
 
@@ -132,18 +131,33 @@ namespace Oxylus {
         float Time = 0.15f; // Not used by shader.
       } UBO_Atmosphere;
 
-      VulkanBuffer SkyboxBuffer;
-      VulkanBuffer ParametersBuffer;
-      VulkanBuffer VSBuffer;
-      VulkanBuffer LightsBuffer;
+      //Uniform and light data is written every frame into the frame allocator and bound with dynamic offsets.
+      struct DynamicBinding {
+        vk::DescriptorBufferInfo Descriptor;
+        //Where the current frame's copy starts.
+        uint32_t Offset = 0;
+      };
+
+      VulkanFrameAllocator FrameAllocator;
+      DynamicBinding SkyboxData;
+      DynamicBinding ParametersData;
+      DynamicBinding VSData;
+      DynamicBinding LightsData;
+      DynamicBinding DirectShadowData;
+      DynamicBinding AtmosphereData;
+      uint32_t LightCapacity = INITIAL_LIGHT_CAPACITY;
+
+      //Written every frame, one copy per frame in flight.
+      PerFrame<VulkanBuffer> InstanceBuffer;
+      PerFrame<VulkanBuffer> IndirectBuffer;
+
+      //Only written by the GPU or on config changes.
       VulkanBuffer FrustumBuffer;
       VulkanBuffer LighIndexBuffer;
       VulkanBuffer LighGridBuffer;
       VulkanBuffer SSAOBuffer;
       VulkanBuffer PostProcessBuffer;
-      VulkanBuffer DirectShadowBuffer;
       VulkanBuffer SSRBuffer;
-      VulkanBuffer AtmosphereBuffer;
 
       vk::DescriptorSetLayout ImageDescriptorSetLayout;
     } s_RendererData;
@@ -202,9 +216,16 @@ namespace Oxylus {
     static void CreateGraphicsPipelines();
     static void CreateFramebuffers();
     static void ResizeBuffers();
+    //Descriptor set updates are deferred until each frame in flight comes around again. See DescriptorUpdateQueue.
     static void UpdateSkyboxDescriptorSets();
     static void UpdateComputeDescriptorSets();
     static void UpdateSSAODescriptorSets();
+    static void UpdateSceneDescriptorSets();
+    /**
+     * \brief Allocates one copy of a pipeline's descriptor set per frame in flight.
+     * Frame data is bound with dynamic offsets so every copy has the same writes, call Update on each set afterwards.
+     */
+    static void CreateFrameDescriptorSets(PerFrame<VulkanDescriptorSet>& sets, const VulkanPipeline& pipeline, uint32_t layoutIndex = 0);
 
     //Queue
     static void Submit(const std::function<void()>& submitFunc);
@@ -218,10 +239,15 @@ namespace Oxylus {
     //Drawing
     static void Draw();
     static void DrawFullscreenQuad(const vk::CommandBuffer& commandBuffer, bool bindVertex = false);
-    static void SubmitMesh(Mesh& mesh, const Mat4& transform, std::vector<Ref<Material>>& materials, uint32_t submeshIndex);
+    //Meshes can be submitted from parallel jobs as long as every job uses its own chunk. See BeginMeshSubmission.
+    static void SubmitMesh(Mesh& mesh, const Mat4& transform, std::vector<Ref<Material>>& materials, uint32_t submeshIndex, uint32_t chunkIndex = 0);
+    static void BeginMeshSubmission(uint32_t chunkCount);
     static void SubmitQuad(const Mat4& transform, const Ref<VulkanImage>& image, const Vec4& color);
 
     static const VulkanImage& GetFinalImage();
+    static const DrawStats& GetDrawStats() { return s_DrawStats; }
+    //Disabled, the commands of every draw list are drawn one by one from the CPU. Render tests compare both paths.
+    static void SetIndirectDraws(const bool enabled) { s_IndirectDraws = enabled; }
 
     static void SetCamera(Camera& camera);
 
@@ -245,16 +271,100 @@ namespace Oxylus {
                                               SubmeshIndex(submeshIndex) {}
     };
 
-    static std::vector<MeshData> s_MeshDrawList;
+    //Submitted meshes, one list per submission chunk.
+    static std::vector<std::vector<MeshData>> s_MeshDrawChunks;
+
+    //Culling
+    struct MeshDrawItem {
+      const MeshData* Data;
+      const Mesh::Primitive* Primitive;
+    };
+
+    struct MeshDrawList {
+      std::vector<MeshDrawItem> Items;
+      std::vector<uint64_t> Keys; //Sort keys, parallel to Items
+      //Indirect commands of the list, materials are indexed per instance so they draw without binds in between.
+      uint32_t FirstCommand = 0;
+      uint32_t CommandCount = 0;
+
+      void Add(const MeshDrawItem& item, uint64_t key) {
+        Items.emplace_back(item);
+        Keys.emplace_back(key);
+      }
+
+      void Clear() {
+        Items.clear();
+        Keys.clear();
+        FirstCommand = 0;
+        CommandCount = 0;
+      }
+    };
+
+    static struct VisibleMeshLists {
+      static constexpr uint32_t LIST_COUNT = 2 + SHADOW_MAP_CASCADE_COUNT;
+
+      MeshDrawList Camera;
+      MeshDrawList DepthPrePass; //Opaque subset of Camera
+      MeshDrawList Cascades[SHADOW_MAP_CASCADE_COUNT];
+
+      MeshDrawList& Get(uint32_t index) {
+        return index == 0 ? Camera : index == 1 ? DepthPrePass : Cascades[index - 2];
+      }
+    } s_VisibleMeshes;
+
+    //Output of a single culling job, merged in job order.
+    struct CullChunk {
+      VisibleMeshLists Lists;
+      std::vector<Mesh*> MaterialUpdates;
+    };
+
+    //Frustums and view data shared by every culling job.
+    struct CullView {
+      Frustum CameraFrustum;
+      Frustum CascadeFrustums[SHADOW_MAP_CASCADE_COUNT];
+      bool HasCascades = false;
+      Vec3 ViewPosition = {};
+      float MaxDistance = 1.0f;
+    };
+
+    static std::vector<CullChunk> s_CullChunks;
+
+    static void CullMeshDrawList();
+    static void CullMeshChunk(const std::vector<MeshData>& meshes, const CullView& view, CullChunk& chunk);
+
+    //Sorting
+    enum DrawPass : uint32_t {
+      DRAW_PASS_DEPTH = 0,
+      DRAW_PASS_SHADOW,
+      DRAW_PASS_PBR,
+    };
+
+    static DrawPacketBuilder s_DrawPacketBuilder;
+    static DrawStats s_DrawStats;
+
+    //depth is the normalized view distance, 0 for passes that only group by state.
+    static uint64_t MakeDrawKey(DrawPass pass, const MeshDrawItem& item, float depth);
+    static void SortDrawItems(MeshDrawList& drawList);
+
+    //Indirect drawing
+    struct InstanceData {
+      Mat4 Transform;
+      //Into the material pool buffer.
+      uint32_t MaterialIndex = 0;
+      uint32_t Padding[3] = {};
+    };
+
+    static std::vector<InstanceData> s_InstanceData;
+    static std::vector<vk::DrawIndexedIndirectCommand> s_DrawCommands;
+    static bool s_IndirectDraws;
+
+    //Writes one indirect command per primitive and instance data per item, materials of drawn items are written to the material pool.
+    static void BuildDrawCommands(MeshDrawList& drawList);
+    static void UploadDrawCommands();
+    static void DrawIndexedIndirect(const vk::CommandBuffer& commandBuffer, const MeshDrawList& drawList);
 
-    static void RenderNode(const Mesh::Node* node,
-                           const vk::CommandBuffer& commandBuffer,
-                           const VulkanPipeline& pipeline,
-                           const std::function<bool(Mesh::Primitive* prim)>& perMeshFunc);
-    static void RenderMesh(const MeshData& mesh,
-                           const vk::CommandBuffer& commandBuffer,
-                           const VulkanPipeline& pipeline,
-                           const std::function<bool(Mesh::Primitive* prim)>& perMeshFunc);
+    //Draws a list with the geometry pool and instance buffer bound once. Descriptor sets have to be bound by the pass.
+    static void RenderMeshes(const MeshDrawList& drawList, const vk::CommandBuffer& commandBuffer, const VulkanPipeline& pipeline);
 
     //Lighting
     struct LightingData {
@@ -269,6 +379,10 @@ namespace Oxylus {
 
     static void UpdateCascades(const Mat4& Transform, Camera* camera, RendererData::DirectShadowUB& cascadesUbo);
     static void UpdateLightingData();
+    //Makes the light binding see at least lightCount lights.
+    static void GrowLightCapacity(uint32_t lightCount);
+    //Called before a frame begins once the frame allocator overflowed, points the dynamic bindings at the new buffer.
+    static void GrowFrameAllocator();
 
     //Particle
     static constexpr uint32_t MAX_PARTICLE_COUNT = 800;
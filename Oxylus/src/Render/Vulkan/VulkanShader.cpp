@@ -4,15 +4,40 @@
 
 #include <filesystem>
 #include <fstream>
+#include <thread>
 #include <fmt/format.h>
 
 #include "VulkanRenderer.h"
 #include "Render/ShaderLibrary.h"
 #include "Utils/Profiler.h"
 #include "Utils/FileUtils.h"
+#include "Utils/Hash.h"
 
 namespace Oxylus {
+  //Bump to invalidate every cached shader, e.g. after changing how the cache key is built.
+  static constexpr uint32_t SHADER_CACHE_VERSION = 1;
+  static constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+
+  struct ShaderDependency {
+    std::string Path;
+    uint64_t Hash = 0;
+  };
+
+  /**
+   * \brief Everything a cached SPIR-V binary was built from.
+   * Lets an unchanged shader be loaded without running shaderc at all.
+   */
+  struct ShaderCacheManifest {
+    uint64_t OptionsHash = 0;
+    uint64_t SourceHash = 0;
+    //Hash of the preprocessed source and options, names the SPIR-V file.
+    uint64_t SpirvKey = 0;
+    std::vector<ShaderDependency> Includes;
+  };
+
   struct Includer : shaderc::CompileOptions::IncluderInterface {
+    explicit Includer(std::vector<ShaderDependency>* dependencies) : m_Dependencies(dependencies) {}
+
     shaderc_include_result* GetInclude(const char* requested_source,
                                        shaderc_include_type type,
                                        const char* requesting_source,
@@ -23,6 +48,15 @@ namespace Oxylus {
       OX_CORE_ASSERT(content,
         fmt::format("Couldn't load the include file: {0} for shader: {1}", requested_source, requesting_source).c_str());
 
+      //Record the content that was actually included, the same file is resolved again when compiling.
+      if (m_Dependencies) {
+        const bool known = std::any_of(m_Dependencies->begin(),
+          m_Dependencies->end(),
+          [&filepath](const ShaderDependency& dependency) { return dependency.Path == filepath; });
+        if (!known)
+          m_Dependencies->emplace_back(ShaderDependency{filepath, Hash::FNV1a(content.value())});
+      }
+
       const auto container = new std::array<std::string, 2>;
       (*container)[0] = name;
       (*container)[1] = content.value();
@@ -43,6 +77,9 @@ namespace Oxylus {
       delete (std::array<std::string, 2>*)data->user_data;
       delete data;
     }
+
+  private:
+    std::vector<ShaderDependency>* m_Dependencies = nullptr;
   };
 
   static const char* GetCacheDirectory() {
@@ -55,13 +92,92 @@ namespace Oxylus {
       std::filesystem::create_directories(cacheDirectory);
   }
 
-  static const char* GetCompiledFileExtension(vk::ShaderStageFlagBits stage) {
-    switch (stage) {
-      case vk::ShaderStageFlagBits::eFragment: return "_compiled.frag";
-      case vk::ShaderStageFlagBits::eVertex: return "_compiled.vert";
-      case vk::ShaderStageFlagBits::eCompute: return "_compiled.comp";
+  static std::filesystem::path GetSpirvPath(const std::filesystem::path& cacheDirectory, const uint64_t key) {
+    return cacheDirectory / (Hash::ToHex(key) + ".spv");
+  }
+
+  //Written to a temporary file first so other runs or threads never see a partial file.
+  static void WriteCacheFile(const std::filesystem::path& path, const void* data, const size_t size) {
+    std::filesystem::path tempPath = path;
+    tempPath += fmt::format(".{}.tmp", std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    {
+      std::ofstream out(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+      if (!out.is_open())
+        return;
+      out.write((const char*)data, (std::streamsize)size);
     }
-    return "";
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error)
+      std::filesystem::remove(tempPath, error);
+  }
+
+  static bool ReadSpirv(const std::filesystem::path& path, std::vector<uint32_t>& spirv) {
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+    if (!in.is_open())
+      return false;
+    in.seekg(0, std::ios::end);
+    const auto size = (size_t)in.tellg();
+    in.seekg(0, std::ios::beg);
+    if (size < sizeof(uint32_t) || size % sizeof(uint32_t) != 0)
+      return false;
+
+    spirv.resize(size / sizeof(uint32_t));
+    in.read((char*)spirv.data(), (std::streamsize)size);
+    if (!in || spirv[0] != SPIRV_MAGIC) {
+      spirv.clear();
+      return false;
+    }
+    return true;
+  }
+
+  static bool ReadManifest(const std::filesystem::path& path, ShaderCacheManifest& manifest) {
+    std::ifstream in(path);
+    if (!in.is_open())
+      return false;
+
+    std::string line;
+    if (!std::getline(in, line) || line != fmt::format("OxShaderCache {}", SHADER_CACHE_VERSION))
+      return false;
+
+    while (std::getline(in, line)) {
+      std::istringstream stream(line);
+      std::string key, hex;
+      stream >> key >> hex;
+      const uint64_t value = std::strtoull(hex.c_str(), nullptr, 16);
+      if (key == "options")
+        manifest.OptionsHash = value;
+      else if (key == "source")
+        manifest.SourceHash = value;
+      else if (key == "spirv")
+        manifest.SpirvKey = value;
+      else if (key == "include") {
+        //The path is the rest of the line, it might contain spaces.
+        std::string includePath;
+        std::getline(stream >> std::ws, includePath);
+        manifest.Includes.emplace_back(ShaderDependency{includePath, value});
+      }
+    }
+    return true;
+  }
+
+  static void WriteManifest(const std::filesystem::path& path, const ShaderCacheManifest& manifest) {
+    std::string text = fmt::format("OxShaderCache {}\n", SHADER_CACHE_VERSION);
+    text += fmt::format("options {}\n", Hash::ToHex(manifest.OptionsHash));
+    text += fmt::format("source {}\n", Hash::ToHex(manifest.SourceHash));
+    text += fmt::format("spirv {}\n", Hash::ToHex(manifest.SpirvKey));
+    for (const auto& include : manifest.Includes)
+      text += fmt::format("include {} {}\n", Hash::ToHex(include.Hash), include.Path);
+    WriteCacheFile(path, text.data(), text.size());
+  }
+
+  static bool AreDependenciesUpToDate(const std::vector<ShaderDependency>& dependencies) {
+    for (const auto& dependency : dependencies) {
+      const auto content = FileUtils::ReadFile(dependency.Path);
+      if (!content || Hash::FNV1a(content.value()) != dependency.Hash)
+        return false;
+    }
+    return true;
   }
 
   static shaderc_shader_kind GLShaderStageToShaderC(vk::ShaderStageFlagBits stage) {
@@ -102,20 +218,27 @@ namespace Oxylus {
       m_VulkanSourceCode[vk::ShaderStageFlagBits::eFragment] = content.value();
     }
 
-    shaderc::CompileOptions options;
-    options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_3);
-    options.SetTargetSpirv(shaderc_spirv_version_1_6);
 #if defined (OX_RELEASE) || defined (OX_DIST)
-    options.SetOptimizationLevel(shaderc_optimization_level_performance);
+    constexpr auto optimizationLevel = shaderc_optimization_level_performance;
 #else
-    options.SetOptimizationLevel(shaderc_optimization_level_zero);
+    constexpr auto optimizationLevel = shaderc_optimization_level_zero;
 #endif
-    options.SetIncluder(std::make_unique<Includer>());
+    shaderc::CompileOptions options;
+    options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_3);
+    options.SetTargetSpirv(shaderc_spirv_version_1_6);
+    options.SetOptimizationLevel(optimizationLevel);
+
+    //Everything set on the options has to be part of this key.
+    std::string optionsKey = fmt::format("v{};vulkan1.3;spirv1.6;O{};", SHADER_CACHE_VERSION, (int)optimizationLevel);
+    for (const auto& [name, value] : m_ShaderDesc.Defines) {
+      options.AddMacroDefinition(name, value);
+      optionsKey += fmt::format("{}={};", name, value);
+    }
+    const uint64_t optionsHash = Hash::FNV1a(optionsKey);
     m_VulkanSPIRV.clear();
 
-    std::filesystem::path cacheDirectory = GetCacheDirectory();
     for (auto&& [stage, source] : m_VulkanSourceCode) {
-      ReadOrCompile(stage, source, options);
+      ReadOrCompile(stage, source, options, optionsHash);
     }
     for (auto&& [stage, source] : m_VulkanSPIRV) {
       CreateShaderModule(stage, source);
@@ -129,46 +252,62 @@ namespace Oxylus {
     m_Loaded = true;
   }
 
-  std::filesystem::path VulkanShader::GetCachedDirectory(vk::ShaderStageFlagBits stage,
-                                                         std::filesystem::path cacheDirectory) {
-    return cacheDirectory / (m_VulkanFilePath[stage].filename().string() + GetCompiledFileExtension(stage));
+  std::filesystem::path VulkanShader::GetManifestPath(vk::ShaderStageFlagBits stage,
+                                                      const std::filesystem::path& cacheDirectory) {
+    return cacheDirectory / (m_VulkanFilePath[stage].filename().string() + ".manifest");
   }
 
   void VulkanShader::ReadOrCompile(vk::ShaderStageFlagBits stage,
                                    const std::string& source,
-                                   shaderc::CompileOptions options) {
-    std::filesystem::path cacheDirectory = GetCacheDirectory();
-    std::filesystem::path cachedPath = GetCachedDirectory(stage, cacheDirectory);
-    std::ifstream in(cachedPath, std::ios::in | std::ios::binary);
-    if (in.is_open()) {
-      in.seekg(0, std::ios::end);
-      auto size = in.tellg();
-      in.seekg(0, std::ios::beg);
-
-      auto& data = m_VulkanSPIRV[stage];
-      data.resize(size / sizeof(uint32_t));
-      in.read((char*)data.data(), size);
-    }
-    else {
-      shaderc::Compiler compiler;
-      shaderc::SpvCompilationResult module = compiler.CompileGlslToSpv(source,
-        GLShaderStageToShaderC(stage),
-        m_VulkanFilePath[stage].string().c_str(),
-        options);
-      if (module.GetCompilationStatus() != shaderc_compilation_status_success) {
-        OX_CORE_ERROR(module.GetErrorMessage());
-      }
+                                   shaderc::CompileOptions options,
+                                   uint64_t optionsHash) {
+    ZoneScoped;
+    const std::filesystem::path cacheDirectory = GetCacheDirectory();
+    const std::filesystem::path manifestPath = GetManifestPath(stage, cacheDirectory);
+    optionsHash = Hash::FNV1a(&stage, sizeof stage, optionsHash);
+    const uint64_t sourceHash = Hash::FNV1a(source);
+    auto& spirv = m_VulkanSPIRV[stage];
+
+    //Nothing the cached binary was built from changed, shaderc isn't needed.
+    ShaderCacheManifest manifest;
+    if (ReadManifest(manifestPath, manifest) &&
+        manifest.OptionsHash == optionsHash &&
+        manifest.SourceHash == sourceHash &&
+        AreDependenciesUpToDate(manifest.Includes) &&
+        ReadSpirv(GetSpirvPath(cacheDirectory, manifest.SpirvKey), spirv)) {
+      return;
+    }
 
-      m_VulkanSPIRV[stage] = std::vector(module.cbegin(), module.cend());
+    shaderc::Compiler compiler;
+    const auto kind = GLShaderStageToShaderC(stage);
+    const std::string fileName = m_VulkanFilePath[stage].string();
+
+    std::vector<ShaderDependency> includes;
+    options.SetIncluder(std::make_unique<Includer>(&includes));
+    const shaderc::PreprocessedSourceCompilationResult preprocessed = compiler.PreprocessGlsl(source, kind, fileName.c_str(), options);
+    if (preprocessed.GetCompilationStatus() != shaderc_compilation_status_success) {
+      OX_CORE_ERROR(preprocessed.GetErrorMessage());
+      spirv.clear();
+      return;
+    }
 
-      std::ofstream out(cachedPath, std::ios::out | std::ios::binary);
-      if (out.is_open()) {
-        auto& data = m_VulkanSPIRV[stage];
-        out.write((char*)data.data(), data.size() * sizeof(uint32_t));
-        out.flush();
-        out.close();
+    const std::string_view preprocessedSource(preprocessed.cbegin(), (size_t)(preprocessed.cend() - preprocessed.cbegin()));
+    const uint64_t spirvKey = Hash::FNV1a(preprocessedSource, optionsHash);
+    const std::filesystem::path spirvPath = GetSpirvPath(cacheDirectory, spirvKey);
+
+    //The preprocessed source can match an earlier build even if the file changed, e.g. only comments were edited.
+    if (!ReadSpirv(spirvPath, spirv)) {
+      const shaderc::SpvCompilationResult module = compiler.CompileGlslToSpv(source, kind, fileName.c_str(), options);
+      if (module.GetCompilationStatus() != shaderc_compilation_status_success) {
+        OX_CORE_ERROR(module.GetErrorMessage());
+        spirv.clear();
+        return;
       }
+      spirv = std::vector(module.cbegin(), module.cend());
+      WriteCacheFile(spirvPath, spirv.data(), spirv.size() * sizeof(uint32_t));
     }
+
+    WriteManifest(manifestPath, ShaderCacheManifest{optionsHash, sourceHash, spirvKey, std::move(includes)});
   }
 
   void VulkanShader::CreateShaderModule(vk::ShaderStageFlagBits stage, const std::vector<unsigned>& source) {
@@ -207,12 +346,7 @@ namespace Oxylus {
 
   void VulkanShader::Reload() {
     VulkanRenderer::WaitDeviceIdle();
-    //Delete compiled files
-    for (const auto& [stage, flag] : m_ShaderStage) {
-      const std::filesystem::path cacheDirectory = GetCacheDirectory();
-      std::filesystem::path cachedPath = GetCachedDirectory(stage, cacheDirectory);
-      std::remove(cachedPath.string().c_str());
-    }
+    //No need to touch the cache, changed sources or includes no longer match their manifest.
     m_OnReloadBeginEvent();
     Unload();
     CreateShader();
@@ -52,6 +52,8 @@ namespace Oxylus {
     std::string Name;
     std::string ComputePath;
     std::vector<DesciptorProperty> DesciptorProperties = {};
+    //Macro name and value pairs, part of the shader cache key.
+    std::vector<std::pair<std::string, std::string>> Defines = {};
   };
 
   class VulkanShader {
@@ -104,8 +106,8 @@ namespace Oxylus {
     
   private:
     void CreateShader();
-    std::filesystem::path GetCachedDirectory(vk::ShaderStageFlagBits stage, std::filesystem::path cacheDirectory);
-    void ReadOrCompile(vk::ShaderStageFlagBits stage, const std::string& source, shaderc::CompileOptions options);
+    std::filesystem::path GetManifestPath(vk::ShaderStageFlagBits stage, const std::filesystem::path& cacheDirectory);
+    void ReadOrCompile(vk::ShaderStageFlagBits stage, const std::string& source, shaderc::CompileOptions options, uint64_t optionsHash);
     void CreateShaderModule(vk::ShaderStageFlagBits stage, const std::vector<unsigned>& source);
     std::unordered_map<vk::ShaderStageFlagBits, std::vector<uint32_t>> m_VulkanSPIRV;
     std::unordered_map<vk::ShaderStageFlagBits, std::string> m_VulkanSourceCode;
@@ -114,7 +114,9 @@ namespace Oxylus {
 
     m_ImageViews.reserve(m_Images.size());
 
-    MaxFramesInFlight = m_ImageCount - 1;
+    //Per frame renderer resources only exist MAX_FRAMES_IN_FLIGHT times.
+    MaxFramesInFlight = std::clamp(m_ImageCount - 1, 1u, MAX_FRAMES_IN_FLIGHT);
+    CurrentFrame %= MaxFramesInFlight;
 
     for (const auto& view : m_ImageViews) {
       LogicalDevice.destroyImageView(view);
@@ -287,6 +289,7 @@ namespace Oxylus {
     const vk::PipelineStageFlags pipelineStageFlags = vk::PipelineStageFlagBits::eColorAttachmentOutput;
     submitInfo.pWaitDstStageMask = &pipelineStageFlags;
 
+    std::lock_guard lock(VulkanContext::VulkanQueue.SubmitMutex);
     VulkanUtils::CheckResult(
       VulkanContext::VulkanQueue.GraphicsQueue.submit(1, &submitInfo, InFlightFences[CurrentFrame]));
 
@@ -331,7 +334,11 @@ namespace Oxylus {
     presentInfo.pSwapchains = &m_SwapChain;
     presentInfo.pImageIndices = &ImageIndex;
 
-    const auto& result = VulkanContext::VulkanQueue.PresentQueue.presentKHR(&presentInfo);
+    vk::Result result;
+    {
+      std::lock_guard lock(VulkanContext::VulkanQueue.SubmitMutex);
+      result = VulkanContext::VulkanQueue.PresentQueue.presentKHR(&presentInfo);
+    }
 
     IsOutOfDate = false;
     if (VulkanUtils::IsOutOfDate(result) || VulkanUtils::IsSubOptimal(result)) {
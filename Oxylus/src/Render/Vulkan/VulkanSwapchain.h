@@ -4,6 +4,7 @@
 
 #include <vulkan/vulkan.hpp>
 
+#include "PerFrame.h"
 #include "VulkanImage.h"
 #include "VulkanRenderPass.h"
 
@@ -0,0 +1,373 @@
+#include "src/oxpch.h"
+#include "VulkanUploader.h"
+
+#include "VulkanContext.h"
+#include "Utils/Log.h"
+#include "Utils/Profiler.h"
+#include "Utils/VulkanUtils.h"
+
+namespace Oxylus {
+  VulkanUploader::UploaderData VulkanUploader::s_Data;
+
+  //Timeline values only grow, a thread that read an older one must not store it over a newer one.
+  static void RaiseTo(std::atomic<uint64_t>& target, const uint64_t value) {
+    uint64_t current = target.load();
+    while (current < value && !target.compare_exchange_weak(current, value)) { }
+  }
+
+  bool UploadTicket::IsDone() const {
+    return m_Value <= VulkanUploader::s_Data.CompletedValue.load() || m_Value <= VulkanUploader::PollCompleted();
+  }
+
+  bool UploadTicket::IsAvailable() const {
+    return m_Value <= VulkanUploader::s_Data.AcquiredValue.load();
+  }
+
+  void UploadTicket::Wait() const {
+    if (IsDone())
+      return;
+    VulkanUploader::WaitForValue(m_Value);
+  }
+
+  void VulkanUploader::Init() {
+    if (s_Data.Initialized)
+      return;
+    const auto& LogicalDevice = VulkanContext::GetDevice();
+    const auto& queues = VulkanContext::VulkanQueue;
+    s_Data.SharesGraphicsQueue = queues.transferQueueFamilyIndex == queues.graphicsQueueFamilyIndex;
+
+    vk::SemaphoreTypeCreateInfo typeCreateInfo{vk::SemaphoreType::eTimeline, 0};
+    vk::SemaphoreCreateInfo semaphoreCreateInfo{};
+    semaphoreCreateInfo.pNext = &typeCreateInfo;
+    VulkanUtils::CheckResult(LogicalDevice.createSemaphore(&semaphoreCreateInfo, nullptr, &s_Data.Timeline));
+
+    vk::CommandPoolCreateInfo poolInfo;
+    poolInfo.queueFamilyIndex = queues.transferQueueFamilyIndex;
+    poolInfo.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
+    s_Data.CommandPool = LogicalDevice.createCommandPool(poolInfo).value;
+
+    s_Data.Staging.CreateBuffer(vk::BufferUsageFlagBits::eTransferSrc,
+      vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+      STAGING_SIZE,
+      nullptr,
+      VMA_MEMORY_USAGE_AUTO_PREFER_HOST).Map();
+    s_Data.Head = 0;
+    s_Data.Initialized = true;
+
+    OX_CORE_TRACE("Uploader initialized on the {} queue", s_Data.SharesGraphicsQueue ? "graphics" : "dedicated transfer");
+  }
+
+  void VulkanUploader::Shutdown() {
+    if (!s_Data.Initialized)
+      return;
+    WaitIdle();
+
+    const auto& LogicalDevice = VulkanContext::GetDevice();
+    for (auto& temporary : s_Data.TemporaryBuffers)
+      temporary.Buffer.Destroy();
+    s_Data.TemporaryBuffers.clear();
+    s_Data.StagingRegions.clear();
+    s_Data.Staging.Destroy();
+    //Frees every command buffer allocated from it.
+    LogicalDevice.destroyCommandPool(s_Data.CommandPool);
+    s_Data.InFlightBatches.clear();
+    s_Data.FreeCommandBuffers.clear();
+    s_Data.PendingAcquires.clear();
+    LogicalDevice.destroySemaphore(s_Data.Timeline);
+    s_Data.Timeline = vk::Semaphore{};
+    s_Data.Initialized = false;
+  }
+
+  UploadTicket VulkanUploader::UploadBuffer(const VulkanBuffer& buffer, const void* data, const vk::DeviceSize size, const vk::DeviceSize offset) {
+    ZoneScoped;
+    if (size == 0)
+      return {};
+    std::unique_lock lock(s_Data.Mutex);
+    vk::DeviceSize stagingOffset = 0;
+    const vk::Buffer staging = Stage(data, size, stagingOffset, lock);
+
+    const auto& commandBuffer = GetRecordingBuffer();
+    const vk::BufferCopy copyRegion{stagingOffset, offset, size};
+    commandBuffer.Get().copyBuffer(staging, buffer.Get(), 1, &copyRegion);
+
+    PendingAcquire barrier;
+    barrier.BufferBarrier.buffer = buffer.Get();
+    barrier.BufferBarrier.offset = offset;
+    barrier.BufferBarrier.size = size;
+    RecordRelease(commandBuffer, barrier);
+
+    return UploadTicket(s_Data.SubmittedValue + 1);
+  }
+
+  UploadTicket VulkanUploader::UploadImage(const vk::Image image,
+                                           const vk::ImageSubresourceRange& range,
+                                           const vk::Extent3D extent,
+                                           const void* data,
+                                           const vk::DeviceSize size,
+                                           const vk::ImageLayout finalLayout) {
+    ZoneScoped;
+    if (size == 0)
+      return {};
+    std::unique_lock lock(s_Data.Mutex);
+    vk::DeviceSize stagingOffset = 0;
+    const vk::Buffer staging = Stage(data, size, stagingOffset, lock);
+
+    const auto& commandBuffer = GetRecordingBuffer();
+    vk::ImageMemoryBarrier imageMemoryBarrier{};
+    imageMemoryBarrier.image = image;
+    imageMemoryBarrier.subresourceRange = range;
+    imageMemoryBarrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+    imageMemoryBarrier.oldLayout = vk::ImageLayout::eUndefined;
+    imageMemoryBarrier.newLayout = vk::ImageLayout::eTransferDstOptimal;
+    commandBuffer.Get().pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe,
+      vk::PipelineStageFlagBits::eTransfer,
+      {},
+      nullptr,
+      nullptr,
+      imageMemoryBarrier);
+
+    vk::BufferImageCopy copyRegion{};
+    copyRegion.bufferOffset = stagingOffset;
+    copyRegion.imageSubresource.aspectMask = range.aspectMask;
+    copyRegion.imageSubresource.mipLevel = range.baseMipLevel;
+    copyRegion.imageSubresource.baseArrayLayer = range.baseArrayLayer;
+    copyRegion.imageSubresource.layerCount = range.layerCount;
+    copyRegion.imageExtent = extent;
+    commandBuffer.Get().copyBufferToImage(staging, image, vk::ImageLayout::eTransferDstOptimal, 1, &copyRegion);
+
+    PendingAcquire barrier;
+    barrier.IsImage = true;
+    barrier.ImageBarrier = imageMemoryBarrier;
+    barrier.ImageBarrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+    barrier.ImageBarrier.newLayout = finalLayout;
+    RecordRelease(commandBuffer, barrier);
+
+    return UploadTicket(s_Data.SubmittedValue + 1);
+  }
+
+  void VulkanUploader::Flush() {
+    if (!s_Data.Initialized)
+      return;
+    std::lock_guard lock(s_Data.Mutex);
+    FlushLocked();
+    Retire(PollCompleted());
+  }
+
+  void VulkanUploader::WaitIdle() {
+    if (!s_Data.Initialized)
+      return;
+    ZoneScoped;
+    Flush();
+    WaitForValue(s_Data.SubmittedValue.load());
+    std::lock_guard lock(s_Data.Mutex);
+    Retire(s_Data.CompletedValue.load());
+  }
+
+  uint64_t VulkanUploader::AcquireCompleted(const VulkanCommandBuffer& commandBuffer) {
+    if (!s_Data.Initialized)
+      return 0;
+    const uint64_t completedValue = PollCompleted();
+    std::lock_guard lock(s_Data.Mutex);
+    Retire(completedValue);
+
+    if (!s_Data.PendingAcquires.empty()) {
+      ZoneScoped;
+      std::vector<vk::BufferMemoryBarrier> bufferBarriers;
+      std::vector<vk::ImageMemoryBarrier> imageBarriers;
+      auto& pending = s_Data.PendingAcquires;
+      for (const auto& acquire : pending) {
+        if (acquire.Value > completedValue)
+          continue;
+        if (acquire.IsImage)
+          imageBarriers.emplace_back(acquire.ImageBarrier);
+        else
+          bufferBarriers.emplace_back(acquire.BufferBarrier);
+      }
+      pending.erase(std::remove_if(pending.begin(), pending.end(), [completedValue](const PendingAcquire& acquire) {
+        return acquire.Value <= completedValue;
+      }), pending.end());
+
+      if (!bufferBarriers.empty() || !imageBarriers.empty()) {
+        commandBuffer.Get().pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands,
+          vk::PipelineStageFlagBits::eAllCommands,
+          {},
+          nullptr,
+          bufferBarriers,
+          imageBarriers);
+      }
+    }
+
+    RaiseTo(s_Data.AcquiredValue, completedValue);
+    return completedValue;
+  }
+
+  uint64_t VulkanUploader::PollCompleted() {
+    if (!s_Data.Initialized)
+      return 0;
+    const uint64_t value = VulkanContext::GetDevice().getSemaphoreCounterValue(s_Data.Timeline).value;
+    RaiseTo(s_Data.CompletedValue, value);
+    return value;
+  }
+
+  void VulkanUploader::WaitForValue(const uint64_t value) {
+    if (value == 0 || value <= s_Data.CompletedValue.load())
+      return;
+    ZoneScoped;
+    //Any thread can submit, the batch of the value is in flight afterwards.
+    if (value > s_Data.SubmittedValue.load())
+      Flush();
+
+    vk::SemaphoreWaitInfo waitInfo{};
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &s_Data.Timeline;
+    waitInfo.pValues = &value;
+    VulkanUtils::CheckResult(VulkanContext::GetDevice().waitSemaphores(waitInfo, UINT64_MAX));
+    RaiseTo(s_Data.CompletedValue, value);
+  }
+
+  const VulkanCommandBuffer& VulkanUploader::GetRecordingBuffer() {
+    if (!s_Data.Recording) {
+      if (s_Data.FreeCommandBuffers.empty()) {
+        s_Data.RecordingBuffer.CreateBuffer(vk::CommandBufferLevel::ePrimary, s_Data.CommandPool);
+      }
+      else {
+        s_Data.RecordingBuffer = s_Data.FreeCommandBuffers.back();
+        s_Data.FreeCommandBuffers.pop_back();
+      }
+      s_Data.RecordingBuffer.Begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+      s_Data.Recording = true;
+    }
+    return s_Data.RecordingBuffer;
+  }
+
+  void VulkanUploader::RecordRelease(const VulkanCommandBuffer& commandBuffer, PendingAcquire barrier) {
+    const auto& queues = VulkanContext::VulkanQueue;
+    const auto recordBarrier = [&](const vk::PipelineStageFlags dstStage) {
+      if (barrier.IsImage)
+        commandBuffer.Get().pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, dstStage, {}, nullptr, nullptr, barrier.ImageBarrier);
+      else
+        commandBuffer.Get().pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, dstStage, {}, nullptr, barrier.BufferBarrier, nullptr);
+    };
+    barrier.BufferBarrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+    barrier.ImageBarrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+
+    if (s_Data.SharesGraphicsQueue) {
+      //Same queue, the batch finishes before later graphics submits read the data.
+      barrier.BufferBarrier.dstAccessMask = vk::AccessFlagBits::eMemoryRead;
+      barrier.ImageBarrier.dstAccessMask = vk::AccessFlagBits::eMemoryRead;
+      recordBarrier(vk::PipelineStageFlagBits::eAllCommands);
+      return;
+    }
+
+    //Release on the transfer queue, the layout transition is part of both halves.
+    barrier.BufferBarrier.srcQueueFamilyIndex = queues.transferQueueFamilyIndex;
+    barrier.BufferBarrier.dstQueueFamilyIndex = queues.graphicsQueueFamilyIndex;
+    barrier.ImageBarrier.srcQueueFamilyIndex = queues.transferQueueFamilyIndex;
+    barrier.ImageBarrier.dstQueueFamilyIndex = queues.graphicsQueueFamilyIndex;
+    barrier.BufferBarrier.dstAccessMask = {};
+    barrier.ImageBarrier.dstAccessMask = {};
+    recordBarrier(vk::PipelineStageFlagBits::eBottomOfPipe);
+
+    barrier.Value = s_Data.SubmittedValue + 1;
+    barrier.BufferBarrier.srcAccessMask = {};
+    barrier.ImageBarrier.srcAccessMask = {};
+    barrier.BufferBarrier.dstAccessMask = vk::AccessFlagBits::eMemoryRead;
+    barrier.ImageBarrier.dstAccessMask = vk::AccessFlagBits::eMemoryRead;
+    s_Data.PendingAcquires.emplace_back(barrier);
+  }
+
+  vk::Buffer VulkanUploader::Stage(const void* data, const vk::DeviceSize size, vk::DeviceSize& offset, std::unique_lock<std::mutex>& lock) {
+    const vk::DeviceSize alignedSize = (size + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+    if (alignedSize > STAGING_SIZE) {
+      auto& temporary = s_Data.TemporaryBuffers.emplace_back();
+      temporary.Buffer.CreateBuffer(vk::BufferUsageFlagBits::eTransferSrc,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+        size,
+        data,
+        VMA_MEMORY_USAGE_AUTO_PREFER_HOST);
+      temporary.Value = s_Data.SubmittedValue + 1;
+      offset = 0;
+      return temporary.Buffer.Get();
+    }
+
+    auto& regions = s_Data.StagingRegions;
+    while (true) {
+      if (regions.empty())
+        s_Data.Head = 0;
+      //Regions are allocated in order, free space is behind the head and in front of the oldest region.
+      const vk::DeviceSize tail = regions.empty() ? 0 : regions.front().Begin;
+      const bool wrapped = !regions.empty() && s_Data.Head <= tail;
+      std::optional<vk::DeviceSize> begin;
+      if (!wrapped) {
+        if (s_Data.Head + alignedSize <= STAGING_SIZE)
+          begin = s_Data.Head;
+        else if (alignedSize <= tail)
+          begin = 0;
+      }
+      else if (s_Data.Head + alignedSize <= tail) {
+        begin = s_Data.Head;
+      }
+
+      if (begin) {
+        offset = *begin;
+        s_Data.Head = offset + alignedSize;
+        regions.emplace_back(StagingRegion{offset, s_Data.Head, s_Data.SubmittedValue + 1});
+        if (data)
+          s_Data.Staging.Copy(data, size, offset);
+        return s_Data.Staging.Get();
+      }
+
+      //Out of space, wait for the oldest copy to free its region.
+      ZoneScopedN("Wait for staging memory");
+      const uint64_t oldestValue = regions.front().Value;
+      if (oldestValue > s_Data.SubmittedValue)
+        FlushLocked();
+      lock.unlock();
+      WaitForValue(oldestValue);
+      lock.lock();
+      Retire(s_Data.CompletedValue.load());
+    }
+  }
+
+  void VulkanUploader::FlushLocked() {
+    if (!s_Data.Recording)
+      return;
+    ZoneScoped;
+    s_Data.RecordingBuffer.End();
+    s_Data.Staging.Flush();
+
+    const uint64_t signalValue = s_Data.SubmittedValue + 1;
+    vk::TimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &signalValue;
+
+    vk::SubmitInfo submitInfo = {};
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &s_Data.RecordingBuffer.Get();
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &s_Data.Timeline;
+    {
+      //The transfer queue might be the graphics queue the renderer submits to from another thread.
+      std::lock_guard queueLock(VulkanContext::VulkanQueue.SubmitMutex);
+      VulkanUtils::CheckResult(VulkanContext::VulkanQueue.TransferQueue.submit(1, &submitInfo, vk::Fence{}));
+    }
+
+    s_Data.InFlightBatches.emplace_back(Batch{s_Data.RecordingBuffer, signalValue});
+    s_Data.Recording = false;
+    s_Data.SubmittedValue.store(signalValue);
+  }
+
+  void VulkanUploader::Retire(const uint64_t completedValue) {
+    while (!s_Data.StagingRegions.empty() && s_Data.StagingRegions.front().Value <= completedValue)
+      s_Data.StagingRegions.pop_front();
+    while (!s_Data.TemporaryBuffers.empty() && s_Data.TemporaryBuffers.front().Value <= completedValue) {
+      s_Data.TemporaryBuffers.front().Buffer.Destroy();
+      s_Data.TemporaryBuffers.pop_front();
+    }
+    while (!s_Data.InFlightBatches.empty() && s_Data.InFlightBatches.front().Value <= completedValue) {
+      s_Data.FreeCommandBuffers.emplace_back(s_Data.InFlightBatches.front().CommandBuffer);
+      s_Data.InFlightBatches.pop_front();
+    }
+  }
+}
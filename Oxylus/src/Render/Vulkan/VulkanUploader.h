@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+#include "VulkanBuffer.h"
+#include "VulkanCommandBuffer.h"
+
+namespace Oxylus {
+  /**
+   * \brief Completion handle of an upload. Copies share the upload, an empty ticket counts as done.
+   */
+  class UploadTicket {
+  public:
+    UploadTicket() = default;
+
+    bool IsValid() const { return m_Value != 0; }
+    //The copy finished on the transfer queue.
+    bool IsDone() const;
+    //Done and acquired by a graphics submit, commands recorded from now on can use the data.
+    bool IsAvailable() const;
+    //Submits the batch of the upload if it wasn't yet and waits for it, other queues keep running.
+    void Wait() const;
+
+    uint64_t GetValue() const { return m_Value; }
+
+  private:
+    explicit UploadTicket(const uint64_t value) : m_Value(value) {}
+
+    //Timeline value the batch of the upload signals.
+    uint64_t m_Value = 0;
+
+    friend class VulkanUploader;
+  };
+
+  /**
+   * \brief Streams data to device local buffers and images through the transfer queue.
+   * Data is staged in a persistently mapped ring buffer and copies are batched into one submit per frame,
+   * every batch signals the next value of a timeline semaphore which tickets are checked against.
+   * Resources are released from the transfer family, graphics submits acquire them with AcquireCompleted.
+   */
+  class VulkanUploader {
+  public:
+    static void Init();
+    static void Shutdown();
+
+    static UploadTicket UploadBuffer(const VulkanBuffer& buffer, const void* data, vk::DeviceSize size, vk::DeviceSize offset = 0);
+    //Copies tightly packed texels into the first mip of every layer in range and leaves the whole range in finalLayout.
+    static UploadTicket UploadImage(vk::Image image,
+                                    const vk::ImageSubresourceRange& range,
+                                    vk::Extent3D extent,
+                                    const void* data,
+                                    vk::DeviceSize size,
+                                    vk::ImageLayout finalLayout);
+
+    /**
+     * \brief Submits the copies recorded so far. The renderer flushes once per frame, waiting on a ticket flushes as well.
+     * Any thread can flush, submits hold the queue lock shared with the renderer since the uploader might use the graphics queue.
+     */
+    static void Flush();
+    //Flushes and waits for every upload, needed before destroying a resource uploads might still write to.
+    static void WaitIdle();
+
+    /**
+     * \brief Records the queue family acquires of the uploads that completed so far into a graphics command buffer.
+     * Returns the timeline value its submit has to wait on for the uploaded data to be visible, 0 if there is nothing to wait on.
+     */
+    static uint64_t AcquireCompleted(const VulkanCommandBuffer& commandBuffer);
+    static vk::Semaphore GetTimeline() { return s_Data.Timeline; }
+
+  private:
+    static constexpr vk::DeviceSize STAGING_SIZE = 64ull * 1024 * 1024;
+    //Satisfies the offset alignment of buffer to image copies for every format.
+    static constexpr vk::DeviceSize STAGING_ALIGNMENT = 16;
+
+    struct StagingRegion {
+      vk::DeviceSize Begin = 0;
+      vk::DeviceSize End = 0;
+      uint64_t Value = 0;
+    };
+
+    //Uploads larger than the ring get a buffer of their own.
+    struct TemporaryStaging {
+      VulkanBuffer Buffer;
+      uint64_t Value = 0;
+    };
+
+    struct Batch {
+      VulkanCommandBuffer CommandBuffer;
+      uint64_t Value = 0;
+    };
+
+    struct PendingAcquire {
+      uint64_t Value = 0;
+      vk::BufferMemoryBarrier BufferBarrier;
+      vk::ImageMemoryBarrier ImageBarrier;
+      bool IsImage = false;
+    };
+
+    static struct UploaderData {
+      std::mutex Mutex;
+      vk::Semaphore Timeline;
+      vk::CommandPool CommandPool;
+      VulkanBuffer Staging;
+      vk::DeviceSize Head = 0;
+      std::deque<StagingRegion> StagingRegions;
+      std::deque<TemporaryStaging> TemporaryBuffers;
+
+      //Batch recording right now, submitted by the next flush.
+      VulkanCommandBuffer RecordingBuffer;
+      bool Recording = false;
+      std::deque<Batch> InFlightBatches;
+      std::vector<VulkanCommandBuffer> FreeCommandBuffers;
+      std::vector<PendingAcquire> PendingAcquires;
+
+      std::atomic<uint64_t> SubmittedValue = 0;
+      std::atomic<uint64_t> CompletedValue = 0;
+      //Highest value whose acquires were recorded into a graphics command buffer.
+      std::atomic<uint64_t> AcquiredValue = 0;
+      bool SharesGraphicsQueue = true;
+      bool Initialized = false;
+    } s_Data;
+
+    static uint64_t PollCompleted();
+    static void WaitForValue(uint64_t value);
+    //Returns the command buffer of the batch recording right now, begins a new one if needed. Requires the lock.
+    static const VulkanCommandBuffer& GetRecordingBuffer();
+    //Makes the copy visible to the graphics queue, either with a barrier or a release whose acquire is recorded later. Requires the lock.
+    static void RecordRelease(const VulkanCommandBuffer& commandBuffer, PendingAcquire barrier);
+    //Copies data into staging memory and returns the buffer and offset to copy from. Requires the lock.
+    static vk::Buffer Stage(const void* data, vk::DeviceSize size, vk::DeviceSize& offset, std::unique_lock<std::mutex>& lock);
+    static void FlushLocked();
+    static void Retire(uint64_t completedValue);
+
+    friend class UploadTicket;
+  };
+}
@@ -127,6 +127,24 @@ namespace Oxylus {
     }
   }
 
+  void EntitySerializer::LoadEntityAssetsAsync(ryml::ConstNodeRef entityNode) {
+    if (entityNode.has_child("MeshRendererComponent")) {
+      std::string meshPath;
+      entityNode["MeshRendererComponent"]["Mesh"] >> meshPath;
+      if (!meshPath.empty())
+        AssetManager::LoadMeshAsync(meshPath);
+    }
+
+    if (entityNode.has_child("MaterialComponent")) {
+      const auto& node = entityNode["MaterialComponent"];
+      std::string assetPath;
+      if (node.has_child("Path"))
+        node["Path"] >> assetPath;
+      if (!assetPath.empty())
+        AssetManager::LoadMaterialAsync(assetPath);
+    }
+  }
+
   UUID EntitySerializer::DeserializeEntity(ryml::ConstNodeRef entityNode, Scene& scene, bool preserveUUID) {
     const auto st = std::string(entityNode["Entity"].val().data());
     const uint64_t uuid = std::stoull(st.substr(0, st.find('\n')));
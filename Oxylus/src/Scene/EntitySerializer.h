@@ -14,6 +14,8 @@ namespace Oxylus {
     static void SerializeEntity(ryml::NodeRef& entities, Entity entity);
 
     static UUID DeserializeEntity(ryml::ConstNodeRef entityNode, Scene& scene, bool preserveUUID);
+    //Starts loading the meshes and materials the entity references so DeserializeEntity finds them loaded.
+    static void LoadEntityAssetsAsync(ryml::ConstNodeRef entityNode);
 
     static void SerializeEntityAsPrefab(const char* filepath, Entity entity);
 
@@ -41,8 +41,6 @@ namespace Oxylus {
 
   void Scene::InitPhysics() {
     // Physics
-    m_JobSystem = CreateRef<JPH::JobSystemThreadPool>();
-    m_JobSystem->Init(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, std::thread::hardware_concurrency() - 1);
     m_PhysicsSystem = CreateRef<JPH::PhysicsSystem>();
     m_PhysicsSystem->Init(
       Physics::MAX_BODIES,
@@ -65,6 +63,7 @@ namespace Oxylus {
     entity.AddComponentI<IDComponent>(uuid);
     entity.AddComponentI<RelationshipComponent>();
     entity.AddComponentI<TransformComponent>();
+    entity.AddComponentI<WorldTransformComponent>();
     entity.AddComponentI<TagComponent>().Tag = name.empty() ? "Entity" : name;
     return entity;
   }
@@ -74,7 +73,7 @@ namespace Oxylus {
     constexpr int cCollisionSteps = 1;
     constexpr int cIntegrationSubSteps = 1;
 
-    m_PhysicsSystem->Update(cDeltaTime, cCollisionSteps, cIntegrationSubSteps, Physics::s_TempAllocator, m_JobSystem.get());
+    m_PhysicsSystem->Update(cDeltaTime, cCollisionSteps, cIntegrationSubSteps, Physics::s_TempAllocator, Physics::s_JobSystem);
 
     // Physics
     {
@@ -239,7 +238,6 @@ namespace Oxylus {
     // Copy physics
     newScene->m_BodyInterface = other->m_BodyInterface;
     newScene->m_PhysicsSystem = other->m_PhysicsSystem;
-    newScene->m_JobSystem = other->m_JobSystem;
 
     // Copy components (except IDComponent and TagComponent)
     CopyComponent(AllComponents{}, dstSceneRegistry, srcSceneRegistry, newScene->m_EntityMap);
@@ -258,10 +256,77 @@ namespace Oxylus {
     }
   }
 
+  void Scene::UpdateTransforms() {
+    ZoneScoped;
+
+    struct StackEntry {
+      entt::entity Entity;
+      Mat4 ParentTransform;
+    };
+
+    // Entities are compared against their cache in one linear pass, only the subtrees below changed ones are walked.
+    const auto view = m_Registry.view<RelationshipComponent, TransformComponent, WorldTransformComponent>();
+    std::vector<entt::entity> changed;
+    for (const auto entity : view) {
+      auto [transform, world] = view.get<TransformComponent, WorldTransformComponent>(entity);
+      if (world.Dirty || !world.Matches(transform)) {
+        world.Dirty = true;
+        changed.emplace_back(entity);
+      }
+    }
+    if (changed.empty())
+      return;
+
+    // Parents missing from the scene are treated as the root.
+    const auto getParent = [this, &view](const entt::entity entity) -> entt::entity {
+      const UUID parent = view.get<RelationshipComponent>(entity).Parent;
+      if (parent == 0)
+        return entt::null;
+      const auto it = m_EntityMap.find(parent);
+      return it != m_EntityMap.end() ? it->second : entt::null;
+    };
+
+    std::vector<StackEntry> stack;
+    for (const auto root : changed) {
+      // Walked already as part of a changed parent's subtree.
+      if (!view.get<WorldTransformComponent>(root).Dirty)
+        continue;
+
+      // Changed entities below another changed one are covered by the walk from the topmost.
+      bool covered = false;
+      entt::entity parent = getParent(root);
+      for (entt::entity ancestor = parent; ancestor != entt::null && !covered; ancestor = getParent(ancestor))
+        covered = view.get<WorldTransformComponent>(ancestor).Dirty;
+      if (covered)
+        continue;
+
+      // Every ancestor is clean, so the parent's cache is current.
+      stack.push_back({root, parent != entt::null ? view.get<WorldTransformComponent>(parent).Transform : Mat4(1.0f)});
+      while (!stack.empty()) {
+        const StackEntry entry = stack.back();
+        stack.pop_back();
+
+        auto [rc, transform, world] = view.get<RelationshipComponent, TransformComponent, WorldTransformComponent>(entry.Entity);
+        world.Translation = transform.Translation;
+        world.Rotation = transform.Rotation;
+        world.Scale = transform.Scale;
+        world.Transform = entry.ParentTransform * transform.GetTransform();
+        world.Dirty = false;
+
+        for (const auto& child : rc.Children) {
+          const auto it = m_EntityMap.find(child);
+          if (it != m_EntityMap.end())
+            stack.push_back({it->second, world.Transform});
+        }
+      }
+    }
+  }
+
   void Scene::OnUpdate(float deltaTime) {
     ZoneScoped;
 
     UpdateSystems();
+    UpdateTransforms();
     RenderScene();
     UpdatePhysics();
 
@@ -306,7 +371,8 @@ namespace Oxylus {
     }
   }
 
-  void Scene::OnEditorUpdate([[maybe_unused]] float deltaTime, Camera& camera) const {
+  void Scene::OnEditorUpdate([[maybe_unused]] float deltaTime, Camera& camera) {
+    UpdateTransforms();
     RenderScene();
 
     VulkanRenderer::SetCamera(camera);
@@ -332,6 +398,9 @@ namespace Oxylus {
   template <>
   void Scene::OnComponentAdded<TransformComponent>(Entity entity, TransformComponent& component) { }
 
+  template <>
+  void Scene::OnComponentAdded<WorldTransformComponent>(Entity entity, WorldTransformComponent& component) { }
+
   template <>
   void Scene::OnComponentAdded<CameraComponent>(Entity entity, CameraComponent& component) { }
 
@@ -7,7 +7,6 @@
 #include "Core/UUID.h"
 #include "Core/Systems/System.h"
 #include "entt/entt.hpp"
-#include "Jolt/Core/JobSystemThreadPool.h"
 #include "Jolt/Physics/PhysicsSystem.h"
 #include "Jolt/Physics/Body/BodyInterface.h"
 #include "Render/Mesh.h"
@@ -41,9 +40,10 @@ namespace Oxylus {
     void OnPlay();
     void OnStop();
     void OnUpdate(float deltaTime);
-    void OnEditorUpdate(float deltaTime, Camera& camera) const;
+    void OnEditorUpdate(float deltaTime, Camera& camera);
     void RenderScene() const;
     void UpdateSystems();
+    void UpdateTransforms();
     Entity FindEntity(const std::string_view& name);
     bool HasEntity(UUID uuid) const;
     Entity GetEntityByUUID(UUID uuid);
@@ -75,7 +75,6 @@ namespace Oxylus {
     // Physics
     JPH::BodyInterface* m_BodyInterface = nullptr;
     Ref<JPH::PhysicsSystem> m_PhysicsSystem = nullptr;
-    Ref<JPH::JobSystemThreadPool> m_JobSystem = nullptr;
    
     friend class Entity;
     friend class SceneSerializer;
@@ -5,11 +5,15 @@
 #include "Core/Entity.h"
 
 #include "Render/Vulkan/VulkanRenderer.h"
+#include "Thread/JobSystem.h"
 
 #include "Utils/Profiler.h"
 #include "Utils/TimeStep.h"
 
 namespace Oxylus {
+  //Smallest number of entities worth handing to a separate job.
+  static constexpr uint32_t MESH_EXTRACTION_CHUNK_SIZE = 1024;
+
   void SceneRenderer::Init(Scene& scene) {
     m_Scene = &scene;
     Dispatcher.sink<ProbeChangeEvent>().connect<&SceneRenderer::UpdateProbes>(*this);
@@ -22,11 +26,25 @@ namespace Oxylus {
     // Mesh
     {
       ZoneScopedN("Mesh System");
-      const auto view = m_Scene->m_Registry.view<TransformComponent, MeshRendererComponent, MaterialComponent, TagComponent>();
-      for (const auto&& [entity, transform, meshrenderer, material, tag] : view.each()) {
-        if (tag.Enabled)
-          VulkanRenderer::SubmitMesh(*meshrenderer.MeshGeometry, Entity(entity, m_Scene).GetWorldTransform(), material.Materials, meshrenderer.SubmesIndex);
-      }
+      const auto view = m_Scene->m_Registry.view<WorldTransformComponent, MeshRendererComponent, MaterialComponent, TagComponent>();
+      //Split the leading storage of the view into chunks, every job submits to its own chunk.
+      const auto& entities = view.handle();
+      const uint32_t entityCount = (uint32_t)entities.size();
+      const uint32_t chunkCount = JobSystem::GetChunkCount(entityCount, MESH_EXTRACTION_CHUNK_SIZE);
+      VulkanRenderer::BeginMeshSubmission(chunkCount);
+      JobSystem::ParallelFor(entityCount,
+        chunkCount,
+        [&view, &entities](const uint32_t chunkIndex, const uint32_t begin, const uint32_t end) {
+          ZoneScopedN("Mesh Extraction");
+          for (uint32_t i = begin; i < end; i++) {
+            const auto entity = entities[i];
+            if (!view.contains(entity))
+              continue;
+            auto [world, meshrenderer, material, tag] = view.get<WorldTransformComponent, MeshRendererComponent, MaterialComponent, TagComponent>(entity);
+            if (tag.Enabled)
+              VulkanRenderer::SubmitMesh(*meshrenderer.MeshGeometry, world.Transform, material.Materials, meshrenderer.SubmesIndex, chunkIndex);
+          }
+        });
     }
 
     // Particle system
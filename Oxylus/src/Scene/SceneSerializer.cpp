@@ -76,6 +76,11 @@ namespace Oxylus {
     if (root.has_child("Entities")) {
       const ryml::ConstNodeRef entities = root["Entities"];
 
+      //Assets of all entities load in parallel, entities are created once everything they reference is loaded.
+      for (const auto entity : entities)
+        EntitySerializer::LoadEntityAssetsAsync(entity);
+      AssetManager::WaitForLoads();
+
       for (const auto entity : entities) {
         EntitySerializer::DeserializeEntity(entity, *m_Scene, true);
       }
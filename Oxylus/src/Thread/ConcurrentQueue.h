@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Oxylus {
+  /**
+   * \brief Bounded lock-free multi-producer multi-consumer queue (Vyukov's ring).
+   * Every slot carries a sequence number telling producers and consumers whose turn it is,
+   * so neither side takes a lock and no allocation happens after construction.
+   * capacity has to be a power of two.
+   */
+  template<typename T>
+  class ConcurrentQueue {
+  public:
+    explicit ConcurrentQueue(const size_t capacity) : m_Cells(new Cell[capacity]), m_Mask(capacity - 1) {
+      for (size_t i = 0; i < capacity; i++)
+        m_Cells[i].Sequence.store(i, std::memory_order_relaxed);
+    }
+
+    ConcurrentQueue(const ConcurrentQueue&) = delete;
+    ConcurrentQueue& operator=(const ConcurrentQueue&) = delete;
+
+    //Returns false if the queue is full, value is left untouched in that case.
+    bool TryPush(T&& value) {
+      Cell* cell;
+      size_t pos = m_EnqueuePos.load(std::memory_order_relaxed);
+      while (true) {
+        cell = &m_Cells[pos & m_Mask];
+        const size_t sequence = cell->Sequence.load(std::memory_order_acquire);
+        const intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+        if (diff == 0) {
+          if (m_EnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            break;
+        }
+        else if (diff < 0) {
+          return false;
+        }
+        else {
+          pos = m_EnqueuePos.load(std::memory_order_relaxed);
+        }
+      }
+      cell->Value = std::move(value);
+      cell->Sequence.store(pos + 1, std::memory_order_release);
+      return true;
+    }
+
+    bool TryPop(T& value) {
+      Cell* cell;
+      size_t pos = m_DequeuePos.load(std::memory_order_relaxed);
+      while (true) {
+        cell = &m_Cells[pos & m_Mask];
+        const size_t sequence = cell->Sequence.load(std::memory_order_acquire);
+        const intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+        if (diff == 0) {
+          if (m_DequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            break;
+        }
+        else if (diff < 0) {
+          return false;
+        }
+        else {
+          pos = m_DequeuePos.load(std::memory_order_relaxed);
+        }
+      }
+      value = std::move(cell->Value);
+      cell->Sequence.store(pos + m_Mask + 1, std::memory_order_release);
+      return true;
+    }
+
+  private:
+    struct Cell {
+      std::atomic<size_t> Sequence;
+      T Value;
+    };
+
+    std::unique_ptr<Cell[]> m_Cells;
+    const size_t m_Mask;
+    //Kept on separate cache lines so producers and consumers don't false share.
+    alignas(64) std::atomic<size_t> m_EnqueuePos = 0;
+    alignas(64) std::atomic<size_t> m_DequeuePos = 0;
+  };
+}
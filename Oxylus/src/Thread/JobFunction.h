@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Oxylus {
+  /**
+   * \brief Move-only type erased void() callable.
+   * Callables up to INLINE_SIZE bytes are stored in place so queuing a job doesn't allocate,
+   * bigger ones fall back to the heap.
+   */
+  class JobFunction {
+  public:
+    static constexpr size_t INLINE_SIZE = 48;
+
+    JobFunction() = default;
+    JobFunction(std::nullptr_t) {}
+
+    template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, JobFunction> && !std::is_same_v<std::decay_t<F>, std::nullptr_t>>>
+    JobFunction(F&& func) {
+      using T = std::decay_t<F>;
+      if constexpr (IsInline<T>()) {
+        new(m_Storage) T(std::forward<F>(func));
+        m_Ops = &s_InlineOps<T>;
+      }
+      else {
+        *reinterpret_cast<T**>(m_Storage) = new T(std::forward<F>(func));
+        m_Ops = &s_HeapOps<T>;
+      }
+    }
+
+    JobFunction(JobFunction&& other) noexcept {
+      MoveFrom(other);
+    }
+
+    JobFunction& operator=(JobFunction&& other) noexcept {
+      if (this != &other) {
+        Reset();
+        MoveFrom(other);
+      }
+      return *this;
+    }
+
+    JobFunction(const JobFunction&) = delete;
+    JobFunction& operator=(const JobFunction&) = delete;
+
+    ~JobFunction() { Reset(); }
+
+    void operator()() { m_Ops->Invoke(m_Storage); }
+    explicit operator bool() const { return m_Ops != nullptr; }
+
+    void Reset() {
+      if (m_Ops) {
+        m_Ops->Destroy(m_Storage);
+        m_Ops = nullptr;
+      }
+    }
+
+  private:
+    struct Ops {
+      void (*Invoke)(void* storage);
+      //Move constructs into dst and destroys src.
+      void (*Move)(void* dst, void* src);
+      void (*Destroy)(void* storage);
+    };
+
+    template<typename T>
+    static constexpr bool IsInline() {
+      return sizeof(T) <= INLINE_SIZE && alignof(T) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<T>;
+    }
+
+    template<typename T>
+    static constexpr Ops s_InlineOps = {
+      [](void* storage) { (*static_cast<T*>(storage))(); },
+      [](void* dst, void* src) {
+        new(dst) T(std::move(*static_cast<T*>(src)));
+        static_cast<T*>(src)->~T();
+      },
+      [](void* storage) { static_cast<T*>(storage)->~T(); }
+    };
+
+    template<typename T>
+    static constexpr Ops s_HeapOps = {
+      [](void* storage) { (**static_cast<T**>(storage))(); },
+      [](void* dst, void* src) { *static_cast<T**>(dst) = *static_cast<T**>(src); },
+      [](void* storage) { delete *static_cast<T**>(storage); }
+    };
+
+    void MoveFrom(JobFunction& other) {
+      if (other.m_Ops) {
+        other.m_Ops->Move(m_Storage, other.m_Storage);
+        m_Ops = other.m_Ops;
+        other.m_Ops = nullptr;
+      }
+    }
+
+    alignas(std::max_align_t) unsigned char m_Storage[INLINE_SIZE] = {};
+    const Ops* m_Ops = nullptr;
+  };
+}
@@ -0,0 +1,388 @@
+#include "src/oxpch.h"
+#include "JobSystem.h"
+
+#include "Utils/Log.h"
+#include "Utils/Profiler.h"
+
+namespace Oxylus {
+  JobSystem::SchedulerData JobSystem::s_Data;
+
+  //Index of the worker running on this thread, -1 for threads that are not workers.
+  static thread_local int32_t t_WorkerIndex = -1;
+
+  bool JobCounter::IsDone() {
+    if (m_Value.load(std::memory_order_acquire) != 0)
+      return false;
+    //Wait for the last decrement to release the counter so it can be destroyed safely.
+    std::lock_guard lock(m_Mutex);
+    return m_Value.load(std::memory_order_relaxed) == 0;
+  }
+
+  void JobCounter::Increment(const uint32_t count) {
+    m_Value.fetch_add(count, std::memory_order_relaxed);
+  }
+
+  void JobCounter::Decrement() {
+    std::vector<Job> continuations;
+    {
+      std::lock_guard lock(m_Mutex);
+      if (m_Value.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+      std::swap(continuations, m_Continuations);
+    }
+    for (auto& job : continuations)
+      JobSystem::Push(std::move(job));
+  }
+
+  bool JobCounter::AddContinuation(Job& job) {
+    std::lock_guard lock(m_Mutex);
+    if (m_Value.load(std::memory_order_acquire) == 0)
+      return false;
+    m_Continuations.emplace_back(std::move(job));
+    return true;
+  }
+
+  void JobCounter::AddReference() {
+    m_References.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void JobCounter::RemoveReference() {
+    if (m_References.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      JobSystem::ReleaseCounter(this);
+  }
+
+  JobHandle::~JobHandle() {
+    if (m_Counter)
+      m_Counter->RemoveReference();
+  }
+
+  JobHandle::JobHandle(const JobHandle& other) : m_Counter(other.m_Counter) {
+    if (m_Counter)
+      m_Counter->AddReference();
+  }
+
+  JobHandle::JobHandle(JobHandle&& other) noexcept : m_Counter(other.m_Counter) {
+    other.m_Counter = nullptr;
+  }
+
+  JobHandle& JobHandle::operator=(const JobHandle& other) {
+    if (this != &other) {
+      if (other.m_Counter)
+        other.m_Counter->AddReference();
+      if (m_Counter)
+        m_Counter->RemoveReference();
+      m_Counter = other.m_Counter;
+    }
+    return *this;
+  }
+
+  JobHandle& JobHandle::operator=(JobHandle&& other) noexcept {
+    if (this != &other) {
+      if (m_Counter)
+        m_Counter->RemoveReference();
+      m_Counter = other.m_Counter;
+      other.m_Counter = nullptr;
+    }
+    return *this;
+  }
+
+  bool JobHandle::IsDone() const {
+    return !m_Counter || m_Counter->IsDone();
+  }
+
+  void JobHandle::Wait() const {
+    if (m_Counter)
+      JobSystem::Wait(*m_Counter);
+  }
+
+  void JobSystem::Init(uint32_t workerCount) {
+    if (s_Data.Running)
+      return;
+    if (workerCount == 0)
+      workerCount = std::max(1u, std::thread::hardware_concurrency() - 1);
+
+    s_Data.Running = true;
+    s_Data.Workers.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; i++)
+      s_Data.Workers.emplace_back(CreateScope<Worker>());
+    //Start the threads only after every deque exists, workers steal from each other right away.
+    for (uint32_t i = 0; i < workerCount; i++)
+      s_Data.Workers[i]->Thread = std::thread(&JobSystem::WorkerLoop, i);
+
+    OX_CORE_TRACE("Job system initialized with {} workers", workerCount);
+  }
+
+  void JobSystem::Shutdown() {
+    if (!s_Data.Running)
+      return;
+    {
+      std::lock_guard lock(s_Data.SleepMutex);
+      s_Data.Running = false;
+    }
+    s_Data.WakeCondition.notify_all();
+    for (const auto& worker : s_Data.Workers)
+      worker->Thread.join();
+    s_Data.Workers.clear();
+  }
+
+  void JobSystem::Execute(JobFunction function, JobCounter* counter) {
+    Submit(Job{std::move(function), counter});
+  }
+
+  void JobSystem::ExecuteAfter(JobCounter& dependency, JobFunction function, JobCounter* counter) {
+    SubmitAfter(dependency, Job{std::move(function), counter});
+  }
+
+  JobHandle JobSystem::Schedule(JobFunction function) {
+    auto* counter = AcquireCounter();
+    Submit(Job{std::move(function), counter, true});
+    return JobHandle(counter);
+  }
+
+  JobHandle JobSystem::ScheduleAfter(const JobHandle& dependency, JobFunction function) {
+    if (!dependency.IsValid())
+      return Schedule(std::move(function));
+    auto* counter = AcquireCounter();
+    SubmitAfter(*dependency.m_Counter, Job{std::move(function), counter, true});
+    return JobHandle(counter);
+  }
+
+  void JobSystem::Wait(JobCounter& counter) {
+    ZoneScoped;
+    Job job;
+    while (!counter.IsDone()) {
+      //The main thread waits mid-frame, it must not start long unrelated jobs like asset loads.
+      if (t_WorkerIndex >= 0 ? TryPop(job) : TryPopFor(counter, job))
+        Run(job);
+      else
+        std::this_thread::yield();
+    }
+  }
+
+  void JobSystem::ParallelFor(const uint32_t count,
+                              const uint32_t chunkCount,
+                              const std::function<void(uint32_t chunkIndex, uint32_t begin, uint32_t end)>& func) {
+    if (chunkCount <= 1 || s_Data.Workers.empty()) {
+      func(0, 0, count);
+      return;
+    }
+
+    //Chunks are claimed from the group instead of being queued one by one, so the calling thread only ever runs chunks of this call.
+    //Helpers that start after every chunk was claimed return without touching func, the group outlives them.
+    struct ParallelForGroup {
+      std::atomic<uint32_t> NextChunk = 1;
+      std::atomic<uint32_t> DoneChunks = 0;
+    };
+    const auto group = CreateRef<ParallelForGroup>();
+    const uint32_t chunkSize = (count + chunkCount - 1) / chunkCount;
+    const auto runChunks = [&func, chunkCount, chunkSize, count](ParallelForGroup& state) {
+      for (uint32_t i = state.NextChunk.fetch_add(1); i < chunkCount; i = state.NextChunk.fetch_add(1)) {
+        const uint32_t begin = std::min(count, i * chunkSize);
+        const uint32_t end = std::min(count, begin + chunkSize);
+        func(i, begin, end);
+        state.DoneChunks.fetch_add(1, std::memory_order_release);
+      }
+    };
+
+    const uint32_t helperCount = std::min(chunkCount - 1, GetWorkerCount());
+    for (uint32_t i = 0; i < helperCount; i++)
+      Execute([group, runChunks] { runChunks(*group); });
+
+    func(0, 0, std::min(count, chunkSize));
+    runChunks(*group);
+
+    //Only chunks claimed by helpers that are still running are left.
+    while (group->DoneChunks.load(std::memory_order_acquire) != chunkCount - 1)
+      std::this_thread::yield();
+  }
+
+  uint32_t JobSystem::GetChunkCount(const uint32_t count, const uint32_t minChunkSize) {
+    const uint32_t chunks = (count + minChunkSize - 1) / std::max(1u, minChunkSize);
+    return std::clamp(chunks, 1u, GetConcurrency());
+  }
+
+  bool JobSystem::IsWorkerThread() {
+    return t_WorkerIndex >= 0;
+  }
+
+  uint32_t JobSystem::GetThreadIndex() {
+    return (uint32_t)(t_WorkerIndex + 1);
+  }
+
+  JobCounter* JobSystem::AcquireCounter() {
+    JobCounter* counter;
+    {
+      std::lock_guard lock(s_Data.CounterPoolMutex);
+      if (s_Data.FreeCounters.empty()) {
+        counter = &s_Data.CounterStorage.emplace_back();
+      }
+      else {
+        counter = s_Data.FreeCounters.back();
+        s_Data.FreeCounters.pop_back();
+      }
+    }
+    counter->m_References.store(2, std::memory_order_relaxed);
+    return counter;
+  }
+
+  void JobSystem::ReleaseCounter(JobCounter* counter) {
+    std::lock_guard lock(s_Data.CounterPoolMutex);
+    s_Data.FreeCounters.emplace_back(counter);
+  }
+
+  void JobSystem::Submit(Job&& job) {
+    if (job.Counter)
+      job.Counter->Increment();
+    Push(std::move(job));
+  }
+
+  void JobSystem::SubmitAfter(JobCounter& dependency, Job&& job) {
+    if (job.Counter)
+      job.Counter->Increment();
+    if (!dependency.AddContinuation(job))
+      Push(std::move(job));
+  }
+
+  void JobSystem::Push(Job&& job) {
+    if (!s_Data.Running) {
+      //Nothing would pick it up, run it in place.
+      Run(job);
+      return;
+    }
+
+    //Counted before it becomes visible so a thief can never take the count below zero.
+    s_Data.PendingJobs.fetch_add(1);
+    if (t_WorkerIndex >= 0) {
+      auto& worker = *s_Data.Workers[t_WorkerIndex];
+      std::lock_guard lock(worker.Mutex);
+      worker.Jobs.emplace_back(std::move(job));
+    }
+    else if (!s_Data.GlobalJobs.TryPush(std::move(job))) {
+      std::lock_guard lock(s_Data.OverflowMutex);
+      s_Data.OverflowJobs.emplace_back(std::move(job));
+      s_Data.OverflowCount.fetch_add(1);
+    }
+
+    //A sleeping worker registers itself under the sleep mutex before checking for jobs, so taking it here can't miss it.
+    if (s_Data.SleepingWorkers.load() > 0) {
+      std::lock_guard lock(s_Data.SleepMutex);
+      s_Data.WakeCondition.notify_one();
+    }
+  }
+
+  bool JobSystem::TryPop(Job& job) {
+    if (s_Data.PendingJobs.load(std::memory_order_acquire) == 0)
+      return false;
+
+    const auto workerCount = (uint32_t)s_Data.Workers.size();
+
+    //Own jobs first, newest first while they are still in cache.
+    if (t_WorkerIndex >= 0) {
+      auto& worker = *s_Data.Workers[t_WorkerIndex];
+      std::lock_guard lock(worker.Mutex);
+      if (!worker.Jobs.empty()) {
+        job = std::move(worker.Jobs.back());
+        worker.Jobs.pop_back();
+        s_Data.PendingJobs.fetch_sub(1);
+        return true;
+      }
+    }
+
+    if (s_Data.GlobalJobs.TryPop(job)) {
+      s_Data.PendingJobs.fetch_sub(1);
+      return true;
+    }
+
+    if (s_Data.OverflowCount.load(std::memory_order_acquire) > 0) {
+      std::lock_guard lock(s_Data.OverflowMutex);
+      if (!s_Data.OverflowJobs.empty()) {
+        job = std::move(s_Data.OverflowJobs.front());
+        s_Data.OverflowJobs.pop_front();
+        s_Data.OverflowCount.fetch_sub(1);
+        s_Data.PendingJobs.fetch_sub(1);
+        return true;
+      }
+    }
+
+    //Steal the oldest job of another worker.
+    const uint32_t start = t_WorkerIndex >= 0 ? (uint32_t)t_WorkerIndex + 1 : 0;
+    for (uint32_t i = 0; i < workerCount; i++) {
+      const uint32_t victimIndex = (start + i) % workerCount;
+      if ((int32_t)victimIndex == t_WorkerIndex)
+        continue;
+      auto& victim = *s_Data.Workers[victimIndex];
+      std::lock_guard lock(victim.Mutex);
+      if (!victim.Jobs.empty()) {
+        job = std::move(victim.Jobs.front());
+        victim.Jobs.pop_front();
+        s_Data.PendingJobs.fetch_sub(1);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool JobSystem::TryPopFor(const JobCounter& counter, Job& job) {
+    if (s_Data.PendingJobs.load(std::memory_order_acquire) == 0)
+      return false;
+
+    const auto takeFrom = [&counter, &job](std::deque<Job>& jobs) {
+      const auto it = std::find_if(jobs.begin(), jobs.end(), [&counter](const Job& queued) { return queued.Counter == &counter; });
+      if (it == jobs.end())
+        return false;
+      job = std::move(*it);
+      jobs.erase(it);
+      s_Data.PendingJobs.fetch_sub(1);
+      return true;
+    };
+
+    //Jobs of the counter spawned by other jobs end up in the deque of the worker that ran them.
+    for (const auto& worker : s_Data.Workers) {
+      std::lock_guard lock(worker->Mutex);
+      if (takeFrom(worker->Jobs))
+        return true;
+    }
+
+    if (s_Data.OverflowCount.load(std::memory_order_acquire) > 0) {
+      std::lock_guard lock(s_Data.OverflowMutex);
+      if (takeFrom(s_Data.OverflowJobs)) {
+        s_Data.OverflowCount.fetch_sub(1);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void JobSystem::Run(Job& job) {
+    job.Function();
+    if (job.Counter)
+      job.Counter->Decrement();
+    //Released only after the counter was signaled, the function or the job might hold the last reference to it.
+    job.Function.Reset();
+    if (job.OwnsCounter)
+      job.Counter->RemoveReference();
+    job.Counter = nullptr;
+    job.OwnsCounter = false;
+  }
+
+  void JobSystem::WorkerLoop(const uint32_t index) {
+    t_WorkerIndex = (int32_t)index;
+    const std::string threadName = "Job Worker " + std::to_string(index);
+    tracy::SetThreadName(threadName.c_str());
+
+    Job job;
+    while (true) {
+      if (TryPop(job)) {
+        Run(job);
+        continue;
+      }
+      if (!s_Data.Running && s_Data.PendingJobs.load() == 0)
+        break;
+
+      std::unique_lock lock(s_Data.SleepMutex);
+      s_Data.SleepingWorkers.fetch_add(1);
+      s_Data.WakeCondition.wait(lock, [] { return s_Data.PendingJobs.load() > 0 || !s_Data.Running; });
+      s_Data.SleepingWorkers.fetch_sub(1);
+    }
+  }
+}
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "ConcurrentQueue.h"
+#include "JobFunction.h"
+#include "Core/Base.h"
+
+namespace Oxylus {
+  class JobCounter;
+
+  struct Job {
+    JobFunction Function;
+    //Decremented once the job has run.
+    JobCounter* Counter = nullptr;
+    //Holds a reference to a pooled counter of a handle until the job has signaled it.
+    bool OwnsCounter = false;
+  };
+
+  /**
+   * \brief Tracks how many jobs are still outstanding.
+   * Jobs can be made to depend on a counter, they are queued once it reaches zero.
+   * A counter has to outlive the jobs that signal it, wait on it before destroying it.
+   */
+  class JobCounter {
+  public:
+    JobCounter() = default;
+    ~JobCounter() = default;
+
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    bool IsDone();
+
+  private:
+    void Increment(uint32_t count = 1);
+    void Decrement();
+    //Returns false if the counter is already done and the job should be queued right away.
+    bool AddContinuation(Job& job);
+    //Counters of handles are pooled, the last reference returns it to the job system.
+    void AddReference();
+    void RemoveReference();
+
+    std::atomic<uint32_t> m_Value = 0;
+    std::mutex m_Mutex;
+    std::vector<Job> m_Continuations;
+    std::atomic<uint32_t> m_References = 0;
+
+    friend class JobSystem;
+    friend class JobHandle;
+  };
+
+  /**
+   * \brief Completion handle of a scheduled job. Copies share the same job, an empty handle counts as done.
+   */
+  class JobHandle {
+  public:
+    JobHandle() = default;
+    ~JobHandle();
+
+    JobHandle(const JobHandle& other);
+    JobHandle(JobHandle&& other) noexcept;
+    JobHandle& operator=(const JobHandle& other);
+    JobHandle& operator=(JobHandle&& other) noexcept;
+
+    bool IsValid() const { return m_Counter != nullptr; }
+    bool IsDone() const;
+    //Runs other jobs on the calling thread until the job is done.
+    void Wait() const;
+
+  private:
+    //Takes over a reference the caller already added.
+    explicit JobHandle(JobCounter* counter) : m_Counter(counter) {}
+
+    JobCounter* m_Counter = nullptr;
+
+    friend class JobSystem;
+  };
+
+  /**
+   * \brief Result of a job scheduled with JobSystem::Async.
+   */
+  template<typename T>
+  class JobFuture {
+  public:
+    JobFuture() = default;
+
+    bool IsValid() const { return m_Handle.IsValid(); }
+    bool IsDone() const { return m_Handle.IsDone(); }
+    void Wait() const { m_Handle.Wait(); }
+    //Waits for the job and returns its result.
+    T& Get() {
+      Wait();
+      return m_Result->value();
+    }
+
+    const JobHandle& GetHandle() const { return m_Handle; }
+
+  private:
+    JobFuture(JobHandle handle, Ref<std::optional<T>> result) : m_Handle(std::move(handle)), m_Result(std::move(result)) {}
+
+    JobHandle m_Handle;
+    Ref<std::optional<T>> m_Result = nullptr;
+
+    friend class JobSystem;
+  };
+
+  /**
+   * \brief Engine wide work-stealing scheduler.
+   * Every worker owns a deque, it pushes and pops its own jobs at the back while idle workers steal from the front.
+   * Jobs queued from outside of the workers go to a shared lock-free queue so producers never contend on a lock.
+   */
+  class JobSystem {
+  public:
+    //workerCount 0 uses one worker per hardware thread besides the main thread.
+    static void Init(uint32_t workerCount = 0);
+    //Finishes every queued job and joins the workers.
+    static void Shutdown();
+
+    static void Execute(JobFunction function, JobCounter* counter = nullptr);
+    //Queues the job once dependency reaches zero.
+    static void ExecuteAfter(JobCounter& dependency, JobFunction function, JobCounter* counter = nullptr);
+
+    /**
+     * \brief Runs other jobs on the calling thread until the counter reaches zero.
+     * Threads that are not workers only run jobs signaling the counter, they never pick up unrelated ones from the shared queue.
+     */
+    static void Wait(JobCounter& counter);
+
+    static JobHandle Schedule(JobFunction function);
+    //Queues the job once dependency is done.
+    static JobHandle ScheduleAfter(const JobHandle& dependency, JobFunction function);
+
+    template<typename F>
+    static JobFuture<std::invoke_result_t<F>> Async(F&& func) {
+      using T = std::invoke_result_t<F>;
+      static_assert(!std::is_void_v<T>, "Use Schedule for jobs without a result");
+      auto result = CreateRef<std::optional<T>>();
+      JobHandle handle = Schedule([result, f = std::forward<F>(func)]() mutable { result->emplace(f()); });
+      return JobFuture<T>(std::move(handle), std::move(result));
+    }
+
+    /**
+     * \brief Splits [0, count) into chunkCount ranges and runs func on each of them.
+     * The first chunk runs on the calling thread which then only takes further chunks of the same call until every chunk is done.
+     */
+    static void ParallelFor(uint32_t count,
+                            uint32_t chunkCount,
+                            const std::function<void(uint32_t chunkIndex, uint32_t begin, uint32_t end)>& func);
+
+    //Number of chunks to split count elements into, each at least minChunkSize large and at most one per thread.
+    static uint32_t GetChunkCount(uint32_t count, uint32_t minChunkSize);
+
+    static uint32_t GetWorkerCount() { return (uint32_t)s_Data.Workers.size(); }
+    //Workers plus the calling thread.
+    static uint32_t GetConcurrency() { return GetWorkerCount() + 1; }
+    static bool IsWorkerThread();
+    //Index in [0, GetConcurrency()) that is unique per worker, threads that are not workers share 0.
+    static uint32_t GetThreadIndex();
+
+  private:
+    struct Worker {
+      std::thread Thread;
+      std::mutex Mutex;
+      std::deque<Job> Jobs;
+    };
+
+    static constexpr size_t GLOBAL_QUEUE_CAPACITY = 4096;
+
+    static struct SchedulerData {
+      std::vector<Scope<Worker>> Workers;
+      ConcurrentQueue<Job> GlobalJobs{GLOBAL_QUEUE_CAPACITY};
+      //Only used once the global queue is full.
+      std::mutex OverflowMutex;
+      std::deque<Job> OverflowJobs;
+      std::atomic<uint32_t> OverflowCount = 0;
+
+      //Counters of handles, reused so scheduling a job doesn't allocate. Deque so handed out counters never move.
+      std::mutex CounterPoolMutex;
+      std::deque<JobCounter> CounterStorage;
+      std::vector<JobCounter*> FreeCounters;
+
+      std::atomic<uint32_t> PendingJobs = 0;
+      std::atomic<uint32_t> SleepingWorkers = 0;
+      std::atomic<bool> Running = false;
+      std::mutex SleepMutex;
+      std::condition_variable WakeCondition;
+    } s_Data;
+
+    //Returns a counter from the pool with one reference for the handle and one for the job.
+    static JobCounter* AcquireCounter();
+    static void ReleaseCounter(JobCounter* counter);
+    static void Submit(Job&& job);
+    static void SubmitAfter(JobCounter& dependency, Job&& job);
+    static void Push(Job&& job);
+    static bool TryPop(Job& job);
+    //Pops a job that signals counter, jobs in the shared lock-free queue can't be searched and are left to the workers.
+    static bool TryPopFor(const JobCounter& counter, Job& job);
+    static void Run(Job& job);
+    static void WorkerLoop(uint32_t index);
+
+    friend class JobCounter;
+  };
+}
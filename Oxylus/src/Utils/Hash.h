@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace Oxylus {
+  class Hash {
+  public:
+    static constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+    static constexpr uint64_t FNV_PRIME = 0x100000001b3ull;
+
+    //64-bit FNV-1a, used to detect changed content, not for security. Pass a previous result as seed to chain data.
+    static uint64_t FNV1a(const void* data, const size_t size, uint64_t seed = FNV_OFFSET_BASIS) {
+      const auto* bytes = static_cast<const uint8_t*>(data);
+      for (size_t i = 0; i < size; i++) {
+        seed ^= bytes[i];
+        seed *= FNV_PRIME;
+      }
+      return seed;
+    }
+
+    static uint64_t FNV1a(const std::string_view str, const uint64_t seed = FNV_OFFSET_BASIS) {
+      return FNV1a(str.data(), str.size(), seed);
+    }
+
+    static std::string ToHex(const uint64_t hash) {
+      constexpr char digits[] = "0123456789abcdef";
+      std::string result(16, '0');
+      for (int i = 15; i >= 0; i--)
+        result[15 - i] = digits[(hash >> (i * 4)) & 0xF];
+      return result;
+    }
+  };
+}
@@ -0,0 +1,85 @@
+#include "src/oxpch.h"
+#include "MappedFile.h"
+
+#ifndef OX_PLATFORM_WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Oxylus {
+  MappedFile::~MappedFile() {
+    Close();
+  }
+
+#ifdef OX_PLATFORM_WINDOWS
+  bool MappedFile::Open(const std::string& path) {
+    Close();
+    const HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+      return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+      CloseHandle(file);
+      return false;
+    }
+    const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+      CloseHandle(file);
+      return false;
+    }
+    const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+      CloseHandle(mapping);
+      CloseHandle(file);
+      return false;
+    }
+    m_File = file;
+    m_Mapping = mapping;
+    m_Data = (const uint8_t*)data;
+    m_Size = (size_t)size.QuadPart;
+    return true;
+  }
+
+  void MappedFile::Close() {
+    if (m_Data)
+      UnmapViewOfFile(m_Data);
+    if (m_Mapping)
+      CloseHandle(m_Mapping);
+    if (m_File)
+      CloseHandle(m_File);
+    m_Data = nullptr;
+    m_Mapping = nullptr;
+    m_File = nullptr;
+    m_Size = 0;
+  }
+#else
+  bool MappedFile::Open(const std::string& path) {
+    Close();
+    const int file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+      return false;
+    struct stat info = {};
+    if (fstat(file, &info) != 0 || info.st_size == 0) {
+      close(file);
+      return false;
+    }
+    void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    //The mapping stays valid without the descriptor.
+    close(file);
+    if (data == MAP_FAILED)
+      return false;
+    m_Data = (const uint8_t*)data;
+    m_Size = (size_t)info.st_size;
+    return true;
+  }
+
+  void MappedFile::Close() {
+    if (m_Data)
+      munmap((void*)m_Data, m_Size);
+    m_Data = nullptr;
+    m_Size = 0;
+  }
+#endif
+}
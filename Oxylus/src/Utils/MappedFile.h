@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "Core/PlatformDetection.h"
+
+namespace Oxylus {
+  /**
+   * \brief Read only mapping of a whole file, pages are read in by the OS on first access instead of copied up front.
+   */
+  class MappedFile {
+  public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    //Returns false for missing or empty files.
+    bool Open(const std::string& path);
+    void Close();
+
+    bool IsOpen() const { return m_Data != nullptr; }
+    const uint8_t* GetData() const { return m_Data; }
+    size_t GetSize() const { return m_Size; }
+
+  private:
+    const uint8_t* m_Data = nullptr;
+    size_t m_Size = 0;
+#ifdef OX_PLATFORM_WINDOWS
+    void* m_File = nullptr;
+    void* m_Mapping = nullptr;
+#endif
+  };
+}
@@ -5,6 +5,8 @@
 
 namespace Oxylus {
   TracyVkCtx TracyProfiler::s_VulkanContext;
+  TracyVkCtx TracyProfiler::s_ComputeContext = nullptr;
+  thread_local bool TracyProfiler::t_RecordingCompute = false;
 
   void TracyProfiler::InitTracyForVulkan(VkPhysicalDevice physdev,
                                          VkDevice device,
@@ -19,18 +21,38 @@ namespace Oxylus {
                                                                                  "vkGetCalibratedTimestampsEXT");
 
     s_VulkanContext = TracyVkContextCalibrated(physdev, device, queue, cmdbuf, timedomains, timesteps);
+
+    //The context calibrates and resets its queries with a buffer of its own queue family, it is only used while creating it.
+    const auto& queues = VulkanContext::VulkanQueue;
+    if (queues.ComputeQueue != queues.GraphicsQueue) {
+      const auto& LogicalDevice = VulkanContext::GetDevice();
+      vk::CommandPoolCreateInfo poolInfo;
+      poolInfo.queueFamilyIndex = queues.computeQueueFamilyIndex;
+      poolInfo.flags = vk::CommandPoolCreateFlagBits::eTransient;
+      const vk::CommandPool commandPool = LogicalDevice.createCommandPool(poolInfo).value;
+
+      const vk::CommandBufferAllocateInfo allocateInfo{commandPool, vk::CommandBufferLevel::ePrimary, 1};
+      const vk::CommandBuffer computeCommandBuffer = LogicalDevice.allocateCommandBuffers(allocateInfo).value[0];
+      s_ComputeContext = TracyVkContextCalibrated(physdev, device, queues.ComputeQueue, computeCommandBuffer, timedomains, timesteps);
+
+      LogicalDevice.destroyCommandPool(commandPool);
+    }
 #endif
   }
 
   void TracyProfiler::DestroyContext() {
 #if GPU_PROFILER_ENABLED
     TracyVkDestroy(s_VulkanContext);
+    if (s_ComputeContext) {
+      TracyVkDestroy(s_ComputeContext);
+      s_ComputeContext = nullptr;
+    }
 #endif
   }
 
   void TracyProfiler::Collect(const vk::CommandBuffer& commandBuffer) {
 #if GPU_PROFILER_ENABLED
-    s_VulkanContext->Collect(commandBuffer);
+    GetContext()->Collect(commandBuffer);
 #endif
   }
 
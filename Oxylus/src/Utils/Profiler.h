@@ -27,10 +27,17 @@ namespace Oxylus {
 
     static void Collect(const vk::CommandBuffer& commandBuffer);
 
-    static TracyVkCtx& GetContext() { return s_VulkanContext; }
+    //Context of the queue the calling thread is recording for, see SetRecordingCompute.
+    static TracyVkCtx& GetContext() { return t_RecordingCompute && s_ComputeContext ? s_ComputeContext : s_VulkanContext; }
+
+    //Zones recorded on this thread go to the compute queue context until reset. Timestamps can't be read across queues.
+    static void SetRecordingCompute(const bool compute) { t_RecordingCompute = compute; }
 
   private:
     static TracyVkCtx s_VulkanContext;
+    //Only created when compute work is submitted on a separate queue.
+    static TracyVkCtx s_ComputeContext;
+    static thread_local bool t_RecordingCompute;
   };
 
   using FloatingPointMicroseconds = std::chrono::duration<double, std::micro>;
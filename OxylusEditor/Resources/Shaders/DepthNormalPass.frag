@@ -1,12 +1,12 @@
 #version 450
 
-layout(set = 1, binding = 1) uniform sampler2D in_NormalSampler;
-layout(set = 1, binding = 4) uniform sampler2D in_RoughnessSampler;
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout(location = 0) in vec3 in_WorldPos;
 layout(location = 1) in vec3 in_Normal;
 layout(location = 2) in vec2 in_UV;
 layout(location = 3) in mat3 in_WorldTangent;
+layout(location = 6) flat in uint in_MaterialIndex;
 
 layout(location = 0) out vec4 out_Normal;
 
@@ -15,14 +15,14 @@ layout(location = 0) out vec4 out_Normal;
 void main()
 {
     const float normalMapStrenght = u_Material.UseNormal ? 1.0 : 0.0;
-    vec3 normal = texture(in_NormalSampler, in_UV).rgb;
+    vec3 normal = SampleMaterialTexture(u_Material.NormalIndex, in_UV).rgb;
     normal = in_WorldTangent * normalize(normal * 2.0 - 1.0);
     normal = normalize(mix(normalize(in_Normal), normal, normalMapStrenght));
 
     float roughness = 0;
     if (u_Material.UseRoughness)
     {
-        roughness = 1.0 - texture(in_RoughnessSampler, in_UV * u_Material.UVScale).r;
+        roughness = 1.0 - SampleMaterialTexture(u_Material.RoughnessIndex, in_UV * u_Material.UVScale).r;
         roughness *= u_Material.Roughness;
     }
     else
@@ -3,10 +3,14 @@
 #extension GL_ARB_separate_shader_objects : enable
 #extension GL_ARB_shading_language_420pack : enable
 
+#include "VertexFormat.glsl"
+
 layout(location = 0) in vec3 inPos;
-layout(location = 1) in vec3 inNormal;
+layout(location = 1) in vec2 inNormal; // octahedral
 layout(location = 2) in vec2 inUV;
-layout(location = 3) in vec4 inTangent;
+layout(location = 3) in vec2 inTangent; // octahedral with the bitangent sign
+layout(location = 4) in mat4 inModel; // per instance
+layout(location = 8) in uint inMaterialIndex; // per instance
 
 layout(binding = 0) uniform UBO {
   mat4 projection;
@@ -15,31 +19,32 @@ layout(binding = 0) uniform UBO {
 }
 u_Ubo;
 
-layout(push_constant) uniform ModelConst { mat4 model; }
-u_ModelUbo;
-
 layout(location = 0) out vec3 outWorldPos;
 layout(location = 1) out vec3 outNormal;
 layout(location = 2) out vec2 outUV;
 layout(location = 3) out mat3 outWorldTangent;
+layout(location = 6) flat out uint outMaterialIndex;
 
 out gl_PerVertex { vec4 gl_Position; };
 
 void main() {
-  vec3 locPos = vec3(u_ModelUbo.model * vec4(inPos, 1.0));
+  vec3 locPos = vec3(inModel * vec4(inPos, 1.0));
   outWorldPos = locPos;
 
   // normal in viewspace
   mat4 view = u_Ubo.view;
-  mat3 normalMatrix = transpose(inverse(mat3(u_ModelUbo.model)));
-  outNormal = normalMatrix * inNormal;
+  mat3 normalMatrix = transpose(inverse(mat3(inModel)));
+  vec3 normal = DecodeOctahedral(inNormal);
+  vec4 tangent = DecodeTangent(inTangent);
+  outNormal = normalMatrix * normal;
 
   outUV = inUV;
+  outMaterialIndex = inMaterialIndex;
 
-  vec3 T = normalize((u_ModelUbo.model * inTangent).xyz);
-  vec3 N = normalize((u_ModelUbo.model * vec4(inNormal, 0.0)).xyz);
+  vec3 T = normalize((inModel * vec4(tangent.xyz, 0.0)).xyz);
+  vec3 N = normalize((inModel * vec4(normal, 0.0)).xyz);
   T = normalize(T - dot(T, N) * N);
-  vec3 B = cross(N, T);
+  vec3 B = cross(N, T) * tangent.w;
 
   outWorldTangent = mat3(T, B, N);
 
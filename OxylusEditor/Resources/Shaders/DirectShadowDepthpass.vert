@@ -5,6 +5,7 @@
 
 layout(location = 0) in vec3 in_Pos;
 layout(location = 2) in vec2 in_UV;
+layout(location = 4) in mat4 in_Model; // per instance
 
 layout(binding = 0) uniform UBO {
   mat4 projection[4];
@@ -12,11 +13,8 @@ layout(binding = 0) uniform UBO {
 }
 u_Ubo;
 
-layout(push_constant) uniform ModelConst {
-  mat4 model;
-  uint cascadeIndex;
-}
-u_ModelUbo;
+layout(push_constant) uniform CascadeConst { uint cascadeIndex; }
+u_Cascade;
 
 layout(location = 0) out vec3 out_Pos;
 layout(location = 2) out vec2 out_UV;
@@ -27,8 +25,8 @@ void main() {
   out_UV = in_UV;
   out_Pos = in_Pos;
 
-  mat4 projection = u_Ubo.projection[u_ModelUbo.cascadeIndex];
+  mat4 projection = u_Ubo.projection[u_Cascade.cascadeIndex];
   projection[1][1] *= -1.0f;
 
-  gl_Position = projection * u_ModelUbo.model * vec4(in_Pos, 1.0);
+  gl_Position = projection * in_Model * vec4(in_Pos, 1.0);
 }
\ No newline at end of file
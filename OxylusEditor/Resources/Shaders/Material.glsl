@@ -1,21 +1,36 @@
-layout(push_constant, std140) uniform Material {
-  layout(offset = 64) vec4 Color;
-  layout(offset = 80) vec4 Emmisive;
-  layout(offset = 96) float Roughness;
-  layout(offset = 100) float Metallic;
-  layout(offset = 104) float Specular;
-  layout(offset = 108) float Normal;
-  layout(offset = 112) float AO;
-  layout(offset = 116) bool UseAlbedo;
-  layout(offset = 120) bool UseRoughness;
-  layout(offset = 124) bool UseMetallic;
-  layout(offset = 128) bool UseNormal;
-  layout(offset = 132) bool UseAO;
-  layout(offset = 136) bool UseEmissive;
-  layout(offset = 140) bool UseSpecular;
-  layout(offset = 144) bool FlipImage;
-  layout(offset = 148) float AlphaCutoff;
-  layout(offset = 152) bool DoubleSided;
-  layout(offset = 156) uint UVScale;
+// Needs GL_EXT_nonuniform_qualifier. Mirrors GPUMaterial in MaterialPool.cpp
+struct MaterialData {
+  vec4 Color;
+  vec4 Emmisive;
+  float Roughness;
+  float Metallic;
+  float Specular;
+  float Normal;
+  float AO;
+  bool UseAlbedo;
+  bool UseRoughness;
+  bool UseMetallic;
+  bool UseNormal;
+  bool UseAO;
+  bool UseEmissive;
+  bool UseSpecular;
+  bool FlipImage;
+  float AlphaCutoff;
+  bool DoubleSided;
+  uint UVScale;
+  uint AlbedoIndex;
+  uint NormalIndex;
+  uint AOIndex;
+  uint MetallicIndex;
+  uint RoughnessIndex;
+};
+
+layout(set = 1, binding = 0) readonly buffer Materials { MaterialData materials[]; };
+layout(set = 1, binding = 1) uniform sampler2D u_Textures[];
+
+// Shaders including this declare in_MaterialIndex, the index comes from the instance buffer.
+#define u_Material materials[in_MaterialIndex]
+
+vec4 SampleMaterialTexture(uint index, vec2 uv) {
+  return texture(u_Textures[nonuniformEXT(index)], uv);
 }
-u_Material;
\ No newline at end of file
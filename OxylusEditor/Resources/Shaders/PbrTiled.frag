@@ -1,5 +1,7 @@
 #version 450
 
+#extension GL_EXT_nonuniform_qualifier : require
+
 #include "shadows.glsl"
 
 #extension GL_ARB_separate_shader_objects : enable
@@ -22,6 +24,7 @@ layout(location = 0) in vec3 inWorldPos;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inUV;
 layout(location = 3) in vec3 in_ViewPos;
+layout(location = 4) flat in uint in_MaterialIndex;
 
 layout(binding = 0) uniform UBO {
   mat4 projection;
@@ -64,13 +67,6 @@ layout(binding = 11) uniform ShadowUBO {
 }
 u_ShadowUbo;
 
-// Material
-layout(set = 1, binding = 0) uniform sampler2D albedoMap;
-layout(set = 1, binding = 1) uniform sampler2D normalMap;
-layout(set = 1, binding = 2) uniform sampler2D aoMap;
-layout(set = 1, binding = 3) uniform sampler2D metallicMap;
-layout(set = 1, binding = 4) uniform sampler2D roughnessMap;
-
 layout(location = 0) out vec4 outColor;
 
 #include "Material.glsl"
@@ -140,7 +136,7 @@ vec3 specularContribution(vec3 L, vec3 V, vec3 N, vec3 F0, float metallic,
 vec3 perturbNormal(vec2 uv) {
   vec3 tangentNormal = normalize(inNormal);
   if (u_Material.UseNormal) {
-    tangentNormal = texture(normalMap, uv).xyz * 2.0 - 1.0;
+    tangentNormal = SampleMaterialTexture(u_Material.NormalIndex, uv).xyz * 2.0 - 1.0;
     vec3 q1 = dFdx(inWorldPos);
     vec3 q2 = dFdy(inWorldPos);
     vec2 st1 = dFdx(uv);
@@ -166,7 +162,7 @@ void main() {
   float alpha = 1;
   vec3 albedo;
   if (u_Material.UseAlbedo) {
-    vec4 tex4 = texture(albedoMap, scaledUV);
+    vec4 tex4 = SampleMaterialTexture(u_Material.AlbedoIndex, scaledUV);
     alpha = tex4.a;
     albedo = pow(tex4.rgb, vec3(2.2));
     albedo *= vec3(u_Material.Color.r, u_Material.Color.g, u_Material.Color.b);
@@ -185,13 +181,13 @@ void main() {
 
   float metallic = u_Material.Metallic;
   if (u_Material.UseMetallic) {
-    metallic = texture(metallicMap, scaledUV).r;
+    metallic = SampleMaterialTexture(u_Material.MetallicIndex, scaledUV).r;
     metallic *= u_Material.Metallic;
   }
 
   float roughness = u_Material.Roughness;
   if (u_Material.UseRoughness) {
-    roughness = texture(roughnessMap, scaledUV).r;
+    roughness = SampleMaterialTexture(u_Material.RoughnessIndex, scaledUV).r;
     roughness *= u_Material.Roughness;
   }
 
@@ -219,7 +215,7 @@ void main() {
   // u_Material.ao;
   vec3 ambient = (kD * diffuse + specular);
   if (u_Material.UseAO)
-    ambient = (kD * diffuse + specular) * texture(aoMap, scaledUV).rrr;
+    ambient = (kD * diffuse + specular) * SampleMaterialTexture(u_Material.AOIndex, scaledUV).rrr;
 
   vec3 color;
 
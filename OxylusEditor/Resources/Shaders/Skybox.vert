@@ -4,7 +4,7 @@
 #extension GL_ARB_shading_language_420pack : enable
 
 layout(location = 0) in vec3 inPos;
-layout(location = 1) in vec3 inNormal;
+layout(location = 1) in vec2 inNormal; // octahedral, unused
 layout(location = 2) in vec2 inUV;
 
 layout(binding = 0) uniform UBO { mat4 projection; }
@@ -0,0 +1,14 @@
+// Mirrors VertexFormat in VertexFormat.h. Normals and tangents arrive as octahedral snorm pairs.
+vec3 DecodeOctahedral(vec2 encoded) {
+  vec3 n = vec3(encoded.xy, 1.0 - abs(encoded.x) - abs(encoded.y));
+  float t = max(-n.z, 0.0);
+  n.x += n.x >= 0.0 ? -t : t;
+  n.y += n.y >= 0.0 ? -t : t;
+  return normalize(n);
+}
+
+// The sign of the second component is the bitangent sign, its magnitude is remapped to [0, 1].
+vec4 DecodeTangent(vec2 encoded) {
+  float w = encoded.y < 0.0 ? -1.0 : 1.0;
+  return vec4(DecodeOctahedral(vec2(encoded.x, abs(encoded.y) * 2.0 - 1.0)), w);
+}
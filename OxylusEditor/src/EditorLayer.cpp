@@ -9,6 +9,7 @@
 #include "Core/Project.h"
 #include "Core/Resources.h"
 #include "Scene/SceneManager.h"
+#include "Thread/JobSystem.h"
 #include "Panels/ContentPanel.h"
 #include "Panels/ConsolePanel.h"
 #include "Panels/EditorSettingsPanel.h"
@@ -321,7 +322,7 @@ namespace Oxylus {
 
   void EditorLayer::SaveScene() {
     if (!m_LastSaveScenePath.empty()) {
-      ThreadManager::Get()->AssetThread.QueueJob([this] {
+      JobSystem::Execute([this] {
         SceneSerializer(GetActiveScene()).Serialize(m_LastSaveScenePath);
       });
     }
@@ -333,7 +334,7 @@ namespace Oxylus {
   void EditorLayer::SaveSceneAs() {
     const std::string filepath = FileDialogs::SaveFile({{"Oxylus Scene", "oxscene"}}, "New Scene");
     if (!filepath.empty()) {
-      ThreadManager::Get()->AssetThread.QueueJob([this, filepath] {
+      JobSystem::Execute([this, filepath] {
         SceneSerializer(GetActiveScene()).Serialize(filepath);
       });
       m_LastSaveScenePath = filepath;
@@ -9,6 +9,7 @@
 #include "Assets/AssetManager.h"
 #include "Assets/MaterialSerializer.h"
 #include "Core/Project.h"
+#include "Thread/JobSystem.h"
 #include "UI/IGUI.h"
 #include "Utils/FileWatch.h"
 #include "Utils/StringUtils.h"
@@ -280,7 +281,7 @@ namespace Oxylus {
 
     static filewatch::FileWatch<std::string> watch(m_AssetsDirectory.string(),
       [this](const auto&, const filewatch::Event) {
-        ThreadManager::Get()->AssetThread.QueueJob([this] {
+        JobSystem::Execute([this] {
           Refresh();
         });
       }
@@ -302,6 +303,9 @@ namespace Oxylus {
       Init();
     }
 
+    //Entries are rebuilt by refresh jobs, hold them off while the panel iterates over them.
+    std::lock_guard lock(m_RefreshMutex);
+
     if (OnBegin(windowFlags)) {
       RenderHeader();
       ImGui::Separator();
@@ -541,7 +545,6 @@ namespace Oxylus {
 
     if (ImGui::BeginTable("BodyTable", columnCount, flags)) {
       bool anyItemHovered = false;
-      bool textureCreated = false;
 
       int i = 0;
       for (auto& file : m_DirectoryEntries) {
@@ -553,20 +556,9 @@ namespace Oxylus {
         VkDescriptorSet textureId = m_DirectoryIcon->GetDescriptorSet();
         if (!isDir) {
           if (file.Type == FileType::Texture) {
-            if (file.Thumbnail) {
-              textureId = file.Thumbnail->GetDescriptorSet();
-            }
-            else if (!textureCreated) {
-              textureCreated = true;
-              file.Thumbnail = VulkanImage::GetBlankImage();
-              ThreadManager::Get()->AssetThread.QueueJob([&file] {
-                file.Thumbnail = AssetManager::GetImageAsset(file.Filepath).Data;
-              });
-              textureId = file.Thumbnail->GetDescriptorSet();
-            }
-            else {
-              textureId = 0;
-            }
+            if (!file.Thumbnail)
+              file.Thumbnail = RequestThumbnail(file.Filepath);
+            textureId = file.Thumbnail ? file.Thumbnail->GetDescriptorSet() : VulkanImage::GetBlankImage()->GetDescriptorSet();
           }
           else if (file.Type == FileType::Model) {
             if (file.Thumbnail) {
@@ -718,7 +710,7 @@ namespace Oxylus {
       if (ImGui::Button("OK", ImVec2(120, 0))) {
         std::filesystem::remove_all(m_DirectoryToDelete);
         m_DirectoryToDelete.clear();
-        ThreadManager::Get()->AssetThread.QueueJob([this] {
+        JobSystem::Execute([this] {
           Refresh();
         });
         ImGui::CloseCurrentPopup();
@@ -772,6 +764,26 @@ namespace Oxylus {
     m_ElapsedTime = 0.0f;
   }
 
+  Ref<VulkanImage> ContentPanel::RequestThumbnail(const std::string& path) {
+    std::lock_guard lock(m_ThumbnailMutex);
+    const auto it = m_Thumbnails.find(path);
+    if (it != m_Thumbnails.end())
+      return it->second;
+    if (m_ThumbnailJobs >= MAX_THUMBNAIL_JOBS)
+      return nullptr;
+
+    m_ThumbnailJobs++;
+    m_Thumbnails.emplace(path, nullptr);
+    //The job only knows the path, the entry it was requested for can be gone by the time the image is decoded.
+    JobSystem::Execute([this, path] {
+      Ref<VulkanImage> thumbnail = AssetManager::GetImageAsset(path).Data;
+      std::lock_guard jobLock(m_ThumbnailMutex);
+      m_Thumbnails[path] = std::move(thumbnail);
+      m_ThumbnailJobs--;
+    });
+    return nullptr;
+  }
+
   void ContentPanel::DrawContextMenuItems(const std::filesystem::path& context, bool isDir) {
     if (isDir) {
       if (ImGui::BeginMenu("Create")) {
@@ -816,7 +828,9 @@ namespace Oxylus {
 
     if (isDir) {
       if (ImGui::MenuItem("Refresh")) {
-        Refresh();
+        JobSystem::Execute([this] {
+          Refresh();
+        });
         ImGui::CloseCurrentPopup();
       }
     }
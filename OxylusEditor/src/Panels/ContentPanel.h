@@ -1,7 +1,9 @@
 #pragma once
 
 #include <filesystem>
+#include <mutex>
 #include <stack>
+#include <unordered_map>
 
 #include "EditorPanel.h"
 #include <imgui.h>
@@ -43,7 +45,13 @@ namespace Oxylus {
     void RenderSideView();
     void RenderBody(bool grid);
     void UpdateDirectoryEntries(const std::filesystem::path& directory);
-    void Refresh() { UpdateDirectoryEntries(m_CurrentDirectory); }
+    //Returns the thumbnail of a texture once it is decoded, queues the decoding on first request.
+    Ref<VulkanImage> RequestThumbnail(const std::string& path);
+    void Refresh() {
+      //Refreshes can be queued as jobs, keep them from overlapping each other.
+      std::lock_guard lock(m_RefreshMutex);
+      UpdateDirectoryEntries(m_CurrentDirectory);
+    }
 
     void DrawContextMenuItems(const std::filesystem::path& context, bool isDir);
 
@@ -75,5 +83,12 @@ namespace Oxylus {
     Ref<VulkanImage> m_MeshIcon;
     Ref<VulkanImage> m_FileIcon;
     std::filesystem::path m_DirectoryToDelete;
+    std::mutex m_RefreshMutex;
+
+    //Decoded by jobs and published by path, null while decoding.
+    static constexpr uint32_t MAX_THUMBNAIL_JOBS = 4;
+    std::unordered_map<std::string, Ref<VulkanImage>> m_Thumbnails;
+    uint32_t m_ThumbnailJobs = 0;
+    std::mutex m_ThumbnailMutex;
   };
 }
@@ -4,7 +4,9 @@
 #include <imgui.h>
 #include <fmt/format.h>
 
+#include "Assets/AssetManager.h"
 #include "Core/Memory.h"
+#include "Render/Vulkan/VulkanRenderer.h"
 
 namespace Oxylus {
   StatisticsPanel::StatisticsPanel() : EditorPanel("Statistics", ICON_MDI_CLIPBOARD_TEXT, false) {}
@@ -57,6 +59,27 @@ namespace Oxylus {
       ImGui::Text(fmt::format("Total Allocated: {0} {1}", totalAllocated, sizetype).c_str());
       ImGui::Text(fmt::format("Total Freed: {0} {1}", totalFreed, sizetype).c_str());
       ImGui::Text(fmt::format("Current Usage: {0} {1}", currentUsage, sizetype).c_str());
+
+      const auto& transientStats = VulkanRenderer::s_RendererContext.RenderGraph.GetTransientMemoryStats();
+      const float sizeDivisor = showInMegabytes ? 1024.0f * 1024.0f : 1024.0f;
+      ImGui::Text(fmt::format("Transient Images: {0} {1} in {2} blocks", (float)transientStats.AllocatedSize / sizeDivisor, sizetype, transientStats.BlockCount).c_str());
+      ImGui::Text(fmt::format("Saved By Aliasing: {0} {1}", (float)(transientStats.RequiredSize - transientStats.AllocatedSize) / sizeDivisor, sizetype).c_str());
+    }
+    ImGui::Separator();
+    //Assets
+    {
+      ImGui::Text("Assets");
+      const float sizeDivisor = showInMegabytes ? 1024.0f * 1024.0f : 1024.0f;
+      const auto budgetText = [sizeDivisor](const uint64_t budget) {
+        return budget == UINT64_MAX ? std::string("-") : fmt::format("{0}", (float)budget / sizeDivisor);
+      };
+      const std::pair<const char*, AssetType> types[] = {{"Meshes", AssetType::Mesh}, {"Materials", AssetType::Material}, {"Images", AssetType::Image}};
+      for (const auto& [name, type] : types) {
+        const AssetStats stats = AssetManager::GetStats(type);
+        ImGui::Text(fmt::format("{0}: {1} resident, {2} unused, {3} loading, {4} evicted", name, stats.ResidentCount, stats.UnreferencedCount, stats.PendingCount, stats.EvictionCount).c_str());
+        ImGui::Text(fmt::format("  CPU: {0} / {1} {2}", (float)stats.CPUBytes / sizeDivisor, budgetText(stats.Budget.CPUBytes), sizetype).c_str());
+        ImGui::Text(fmt::format("  GPU: {0} / {1} {2}", (float)stats.GPUBytes / sizeDivisor, budgetText(stats.Budget.GPUBytes), sizetype).c_str());
+      }
     }
   }
 
@@ -77,5 +100,14 @@ namespace Oxylus {
     ImGui::Text("FPS: %lf", static_cast<double>(avg));
     const double fps = (1.0 / static_cast<double>(avg)) * 1000.0;
     ImGui::Text("Frame time (ms): %lf", fps);
+
+    ImGui::Separator();
+    const auto& drawStats = VulkanRenderer::GetDrawStats();
+    ImGui::Text("Draw calls: %u", drawStats.DrawCalls.load());
+    ImGui::Text("Draw commands: %u", drawStats.DrawCommands.load());
+    ImGui::Text("Instances: %u", drawStats.Instances.load());
+    ImGui::Text("Pipeline binds: %u (skipped %u)", drawStats.PipelineBinds.load(), drawStats.SkippedPipelineBinds());
+    ImGui::Text("Vertex buffer binds: %u (skipped %u)", drawStats.VertexBufferBinds.load(), drawStats.SkippedVertexBufferBinds());
+    ImGui::Text("Descriptor set binds: %u (skipped %u)", drawStats.DescriptorSetBinds.load(), drawStats.SkippedDescriptorSetBinds());
   }
 }
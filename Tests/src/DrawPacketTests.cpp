@@ -0,0 +1,117 @@
+#include "Test.h"
+
+#include <algorithm>
+#include <random>
+
+#include "Render/DrawPacket.h"
+
+namespace Oxylus {
+  using Builder = DrawPacketBuilder;
+
+  OX_TEST(DrawPacket_KeyFieldsSortByPriority) {
+    //Each field outranks everything below it regardless of their values.
+    OX_CHECK(Builder::MakeKey(1, 0, 0, 0, 0.0f) > Builder::MakeKey(0, 63, 0xFFFF, 0xFFFF, 1.0f));
+    OX_CHECK(Builder::MakeKey(0, 1, 0, 0, 0.0f) > Builder::MakeKey(0, 0, 0xFFFF, 0xFFFF, 1.0f));
+    OX_CHECK(Builder::MakeKey(0, 0, 1, 0, 0.0f) > Builder::MakeKey(0, 0, 0, 0xFFFF, 1.0f));
+    OX_CHECK(Builder::MakeKey(0, 0, 0, 1, 0.0f) > Builder::MakeKey(0, 0, 0, 0, 1.0f));
+    OX_CHECK(Builder::MakeKey(0, 0, 0, 0, 0.5f) > Builder::MakeKey(0, 0, 0, 0, 0.25f));
+  }
+
+  OX_TEST(DrawPacket_KeyFieldsAreMasked) {
+    //Values wider than their field wrap instead of spilling into the field above.
+    OX_CHECK(Builder::MakeKey(0, 0, 0, 1u << Builder::GEOMETRY_BITS, 0.0f) == 0);
+    OX_CHECK(Builder::MakeKey(0, 0, 1u << Builder::MATERIAL_BITS, 0, 0.0f) == 0);
+    OX_CHECK(Builder::MakeKey(0, 1u << Builder::PIPELINE_BITS, 0, 0, 0.0f) == 0);
+    OX_CHECK(Builder::MakeKey(1u << Builder::PASS_BITS, 0, 0, 0, 0.0f) == 0);
+    OX_CHECK(Builder::MakeKey(0, 0, 0x1FFFF, 0, 0.0f) == Builder::MakeKey(0, 0, 0xFFFF, 0, 0.0f));
+
+    constexpr uint32_t totalBits = Builder::PASS_BITS + Builder::PIPELINE_BITS + Builder::MATERIAL_BITS + Builder::GEOMETRY_BITS + Builder::DEPTH_BITS;
+    static_assert(totalBits == 64);
+    OX_CHECK(Builder::MakeKey(0xF, 0x3F, 0xFFFF, 0xFFFF, 1.0f) == ~0ull);
+  }
+
+  OX_TEST(DrawPacket_KeyDepthIsClamped) {
+    OX_CHECK(Builder::MakeKey(0, 0, 0, 0, -1.0f) == Builder::MakeKey(0, 0, 0, 0, 0.0f));
+    OX_CHECK(Builder::MakeKey(0, 0, 0, 0, 4.0f) == Builder::MakeKey(0, 0, 0, 0, 1.0f));
+    //A clamped depth never reaches the geometry bits.
+    OX_CHECK(Builder::MakeKey(0, 0, 0, 0, 4.0f) < Builder::MakeKey(0, 0, 0, 1, 0.0f));
+  }
+
+  static bool MatchesStableSort(const std::vector<uint64_t>& keys) {
+    Builder builder;
+    builder.Begin(keys.size());
+    std::vector<DrawPacket> expected;
+    for (uint32_t i = 0; i < keys.size(); i++) {
+      builder.Add(keys[i], i);
+      expected.emplace_back(DrawPacket{keys[i], i});
+    }
+    builder.Sort();
+    std::stable_sort(expected.begin(), expected.end(), [](const DrawPacket& a, const DrawPacket& b) { return a.Key < b.Key; });
+
+    const auto& packets = builder.GetPackets();
+    if (packets.size() != expected.size())
+      return false;
+    for (size_t i = 0; i < packets.size(); i++) {
+      if (packets[i].Key != expected[i].Key || packets[i].Index != expected[i].Index)
+        return false;
+    }
+    return true;
+  }
+
+  OX_TEST(DrawPacket_SortMatchesStableSort) {
+    std::mt19937_64 random(1234);
+    for (const size_t count : {0, 1, 2, 17, 256, 5000}) {
+      std::vector<uint64_t> keys(count);
+      for (auto& key : keys)
+        key = random();
+      OX_CHECK(MatchesStableSort(keys));
+    }
+  }
+
+  OX_TEST(DrawPacket_SortKeepsEqualKeysInOrder) {
+    //Few distinct keys, so most packets compare equal and only their insertion order tells them apart.
+    std::mt19937_64 random(42);
+    std::vector<uint64_t> keys(2000);
+    for (auto& key : keys)
+      key = Builder::MakeKey((uint32_t)(random() % 3), 0, (uint32_t)(random() % 4), 7, 0.0f);
+    OX_CHECK(MatchesStableSort(keys));
+  }
+
+  OX_TEST(DrawPacket_SortSkipsUniformDigits) {
+    //Only the top byte differs, every other radix pass is skipped.
+    std::vector<uint64_t> keys;
+    for (uint64_t i = 0; i < 300; i++)
+      keys.emplace_back(((i * 37) % 256) << 56 | 0x00ABCDEF12345678ull);
+    OX_CHECK(MatchesStableSort(keys));
+
+    //Identical keys, nothing moves.
+    OX_CHECK(MatchesStableSort(std::vector<uint64_t>(100, 0x0123456789ABCDEFull)));
+  }
+
+  OX_TEST(DrawPacket_BuilderIsReusable) {
+    Builder builder;
+    builder.Begin(2);
+    builder.Add(5, 0);
+    builder.Add(3, 1);
+    builder.Sort();
+
+    builder.Begin(1);
+    builder.Add(9, 7);
+    builder.Sort();
+    OX_CHECK(builder.GetPackets().size() == 1);
+    OX_CHECK(builder.GetPackets()[0].Key == 9 && builder.GetPackets()[0].Index == 7);
+  }
+
+  OX_TEST(DrawPacket_IdIsStableAndSpreadsAddresses) {
+    std::vector<uint64_t> objects(64);
+    OX_CHECK(Builder::GetID(&objects[0]) == Builder::GetID(&objects[0]));
+
+    //Neighbouring allocations differ in their low bits, which is what the 16-bit key fields keep.
+    std::vector<uint32_t> ids;
+    for (const auto& object : objects)
+      ids.emplace_back(Builder::GetID(&object) & 0xFFFF);
+    //Addresses change between runs, allow the odd collision.
+    std::sort(ids.begin(), ids.end());
+    OX_CHECK(std::unique(ids.begin(), ids.end()) - ids.begin() >= 60);
+  }
+}
@@ -0,0 +1,208 @@
+#include "Test.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "Thread/ConcurrentQueue.h"
+#include "Thread/JobFunction.h"
+#include "Thread/JobSystem.h"
+
+namespace Oxylus {
+  OX_TEST(JobSystem_QueueIsFifoAndBounded) {
+    ConcurrentQueue<uint32_t> queue(8);
+    uint32_t value = 0;
+    OX_CHECK(!queue.TryPop(value));
+
+    //Several laps around the ring so the sequence numbers wrap.
+    for (uint32_t lap = 0; lap < 4; lap++) {
+      for (uint32_t i = 0; i < 8; i++)
+        OX_CHECK(queue.TryPush(lap * 8 + i));
+      uint32_t rejected = 100;
+      OX_CHECK(!queue.TryPush(std::move(rejected)));
+      OX_CHECK(rejected == 100);
+
+      for (uint32_t i = 0; i < 8; i++) {
+        OX_CHECK(queue.TryPop(value));
+        OX_CHECK(value == lap * 8 + i);
+      }
+      OX_CHECK(!queue.TryPop(value));
+    }
+  }
+
+  OX_TEST(JobSystem_QueueDeliversEveryValueOnce) {
+    constexpr uint32_t producers = 4;
+    constexpr uint32_t consumers = 4;
+    constexpr uint32_t perProducer = 20000;
+    ConcurrentQueue<uint32_t> queue(1024);
+    std::vector<std::atomic<uint32_t>> seen(producers * perProducer);
+    std::atomic<uint32_t> popped = 0;
+
+    std::vector<std::thread> threads;
+    for (uint32_t p = 0; p < producers; p++) {
+      threads.emplace_back([&, p] {
+        for (uint32_t i = 0; i < perProducer; i++) {
+          uint32_t value = p * perProducer + i;
+          while (!queue.TryPush(std::move(value)))
+            std::this_thread::yield();
+        }
+      });
+    }
+    for (uint32_t c = 0; c < consumers; c++) {
+      threads.emplace_back([&] {
+        uint32_t value;
+        while (popped.load() < producers * perProducer) {
+          if (queue.TryPop(value)) {
+            seen[value]++;
+            popped++;
+          }
+          else {
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+    for (auto& thread : threads)
+      thread.join();
+
+    uint32_t wrong = 0;
+    for (const auto& count : seen)
+      wrong += count.load() != 1;
+    OX_CHECK(wrong == 0);
+  }
+
+  OX_TEST(JobSystem_FunctionStoresInlineAndOnHeap) {
+    auto destroyed = std::make_shared<uint32_t>(0);
+    //Counts destructions of instances that weren't moved from.
+    struct Tracked {
+      std::shared_ptr<uint32_t> Destroyed;
+      uint32_t* Calls;
+      uint8_t Padding[JobFunction::INLINE_SIZE]{};
+
+      Tracked(std::shared_ptr<uint32_t> destroyed, uint32_t* calls) : Destroyed(std::move(destroyed)), Calls(calls) {}
+      Tracked(Tracked&& other) noexcept = default;
+      ~Tracked() { if (Destroyed) (*Destroyed)++; }
+
+      void operator()() const { (*Calls)++; }
+    };
+
+    uint32_t calls = 0;
+    {
+      //Too big for the inline storage, moving only passes the pointer along.
+      JobFunction heap(Tracked{destroyed, &calls});
+      JobFunction moved(std::move(heap));
+      OX_CHECK(!heap);
+      OX_CHECK((bool)moved);
+      moved();
+    }
+    OX_CHECK(calls == 1);
+    //The temporary was moved from, the heap copy is destroyed once with the function.
+    OX_CHECK(*destroyed == 1);
+
+    uint32_t small = 0;
+    JobFunction inlined([&small] { small += 2; });
+    JobFunction target;
+    target = std::move(inlined);
+    target();
+    OX_CHECK(small == 2);
+    target.Reset();
+    OX_CHECK(!target);
+  }
+
+  OX_TEST(JobSystem_CounterWaitsForNestedJobs) {
+    JobSystem::Init(4);
+    JobCounter counter;
+    std::atomic<uint32_t> runs = 0;
+    for (uint32_t i = 0; i < 64; i++) {
+      JobSystem::Execute([&] {
+        JobSystem::Execute([&] { runs++; }, &counter);
+        runs++;
+      }, &counter);
+    }
+    JobSystem::Wait(counter);
+    OX_CHECK(counter.IsDone());
+    OX_CHECK(runs == 128);
+    JobSystem::Shutdown();
+  }
+
+  OX_TEST(JobSystem_ContinuationsRunAfterTheirDependency) {
+    JobSystem::Init(4);
+    for (uint32_t repeat = 0; repeat < 100; repeat++) {
+      std::atomic<uint32_t> stage = 0;
+      std::atomic<bool> ordered = true;
+      const JobHandle first = JobSystem::Schedule([&] { stage = 1; });
+      const JobHandle second = JobSystem::ScheduleAfter(first, [&] {
+        ordered = ordered && stage == 1;
+        stage = 2;
+      });
+
+      JobCounter dependency;
+      JobCounter counter;
+      JobSystem::Execute([&] { stage.load(); }, &dependency);
+      JobSystem::ExecuteAfter(dependency, [&] { ordered = ordered && dependency.IsDone(); }, &counter);
+
+      second.Wait();
+      JobSystem::Wait(counter);
+      OX_CHECK(first.IsDone());
+      OX_CHECK(stage == 2);
+      OX_CHECK(ordered);
+    }
+
+    //Empty handles count as done, depending on one queues right away.
+    const JobHandle empty;
+    OX_CHECK(empty.IsDone());
+    std::atomic<bool> ran = false;
+    JobSystem::ScheduleAfter(empty, [&] { ran = true; }).Wait();
+    OX_CHECK(ran);
+    JobSystem::Shutdown();
+  }
+
+  OX_TEST(JobSystem_AsyncReturnsResult) {
+    JobSystem::Init(2);
+    auto future = JobSystem::Async([] { return 42; });
+    OX_CHECK(future.IsValid());
+    OX_CHECK(future.Get() == 42);
+    OX_CHECK(future.IsDone());
+    JobSystem::Shutdown();
+  }
+
+  OX_TEST(JobSystem_ParallelForCoversEveryIndexOnce) {
+    JobSystem::Init(4);
+    for (const uint32_t count : {0u, 1u, 7u, 1000u, 100003u}) {
+      for (const uint32_t chunks : {1u, 3u, 16u, 64u}) {
+        std::vector<std::atomic<uint32_t>> hits(count);
+        JobSystem::ParallelFor(count, chunks, [&](uint32_t, const uint32_t begin, const uint32_t end) {
+          for (uint32_t i = begin; i < end; i++)
+            hits[i]++;
+        });
+
+        uint32_t wrong = 0;
+        for (const auto& hit : hits)
+          wrong += hit.load() != 1;
+        OX_CHECK(wrong == 0);
+      }
+    }
+
+    OX_CHECK(JobSystem::GetChunkCount(0, 16) == 1);
+    OX_CHECK(JobSystem::GetChunkCount(10, 16) == 1);
+    OX_CHECK(JobSystem::GetChunkCount(1000000, 16) == JobSystem::GetConcurrency());
+    JobSystem::Shutdown();
+  }
+
+  OX_TEST(JobSystem_OverflowsPastTheSharedQueue) {
+    JobSystem::Init(2);
+    //More jobs from a thread that isn't a worker than the shared queue holds.
+    JobCounter counter;
+    std::atomic<uint32_t> runs = 0;
+    for (uint32_t i = 0; i < 20000; i++)
+      JobSystem::Execute([&] { runs++; }, &counter);
+    JobSystem::Wait(counter);
+    OX_CHECK(runs == 20000);
+
+    //Handles return their counters to the pool, scheduling many in a row has to keep working.
+    for (uint32_t i = 0; i < 10000; i++)
+      JobSystem::Schedule([&] { runs++; }).Wait();
+    OX_CHECK(runs == 30000);
+    JobSystem::Shutdown();
+  }
+}
@@ -0,0 +1,212 @@
+#include "Test.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+#include "Render/Mesh.h"
+#include "Render/MeshCache.h"
+
+namespace Oxylus {
+  //Cooks a copy of the cube into a directory of its own, so the source stamp can be changed and nothing is left behind.
+  //LoadData only parses and cooks, nothing here touches the GPU.
+  class MeshCacheFixture {
+  public:
+    MeshCacheFixture() {
+      std::error_code error;
+      m_Directory = std::filesystem::temp_directory_path(error) / "OxylusTests" / "MeshCache";
+      std::filesystem::remove_all(m_Directory, error);
+      std::filesystem::create_directories(m_Directory, error);
+      m_SourcePath = (m_Directory / "cube.gltf").string();
+      std::filesystem::copy_file(std::filesystem::path(OX_TEST_RESOURCES_PATH) / "Objects/cube.gltf", m_SourcePath, error);
+      MeshCache::SetDirectory(m_Directory / "Cooked");
+    }
+
+    ~MeshCacheFixture() {
+      MeshCache::SetDirectory({});
+      std::error_code error;
+      std::filesystem::remove_all(m_Directory, error);
+    }
+
+    const std::string& GetSourcePath() const { return m_SourcePath; }
+    std::filesystem::path GetCookedPath() const { return MeshCache::GetCookedPath(m_SourcePath, Mesh::None); }
+
+    //Parses the source and writes its cooked file.
+    bool Cook() const {
+      Mesh mesh;
+      return mesh.LoadData(m_SourcePath) && std::filesystem::exists(GetCookedPath());
+    }
+
+    bool Load(Mesh& mesh, const float scale = 1.0f) const {
+      return MeshCache::Load(mesh, m_SourcePath, Mesh::None, scale);
+    }
+
+    //Cooked files are mapped while loaded, meshes loaded from them have to be gone before they are rewritten.
+    std::vector<char> ReadCooked() const {
+      std::ifstream stream(GetCookedPath(), std::ios::binary);
+      return {std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+    }
+
+    void WriteCooked(const std::vector<char>& bytes) const {
+      std::ofstream stream(GetCookedPath(), std::ios::binary | std::ios::trunc);
+      stream.write(bytes.data(), (std::streamsize)bytes.size());
+    }
+
+    //Checks the invariants Load promises for whatever it accepted, the geometry pool relies on them.
+    static bool IsConsistent(const Mesh& mesh) {
+      for (const Mesh::Node* node : mesh.LinearNodes) {
+        for (const Mesh::Primitive* primitive : node->Primitives) {
+          if ((uint64_t)primitive->firstIndex + primitive->indexCount > mesh.IndexCount)
+            return false;
+        }
+      }
+      return true;
+    }
+
+  private:
+    std::filesystem::path m_Directory;
+    std::string m_SourcePath;
+  };
+
+  OX_TEST(MeshCache_RoundTrip) {
+    MeshCacheFixture fixture;
+    Mesh parsed;
+    OX_CHECK(parsed.LoadData(fixture.GetSourcePath()));
+    OX_CHECK(std::filesystem::exists(fixture.GetCookedPath()));
+
+    Mesh cooked;
+    OX_CHECK(fixture.Load(cooked));
+    OX_CHECK(cooked.IndexCount == parsed.IndexCount);
+    OX_CHECK(cooked.IndexCount > 0);
+    OX_CHECK(cooked.Nodes.size() == parsed.Nodes.size());
+    OX_CHECK(cooked.LinearNodes.size() == parsed.LinearNodes.size());
+    if (cooked.LinearNodes.size() != parsed.LinearNodes.size())
+      return;
+
+    for (size_t i = 0; i < parsed.LinearNodes.size(); i++) {
+      const Mesh::Node* expected = parsed.LinearNodes[i];
+      const Mesh::Node* node = cooked.LinearNodes[i];
+      OX_CHECK(node->Name == expected->Name);
+      OX_CHECK(node->Index == expected->Index);
+      OX_CHECK(node->MeshIndex == expected->MeshIndex);
+      OX_CHECK(node->ContainsMesh == expected->ContainsMesh);
+      OX_CHECK(node->Matrix == expected->Matrix);
+      OX_CHECK(node->Translation == expected->Translation);
+      OX_CHECK(node->Rotation == expected->Rotation);
+      OX_CHECK(node->Scale == expected->Scale);
+      OX_CHECK((node->Parent == nullptr) == (expected->Parent == nullptr));
+      OX_CHECK(node->Children.size() == expected->Children.size());
+      OX_CHECK(node->Primitives.size() == expected->Primitives.size());
+      if (node->Primitives.size() != expected->Primitives.size())
+        continue;
+
+      for (size_t p = 0; p < expected->Primitives.size(); p++) {
+        const Mesh::Primitive* expectedPrimitive = expected->Primitives[p];
+        const Mesh::Primitive* primitive = node->Primitives[p];
+        OX_CHECK(primitive->firstIndex == expectedPrimitive->firstIndex);
+        OX_CHECK(primitive->indexCount == expectedPrimitive->indexCount);
+        OX_CHECK(primitive->firstVertex == expectedPrimitive->firstVertex);
+        OX_CHECK(primitive->vertexCount == expectedPrimitive->vertexCount);
+        OX_CHECK(primitive->materialIndex == expectedPrimitive->materialIndex);
+        OX_CHECK(primitive->dimensions.min == expectedPrimitive->dimensions.min);
+        OX_CHECK(primitive->dimensions.max == expectedPrimitive->dimensions.max);
+      }
+    }
+  }
+
+  OX_TEST(MeshCache_CookedPathDependsOnFlags) {
+    MeshCacheFixture fixture;
+    OX_CHECK(fixture.GetCookedPath() == MeshCache::GetCookedPath(fixture.GetSourcePath(), Mesh::None));
+    OX_CHECK(fixture.GetCookedPath() != MeshCache::GetCookedPath(fixture.GetSourcePath(), Mesh::FlipY));
+    //Different spellings of the same file share the cooked file.
+    const auto spelled = (std::filesystem::path(fixture.GetSourcePath()).parent_path() / "." / "cube.gltf").string();
+    OX_CHECK(fixture.GetCookedPath() == MeshCache::GetCookedPath(spelled, Mesh::None));
+  }
+
+  OX_TEST(MeshCache_RejectsStaleFiles) {
+    MeshCacheFixture fixture;
+    OX_CHECK(fixture.Cook());
+    {
+      Mesh mesh;
+      OX_CHECK(fixture.Load(mesh));
+    }
+    {
+      Mesh mesh;
+      OX_CHECK(!fixture.Load(mesh, 2.0f));
+      OX_CHECK(!MeshCache::Load(mesh, fixture.GetSourcePath(), Mesh::FlipY, 1.0f));
+    }
+
+    //Editing the source invalidates the cooked file until the next parse cooks it again.
+    std::error_code error;
+    const auto sourceTime = std::filesystem::last_write_time(fixture.GetSourcePath(), error);
+    std::filesystem::last_write_time(fixture.GetSourcePath(), sourceTime + std::chrono::hours(1), error);
+    {
+      Mesh mesh;
+      OX_CHECK(!fixture.Load(mesh));
+    }
+    OX_CHECK(fixture.Cook());
+    {
+      Mesh mesh;
+      OX_CHECK(fixture.Load(mesh));
+    }
+  }
+
+  OX_TEST(MeshCache_RejectsCorruptFiles) {
+    MeshCacheFixture fixture;
+    OX_CHECK(fixture.Cook());
+    const std::vector<char> original = fixture.ReadCooked();
+    OX_CHECK(original.size() > 64);
+    if (original.size() <= 64)
+      return;
+
+    const auto rejects = [&fixture](const std::vector<char>& bytes) {
+      fixture.WriteCooked(bytes);
+      Mesh mesh;
+      return !fixture.Load(mesh) && mesh.LinearNodes.empty();
+    };
+
+    OX_CHECK(rejects({}));
+    OX_CHECK(rejects(std::vector(original.begin(), original.begin() + (ptrdiff_t)original.size() / 2)));
+    auto bytes = original;
+    bytes.emplace_back(0);
+    OX_CHECK(rejects(bytes));
+    //Magic and version lead the header.
+    bytes = original;
+    bytes[0] ^= 0x7F;
+    OX_CHECK(rejects(bytes));
+    bytes = original;
+    bytes[4] ^= 0x7F;
+    OX_CHECK(rejects(bytes));
+    //The cube has no embedded images, its indices end the file.
+    bytes = original;
+    std::fill(bytes.end() - 4, bytes.end(), (char)0xFF);
+    OX_CHECK(rejects(bytes));
+
+    fixture.WriteCooked(original);
+    Mesh mesh;
+    OX_CHECK(fixture.Load(mesh));
+  }
+
+  OX_TEST(MeshCache_RandomCorruptionIsContained) {
+    MeshCacheFixture fixture;
+    OX_CHECK(fixture.Cook());
+    const std::vector<char> original = fixture.ReadCooked();
+    if (original.empty())
+      return;
+
+    //Damage in vertex data goes unnoticed, but whatever is accepted has to be safe to upload and draw.
+    std::mt19937 random(11);
+    for (uint32_t iteration = 0; iteration < 256; iteration++) {
+      auto bytes = original;
+      const uint32_t flips = 1 + random() % 4;
+      for (uint32_t i = 0; i < flips; i++)
+        bytes[random() % bytes.size()] ^= (char)(1 + random() % 255);
+      fixture.WriteCooked(bytes);
+
+      Mesh mesh;
+      if (fixture.Load(mesh))
+        OX_CHECK(MeshCacheFixture::IsConsistent(mesh));
+    }
+  }
+}
@@ -0,0 +1,212 @@
+#include <OxylusEngine.h>
+
+#include "Assets/AssetManager.h"
+#include "Core/Resources.h"
+#include "Render/Vulkan/VulkanBuffer.h"
+#include "Render/Vulkan/VulkanImage.h"
+#include "Render/Window.h"
+#include "Render/Vulkan/VulkanRenderer.h"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+//Renders the same scene with indirect draws and with one direct draw per command and compares the final images.
+//Both paths read the same sorted commands and instance data, so any difference is a bug in the indirect path.
+namespace Oxylus {
+  static int s_ExitCode = 1;
+
+  class RenderTestLayer : public Layer {
+  public:
+    RenderTestLayer() : Layer("RenderTestLayer") { }
+
+    void OnAttach(EventDispatcher& dispatcher) override {
+      const auto cube = AssetManager::GetMeshAsset(Resources::GetResourcesPath("Objects/cube.gltf").string());
+      const auto sphere = AssetManager::GetMeshAsset(Resources::GetResourcesPath("Objects/sphere.gltf").string());
+
+      //Copies of the same primitive, the indirect path draws each mesh with one instanced command.
+      for (int32_t x = 0; x < GRID_SIZE; x++) {
+        for (int32_t z = 0; z < GRID_SIZE; z++) {
+          const auto& mesh = (x + z) % 2 == 0 ? cube.Data : sphere.Data;
+          Entity entity = m_Scene.CreateEntity(fmt::format("Mesh {} {}", x, z));
+          entity.AddComponentI<MeshRendererComponent>(mesh);
+          entity.GetComponent<MaterialComponent>().Materials = mesh->GetMaterialsAsRef();
+          entity.GetComponent<TransformComponent>().Translation = Vec3((float)x * 2.5f - 10.0f, 0.0f, (float)z * -2.5f);
+        }
+      }
+
+      Entity light = m_Scene.CreateEntity("Sun");
+      light.AddComponentI<LightComponent>().Type = LightComponent::LightType::Directional;
+      light.GetComponent<TransformComponent>().Rotation = Vec3(glm::radians(-60.0f), glm::radians(30.0f), 0.0f);
+
+      m_Camera.SetPosition(Vec3(0.0f, 6.0f, 12.0f));
+      m_Camera.SetYaw(glm::radians(-90.0f));
+      m_Camera.SetPitch(glm::radians(-25.0f));
+      m_Camera.UpdateViewMatrix();
+    }
+
+    void OnUpdate(const float deltaTime) override {
+      m_Frame++;
+      //Layers update before the renderer draws, the image read here is the one of the previous frame.
+      if (m_Frame == SETTLE_FRAMES) {
+        m_IndirectDrawCalls = VulkanRenderer::GetDrawStats().DrawCalls;
+        m_IndirectImage = ReadFinalImage();
+        VulkanRenderer::SetIndirectDraws(false);
+      }
+      else if (m_Frame == SETTLE_FRAMES * 2) {
+        m_DirectDrawCalls = VulkanRenderer::GetDrawStats().DrawCalls;
+        s_ExitCode = Compare(ReadFinalImage()) ? 0 : 1;
+        VulkanRenderer::SetIndirectDraws(true);
+        Application::Get().Close();
+        return;
+      }
+
+      m_Camera.UpdateAspectRatio(Window::GetWindowExtent());
+      m_Scene.OnEditorUpdate(deltaTime, m_Camera);
+    }
+
+  private:
+    static constexpr int32_t GRID_SIZE = 9;
+    //Enough for every frame in flight and the streamed meshes to land.
+    static constexpr uint32_t SETTLE_FRAMES = 16;
+    //Per channel, rasterization of both paths is identical so this only absorbs dithering.
+    static constexpr int32_t CHANNEL_TOLERANCE = 2;
+
+    Scene m_Scene;
+    Camera m_Camera;
+    uint32_t m_Frame = 0;
+    uint32_t m_IndirectDrawCalls = 0;
+    uint32_t m_DirectDrawCalls = 0;
+    std::vector<uint8_t> m_IndirectImage;
+
+    static std::vector<uint8_t> ReadFinalImage() {
+      VulkanRenderer::WaitDeviceIdle();
+
+      const VulkanImage& image = VulkanRenderer::GetFinalImage();
+      const uint32_t width = image.GetWidth();
+      const uint32_t height = image.GetHeight();
+      const vk::DeviceSize size = (vk::DeviceSize)width * height * 4;
+
+      VulkanBuffer readback;
+      readback.CreateBuffer(vk::BufferUsageFlagBits::eTransferDst,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+        size,
+        nullptr,
+        VMA_MEMORY_USAGE_AUTO_PREFER_HOST).Map();
+
+      VulkanRenderer::SubmitOnce([&](const VulkanCommandBuffer& cmd) {
+        vk::ImageMemoryBarrier barrier;
+        barrier.image = image.GetImage();
+        barrier.subresourceRange = {vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1};
+        barrier.oldLayout = image.GetImageLayout();
+        barrier.newLayout = vk::ImageLayout::eTransferSrcOptimal;
+        barrier.srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite;
+        barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+        cmd.Get().pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput,
+          vk::PipelineStageFlagBits::eTransfer,
+          {},
+          nullptr,
+          nullptr,
+          barrier);
+
+        vk::BufferImageCopy region;
+        region.imageSubresource = {vk::ImageAspectFlagBits::eColor, 0, 0, 1};
+        region.imageExtent = vk::Extent3D{width, height, 1};
+        cmd.Get().copyImageToBuffer(image.GetImage(), vk::ImageLayout::eTransferSrcOptimal, readback.Get(), region);
+
+        std::swap(barrier.oldLayout, barrier.newLayout);
+        barrier.srcAccessMask = vk::AccessFlagBits::eTransferRead;
+        barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+        cmd.Get().pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+          vk::PipelineStageFlagBits::eFragmentShader,
+          {},
+          nullptr,
+          nullptr,
+          barrier);
+      });
+
+      std::vector<uint8_t> pixels(size);
+      memcpy(pixels.data(), readback.GetMapped(), size);
+      readback.Destroy();
+      return pixels;
+    }
+
+    bool Compare(const std::vector<uint8_t>& directImage) const {
+      const VulkanImage& image = VulkanRenderer::GetFinalImage();
+      const int32_t width = (int32_t)image.GetWidth();
+      const int32_t height = (int32_t)image.GetHeight();
+
+      uint64_t mismatches = 0;
+      uint64_t covered = 0;
+      for (size_t i = 0; i < directImage.size(); i += 4) {
+        bool mismatch = false;
+        for (size_t c = 0; c < 3; c++) {
+          mismatch |= std::abs((int32_t)m_IndirectImage[i + c] - (int32_t)directImage[i + c]) > CHANNEL_TOLERANCE;
+          covered += directImage[i + c] != 0;
+        }
+        mismatches += mismatch;
+      }
+
+      bool passed = true;
+      if (covered == 0) {
+        OX_CORE_ERROR("Render test: the final image is empty, the scene wasn't drawn.");
+        passed = false;
+      }
+      if (mismatches != 0) {
+        OX_CORE_ERROR("Render test: {} of {} pixels differ between the indirect and the direct draws.", mismatches, directImage.size() / 4);
+        passed = false;
+      }
+      //The copies of each mesh are merged into instanced commands, so there should be far fewer calls than entities.
+      if (m_IndirectDrawCalls == 0 || m_IndirectDrawCalls > m_DirectDrawCalls || m_IndirectDrawCalls >= (uint32_t)(GRID_SIZE * GRID_SIZE)) {
+        OX_CORE_ERROR("Render test: {} indirect and {} direct draw calls for {} meshes.", m_IndirectDrawCalls, m_DirectDrawCalls, GRID_SIZE * GRID_SIZE);
+        passed = false;
+      }
+
+      if (!passed) {
+        const bool bgra = image.GetDesc().Format == vk::Format::eB8G8R8A8Unorm || image.GetDesc().Format == vk::Format::eB8G8R8A8Srgb;
+        WritePNG("RenderTest_Indirect.png", m_IndirectImage, width, height, bgra);
+        WritePNG("RenderTest_Direct.png", directImage, width, height, bgra);
+      }
+      else {
+        OX_CORE_INFO("Render test passed: {} indirect and {} direct draw calls.", m_IndirectDrawCalls, m_DirectDrawCalls);
+      }
+      return passed;
+    }
+
+    static void WritePNG(const char* fileName, std::vector<uint8_t> pixels, const int32_t width, const int32_t height, const bool bgra) {
+      for (size_t i = 0; i < pixels.size(); i += 4) {
+        if (bgra)
+          std::swap(pixels[i], pixels[i + 2]);
+        pixels[i + 3] = 255;
+      }
+      stbi_write_png(fileName, width, height, 4, pixels.data(), width * 4);
+      OX_CORE_ERROR("Render test: wrote {}", fileName);
+    }
+  };
+
+  Application* CreateApplication(ApplicationCommandLineArgs args) {
+    AppSpec spec;
+    spec.Name = "Oxylus Render Tests";
+    spec.Backend = Core::RenderBackend::Vulkan;
+    spec.WorkingDirectory = std::filesystem::current_path().string();
+    spec.CommandLineArgs = args;
+    spec.CustomWindowTitle = false;
+    spec.UseImGui = true;
+
+    const auto app = new Application(spec);
+    app->PushLayer(new RenderTestLayer());
+    return app;
+  }
+}
+
+//Not Core/EntryPoint.h, the test reports its result through the exit code.
+int main(int argc, char** argv) {
+  Oxylus::Log::Init();
+
+  const auto app = Oxylus::CreateApplication({argc, argv});
+
+  app->InitSystems();
+  app->Run();
+
+  delete app;
+  return Oxylus::s_ExitCode;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+//Minimal test registry, tests register themselves and the runner executes every test whose name starts with a filter.
+namespace Oxylus::Test {
+  struct TestCase {
+    const char* Name;
+    void (*Function)();
+  };
+
+  std::vector<TestCase>& GetTests();
+  void ReportFailure(const char* expression, const char* file, int32_t line);
+
+  struct Registrar {
+    Registrar(const char* name, void (*function)()) {
+      GetTests().emplace_back(TestCase{name, function});
+    }
+  };
+}
+
+#define OX_TEST(name) \
+  static void name(); \
+  static ::Oxylus::Test::Registrar name##_Registrar(#name, name); \
+  static void name()
+
+//Records the failure and keeps going so one run reports every broken check.
+#define OX_CHECK(expression) \
+  do { \
+    if (!(expression)) \
+      ::Oxylus::Test::ReportFailure(#expression, __FILE__, __LINE__); \
+  } while (false)
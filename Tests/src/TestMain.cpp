@@ -0,0 +1,52 @@
+#include "Test.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include "Utils/Log.h"
+
+namespace Oxylus::Test {
+  static uint32_t s_Failures = 0;
+
+  std::vector<TestCase>& GetTests() {
+    static std::vector<TestCase> tests;
+    return tests;
+  }
+
+  void ReportFailure(const char* expression, const char* file, const int32_t line) {
+    std::printf("  %s:%d: check failed: %s\n", file, line, expression);
+    s_Failures++;
+  }
+}
+
+//Usage: OxylusTests [name prefix]. Returns the number of failed tests.
+int main(int argc, char** argv) {
+  using namespace Oxylus::Test;
+  Oxylus::Log::Init();
+
+  const char* filter = argc > 1 ? argv[1] : "";
+  uint32_t run = 0;
+  uint32_t failed = 0;
+  for (const auto& test : GetTests()) {
+    if (std::strncmp(test.Name, filter, std::strlen(filter)) != 0)
+      continue;
+
+    const uint32_t failuresBefore = s_Failures;
+    test.Function();
+    run++;
+    if (s_Failures != failuresBefore) {
+      std::printf("[FAILED] %s\n", test.Name);
+      failed++;
+    }
+    else {
+      std::printf("[PASSED] %s\n", test.Name);
+    }
+  }
+
+  std::printf("%u of %u tests passed.\n", run - failed, run);
+  if (run == 0) {
+    std::printf("No test matches '%s'.\n", filter);
+    return 1;
+  }
+  return (int)failed;
+}
@@ -0,0 +1,184 @@
+#include "Test.h"
+
+#include <algorithm>
+#include <random>
+
+#include "Render/TransientMemoryPlanner.h"
+
+namespace Oxylus {
+  using Planner = TransientMemoryPlanner;
+
+  static Planner::Resource MakeResource(const vk::DeviceSize size, const uint32_t firstUse, const uint32_t lastUse,
+                                        const vk::DeviceSize alignment = 256, const uint32_t memoryTypeBits = 0xFF, const uint32_t group = 0) {
+    Planner::Resource resource;
+    resource.Requirements = vk::MemoryRequirements{size, alignment, memoryTypeBits};
+    resource.Group = group;
+    resource.FirstUse = firstUse;
+    resource.LastUse = lastUse;
+    return resource;
+  }
+
+  static bool Contains(const std::vector<uint32_t>& values, const uint32_t value) {
+    return std::find(values.begin(), values.end(), value) != values.end();
+  }
+
+  //Invariants every plan has to hold no matter how well it packs.
+  static void CheckPlan(const std::vector<Planner::Resource>& resources, const Planner::Plan& plan) {
+    OX_CHECK(plan.Placements.size() == resources.size());
+    OX_CHECK(plan.Aliases.size() == resources.size());
+
+    vk::DeviceSize requiredSize = 0;
+    for (size_t i = 0; i < resources.size(); i++) {
+      const auto& requirements = resources[i].Requirements;
+      const auto& placement = plan.Placements[i];
+      requiredSize += requirements.size;
+      OX_CHECK(placement.Block < plan.Blocks.size());
+      if (placement.Block >= plan.Blocks.size())
+        continue;
+      const auto& block = plan.Blocks[placement.Block];
+      OX_CHECK(placement.Offset % requirements.alignment == 0);
+      OX_CHECK(placement.Offset + requirements.size <= block.size);
+      OX_CHECK(block.alignment >= requirements.alignment);
+      OX_CHECK((block.memoryTypeBits & requirements.memoryTypeBits) == block.memoryTypeBits);
+      OX_CHECK(block.memoryTypeBits != 0);
+    }
+    OX_CHECK(plan.RequiredSize == requiredSize);
+
+    vk::DeviceSize allocatedSize = 0;
+    for (const auto& block : plan.Blocks)
+      allocatedSize += block.size;
+    OX_CHECK(plan.AllocatedSize == allocatedSize);
+
+    for (uint32_t a = 0; a < (uint32_t)resources.size(); a++) {
+      for (uint32_t b = a + 1; b < (uint32_t)resources.size(); b++) {
+        const auto& first = resources[a];
+        const auto& second = resources[b];
+        const auto& firstPlacement = plan.Placements[a];
+        const auto& secondPlacement = plan.Placements[b];
+        if (firstPlacement.Block == secondPlacement.Block)
+          OX_CHECK(first.Group == second.Group);
+
+        const bool sharesMemory = firstPlacement.Block == secondPlacement.Block
+                                  && firstPlacement.Offset < secondPlacement.Offset + second.Requirements.size
+                                  && secondPlacement.Offset < firstPlacement.Offset + first.Requirements.size;
+        const bool alive = first.IsUsed() && second.IsUsed() && first.FirstUse <= second.LastUse && second.FirstUse <= first.LastUse;
+        //Resources alive at the same time never share memory, the ones that do are reported to each other.
+        OX_CHECK(!(sharesMemory && alive));
+        const bool aliased = sharesMemory && first.IsUsed() && second.IsUsed();
+        OX_CHECK(Contains(plan.Aliases[a], b) == aliased);
+        OX_CHECK(Contains(plan.Aliases[b], a) == aliased);
+      }
+    }
+  }
+
+  OX_TEST(TransientMemory_EmptyInput) {
+    const auto plan = Planner::Build({});
+    OX_CHECK(plan.Blocks.empty());
+    OX_CHECK(plan.Placements.empty());
+    OX_CHECK(plan.RequiredSize == 0);
+    OX_CHECK(plan.AllocatedSize == 0);
+  }
+
+  OX_TEST(TransientMemory_DisjointLifetimesAlias) {
+    const std::vector resources = {MakeResource(4096, 0, 1), MakeResource(4096, 2, 3)};
+    const auto plan = Planner::Build(resources);
+    CheckPlan(resources, plan);
+
+    OX_CHECK(plan.Blocks.size() == 1);
+    OX_CHECK(plan.Placements[0] == plan.Placements[1]);
+    OX_CHECK(plan.RequiredSize == 8192);
+    OX_CHECK(plan.AllocatedSize == 4096);
+  }
+
+  OX_TEST(TransientMemory_OverlappingLifetimesDontAlias) {
+    const std::vector resources = {MakeResource(4096, 0, 2), MakeResource(4096, 2, 3)};
+    const auto plan = Planner::Build(resources);
+    CheckPlan(resources, plan);
+
+    //One pass using both is enough to keep them apart.
+    OX_CHECK(plan.AllocatedSize == 8192);
+    OX_CHECK(plan.Aliases[0].empty());
+    OX_CHECK(plan.Aliases[1].empty());
+  }
+
+  OX_TEST(TransientMemory_SmallResourcesFillGaps) {
+    //The large resource is placed first, the two small ones are dead while it lives and fit behind each other in its memory.
+    const std::vector resources = {MakeResource(1024, 0, 0), MakeResource(4096, 1, 2), MakeResource(1024, 3, 3)};
+    const auto plan = Planner::Build(resources);
+    CheckPlan(resources, plan);
+
+    OX_CHECK(plan.Blocks.size() == 1);
+    OX_CHECK(plan.AllocatedSize == 4096);
+    OX_CHECK(plan.Aliases[1].size() == 2);
+  }
+
+  OX_TEST(TransientMemory_OffsetsAreAligned) {
+    //The first resource is alive throughout, the others have to go behind it at their own alignment.
+    const std::vector resources = {
+      MakeResource(1000, 0, 3, 1),
+      MakeResource(512, 0, 1, 4096),
+      MakeResource(100, 2, 3, 64),
+    };
+    const auto plan = Planner::Build(resources);
+    CheckPlan(resources, plan);
+
+    OX_CHECK(plan.Blocks.size() == 1);
+    OX_CHECK(plan.Blocks[0].alignment == 4096);
+    OX_CHECK(plan.Placements[1].Offset == 4096);
+  }
+
+  OX_TEST(TransientMemory_GroupsNeverShareBlocks) {
+    const std::vector resources = {MakeResource(4096, 0, 0, 256, 0xFF, 0), MakeResource(4096, 1, 1, 256, 0xFF, 1)};
+    const auto plan = Planner::Build(resources);
+    CheckPlan(resources, plan);
+
+    OX_CHECK(plan.Blocks.size() == 2);
+    OX_CHECK(plan.Aliases[0].empty());
+  }
+
+  OX_TEST(TransientMemory_IncompatibleMemoryTypesGetOwnBlocks) {
+    const std::vector resources = {MakeResource(4096, 0, 0, 256, 0x1), MakeResource(4096, 1, 1, 256, 0x2), MakeResource(4096, 2, 2, 256, 0x3)};
+    const auto plan = Planner::Build(resources);
+    CheckPlan(resources, plan);
+
+    //The third resource can live in either block, it shouldn't need a new one.
+    OX_CHECK(plan.Blocks.size() == 2);
+    OX_CHECK(plan.Placements[0].Block != plan.Placements[1].Block);
+  }
+
+  OX_TEST(TransientMemory_UnusedResourcesAliasNothing) {
+    Planner::Resource unused = MakeResource(4096, 1, 0);
+    OX_CHECK(!unused.IsUsed());
+    const std::vector resources = {MakeResource(4096, 0, 3), unused};
+    const auto plan = Planner::Build(resources);
+    CheckPlan(resources, plan);
+
+    //An unused resource overlaps anything, its memory is free to share but nobody loses contents to it.
+    OX_CHECK(plan.AllocatedSize == 4096);
+    OX_CHECK(plan.Aliases[0].empty());
+    OX_CHECK(plan.Aliases[1].empty());
+  }
+
+  OX_TEST(TransientMemory_RandomPlansHoldInvariants) {
+    std::mt19937 random(7);
+    for (uint32_t iteration = 0; iteration < 200; iteration++) {
+      const uint32_t resourceCount = random() % 24;
+      std::vector<Planner::Resource> resources;
+      for (uint32_t i = 0; i < resourceCount; i++) {
+        uint32_t firstUse = random() % 12;
+        uint32_t lastUse = firstUse + random() % 6;
+        if (random() % 8 == 0)
+          firstUse = lastUse + 1;
+        resources.emplace_back(MakeResource(1 + random() % 65536,
+          firstUse,
+          lastUse,
+          1ull << (random() % 13),
+          1 + random() % 7,
+          random() % 2));
+      }
+
+      const auto plan = Planner::Build(resources);
+      CheckPlan(resources, plan);
+    }
+  }
+}
@@ -0,0 +1,148 @@
+#include "Test.h"
+
+#include <random>
+#include <glm/gtc/packing.hpp>
+
+#include "Render/VertexFormat.h"
+
+namespace Oxylus {
+  //Largest angle in radians between a direction and its decoded octahedral snorm16 pair.
+  static constexpr float MAX_ANGLE_ERROR = 0.0005f;
+
+  //Mirrors of the decoding in VertexFormat.glsl.
+  static glm::vec3 DecodeOctahedral(const glm::vec2& encoded) {
+    glm::vec3 n = glm::vec3(encoded.x, encoded.y, 1.0f - glm::abs(encoded.x) - glm::abs(encoded.y));
+    const float t = glm::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return glm::normalize(n);
+  }
+
+  static glm::vec3 DecodeNormal(const uint32_t normal) {
+    return DecodeOctahedral(glm::unpackSnorm2x16(normal));
+  }
+
+  static glm::vec4 DecodeTangent(const uint32_t tangent) {
+    const glm::vec2 encoded = glm::unpackSnorm2x16(tangent);
+    const float w = encoded.y < 0.0f ? -1.0f : 1.0f;
+    return glm::vec4(DecodeOctahedral(glm::vec2(encoded.x, glm::abs(encoded.y) * 2.0f - 1.0f)), w);
+  }
+
+  //The chord is as good as the angle this close and doesn't lose its precision to a cosine near one.
+  static bool IsClose(const glm::vec3& expected, const glm::vec3& decoded, const float maxAngle = MAX_ANGLE_ERROR) {
+    return glm::length(glm::normalize(expected) - decoded) <= maxAngle;
+  }
+
+  //The axes, the octahedron edges and directions just below the equator, where the -Z hemisphere is folded over.
+  static std::vector<glm::vec3> GetDirections() {
+    std::vector<glm::vec3> directions = {
+      {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1},
+      {1, 1, 0}, {-1, 1, 0}, {1, -1, 0}, {-1, -1, 0},
+      {1, 1, 1}, {-1, -1, -1}, {1, -1, -1}, {-1, 1, -1},
+      {1, 0, -0.0001f}, {0, -1, -0.0001f}, {0.0001f, 0.0001f, -1},
+    };
+    std::mt19937 random(5);
+    std::normal_distribution<float> distribution;
+    for (uint32_t i = 0; i < 4096; i++) {
+      const glm::vec3 direction = {distribution(random), distribution(random), distribution(random)};
+      if (glm::length(direction) > 0.001f)
+        directions.emplace_back(direction);
+    }
+    return directions;
+  }
+
+  OX_TEST(VertexFormat_NormalsRoundTrip) {
+    for (const glm::vec3& direction : GetDirections()) {
+      const auto vertex = VertexFormat::EncodeBase(glm::vec3(0.0f), direction, glm::vec2(0.0f), glm::vec4(1, 0, 0, 1));
+      OX_CHECK(IsClose(direction, DecodeNormal(vertex.Normal)));
+      //The length is not part of the encoding.
+      const auto scaled = VertexFormat::EncodeBase(glm::vec3(0.0f), direction * 7.5f, glm::vec2(0.0f), glm::vec4(1, 0, 0, 1));
+      OX_CHECK(IsClose(direction, DecodeNormal(scaled.Normal)));
+    }
+  }
+
+  OX_TEST(VertexFormat_ZeroDirectionsFaceZ) {
+    const auto vertex = VertexFormat::EncodeBase(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec2(0.0f), glm::vec4(0.0f));
+    const glm::vec3 normal = DecodeNormal(vertex.Normal);
+    OX_CHECK(normal == glm::vec3(0, 0, 1));
+    const glm::vec4 tangent = DecodeTangent(vertex.Tangent);
+    OX_CHECK(IsClose(glm::vec3(0, 0, 1), glm::vec3(tangent)));
+    OX_CHECK(tangent.w == 1.0f);
+  }
+
+  OX_TEST(VertexFormat_TangentsKeepTheirSign) {
+    for (const glm::vec3& direction : GetDirections()) {
+      for (const float sign : {1.0f, -1.0f}) {
+        const auto vertex = VertexFormat::EncodeBase(glm::vec3(0.0f), glm::vec3(0, 0, 1), glm::vec2(0.0f), glm::vec4(direction, sign));
+        const glm::vec4 tangent = DecodeTangent(vertex.Tangent);
+        //The second component has half the precision of a normal's.
+        OX_CHECK(IsClose(direction, glm::vec3(tangent), MAX_ANGLE_ERROR * 2.0f));
+        OX_CHECK(tangent.w == sign);
+      }
+    }
+  }
+
+  OX_TEST(VertexFormat_PositionsAndUVs) {
+    const glm::vec3 position = {1.25f, -1e6f, 3.0e-7f};
+    const auto vertex = VertexFormat::EncodeBase(position, glm::vec3(0, 1, 0), glm::vec2(0.5f, -2.25f), glm::vec4(1, 0, 0, 1));
+    OX_CHECK(vertex.Position == position);
+    //Values a half represents exactly survive, others keep 11 significant bits.
+    OX_CHECK(glm::unpackHalf2x16(vertex.UV) == glm::vec2(0.5f, -2.25f));
+
+    std::mt19937 random(3);
+    std::uniform_real_distribution distribution(-4.0f, 4.0f);
+    for (uint32_t i = 0; i < 1024; i++) {
+      const glm::vec2 uv = {distribution(random), distribution(random)};
+      const glm::vec2 decoded = glm::unpackHalf2x16(VertexFormat::EncodeBase(glm::vec3(0.0f), glm::vec3(0, 0, 1), uv, glm::vec4(1, 0, 0, 1)).UV);
+      OX_CHECK(glm::all(glm::lessThanEqual(glm::abs(decoded - uv), glm::abs(uv) / 2048.0f + 1e-7f)));
+    }
+  }
+
+  OX_TEST(VertexFormat_ColorsAndWeights) {
+    std::mt19937 random(9);
+    std::uniform_real_distribution distribution(0.0f, 1.0f);
+    for (uint32_t i = 0; i < 1024; i++) {
+      const glm::vec4 value = {distribution(random), distribution(random), distribution(random), distribution(random)};
+      const glm::vec4 color = glm::unpackUnorm4x8(VertexFormat::EncodeColor(value).Color);
+      OX_CHECK(glm::all(glm::lessThanEqual(glm::abs(color - value), glm::vec4(0.5f / 255.0f + 1e-6f))));
+      const glm::vec4 weights = glm::unpackUnorm4x8(VertexFormat::EncodeSkin(glm::vec4(0.0f), value).Weights);
+      OX_CHECK(glm::all(glm::lessThanEqual(glm::abs(weights - value), glm::vec4(0.5f / 255.0f + 1e-6f))));
+    }
+    //Out of range values are clamped rather than wrapped.
+    OX_CHECK(glm::unpackUnorm4x8(VertexFormat::EncodeColor(glm::vec4(-1.0f, 2.0f, 0.0f, 1.0f)).Color) == glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
+  }
+
+  OX_TEST(VertexFormat_JointsAreExact) {
+    const auto vertex = VertexFormat::EncodeSkin(glm::vec4(0.0f, 1.0f, 255.0f, 65535.0f), glm::vec4(1.0f, 0.0f, 0.0f, 0.0f));
+    OX_CHECK(vertex.Joints[0] == 0);
+    OX_CHECK(vertex.Joints[1] == 1);
+    OX_CHECK(vertex.Joints[2] == 255);
+    OX_CHECK(vertex.Joints[3] == 65535);
+  }
+
+  OX_TEST(VertexFormat_Layout) {
+    OX_CHECK(VertexFormat::GetVertexSize(0) == 0);
+    OX_CHECK(VertexFormat::GetVertexSize(VertexFormat::BaseStream) == 24);
+    OX_CHECK(VertexFormat::GetVertexSize(VertexFormat::BaseStream | VertexFormat::SkinStream) == 36);
+    OX_CHECK(VertexFormat::GetVertexSize(VertexFormat::BaseStream | VertexFormat::ColorStream | VertexFormat::SkinStream) == 40);
+
+    //Every attribute fits in the stride of its stream and no two in the same stream overlap.
+    const std::vector<std::pair<VertexComponent, uint32_t>> components = {
+      {VertexComponent::POSITION, 12}, {VertexComponent::NORMAL, 4}, {VertexComponent::TANGENT, 4}, {VertexComponent::UV, 4},
+      {VertexComponent::COLOR, 4}, {VertexComponent::JOINT0, 8}, {VertexComponent::WEIGHT0, 4},
+    };
+    for (size_t a = 0; a < components.size(); a++) {
+      const auto first = VertexFormat::GetAttribute(components[a].first);
+      OX_CHECK(first.Format != vk::Format::eUndefined);
+      OX_CHECK(first.Offset + components[a].second <= VertexFormat::STREAM_STRIDES[first.Source]);
+      for (size_t b = a + 1; b < components.size(); b++) {
+        const auto second = VertexFormat::GetAttribute(components[b].first);
+        if (first.Source == second.Source)
+          OX_CHECK(first.Offset + components[a].second <= second.Offset || second.Offset + components[b].second <= first.Offset);
+      }
+    }
+    OX_CHECK(VertexFormat::GetAttribute(VertexComponent::COLOR).Source == VertexFormat::Color);
+    OX_CHECK(VertexFormat::GetAttribute(VertexComponent::JOINT0).Source == VertexFormat::Skin);
+    OX_CHECK(VertexFormat::GetAttribute(VertexComponent::BITANGENT).Format == vk::Format::eUndefined);
+  }
+}